@@ -0,0 +1,105 @@
+// Renders a generated scene for a fixed number of frames and reports cpu frame time, gpu frame time, draw calls
+// and device memory as p50/p95/p99 in JSON. With --baseline the run fails if any of them regressed against a
+// stored report.
+//
+//   GEngineBench [--objects N] [--models M] [--lights L] [--seed S] [--warmup F] [--frames F]
+//                [--headless] [--pipelined] [--output report.json] [--baseline report.json] [--tolerance 0.1]
+#include "app.hpp"
+
+// std
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+int main(int argc, char **argv)
+{
+    gen::BenchmarkScene scene{};
+    std::string outputPath = "bench_results.json";
+    std::string baselinePath{};
+    double tolerance = 0.1;
+    bool headless = false;
+    bool pipelined = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg{argv[i]};
+        bool hasValue = i + 1 < argc;
+        if (arg == "--objects" && hasValue)
+        {
+            scene.objectCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--models" && hasValue)
+        {
+            scene.modelCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--lights" && hasValue)
+        {
+            scene.lightCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--seed" && hasValue)
+        {
+            scene.seed = std::stoull(argv[++i]);
+        }
+        else if (arg == "--warmup" && hasValue)
+        {
+            scene.warmupFrames = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--frames" && hasValue)
+        {
+            scene.measuredFrames = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--output" && hasValue)
+        {
+            outputPath = argv[++i];
+        }
+        else if (arg == "--baseline" && hasValue)
+        {
+            baselinePath = argv[++i];
+        }
+        else if (arg == "--tolerance" && hasValue)
+        {
+            tolerance = std::stod(argv[++i]);
+        }
+        else if (arg == "--headless")
+        {
+            headless = true;
+        }
+        else if (arg == "--pipelined")
+        {
+            pipelined = true;
+        }
+        else
+        {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    try
+    {
+        gen::App app{headless};
+        app.enableBenchmark(scene);
+        if (pipelined)
+        {
+            app.enablePipelinedRendering();
+        }
+        app.run();
+
+        const gen::GenBenchmark &benchmark = *app.getBenchmark();
+        benchmark.writeJson(outputPath);
+        std::cout << "Benchmark results written to " << outputPath << std::endl;
+
+        if (!baselinePath.empty() && !benchmark.checkBaseline(baselinePath, tolerance))
+        {
+            std::cerr << "Benchmark regressed against " << baselinePath << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,201 @@
+// Measures how GenJobSystem scales from one thread to every core: a parallelFor over independent items and a
+// fan-out/fan-in chain of dependent job batches, each timed against the single threaded run.
+#include "gen_job_system.hpp"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t ITEM_COUNT = 1 << 20;
+    constexpr uint32_t BATCH_SIZE = 1024;
+    constexpr uint32_t CHAIN_STAGES = 16;
+    constexpr uint32_t CHAIN_JOBS_PER_STAGE = 256;
+    constexpr int REPEATS = 5;
+
+    // enough arithmetic per item that the benchmark is not bound by memory bandwidth
+    float work(float value)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            value = std::sin(value) * 0.5f + std::sqrt(std::abs(value) + 1.f);
+        }
+        return value;
+    }
+
+    template <typename Function>
+    double bestMillis(Function &&function)
+    {
+        double best = 1e30;
+        for (int i = 0; i < REPEATS; i++)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            function();
+            auto end = std::chrono::high_resolution_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        return best;
+    }
+
+    double runParallelFor(gen::GenJobSystem &jobSystem, const std::vector<float> &input, std::vector<float> &output)
+    {
+        return bestMillis(
+            [&]
+            {
+                jobSystem.parallelFor(
+                    ITEM_COUNT,
+                    BATCH_SIZE,
+                    [&](uint32_t begin, uint32_t end)
+                    {
+                        for (uint32_t i = begin; i < end; i++)
+                        {
+                            output[i] = work(input[i]);
+                        }
+                    });
+            });
+    }
+
+    // every stage only starts once the previous one finished, expressed with submitAfter. Each job takes a
+    // sequence number as it starts and another as it ends; ordered is cleared if any job started before every job
+    // of the stage it depends on had ended
+    double runDependencyChain(gen::GenJobSystem &jobSystem, std::vector<float> &data, bool &ordered)
+    {
+        constexpr uint32_t itemsPerJob = ITEM_COUNT / CHAIN_STAGES / CHAIN_JOBS_PER_STAGE;
+        std::vector<uint32_t> started(CHAIN_STAGES * CHAIN_JOBS_PER_STAGE);
+        std::vector<uint32_t> finished(CHAIN_STAGES * CHAIN_JOBS_PER_STAGE);
+        ordered = true;
+        return bestMillis(
+            [&]
+            {
+                std::atomic<uint32_t> sequence{0};
+                std::vector<gen::GenJobSystem::Counter> stages(CHAIN_STAGES);
+                for (uint32_t stage = 0; stage < CHAIN_STAGES; stage++)
+                {
+                    for (uint32_t job = 0; job < CHAIN_JOBS_PER_STAGE; job++)
+                    {
+                        auto run = [&data, &started, &finished, &sequence, stage, job]
+                        {
+                            uint32_t index = stage * CHAIN_JOBS_PER_STAGE + job;
+                            started[index] = sequence.fetch_add(1);
+                            uint32_t begin = index * itemsPerJob;
+                            for (uint32_t i = begin; i < begin + itemsPerJob; i++)
+                            {
+                                data[i] = work(data[i]);
+                            }
+                            finished[index] = sequence.fetch_add(1);
+                        };
+                        if (stage == 0)
+                        {
+                            jobSystem.submit(run, &stages[stage]);
+                        }
+                        else
+                        {
+                            jobSystem.submitAfter(stages[stage - 1], run, &stages[stage]);
+                        }
+                    }
+                }
+                jobSystem.wait(stages.back());
+
+                // a few thousand comparisons, nothing next to the jobs themselves
+                for (uint32_t stage = 1; stage < CHAIN_STAGES; stage++)
+                {
+                    auto jobs = started.begin() + stage * CHAIN_JOBS_PER_STAGE;
+                    auto parents = finished.begin() + (stage - 1) * CHAIN_JOBS_PER_STAGE;
+                    if (*std::min_element(jobs, jobs + CHAIN_JOBS_PER_STAGE) <
+                        *std::max_element(parents, parents + CHAIN_JOBS_PER_STAGE))
+                    {
+                        ordered = false;
+                    }
+                }
+            });
+    }
+}
+
+// optional argument: highest thread count to measure, defaults to the number of cores
+int main(int argc, char **argv)
+{
+    uint32_t coreCount = std::max(std::thread::hardware_concurrency(), 1u);
+    if (argc > 1)
+    {
+        coreCount = std::max(static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)), 1u);
+    }
+
+    // 1, 2, 4, ... up to every core
+    std::vector<uint32_t> threadCounts;
+    for (uint32_t threads = 1; threads < coreCount; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(coreCount);
+
+    std::vector<float> input(ITEM_COUNT);
+    for (uint32_t i = 0; i < ITEM_COUNT; i++)
+    {
+        input[i] = static_cast<float>(i % 1000) * 0.001f;
+    }
+    std::vector<float> expected(ITEM_COUNT);
+    std::transform(input.begin(), input.end(), expected.begin(), work);
+
+    std::cout << "Job system scaling, " << ITEM_COUNT << " items, best of " << REPEATS << " runs" << std::endl;
+    std::cout << std::setw(8) << "threads"
+              << std::setw(18) << "parallelFor ms" << std::setw(10) << "speedup"
+              << std::setw(18) << "dependent ms" << std::setw(10) << "speedup" << std::endl;
+
+    double baseParallelFor = 0.0;
+    double baseChain = 0.0;
+    for (uint32_t threads : threadCounts)
+    {
+        // the calling thread helps while waiting, so it counts as one of the threads
+        gen::GenJobSystem jobSystem{threads - 1};
+
+        std::vector<float> output(ITEM_COUNT);
+        double parallelForMillis = runParallelFor(jobSystem, input, output);
+        if (output != expected)
+        {
+            std::cerr << "parallelFor produced wrong results with " << threads << " threads" << std::endl;
+            return 1;
+        }
+
+        std::vector<float> data = input;
+        bool ordered = true;
+        double chainMillis = runDependencyChain(jobSystem, data, ordered);
+        if (!ordered)
+        {
+            std::cerr << "a dependent job started before its parents finished with " << threads << " threads"
+                      << std::endl;
+            return 1;
+        }
+        // every repeat applies work once more, compare against the same number of serial passes
+        std::vector<float> chainExpected = input;
+        for (int i = 0; i < REPEATS; i++)
+        {
+            std::transform(chainExpected.begin(), chainExpected.end(), chainExpected.begin(), work);
+        }
+        if (data != chainExpected)
+        {
+            std::cerr << "dependent jobs produced wrong results with " << threads << " threads" << std::endl;
+            return 1;
+        }
+
+        if (threads == 1)
+        {
+            baseParallelFor = parallelForMillis;
+            baseChain = chainMillis;
+        }
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::setw(8) << threads
+                  << std::setw(18) << parallelForMillis << std::setw(9) << baseParallelFor / parallelForMillis << "x"
+                  << std::setw(18) << chainMillis << std::setw(9) << baseChain / chainMillis << "x" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,383 @@
+// Micro-benchmarks of the CPU hot paths: obj loading, vertex hashing and deduplication, transform matrices,
+// point light billboard packing and camera setup. Each benchmark is calibrated to run for at least
+// MIN_SAMPLE_MILLIS per sample and reports the median, minimum and spread over the samples, per item.
+// Nothing here creates a Vulkan instance or device.
+//
+//   GEngineMicroBench [filter] [--repeats N]
+#include "gen_camera.hpp"
+#include "gen_game_object.hpp"
+#include "gen_model.hpp"
+#include "systems/point_light_system.hpp"
+
+// libs
+#include <glm/gtc/constants.hpp>
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    constexpr double MIN_SAMPLE_MILLIS = 2.0;
+    constexpr int WARMUP_CALLS = 3;
+
+    int repeats = 21;
+    std::string filter{};
+
+    // results are folded into this so the compiler can't drop the measured work
+    volatile float sink = 0.f;
+
+    struct Stats
+    {
+        double median = 0.0;
+        double min = 0.0;
+        double relativeStddev = 0.0;
+    };
+
+    Stats computeStats(std::vector<double> samples)
+    {
+        std::sort(samples.begin(), samples.end());
+        double mean = 0.0;
+        for (double sample : samples)
+        {
+            mean += sample;
+        }
+        mean /= samples.size();
+        double variance = 0.0;
+        for (double sample : samples)
+        {
+            variance += (sample - mean) * (sample - mean);
+        }
+        variance /= samples.size();
+
+        Stats stats{};
+        stats.median = samples[samples.size() / 2];
+        stats.min = samples.front();
+        stats.relativeStddev = mean > 0.0 ? 100.0 * std::sqrt(variance) / mean : 0.0;
+        return stats;
+    }
+
+    // function does itemCount items of work per call, results are in nanoseconds per item
+    template <typename Function>
+    void run(const std::string &name, uint32_t itemCount, Function &&function)
+    {
+        if (!filter.empty() && name.find(filter) == std::string::npos)
+        {
+            return;
+        }
+
+        using Clock = std::chrono::high_resolution_clock;
+        for (int i = 0; i < WARMUP_CALLS; i++)
+        {
+            function();
+        }
+
+        // enough calls per sample that timer resolution and noise don't dominate
+        uint32_t callsPerSample = 1;
+        while (true)
+        {
+            auto start = Clock::now();
+            for (uint32_t i = 0; i < callsPerSample; i++)
+            {
+                function();
+            }
+            if (std::chrono::duration<double, std::milli>(Clock::now() - start).count() >= MIN_SAMPLE_MILLIS)
+            {
+                break;
+            }
+            callsPerSample *= 2;
+        }
+
+        std::vector<double> samples;
+        for (int repeat = 0; repeat < repeats; repeat++)
+        {
+            auto start = Clock::now();
+            for (uint32_t i = 0; i < callsPerSample; i++)
+            {
+                function();
+            }
+            double nanos = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            samples.push_back(nanos / (static_cast<double>(callsPerSample) * itemCount));
+        }
+
+        Stats stats = computeStats(samples);
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::left << std::setw(40) << name << std::right
+                  << std::setw(10) << itemCount
+                  << std::setw(16) << stats.median
+                  << std::setw(16) << stats.min
+                  << std::setw(9) << stats.relativeStddev << "%" << std::endl;
+    }
+
+    // deterministic values in [0, 1), the same on every platform
+    float pseudoRandom(uint32_t i)
+    {
+        i = (i ^ 61u) ^ (i >> 16);
+        i *= 9u;
+        i ^= i >> 4;
+        i *= 0x27d4eb2du;
+        i ^= i >> 15;
+        return static_cast<float>(i >> 8) / static_cast<float>(1u << 24);
+    }
+
+    // a side x side grid of quads with positions, uvs and normals, shared corners like a real mesh
+    std::string writeGridObj(uint32_t side)
+    {
+        auto path = std::filesystem::temp_directory_path() / ("gen_micro_bench_grid_" + std::to_string(side) + ".obj");
+        std::ofstream file{path};
+        if (!file.is_open())
+        {
+            throw std::runtime_error{"Failed to open file: " + path.string()};
+        }
+
+        for (uint32_t z = 0; z <= side; z++)
+        {
+            for (uint32_t x = 0; x <= side; x++)
+            {
+                float height = .1f * pseudoRandom(z * (side + 1) + x);
+                file << "v " << x << " " << height << " " << z << "\n";
+                file << "vt " << static_cast<float>(x) / side << " " << static_cast<float>(z) / side << "\n";
+                file << "vn 0 1 0\n";
+            }
+        }
+        for (uint32_t z = 0; z < side; z++)
+        {
+            for (uint32_t x = 0; x < side; x++)
+            {
+                // obj indices start at 1
+                uint32_t i0 = z * (side + 1) + x + 1;
+                uint32_t i1 = i0 + 1;
+                uint32_t i2 = i0 + side + 1;
+                uint32_t i3 = i2 + 1;
+                file << "f " << i0 << "/" << i0 << "/" << i0 << " " << i2 << "/" << i2 << "/" << i2 << " "
+                     << i1 << "/" << i1 << "/" << i1 << "\n";
+                file << "f " << i1 << "/" << i1 << "/" << i1 << " " << i2 << "/" << i2 << "/" << i2 << " "
+                     << i3 << "/" << i3 << "/" << i3 << "\n";
+            }
+        }
+        return path.string();
+    }
+
+    void benchmarkLoadModel()
+    {
+        for (uint32_t side : {16u, 128u, 512u})
+        {
+            std::string path = writeGridObj(side);
+            gen::GenModel::Builder builder{};
+            builder.loadModel(path);
+            // per vertex of the face stream, before deduplication
+            uint32_t indexCount = static_cast<uint32_t>(builder.indices.size());
+            run("loadModel " + std::to_string(side) + "x" + std::to_string(side) + " grid", indexCount,
+                [&]
+                {
+                    builder.loadModel(path);
+                    sink = sink + builder.vertices[0].position.x;
+                });
+            std::filesystem::remove(path);
+        }
+    }
+
+    // the vertex stream of an indexed mesh, every vertex appears about six times like in the grids above
+    std::vector<gen::GenModel::Vertex> makeVertexStream(uint32_t count)
+    {
+        std::vector<gen::GenModel::Vertex> stream(count);
+        uint32_t uniqueCount = std::max(count / 6, 1u);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t id = static_cast<uint32_t>(pseudoRandom(i) * uniqueCount);
+            auto &vertex = stream[i];
+            vertex.position = {pseudoRandom(id), pseudoRandom(id + 1), pseudoRandom(id + 2)};
+            vertex.color = glm::vec3{1.f};
+            vertex.normal = {0.f, 1.f, 0.f};
+            vertex.uv = {vertex.position.x, vertex.position.z};
+        }
+        return stream;
+    }
+
+    void benchmarkVertexHashing()
+    {
+        constexpr uint32_t VERTEX_COUNT = 1 << 16;
+        auto stream = makeVertexStream(VERTEX_COUNT);
+
+        run("hashCombine vertex", VERTEX_COUNT,
+            [&]
+            {
+                std::hash<gen::GenModel::Vertex> hasher{};
+                size_t combined = 0;
+                for (const auto &vertex : stream)
+                {
+                    combined ^= hasher(vertex);
+                }
+                sink = sink + static_cast<float>(combined & 1);
+            });
+
+        // the same map and insertion pattern as loadModel
+        run("vertex deduplication", VERTEX_COUNT,
+            [&]
+            {
+                std::unordered_map<gen::GenModel::Vertex, uint32_t> uniqueVertices{};
+                std::vector<uint32_t> indices;
+                indices.reserve(stream.size());
+                for (const auto &vertex : stream)
+                {
+                    auto inserted = uniqueVertices.emplace(vertex, static_cast<uint32_t>(uniqueVertices.size()));
+                    indices.push_back(inserted.first->second);
+                }
+                sink = sink + static_cast<float>(indices.back());
+            });
+    }
+
+    void benchmarkTransforms()
+    {
+        constexpr uint32_t TRANSFORM_COUNT = 10000;
+        std::vector<gen::TransformComponent> transforms(TRANSFORM_COUNT);
+        for (uint32_t i = 0; i < TRANSFORM_COUNT; i++)
+        {
+            transforms[i].translation = {pseudoRandom(3 * i), pseudoRandom(3 * i + 1), pseudoRandom(3 * i + 2)};
+            transforms[i].rotation = glm::two_pi<float>() * glm::vec3{pseudoRandom(i + 7), pseudoRandom(i + 8), pseudoRandom(i + 9)};
+            transforms[i].scale = glm::vec3{.5f + pseudoRandom(i + 11)};
+        }
+
+        run("TransformComponent::mat4", TRANSFORM_COUNT,
+            [&]
+            {
+                float sum = 0.f;
+                for (auto &transform : transforms)
+                {
+                    sum += transform.mat4()[3][0];
+                }
+                sink = sink + sum;
+            });
+
+        run("TransformComponent::normalMatrix", TRANSFORM_COUNT,
+            [&]
+            {
+                float sum = 0.f;
+                for (auto &transform : transforms)
+                {
+                    sum += transform.normalMatrix()[2][2];
+                }
+                sink = sink + sum;
+            });
+    }
+
+    void benchmarkLightPacking()
+    {
+        for (uint32_t lightCount : {64u, 1024u, 8192u})
+        {
+            gen::GenGameObject::Map gameObjects;
+            for (uint32_t i = 0; i < lightCount; i++)
+            {
+                auto light = gen::GenGameObject::makePointLight(.2f, .1f, glm::vec3{pseudoRandom(i)});
+                light.transform.translation = {4.f * pseudoRandom(3 * i) - 2.f, -pseudoRandom(3 * i + 1), 4.f * pseudoRandom(3 * i + 2) - 2.f};
+                gameObjects.emplace(light.getId(), std::move(light));
+            }
+            // lights are mixed in with the other objects in the real scene
+            for (uint32_t i = 0; i < lightCount; i++)
+            {
+                auto object = gen::GenGameObject::createGameObject();
+                gameObjects.emplace(object.getId(), std::move(object));
+            }
+
+            gen::PointLightSystem::PackScratch scratch{};
+            std::vector<gen::PointLightSystem::BillboardInstance> instances(
+                gen::PointLightSystem::countBillboards(gameObjects));
+            glm::vec3 cameraPosition{0.f, -1.f, -2.5f};
+            for (bool sorted : {false, true})
+            {
+                run(std::string{"packBillboards "} + (sorted ? "sorted " : "unsorted ") + std::to_string(lightCount), lightCount,
+                    [&]
+                    {
+                        uint32_t count = gen::PointLightSystem::packBillboards(gameObjects, cameraPosition, sorted, scratch, instances.data());
+                        sink = sink + instances[count - 1].position.x;
+                    });
+            }
+        }
+    }
+
+    void benchmarkCamera()
+    {
+        constexpr uint32_t POSE_COUNT = 10000;
+        std::vector<glm::vec3> positions(POSE_COUNT);
+        std::vector<glm::vec3> rotations(POSE_COUNT);
+        for (uint32_t i = 0; i < POSE_COUNT; i++)
+        {
+            positions[i] = {pseudoRandom(3 * i), pseudoRandom(3 * i + 1), pseudoRandom(3 * i + 2)};
+            rotations[i] = glm::two_pi<float>() * glm::vec3{pseudoRandom(i + 5), pseudoRandom(i + 6), 0.f};
+        }
+
+        gen::GenCamera camera{};
+        run("GenCamera::setViewYXZ", POSE_COUNT,
+            [&]
+            {
+                float sum = 0.f;
+                for (uint32_t i = 0; i < POSE_COUNT; i++)
+                {
+                    camera.setViewYXZ(positions[i], rotations[i]);
+                    sum += camera.getView()[3][2];
+                }
+                sink = sink + sum;
+            });
+
+        run("GenCamera::setPerspectiveProjection", POSE_COUNT,
+            [&]
+            {
+                float sum = 0.f;
+                for (uint32_t i = 0; i < POSE_COUNT; i++)
+                {
+                    camera.setPerspectiveProjection(glm::radians(50.f), 1.f + positions[i].x, .1f, 1000.f);
+                    sum += camera.getProjection()[0][0];
+                }
+                sink = sink + sum;
+            });
+    }
+}
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg{argv[i]};
+        if (arg == "--repeats" && i + 1 < argc)
+        {
+            repeats = std::max(std::atoi(argv[++i]), 1);
+        }
+        else
+        {
+            filter = arg;
+        }
+    }
+
+    std::cout << "Median, minimum and relative standard deviation over " << repeats << " samples" << std::endl;
+    std::cout << std::left << std::setw(40) << "benchmark" << std::right
+              << std::setw(10) << "items"
+              << std::setw(16) << "median ns/item"
+              << std::setw(16) << "min ns/item"
+              << std::setw(10) << "stddev" << std::endl;
+
+    try
+    {
+        benchmarkLoadModel();
+        benchmarkVertexHashing();
+        benchmarkTransforms();
+        benchmarkLightPacking();
+        benchmarkCamera();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
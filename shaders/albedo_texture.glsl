@@ -0,0 +1,22 @@
+#ifndef ALBEDO_TEXTURE_GLSL
+#define ALBEDO_TEXTURE_GLSL
+
+// the albedo texture of SimpleRenderSystem's draws, after the push constant block
+#ifdef BINDLESS_TEXTURES
+// every texture registered in GenBindlessDescriptors, bound once. The normal matrix is only used as a mat3, its
+// last column carries the index of the draw's texture
+layout(set = 1, binding = 1) uniform sampler2D sampledImages[];
+
+vec3 sampleAlbedo(vec2 uv){
+    return texture(sampledImages[uint(push.normalMatrix[3][0])], uv).rgb;
+}
+#else
+// a set per texture, bound whenever the texture changes between draws
+layout(set = 1, binding = 0) uniform sampler2D albedoTexture;
+
+vec3 sampleAlbedo(vec2 uv){
+    return texture(albedoTexture, uv).rgb;
+}
+#endif
+
+#endif
@@ -0,0 +1,18 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+layout(input_attachment_index = 0, set = 1, binding = 0) uniform subpassInput inputAlbedo;
+layout(input_attachment_index = 2, set = 1, binding = 2) uniform subpassInput inputDepth;
+
+layout (location = 0) out vec4 outColor;
+
+#include "global_ubo.glsl"
+
+void main() {
+    float depth = subpassLoad(inputDepth).r;
+    if(depth >= 1.0){
+        discard; // nothing was drawn here, keep the clear color
+    }
+    vec3 albedo = subpassLoad(inputAlbedo).rgb;
+    outColor = vec4(albedo * ubo.ambientLightColor.xyz * ubo.ambientLightColor.w, 1.0);
+}
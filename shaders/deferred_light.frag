@@ -0,0 +1,48 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+layout(location = 0) flat in uint lightIndex;
+
+layout(input_attachment_index = 0, set = 1, binding = 0) uniform subpassInput inputAlbedo;
+layout(input_attachment_index = 1, set = 1, binding = 1) uniform subpassInput inputNormal;
+layout(input_attachment_index = 2, set = 1, binding = 2) uniform subpassInput inputDepth;
+
+layout (location = 0) out vec4 outColor;
+
+#include "point_lighting.glsl"
+
+// inverse of the perspective projection set up by GenCamera::setPerspectiveProjection
+vec3 reconstructPosWorld(float depth){
+    vec2 ndc = gl_FragCoord.xy / ubo.screenSize * 2.0 - 1.0;
+    float viewZ = ubo.projection[3][2] / (depth - ubo.projection[2][2]);
+    vec3 posView = vec3(
+        (ndc.x - ubo.projection[2][0]) * viewZ / ubo.projection[0][0],
+        (ndc.y - ubo.projection[2][1]) * viewZ / ubo.projection[1][1],
+        viewZ);
+    return (ubo.invView * vec4(posView, 1.0)).xyz;
+}
+
+void main() {
+    float depth = subpassLoad(inputDepth).r;
+    if(depth >= 1.0){
+        discard;
+    }
+
+    vec3 fragPosWorld = reconstructPosWorld(depth);
+    vec3 albedo = subpassLoad(inputAlbedo).rgb;
+    vec3 surfaceNormal = normalize(subpassLoad(inputNormal).xyz);
+
+    PointLight light = lights[lightIndex];
+    vec3 directionToLight = light.position.xyz - fragPosWorld;
+    if(dot(directionToLight, directionToLight) >= light.position.w * light.position.w){
+        discard; // outside of the light's range
+    }
+
+    vec3 cameraPosWorld = ubo.invView[3].xyz;
+    vec3 viewDirection = normalize(cameraPosWorld - fragPosWorld);
+    vec3 diffuseLight = vec3(0.0);
+    vec3 specularLight = vec3(0.0);
+    shadePointLight(light, fragPosWorld, surfaceNormal, viewDirection, diffuseLight, specularLight);
+
+    outColor = vec4((diffuseLight + specularLight) * albedo, 0.0);
+}
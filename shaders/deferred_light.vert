@@ -0,0 +1,51 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+const vec2 CORNERS[6] = vec2[](
+  vec2(0.0, 0.0),
+  vec2(1.0, 0.0),
+  vec2(0.0, 1.0),
+  vec2(0.0, 1.0),
+  vec2(1.0, 0.0),
+  vec2(1.0, 1.0)
+);
+
+layout(location = 0) flat out uint lightIndex;
+
+#include "global_ubo.glsl"
+
+// the light volume is the screen space rectangle that bounds the light's range,
+// computed the same way as the cpu light clustering in LightClusterSystem
+void main(){
+    lightIndex = gl_InstanceIndex;
+    PointLight light = lights[gl_InstanceIndex];
+
+    vec3 center = (ubo.view * vec4(light.position.xyz, 1.0)).xyz;
+    float range = light.position.w;
+    float nearClip = ubo.clusterDepth.x;
+
+    if(center.z + range <= nearClip){
+        gl_Position = vec4(-2.0, -2.0, 0.0, 1.0); // behind the camera, emit a degenerate quad
+        return;
+    }
+
+    float minDepth = max(center.z - range, nearClip);
+    float maxDepth = center.z + range;
+    vec2 ndcMin = vec2(1e9);
+    vec2 ndcMax = vec2(-1e9);
+    for(int i = 0; i < 8; i++){
+        vec4 corner = vec4(
+            center.x + (((i & 1) != 0) ? range : -range),
+            center.y + (((i & 2) != 0) ? range : -range),
+            ((i & 4) != 0) ? maxDepth : minDepth,
+            1.0);
+        vec4 clip = ubo.projection * corner;
+        vec2 ndc = clip.xy / clip.w;
+        ndcMin = min(ndcMin, ndc);
+        ndcMax = max(ndcMax, ndc);
+    }
+    ndcMin = max(ndcMin, vec2(-1.0));
+    ndcMax = min(ndcMax, vec2(1.0));
+
+    gl_Position = vec4(mix(ndcMin, ndcMax, CORNERS[gl_VertexIndex]), 0.0, 1.0);
+}
@@ -0,0 +1,20 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+layout(location = 0) in vec3 position;
+
+// must match simple_shader.vert bit for bit, the main pass tests depth with EQUAL
+invariant gl_Position;
+
+#include "global_ubo.glsl"
+
+//push constant
+layout(push_constant) uniform Push{
+    mat4 modelMatrix;
+    mat4 normalMatrix;
+} push;
+
+void main(){
+    vec4 positionWorld = push.modelMatrix * vec4(position, 1.0);
+    gl_Position = ubo.projection * ubo.view * positionWorld;
+}
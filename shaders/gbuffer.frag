@@ -0,0 +1,28 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+// built a second time as gbuffer_bindless.frag.spv with BINDLESS_TEXTURES defined
+#ifdef BINDLESS_TEXTURES
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec3 fragPosWorld;
+layout(location = 2) in vec3 fragNormalWorld;
+layout(location = 3) in vec2 fragUv;
+
+// g-buffer attachments of the deferred render pass, lighting happens in the next subpass
+layout (location = 0) out vec4 outAlbedo;
+layout (location = 1) out vec4 outNormal;
+
+//push constant
+layout(push_constant) uniform Push{
+    mat4 modelMatrix;
+    mat4 normalMatrix;
+} push;
+
+#include "albedo_texture.glsl"
+
+void main() {
+    outAlbedo = vec4(fragColor * sampleAlbedo(fragUv), 1.0);
+    outNormal = vec4(normalize(fragNormalWorld), 0.0);
+}
@@ -0,0 +1,27 @@
+#ifndef GLOBAL_UBO_GLSL
+#define GLOBAL_UBO_GLSL
+
+// the global descriptor set, keep in sync with GlobalUbo in gen_frame_info.hpp and LightClusterSystem
+
+struct PointLight{
+    vec4 position; // w is range
+    vec4 color; // w is intensity
+};
+
+// descriptor set
+layout(set = 0, binding = 0) uniform GlobalUbo {
+    mat4 projection;
+    mat4 view;
+    mat4 invView;
+    vec4 ambientLightColor; // w is intensity
+    uvec4 clusterGrid; // xyz: number of clusters per axis
+    vec4 clusterDepth; // x: near, y: far, z: slice scale, w: slice bias
+    vec2 screenSize;
+    int numLights;
+} ubo;
+
+layout(std430, set = 0, binding = 1) readonly buffer LightBuffer {
+    PointLight lights[];
+};
+
+#endif
@@ -0,0 +1,18 @@
+#version 450
+
+layout(input_attachment_index = 0, set = 0, binding = 0) uniform subpassInput inputAccum;
+layout(input_attachment_index = 1, set = 0, binding = 1) uniform subpassInput inputRevealage;
+
+layout (location = 0) out vec4 outColor;
+
+void main() {
+    float revealage = subpassLoad(inputRevealage).r;
+    if(revealage >= 1.0){
+        discard; // no transparent surface covers this pixel
+    }
+    vec4 accum = subpassLoad(inputAccum);
+    vec3 averageColor = accum.rgb / max(accum.a, 1e-5);
+
+    // blended with src alpha, so the opaque image shows through by the revealage
+    outColor = vec4(averageColor, 1.0 - revealage);
+}
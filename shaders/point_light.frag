@@ -1,29 +1,12 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
 layout(location = 0) in vec2 fragOffset;
+layout(location = 1) flat in vec4 fragColor;
 
 layout(location = 0) out vec4 outColor;
 
-struct PointLight{
-    vec4 position; // ignore w
-    vec4 color; // w is intensity
-};
-
-// descriptor set
-layout(set = 0, binding = 0) uniform GlobalUbo {
-    mat4 projection;
-    mat4 view;
-    mat4 invView;
-    vec4 ambientLightColor; // w is intensity
-    PointLight pointlights[10]; // instead of hardcoding this, we could pass it in as a specialization constant
-    int numLights;
-} ubo;
-
-layout(push_constant) uniform Push {
-    vec4 position;
-    vec4 color;
-    float radius;
-} push;
+#include "global_ubo.glsl"
 
 const float M_PI = 3.14159265358;
 
@@ -32,5 +15,5 @@ void main(){
     if(dis > 1.0){
         discard; // throw away this fragment and return
     }
-    outColor = vec4(push.color.xyz, 0.5 * (cos(dis * M_PI) + 1.0));
+    outColor = vec4(fragColor.xyz, 0.5 * (cos(dis * M_PI) + 1.0));
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
 const vec2 OFFSETS[6] = vec2[](
   vec2(-1.0, -1.0),
@@ -9,37 +10,25 @@ const vec2 OFFSETS[6] = vec2[](
   vec2(1.0, 1.0)
 );
 
-layout(location = 0) out vec2 fragOffset;
-
-struct PointLight{
-    vec4 position; // ignore w
-    vec4 color; // w is intensity
-};
+// per instance
+layout(location = 0) in vec4 lightPosition; // w is radius
+layout(location = 1) in vec4 lightColor;    // w is intensity
 
-// descriptor set
-layout(set = 0, binding = 0) uniform GlobalUbo {
-    mat4 projection;
-    mat4 view;
-    mat4 invView;
-    vec4 ambientLightColor; // w is intensity
-    PointLight pointlights[10]; // instead of hardcoding this, we could pass it in as a specialization constant
-    int numLights;
-} ubo;
+layout(location = 0) out vec2 fragOffset;
+layout(location = 1) flat out vec4 fragColor;
 
-layout(push_constant) uniform Push {
-    vec4 position;
-    vec4 color;
-    float radius;
-} push;
+#include "global_ubo.glsl"
 
 void main(){
     fragOffset = OFFSETS[gl_VertexIndex];
+    fragColor = lightColor;
     vec3 cameraRightWorld = {ubo.view[0][0], ubo.view[1][0], ubo.view[2][0]};
     vec3 cameraUpWorld = {ubo.view[0][1], ubo.view[1][1], ubo.view[2][1]};
 
-    vec3 positionWorld = push.position.xyz
-        + push.radius * fragOffset.x * cameraRightWorld
-        + push.radius * fragOffset.y * cameraUpWorld;
+    float radius = lightPosition.w;
+    vec3 positionWorld = lightPosition.xyz
+        + radius * fragOffset.x * cameraRightWorld
+        + radius * fragOffset.y * cameraUpWorld;
 
     gl_Position = ubo.projection * ubo.view * vec4(positionWorld, 1.0);
-}
\ No newline at end of file
+}
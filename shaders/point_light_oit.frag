@@ -0,0 +1,25 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+layout(location = 0) in vec2 fragOffset;
+layout(location = 1) flat in vec4 fragColor;
+
+layout(location = 0) out vec4 outAccum;
+layout(location = 1) out float outRevealage;
+
+#include "global_ubo.glsl"
+
+const float M_PI = 3.14159265358;
+
+void main(){
+    float dis = sqrt(dot(fragOffset, fragOffset));
+    if(dis > 1.0){
+        discard; // throw away this fragment and return
+    }
+    float alpha = 0.5 * (cos(dis * M_PI) + 1.0);
+
+    // depth weight from McGuire and Bavoil, closer and more opaque fragments dominate the average
+    float weight = clamp(pow(min(1.0, alpha * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);
+    outAccum = vec4(fragColor.xyz * alpha, alpha) * weight;
+    outRevealage = alpha;
+}
@@ -0,0 +1,65 @@
+#ifndef POINT_LIGHTING_GLSL
+#define POINT_LIGHTING_GLSL
+
+#include "global_ubo.glsl"
+
+layout(std430, set = 0, binding = 2) readonly buffer ClusterBuffer {
+    uvec2 clusters[]; // x: offset into the light index list, y: light count
+};
+
+layout(std430, set = 0, binding = 3) readonly buffer LightIndexBuffer {
+    uint lightIndices[];
+};
+
+uint clusterIndex(vec3 posWorld){
+    float viewDepth = (ubo.view * vec4(posWorld, 1.0)).z;
+    uint slice = uint(max(log(viewDepth) * ubo.clusterDepth.z - ubo.clusterDepth.w, 0.0));
+    uvec2 tile = uvec2(gl_FragCoord.xy / ubo.screenSize * vec2(ubo.clusterGrid.xy));
+    tile = min(tile, ubo.clusterGrid.xy - 1);
+    slice = min(slice, ubo.clusterGrid.z - 1);
+    return tile.x + tile.y * ubo.clusterGrid.x + slice * ubo.clusterGrid.x * ubo.clusterGrid.y;
+}
+
+// blinn-phong, used by the forward shaders and the deferred light volumes alike
+void shadePointLight(
+    PointLight light, vec3 posWorld, vec3 surfaceNormal, vec3 viewDirection,
+    inout vec3 diffuseLight, inout vec3 specularLight){
+    vec3 directionToLight = light.position.xyz - posWorld;
+    float disSquared = dot(directionToLight, directionToLight);
+    // smooth window so the contribution reaches exactly zero at the light's range
+    float rangeFactor = disSquared / (light.position.w * light.position.w);
+    float window = clamp(1.0 - rangeFactor * rangeFactor, 0.0, 1.0);
+    float attenuation = window * window / disSquared;
+    directionToLight = normalize(directionToLight);
+
+    float cosAngIncidence = max(dot(surfaceNormal, directionToLight), 0);
+    vec3 intensity = light.color.xyz * light.color.w * attenuation;
+
+    diffuseLight += intensity * cosAngIncidence;
+
+    //specular lighting
+    vec3 halfAngle = normalize(directionToLight + viewDirection);
+    float blinnTerm = dot(surfaceNormal, halfAngle);
+    blinnTerm = clamp(blinnTerm, 0, 1);
+    blinnTerm = pow(blinnTerm, 32.0); //higher values -> sharper specular highlight, replace 32 with a value passed to the shader
+    specularLight += intensity * blinnTerm;
+}
+
+// ambient plus the lights binned into this fragment's cluster, the only ones that can reach it
+vec3 clusteredLighting(vec3 posWorld, vec3 normalWorld, vec3 albedo){
+    vec3 diffuseLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
+    vec3 specularLight = vec3(0.0); //will hold the total for each point light specular contribution
+    vec3 surfaceNormal = normalize(normalWorld);
+
+    vec3 cameraPosWorld = ubo.invView[3].xyz;
+    vec3 viewDirection = normalize(cameraPosWorld - posWorld);
+
+    uvec2 cluster = clusters[clusterIndex(posWorld)];
+    for(uint i = 0; i < cluster.y; i++){
+        shadePointLight(
+            lights[lightIndices[cluster.x + i]], posWorld, surfaceNormal, viewDirection, diffuseLight, specularLight);
+    }
+    return diffuseLight * albedo + specularLight * albedo;
+}
+
+#endif
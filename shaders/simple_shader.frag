@@ -1,26 +1,19 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
+// built a second time as simple_shader_bindless.frag.spv with BINDLESS_TEXTURES defined
+#ifdef BINDLESS_TEXTURES
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec3 fragPosWorld;
 layout(location = 2) in vec3 fragNormalWorld;
+layout(location = 3) in vec2 fragUv;
 
 
 layout (location = 0) out vec4 outColor;
 
-struct PointLight{
-    vec4 position; // ignore w
-    vec4 color; // w is intensity
-};
-
-// descriptor set
-layout(set = 0, binding = 0) uniform GlobalUbo {
-    mat4 projection;
-    mat4 view;
-    mat4 invView;
-    vec4 ambientLightColor; // w is intensity
-    PointLight pointlights[10]; // instead of hardcoding this, we could pass it in as a specialization constant
-    int numLights;
-} ubo;
+#include "point_lighting.glsl"
 
 //push constant
 layout(push_constant) uniform Push{
@@ -28,32 +21,9 @@ layout(push_constant) uniform Push{
     mat4 normalMatrix;
 } push;
 
-void main() {
-    vec3 diffuseLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
-    vec3 specularLight = vec3(0.0); //will hold the total for each point light specular contribution
-    vec3 surfaceNormal = normalize(fragNormalWorld);
-
-    vec3 cameraPosWorld = ubo.invView[3].xyz;
-    vec3 viewDirection = normalize(cameraPosWorld - fragPosWorld);
-
-    for(int i = 0; i < ubo.numLights; i++){
-        PointLight light = ubo.pointlights[i];
-        vec3 directionToLight = light.position.xyz - fragPosWorld;
-        float attenuation = 1.0 / dot(directionToLight, directionToLight);
-        directionToLight = normalize(directionToLight);
-        
-        float cosAngIncidence = max(dot(surfaceNormal, directionToLight), 0);
-        vec3 intensity = light.color.xyz * light.color.w * attenuation;
+#include "albedo_texture.glsl"
 
-        diffuseLight += intensity * cosAngIncidence;
-
-        //specular lighting
-        vec3 halfAngle = normalize(directionToLight + viewDirection);
-        float blinnTerm = dot(surfaceNormal, halfAngle);
-        blinnTerm = clamp(blinnTerm, 0, 1);
-        blinnTerm = pow(blinnTerm, 32.0); //higher values -> sharper specular highlight, replace 32 with a value passed to the shader
-        specularLight += intensity * blinnTerm;
-    }
-
-    outColor = vec4(diffuseLight * fragColor + specularLight * fragColor, 1.0);
-}
\ No newline at end of file
+void main() {
+    vec3 albedo = fragColor * sampleAlbedo(fragUv);
+    outColor = vec4(clusteredLighting(fragPosWorld, fragNormalWorld, albedo), 1.0);
+}
@@ -1,29 +1,21 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 color;
 layout(location = 2) in vec3 normal;
-layout(location = 3) in vec3 uv;
+layout(location = 3) in vec2 uv;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec3 fragPosWorld;
 layout(location = 2) out vec3 fragNormalWorld;
+layout(location = 3) out vec2 fragUv;
 
+// same transform as depth_prepass.vert, invariant so the EQUAL depth test after the pre-pass passes
+invariant gl_Position;
 
-struct PointLight{
-    vec4 position; // ignore w
-    vec4 color; // w is intensity
-};
 
-// descriptor set
-layout(set = 0, binding = 0) uniform GlobalUbo {
-    mat4 projection;
-    mat4 view;
-    mat4 invView;
-    vec4 ambientLightColor; // w is intensity
-    PointLight pointlights[10]; // instead of hardcoding this, we could pass it in as a specialization constant
-    int numLights;
-} ubo;
+#include "global_ubo.glsl"
 
 //push constant
 layout(push_constant) uniform Push{
@@ -38,4 +30,5 @@ void main(){
     fragNormalWorld = normalize(mat3(push.normalMatrix) * normal);
     fragPosWorld = positionWorld.xyz;
     fragColor = color;
+    fragUv = uv;
 }
\ No newline at end of file
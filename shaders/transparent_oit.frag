@@ -0,0 +1,28 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec3 fragPosWorld;
+layout(location = 2) in vec3 fragNormalWorld;
+
+
+layout (location = 0) out vec4 outAccum;
+layout (location = 1) out float outRevealage;
+
+#include "point_lighting.glsl"
+
+//push constant, the normal matrix is only used as a mat3 so its last element carries the alpha
+layout(push_constant) uniform Push{
+    mat4 modelMatrix;
+    mat4 normalMatrix;
+} push;
+
+void main() {
+    vec3 color = clusteredLighting(fragPosWorld, fragNormalWorld, fragColor);
+    float alpha = push.normalMatrix[3][3];
+
+    // depth weight from McGuire and Bavoil, closer and more opaque fragments dominate the average
+    float weight = clamp(pow(min(1.0, alpha * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);
+    outAccum = vec4(color * alpha, alpha) * weight;
+    outRevealage = alpha;
+}
@@ -0,0 +1,21 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec3 fragPosWorld;
+layout(location = 2) in vec3 fragNormalWorld;
+
+
+layout (location = 0) out vec4 outColor;
+
+#include "point_lighting.glsl"
+
+//push constant, the normal matrix is only used as a mat3 so its last element carries the alpha
+layout(push_constant) uniform Push{
+    mat4 modelMatrix;
+    mat4 normalMatrix;
+} push;
+
+void main() {
+    outColor = vec4(clusteredLighting(fragPosWorld, fragNormalWorld, fragColor), push.normalMatrix[3][3]);
+}
@@ -0,0 +1,42 @@
+#version 450
+
+layout (location = 0) in vec2 fragUv;
+
+layout (location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 0) uniform sampler2D sceneColor;
+
+layout(push_constant) uniform Push {
+    vec2 uvScale;   // rendered region of the scene color, in uv
+    vec2 texelSize; // one scene color texel, in uv
+    vec2 maxUv;     // center of the last rendered texel, nothing past it was rendered this frame
+    float sharpness; // 0 samples bilinear only
+} push;
+
+vec3 fetch(vec2 uv){
+    return texture(sceneColor, clamp(uv, 0.5 * push.texelSize, push.maxUv)).rgb;
+}
+
+void main() {
+    vec2 uv = fragUv * push.uvScale;
+    vec3 center = fetch(uv);
+    if(push.sharpness <= 0.0){
+        outColor = vec4(center, 1.0);
+        return;
+    }
+
+    // contrast adaptive sharpening: a negative lobe on the four neighbours, weaker where the local contrast is
+    // already high so edges don't ring
+    vec3 north = fetch(uv + vec2(0.0, -push.texelSize.y));
+    vec3 south = fetch(uv + vec2(0.0, push.texelSize.y));
+    vec3 west = fetch(uv + vec2(-push.texelSize.x, 0.0));
+    vec3 east = fetch(uv + vec2(push.texelSize.x, 0.0));
+
+    vec3 minColor = min(center, min(min(north, south), min(west, east)));
+    vec3 maxColor = max(center, max(max(north, south), max(west, east)));
+    vec3 amount = sqrt(clamp(min(minColor, 1.0 - maxColor) / max(maxColor, 1e-5), 0.0, 1.0));
+    vec3 weight = amount * (-1.0 / mix(8.0, 5.0, push.sharpness));
+
+    vec3 color = (center + (north + south + west + east) * weight) / (1.0 + 4.0 * weight);
+    outColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
@@ -3,8 +3,16 @@
 #include "keyboard_movement_controller.hpp"
 #include "gen_camera.hpp"
 #include "gen_buffer.hpp"
+#include "gen_cpu_profiler.hpp"
+#include "gen_gpu_profiler.hpp"
+#include "gen_pipeline_statistics.hpp"
+#include "gen_triple_buffer.hpp"
 #include "systems/simple_render_system.hpp"
 #include "systems/point_light_system.hpp"
+#include "systems/light_cluster_system.hpp"
+#include "systems/deferred_lighting_system.hpp"
+#include "systems/transparent_render_system.hpp"
+#include "systems/upscale_system.hpp"
 
 // glm
 #define GLM_FORCE_RADIANS           // glm functions will except values in radians, not degrees
@@ -15,19 +23,312 @@
 // std
 #include <stdexcept>
 #include <chrono>
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
 
 namespace gen
 {
+    namespace
+    {
+        // reports a key only on the frame it goes down, so holding it doesn't toggle every frame
+        struct KeyToggle
+        {
+            int key;
+            bool wasDown = false;
+
+            // never pressed without a window
+            bool pressed(GLFWwindow *window)
+            {
+                if (window == nullptr)
+                {
+                    return false;
+                }
+                bool isDown = glfwGetKey(window, key) == GLFW_PRESS;
+                bool result = isDown && !wasDown;
+                wasDown = isDown;
+                return result;
+            }
+        };
+
+        // steps through thread counts, timing the opaque pass recording for a fixed number of frames each
+        struct RecordingBenchmark
+        {
+            static constexpr uint32_t WARMUP_FRAMES = 20;
+            static constexpr uint32_t MEASURED_FRAMES = 100;
+
+            std::vector<uint32_t> threadCounts;
+            size_t step = 0;
+            uint32_t frame = 0;
+            double recordMicros = 0.0;
+
+            bool done() const { return step >= threadCounts.size(); }
+
+            // returns true once every thread count has been measured
+            bool addFrame(double micros, uint32_t objectCount)
+            {
+                if (frame++ >= WARMUP_FRAMES)
+                {
+                    recordMicros += micros;
+                }
+                if (frame < WARMUP_FRAMES + MEASURED_FRAMES)
+                {
+                    return false;
+                }
+
+                double average = recordMicros / MEASURED_FRAMES;
+                std::cout << "Recording " << objectCount << " objects on " << threadCounts[step] << " thread(s): "
+                          << average / 1000.0 << " ms/frame" << std::endl;
+                step++;
+                frame = 0;
+                recordMicros = 0.0;
+                return done();
+            }
+        };
+
+        // the median of the last light clustering build times, a few slow frames from paging or the first builds
+        // don't skew it like they do the mean. Keeps a fixed number of samples however long the app runs
+        struct ClusterBuildWindow
+        {
+            static constexpr size_t CAPACITY = 256;
+
+            std::vector<float> samples{};
+            size_t next = 0;
+            uint64_t frames = 0;
+
+            void add(float micros)
+            {
+                if (samples.size() < CAPACITY)
+                {
+                    samples.push_back(micros);
+                }
+                else
+                {
+                    samples[next] = micros;
+                }
+                next = (next + 1) % CAPACITY;
+                frames++;
+            }
+
+            float median() const
+            {
+                std::vector<float> sorted = samples;
+                auto middle = sorted.begin() + sorted.size() / 2;
+                std::nth_element(sorted.begin(), middle, sorted.end());
+                return *middle;
+            }
+        };
+
+        // steps the number of uploaded lights through lightCounts, timing the light clustering for a fixed
+        // number of frames each
+        struct LightSweep
+        {
+            static constexpr uint32_t WARMUP_FRAMES = 20;
+            static constexpr uint32_t MEASURED_FRAMES = 100;
+
+            std::vector<uint32_t> lightCounts;
+            size_t step = 0;
+            uint32_t frame = 0;
+            ClusterBuildWindow buildMicros{};
+
+            bool done() const { return step >= lightCounts.size(); }
+            uint32_t lightCount() const { return lightCounts[step]; }
+
+            // returns true once every light count has been measured
+            bool addFrame(float micros, LightClusterSystem::Mode mode, uint32_t uploadedLights)
+            {
+                if (frame++ >= WARMUP_FRAMES)
+                {
+                    buildMicros.add(micros);
+                }
+                if (frame < WARMUP_FRAMES + MEASURED_FRAMES)
+                {
+                    return false;
+                }
+
+                float median = buildMicros.median();
+                std::cout << "Light sweep (" << (mode == LightClusterSystem::Mode::CPU ? "cpu" : "compute") << "): "
+                          << uploadedLights << " lights, " << median << " us/frame median, "
+                          << (uploadedLights > 0 ? 1000.0 * median / uploadedLights : 0.0) << " ns/light" << std::endl;
+                step++;
+                frame = 0;
+                buildMicros = {};
+                return done();
+            }
+        };
+
+        // toggled on the game thread, applied by the render thread before it records a frame
+        struct RenderSettings
+        {
+            LightClusterSystem::Mode clusterMode = LightClusterSystem::Mode::CPU;
+            RenderPath renderPath = RenderPath::Forward;
+            bool depthPrePass = false;
+            // opaque objects recorded into secondary command buffers on all cores
+            bool parallelRecording = false;
+            // weighted blended order independent transparency, only on the forward path
+            bool orderIndependentTransparency = true;
+            uint32_t framesInFlight = GenSwapChain::DEFAULT_FRAMES_IN_FLIGHT;
+            VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+            // wait for the frame slot before sampling input instead of after simulating, serial mode only
+            bool lowLatency = false;
+            // scene resolution follows the gpu frame time, upscaled to the swap chain
+            bool dynamicResolution = false;
+            UpscaleSystem::Filter upscaleFilter = UpscaleSystem::Filter::Bilinear;
+            // bumped for every request to print the gpu timings
+            uint32_t gpuStatsRequests = 0;
+
+            bool samePacing(const RenderSettings &other) const
+            {
+                return framesInFlight == other.framesInFlight && presentMode == other.presentMode &&
+                       lowLatency == other.lowLatency;
+            }
+        };
+
+        // averages the cpu time blocked in the swap chain over the frames rendered with one pacing setup
+        struct FrameWaitReport
+        {
+            RenderSettings settings{};
+            VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR; // the mode in use, may differ from the requested one
+            uint64_t frames = 0;
+            double fenceMicros = 0.0;
+            double acquireMicros = 0.0;
+            double submitMicros = 0.0;
+
+            void add(const FrameWaitTimes &times)
+            {
+                fenceMicros += times.fenceMicros;
+                acquireMicros += times.acquireMicros;
+                submitMicros += times.submitMicros;
+                frames++;
+            }
+
+            void print() const
+            {
+                if (frames == 0)
+                {
+                    return;
+                }
+                std::cout << "Frame waits with " << settings.framesInFlight << " frame(s) in flight, "
+                          << GenSwapChain::presentModeName(presentMode) << (settings.lowLatency ? ", low latency" : "")
+                          << ": fence " << fenceMicros / frames << " us, acquire " << acquireMicros / frames
+                          << " us, submit " << submitMicros / frames << " us per frame over " << frames << " frames"
+                          << std::endl;
+            }
+        };
+
+        // everything the render thread needs from one simulation step, never touched by the game thread
+        // again once published
+        struct FrameSnapshot
+        {
+            float frameTime = 0.f;
+            GenCamera camera{}; // view only, the render thread sets the projection from the swap chain extent
+            std::vector<TransformComponent> transforms{};
+            std::vector<PointLight> lights{};
+            RenderSettings settings{};
+        };
+
+        // keeps the game thread at most one frame ahead of the render thread. The snapshots themselves go
+        // through a lock free triple buffer, this only puts the thread that is ahead to sleep
+        class SnapshotPacer
+        {
+        public:
+            // game thread, after publishing a snapshot
+            void publish()
+            {
+                {
+                    std::lock_guard<std::mutex> lock{mutex};
+                    published++;
+                }
+                condition.notify_all();
+            }
+
+            // game thread, true once the render thread picked up the last snapshot or the pacer was closed
+            bool waitUntilConsumed(std::chrono::milliseconds timeout)
+            {
+                std::unique_lock<std::mutex> lock{mutex};
+                return condition.wait_for(lock, timeout, [this]
+                                          { return closed || consumed == published; });
+            }
+
+            // render thread, false once the pacer was closed
+            bool waitForSnapshot()
+            {
+                {
+                    std::unique_lock<std::mutex> lock{mutex};
+                    condition.wait(lock, [this]
+                                   { return closed || consumed < published; });
+                    if (closed)
+                    {
+                        return false;
+                    }
+                    consumed = published;
+                }
+                condition.notify_all();
+                return true;
+            }
+
+            void close()
+            {
+                {
+                    std::lock_guard<std::mutex> lock{mutex};
+                    closed = true;
+                }
+                condition.notify_all();
+            }
+
+            bool isClosed()
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                return closed;
+            }
+
+        private:
+            std::mutex mutex;
+            std::condition_variable condition;
+            uint64_t published = 0;
+            uint64_t consumed = 0;
+            bool closed = false;
+        };
+
+        // binary PPM, alpha is dropped
+        void writePpm(const std::string &filepath, uint32_t width, uint32_t height, const std::vector<uint8_t> &rgba)
+        {
+            std::ofstream file{filepath, std::ios::binary};
+            if (!file.is_open())
+            {
+                throw std::runtime_error{"Failed to open file: " + filepath};
+            }
 
-    App::App()
+            file << "P6\n" << width << " " << height << "\n255\n";
+            for (size_t i = 0; i < rgba.size(); i += 4)
+            {
+                file.write(reinterpret_cast<const char *>(&rgba[i]), 3);
+            }
+        }
+    }
+
+    App::App(bool headless) : genWindow{WIDTH, HEIGHT, "Vulkan window", headless}
     {
-        globalPool =
-            GenDescriptorPool::Builder(genDevice)
-                .setMaxSets(GenSwapChain::MAX_FRAMES_IN_FLIGHT)
-                .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, GenSwapChain::MAX_FRAMES_IN_FLIGHT)
-                .build();
+        // the global sets are the first pool's, it grows if more long lived sets are added
+        globalDescriptorAllocator = std::make_unique<GenDescriptorAllocator>(
+            genDevice,
+            GenSwapChain::MAX_FRAMES_IN_FLIGHT,
+            std::vector<GenDescriptorAllocator::PoolSizeRatio>{
+                {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.f},
+                {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3.f}});
+        modelResidency = std::make_unique<GenModelResidency>(genDevice);
+        assetManager = std::make_unique<GenAssetManager>(*modelResidency, jobSystem);
+        textureStreamer = std::make_unique<GenTextureStreamer>(genDevice, genRenderer.getSamplerCache(), jobSystem);
         loadGameObjects();
     }
 
@@ -36,116 +337,979 @@ namespace gen
     void App::run()
     {
 
-        std::vector<std::unique_ptr<GenBuffer>> uboBuffers(GenSwapChain::MAX_FRAMES_IN_FLIGHT);
-        for (int i = 0; i < uboBuffers.size(); i++)
-        {
-            uboBuffers[i] = std::make_unique<GenBuffer>(
-                genDevice,
-                sizeof(GlobalUbo),
-                1,
-                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-            uboBuffers[i]->map();
-        }
-
+        // binding 0: the GlobalUbo, written to the frame allocator every frame and bound with a dynamic offset.
+        // binding 1-3: lights, cluster table and light index list, see LightClusterSystem
         auto globalSetLayout =
             GenDescriptorSetLayout::Builder(genDevice)
-                .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+                .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT)
+                .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT)
+                .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT)
+                .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT)
                 .build();
 
+        LightClusterSystem lightClusterSystem{
+            genDevice,
+            globalSetLayout->getDescriptorSetLayout()};
+
         std::vector<VkDescriptorSet> globalDescriptorSets(GenSwapChain::MAX_FRAMES_IN_FLIGHT);
         for (int i = 0; i < globalDescriptorSets.size(); i++)
         {
-            auto bufferInfo = uboBuffers[i]->descriptorInfo();
-            GenDescriptorWriter(*globalSetLayout, *globalPool)
+            auto bufferInfo = genRenderer.getFrameAllocator().descriptorInfo(sizeof(GlobalUbo));
+            auto lightInfo = lightClusterSystem.lightBufferInfo(i);
+            auto clusterInfo = lightClusterSystem.clusterBufferInfo(i);
+            auto lightIndexInfo = lightClusterSystem.lightIndexBufferInfo(i);
+            GenDescriptorWriter(*globalSetLayout, *globalDescriptorAllocator)
                 .writeBuffer(0, &bufferInfo)
+                .writeBuffer(1, &lightInfo)
+                .writeBuffer(2, &clusterInfo)
+                .writeBuffer(3, &lightIndexInfo)
                 .build(globalDescriptorSets[i]);
         }
 
         SimpleRenderSystem simpleRenderSystem{
             genDevice,
             genRenderer.getSwapChainRenderPass(),
-            globalSetLayout->getDescriptorSetLayout()};
+            globalSetLayout->getDescriptorSetLayout(),
+            genRenderer.getSamplerCache(),
+            genRenderer.getFrameDescriptorAllocator(),
+            genRenderer.getBindlessDescriptors()};
 
         PointLightSystem pointLightSystem{
             genDevice,
             genRenderer.getSwapChainRenderPass(),
             globalSetLayout->getDescriptorSetLayout()};
 
-        GenCamera camera{};
+        // deferred path, same scene drawn through the g-buffer render pass
+        SimpleRenderSystem gBufferRenderSystem{
+            genDevice,
+            genRenderer.getDeferredRenderPass(),
+            globalSetLayout->getDescriptorSetLayout(),
+            genRenderer.getSamplerCache(),
+            genRenderer.getFrameDescriptorAllocator(),
+            genRenderer.getBindlessDescriptors(),
+            RenderPath::Deferred};
+
+        DeferredLightingSystem deferredLightingSystem{
+            genDevice,
+            genRenderer.getDeferredRenderPass(),
+            globalSetLayout->getDescriptorSetLayout()};
+
+        PointLightSystem deferredPointLightSystem{
+            genDevice,
+            genRenderer.getDeferredRenderPass(),
+            globalSetLayout->getDescriptorSetLayout(),
+            RenderPath::Deferred};
+
+        TransparentRenderSystem transparentRenderSystem{
+            genDevice,
+            genRenderer.getSwapChainRenderPass(),
+            globalSetLayout->getDescriptorSetLayout()};
+
+        TransparentRenderSystem deferredTransparentRenderSystem{
+            genDevice,
+            genRenderer.getDeferredRenderPass(),
+            globalSetLayout->getDescriptorSetLayout(),
+            RenderPath::Deferred};
+
+        UpscaleSystem upscaleSystem{
+            genDevice,
+            genRenderer.getUpscaleRenderPass(),
+            genRenderer.getSamplerCache()};
+
+        // the game thread's copy of the scene, indexed like the transforms in every snapshot. The render thread
+        // owns the objects themselves and copies each snapshot's transforms into them before recording
+        std::vector<GenGameObject *> sceneObjects{};
+        std::vector<TransformComponent> sceneTransforms{};
+        for (auto &kv : gameObjects)
+        {
+            sceneObjects.push_back(&kv.second);
+            sceneTransforms.push_back(kv.second.transform);
+        }
 
         auto viewerObject = GenGameObject::createGameObject();
         viewerObject.transform.translation.z = -2.5f;
         KeyboardMovementController cameraController{};
+        KeyToggle clusterModeToggle{GLFW_KEY_C};
+        KeyToggle renderPathToggle{GLFW_KEY_R};
+        KeyToggle depthPrePassToggle{GLFW_KEY_P};
+        KeyToggle transparencyToggle{GLFW_KEY_O};
+        KeyToggle parallelRecordingToggle{GLFW_KEY_T};
+        KeyToggle framesInFlightToggle{GLFW_KEY_F};
+        KeyToggle presentModeToggle{GLFW_KEY_V};
+        KeyToggle lowLatencyToggle{GLFW_KEY_L};
+        KeyToggle gpuStatsToggle{GLFW_KEY_G};
+        KeyToggle dynamicResolutionToggle{GLFW_KEY_X};
+        KeyToggle upscaleFilterToggle{GLFW_KEY_U};
+        RenderSettings settings{};
+        settings.dynamicResolution = dynamicResolutionEnabled;
+        FrameWaitReport frameWaitReport{};
 
-        auto currentTime = std::chrono::high_resolution_clock::now();
+        auto &parallelRecorder = genRenderer.getParallelRecorder();
+        RecordingBenchmark recordingBenchmark{};
+        if (recordingBenchmarkObjects > 0)
+        {
+            // 1, 2, 4, ... up to every core
+            for (uint32_t threads = 1; threads < parallelRecorder.getThreadCount(); threads *= 2)
+            {
+                recordingBenchmark.threadCounts.push_back(threads);
+            }
+            recordingBenchmark.threadCounts.push_back(parallelRecorder.getThreadCount());
+            parallelRecorder.setActiveThreadCount(recordingBenchmark.threadCounts[0]);
+        }
+
+        // fragment shader invocations of the opaque pass, to compare shading work with and without the depth pre-pass
+        GenPipelineStatistics fragmentStatistics{genDevice, VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT};
+        std::vector<uint64_t> statisticResults{};
+        std::vector<bool> queryUsedPrePass(GenSwapChain::MAX_FRAMES_IN_FLIGHT, false);
+        std::array<uint64_t, 2> fragmentInvocations{}; // indexed by whether the pre-pass was enabled
+        std::array<uint64_t, 2> fragmentFrames{};
+        if (!fragmentStatistics.isSupported())
+        {
+            std::cout << "Pipeline statistics queries not supported, fragment invocations won't be reported" << std::endl;
+        }
+
+        GenGpuProfiler gpuProfiler{genDevice};
+        uint32_t printedGpuStatsRequests = 0;
 
-        while (!genWindow.shouldClose())
+        // recent build times for the light clustering cost report, by mode and light count
+        std::map<std::pair<LightClusterSystem::Mode, uint32_t>, ClusterBuildWindow> clusterBuildMicros{};
+
+        // 64, 128, ... up to the lights in the scene
+        LightSweep lightSweep{};
+        if (lightSweepMaxLights > 0)
         {
-            glfwPollEvents();
+            for (uint32_t lights = 64; lights < lightSweepMaxLights; lights *= 2)
+            {
+                lightSweep.lightCounts.push_back(lights);
+            }
+            lightSweep.lightCounts.push_back(lightSweepMaxLights);
+        }
+
+        // benchmark state, the simulated time on the game thread and the samples on the render thread
+        float benchmarkTime = 0.f;
+        uint64_t benchmarkFrame = 0;
+        uint64_t lastGpuSamples = 0;
+        auto benchmarkFrameStart = std::chrono::high_resolution_clock::now();
+
+        GenTripleBuffer<FrameSnapshot> snapshots{};
+
+        // game thread: input, camera and animation for one frame, written into snapshot
+        auto currentTime = std::chrono::high_resolution_clock::now();
+        auto simulate = [&](FrameSnapshot &snapshot)
+        {
+            GEN_PROFILE_SCOPE("simulate");
+            GLFWwindow *window = genWindow.getGLFWWindow();
+            if (clusterModeToggle.pressed(window))
+            {
+                bool toCompute = settings.clusterMode == LightClusterSystem::Mode::CPU;
+                settings.clusterMode = toCompute ? LightClusterSystem::Mode::Compute : LightClusterSystem::Mode::CPU;
+                std::cout << "Light clustering: " << (toCompute ? "compute" : "cpu") << std::endl;
+            }
+            if (renderPathToggle.pressed(window))
+            {
+                bool toDeferred = settings.renderPath == RenderPath::Forward;
+                settings.renderPath = toDeferred ? RenderPath::Deferred : RenderPath::Forward;
+                std::cout << "Render path: " << (toDeferred ? "deferred" : "forward") << std::endl;
+            }
+            if (depthPrePassToggle.pressed(window))
+            {
+                settings.depthPrePass = !settings.depthPrePass;
+                std::cout << "Depth pre-pass: " << (settings.depthPrePass ? "on" : "off") << std::endl;
+            }
+            if (parallelRecordingToggle.pressed(window))
+            {
+                settings.parallelRecording = !settings.parallelRecording;
+                std::cout << "Opaque recording: "
+                          << (settings.parallelRecording ? std::to_string(parallelRecorder.getThreadCount()) + " threads" : "inline")
+                          << std::endl;
+            }
+            if (transparencyToggle.pressed(window))
+            {
+                settings.orderIndependentTransparency = !settings.orderIndependentTransparency;
+                std::cout << "Transparency: " << (settings.orderIndependentTransparency ? "weighted blended" : "sorted") << std::endl;
+            }
+            if (framesInFlightToggle.pressed(window))
+            {
+                settings.framesInFlight = settings.framesInFlight % GenSwapChain::MAX_FRAMES_IN_FLIGHT + 1;
+                std::cout << "Frames in flight: " << settings.framesInFlight << std::endl;
+            }
+            if (presentModeToggle.pressed(window))
+            {
+                // the swap chain reports if it has to fall back to FIFO
+                switch (settings.presentMode)
+                {
+                case VK_PRESENT_MODE_FIFO_KHR:
+                    settings.presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+                    break;
+                case VK_PRESENT_MODE_MAILBOX_KHR:
+                    settings.presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+                    break;
+                default:
+                    settings.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+                    break;
+                }
+            }
+            if (gpuStatsToggle.pressed(window))
+            {
+                settings.gpuStatsRequests++;
+            }
+            if (lowLatencyToggle.pressed(window))
+            {
+                settings.lowLatency = !settings.lowLatency;
+                std::cout << "Low latency frame pacing: " << (settings.lowLatency ? "on" : "off")
+                          << (pipelinedRendering ? " (no effect when pipelined)" : "") << std::endl;
+            }
+            if (dynamicResolutionToggle.pressed(window))
+            {
+                settings.dynamicResolution = !settings.dynamicResolution;
+                std::cout << "Dynamic resolution: "
+                          << (settings.dynamicResolution
+                                  ? "on, targeting " + std::to_string(dynamicResolution.getSettings().targetGpuMs) + " ms"
+                                  : "off")
+                          << std::endl;
+            }
+            if (upscaleFilterToggle.pressed(window))
+            {
+                bool toSharpened = settings.upscaleFilter == UpscaleSystem::Filter::Bilinear;
+                settings.upscaleFilter = toSharpened ? UpscaleSystem::Filter::Sharpened : UpscaleSystem::Filter::Bilinear;
+                std::cout << "Upscale filter: " << (toSharpened ? "sharpened" : "bilinear") << std::endl;
+            }
 
             auto newTime = std::chrono::high_resolution_clock::now();
             float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
             currentTime = newTime;
 
-            cameraController.moveInPlaneXZ(genWindow.getGLFWWindow(), frameTime, viewerObject);
-            camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
+            if (benchmark)
+            {
+                // fixed step and scripted camera, every run simulates exactly the same frames
+                frameTime = benchmark->getScene().timestep;
+                benchmarkTime += frameTime;
+                auto pose = benchmarkCameraPose(benchmark->getScene(), benchmarkTime);
+                viewerObject.transform.translation = pose.translation;
+                viewerObject.transform.rotation = pose.rotation;
+            }
+            else if (window != nullptr)
+            {
+                cameraController.moveInPlaneXZ(window, frameTime, viewerObject);
+            }
+            snapshot.camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
+
+            // circle the lights around the scene and pack them for upload
+            auto rotateLight = glm::rotate(glm::mat4(1.f), 0.5f * frameTime, {0.f, -1.f, 0.f});
+            snapshot.lights.clear();
+            for (size_t i = 0; i < sceneObjects.size(); i++)
+            {
+                // the component data never changes after loading, only the transforms are simulated
+                const auto *pointLight = sceneObjects[i]->pointLight.get();
+                if (pointLight == nullptr)
+                    continue;
+
+                auto &transform = sceneTransforms[i];
+                transform.translation = glm::vec3(rotateLight * glm::vec4(transform.translation, 1.f));
+
+                PointLight light{};
+                light.position = glm::vec4(transform.translation, pointLight->range);
+                light.color = glm::vec4(sceneObjects[i]->color, pointLight->lightIntensity);
+                snapshot.lights.push_back(light);
+            }
+
+            snapshot.frameTime = frameTime;
+            snapshot.transforms.assign(sceneTransforms.begin(), sceneTransforms.end());
+            snapshot.settings = settings;
+        };
+
+        // render thread: records and submits one snapshot, owns the renderer, the render systems and the objects
+        auto render = [&](FrameSnapshot &snapshot)
+        {
+            GEN_PROFILE_SCOPE("render");
+            const RenderSettings &frameSettings = snapshot.settings;
+            lightClusterSystem.setMode(frameSettings.clusterMode);
+            genRenderer.setRenderPath(frameSettings.renderPath);
+            simpleRenderSystem.setDepthPrePass(frameSettings.depthPrePass);
+            gBufferRenderSystem.setDepthPrePass(frameSettings.depthPrePass);
+            genRenderer.setFramesInFlight(frameSettings.framesInFlight);
+            genRenderer.setPresentMode(frameSettings.presentMode);
+            // the benchmark always records in parallel, stepping through the thread counts itself
+            bool parallelRecording = frameSettings.parallelRecording || !recordingBenchmark.done();
 
+            for (size_t i = 0; i < sceneObjects.size(); i++)
+            {
+                sceneObjects[i]->transform = snapshot.transforms[i];
+            }
+
+            // the scale picked from the frame times measured so far. The aspect ratio stays the swap chain's, the
+            // scaled scene is stretched back over the whole window
+            genRenderer.setRenderScale(frameSettings.dynamicResolution ? dynamicResolution.getScale() : 1.f);
+
+            // the swap chain extent is only known here
+            GenCamera &camera = snapshot.camera;
             float aspect = genRenderer.getAspectRatio();
             camera.setPerspectiveProjection(glm::radians(50.f), aspect, 0.1f, 1000.f);
 
-            if (auto commandBuffer = genRenderer.beginFrame())
+            auto commandBuffer = genRenderer.beginFrame();
+            if (commandBuffer == nullptr)
+            {
+                return;
+            }
+
+            int frameIndex = genRenderer.getFrameIndex();
+            FrameInfo frameInfo{
+                frameIndex,
+                snapshot.frameTime,
+                commandBuffer,
+                camera,
+                globalDescriptorSets[frameIndex],
+                gameObjects,
+                jobSystem};
+            // the sweep uploads only the first lights, the billboards of all of them are still drawn
+            if (!lightSweep.done() && snapshot.lights.size() > lightSweep.lightCount())
+            {
+                snapshot.lights.resize(lightSweep.lightCount());
+            }
+            const std::vector<PointLight> &pointLights = snapshot.lights;
+
+            // update
+            GlobalUbo ubo{};
+            ubo.projection = camera.getProjection();
+            ubo.view = camera.getView();
+            ubo.inverseView = camera.getInverseView();
+            // the scene is drawn to the top left renderExtent of its full size attachments
+            VkExtent2D extent = genRenderer.getSwapChainExtent();
+            VkExtent2D renderExtent = genRenderer.getRenderExtent();
+            ubo.screenSize = {static_cast<float>(renderExtent.width), static_cast<float>(renderExtent.height)};
+            // a new light buffer, nothing in flight reads this frame's global set anymore
+            if (lightClusterSystem.update(frameInfo, ubo, pointLights))
+            {
+                auto lightInfo = lightClusterSystem.lightBufferInfo(frameIndex);
+                GenDescriptorWriter(*globalSetLayout, *globalDescriptorAllocator)
+                    .writeBuffer(1, &lightInfo)
+                    .overwrite(globalDescriptorSets[frameIndex]);
+            }
+            frameInfo.globalUboOffset = genRenderer.getFrameAllocator().push(ubo).dynamicOffset;
+            frameInfo.extent = renderExtent;
+            // outside any render pass, evicted models and finished loads are uploaded by this frame's command buffer
+            assetManager->update(gameObjects);
+            modelResidency->update(commandBuffer, gameObjects, camera);
+            textureStreamer->update(commandBuffer);
+
+            const auto &clusterStats = lightClusterSystem.getStats();
+            clusterBuildMicros[{lightClusterSystem.getMode(), clusterStats.lightCount}].add(clusterStats.buildMicros);
+            if (!lightSweep.done() &&
+                lightSweep.addFrame(clusterStats.buildMicros, lightClusterSystem.getMode(), clusterStats.lightCount))
+            {
+                genWindow.requestClose();
+            }
+
+            // results of the last time this frame index was recorded, its fence has already been waited on
+            if (fragmentStatistics.collect(commandBuffer, frameIndex, statisticResults))
+            {
+                fragmentInvocations[queryUsedPrePass[frameIndex]] += statisticResults[0];
+                fragmentFrames[queryUsedPrePass[frameIndex]]++;
+            }
+            queryUsedPrePass[frameIndex] = simpleRenderSystem.isDepthPrePassEnabled();
+
+            gpuProfiler.collect(commandBuffer, frameIndex);
+            uint64_t gpuSamples = 0;
+            double gpuFrameMs = 0.0;
+            uint64_t upscaleSamples = 0;
+            double upscaleMs = 0.0;
+            // a new sample only arrives once the frame index comes around again
+            if (gpuProfiler.getLatestSample("frame", gpuSamples, gpuFrameMs) && gpuSamples != lastGpuSamples)
+            {
+                if (benchmark && benchmark->isMeasuring(benchmarkFrame))
+                {
+                    benchmark->addGpuFrame(gpuFrameMs);
+                }
+                // the new scale is used from the next frame on. The upscale always draws the full output, scaling the
+                // scene can't make it cheaper
+                if (frameSettings.dynamicResolution)
+                {
+                    bool upscaled = gpuProfiler.getLatestSample("UpscaleSystem", upscaleSamples, upscaleMs) &&
+                                    upscaleSamples == gpuSamples;
+                    dynamicResolution.addGpuFrameTime(gpuFrameMs, upscaled ? upscaleMs : 0.0);
+                }
+                lastGpuSamples = gpuSamples;
+            }
+            if (frameSettings.gpuStatsRequests != printedGpuStatsRequests)
+            {
+                gpuProfiler.printStats();
+                printedGpuStatsRequests = frameSettings.gpuStatsRequests;
+            }
+            uint32_t frameScope = gpuProfiler.beginScope(commandBuffer, frameIndex, "frame");
+
+            // the frame's graph: the compute light cluster build, the scene render pass and the upscale pass drawing
+            // the scene color onto the swap chain image. The scene color, depth and the render path's attachments
+            // are transient images of the graph, always allocated at the swap chain extent so a render scale change
+            // doesn't reallocate them
+            GenRenderGraph &renderGraph = genRenderer.getRenderGraph();
+            renderGraph.reset();
+            bool deferred = genRenderer.getRenderPath() == RenderPath::Deferred;
+            // the acquire semaphore is waited for before color attachment output
+            auto swapChainImage = renderGraph.importImage(
+                "swap chain image",
+                genRenderer.getSwapChainImage(),
+                genRenderer.getSwapChainImageView(),
+                VK_IMAGE_ASPECT_COLOR_BIT,
+                {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR, VK_ACCESS_2_NONE_KHR, VK_IMAGE_LAYOUT_UNDEFINED});
+            renderGraph.markOutput(swapChainImage);
+            auto clusters = renderGraph.importBuffer(
+                "light clusters", lightClusterSystem.clusterBufferInfo(frameIndex).buffer);
+            auto lightIndices = renderGraph.importBuffer(
+                "light indices", lightClusterSystem.lightIndexBufferInfo(frameIndex).buffer);
+
+            auto sceneColor = renderGraph.createImage(
+                "scene color",
+                {genRenderer.getSwapChainImageFormat(),
+                 extent,
+                 VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT});
+            VkImageUsageFlags attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                                                VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT |
+                                                VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+            auto depth = renderGraph.createImage(
+                "depth",
+                {genRenderer.getDepthFormat(),
+                 extent,
+                 VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
+                 VK_IMAGE_ASPECT_DEPTH_BIT});
+            // g-buffer albedo and normal on the deferred path, transparency accumulation and revealage on the forward path
+            auto pathTarget0 = renderGraph.createImage(
+                deferred ? "albedo" : "accumulation",
+                {deferred ? GenSwapChain::ALBEDO_FORMAT : GenSwapChain::ACCUM_FORMAT, extent, attachmentUsage});
+            auto pathTarget1 = renderGraph.createImage(
+                deferred ? "normal" : "revealage",
+                {deferred ? GenSwapChain::NORMAL_FORMAT : GenSwapChain::REVEALAGE_FORMAT, extent, attachmentUsage});
+
+            // read by the scene pass on both paths, the transparent geometry is lit through the clusters even
+            // when the opaque geometry is shaded deferred
+            if (lightClusterSystem.getMode() == LightClusterSystem::Mode::Compute)
+            {
+                renderGraph
+                    .addPass(
+                        "light clusters",
+                        [&](VkCommandBuffer)
+                        {
+                            GenGpuProfiler::Scope scope{gpuProfiler, commandBuffer, frameIndex, "LightClusterSystem"};
+                            lightClusterSystem.dispatch(frameInfo);
+                        })
+                    .write(clusters, GenRenderGraph::Access::ComputeStorageWrite)
+                    .write(lightIndices, GenRenderGraph::Access::ComputeStorageWrite);
+            }
+
+            // begins the render pass and records the opaque subpass, returns the cpu time spent recording.
+            // The timing scopes of the pass and its opaque subpass begin outside of the render pass, a subpass
+            // with secondary command buffers can't contain timestamps
+            uint32_t passScope = GenGpuProfiler::INVALID_SCOPE;
+            uint32_t opaqueScope = GenGpuProfiler::INVALID_SCOPE;
+            std::array<VkImageView, 4> sceneAttachments{};
+            auto renderOpaque = [&](SimpleRenderSystem &renderSystem, const char *passName)
             {
-                int frameIndex = genRenderer.getFrameIndex();
-                FrameInfo frameInfo{
-                    frameIndex,
-                    frameTime,
-                    commandBuffer,
-                    camera,
-                    globalDescriptorSets[frameIndex],
-                    gameObjects};
+                passScope = gpuProfiler.beginScope(commandBuffer, frameIndex, passName);
+                opaqueScope = gpuProfiler.beginScope(commandBuffer, frameIndex, "SimpleRenderSystem");
+                auto recordStart = std::chrono::high_resolution_clock::now();
+                if (parallelRecording)
+                {
+                    // secondary command buffers can't inherit the statistics query, so it's skipped here
+                    genRenderer.beginSwapChainRenderPass(
+                        commandBuffer, sceneAttachments, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                    renderSystem.renderGameObjectsParallel(
+                        frameInfo,
+                        parallelRecorder,
+                        genRenderer.getInheritanceInfo(),
+                        renderExtent);
+                }
+                else
+                {
+                    genRenderer.beginSwapChainRenderPass(commandBuffer, sceneAttachments);
+                    fragmentStatistics.begin(commandBuffer, frameIndex);
+                    renderSystem.renderGameObjects(frameInfo);
+                    fragmentStatistics.end(commandBuffer, frameIndex);
+                }
+                return std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - recordStart).count();
+            };
+
+            // render
+            double opaqueRecordMicros = 0.0;
+            auto scene = renderGraph.addPass(
+                "scene",
+                [&](VkCommandBuffer)
+                {
+                    sceneAttachments = {
+                        renderGraph.getImageView(sceneColor),
+                        renderGraph.getImageView(depth),
+                        renderGraph.getImageView(pathTarget0),
+                        renderGraph.getImageView(pathTarget1)};
+                    if (deferred)
+                    {
+                        opaqueRecordMicros = renderOpaque(gBufferRenderSystem, "deferred pass");
+                        genRenderer.nextSubpass(commandBuffer);
+                        gpuProfiler.endScope(commandBuffer, frameIndex, opaqueScope);
+                        {
+                            GenGpuProfiler::Scope scope{gpuProfiler, commandBuffer, frameIndex, "DeferredLightingSystem"};
+                            deferredLightingSystem.render(
+                                frameInfo,
+                                GBufferViews{sceneAttachments[2], sceneAttachments[3], sceneAttachments[1]},
+                                static_cast<uint32_t>(pointLights.size()));
+                        }
+                        genRenderer.nextSubpass(commandBuffer);
+                        {
+                            GenGpuProfiler::Scope scope{gpuProfiler, commandBuffer, frameIndex, "TransparentRenderSystem"};
+                            deferredTransparentRenderSystem.renderSorted(frameInfo);
+                        }
+                        {
+                            GenGpuProfiler::Scope scope{gpuProfiler, commandBuffer, frameIndex, "PointLightSystem"};
+                            deferredPointLightSystem.render(frameInfo);
+                        }
+                    }
+                    else
+                    {
+                        opaqueRecordMicros = renderOpaque(simpleRenderSystem, "forward pass");
+
+                        // transparent geometry accumulates in any order, then is resolved over the opaque image
+                        genRenderer.nextSubpass(commandBuffer);
+                        gpuProfiler.endScope(commandBuffer, frameIndex, opaqueScope);
+                        if (frameSettings.orderIndependentTransparency)
+                        {
+                            {
+                                GenGpuProfiler::Scope scope{gpuProfiler, commandBuffer, frameIndex, "TransparentRenderSystem"};
+                                transparentRenderSystem.renderAccumulation(frameInfo);
+                            }
+                            GenGpuProfiler::Scope scope{gpuProfiler, commandBuffer, frameIndex, "PointLightSystem"};
+                            pointLightSystem.renderAccumulation(frameInfo);
+                        }
+                        genRenderer.nextSubpass(commandBuffer);
+                        if (frameSettings.orderIndependentTransparency)
+                        {
+                            GenGpuProfiler::Scope scope{gpuProfiler, commandBuffer, frameIndex, "transparency resolve"};
+                            transparentRenderSystem.resolve(frameInfo, OitViews{sceneAttachments[2], sceneAttachments[3]});
+                        }
+                        else
+                        {
+                            {
+                                GenGpuProfiler::Scope scope{gpuProfiler, commandBuffer, frameIndex, "TransparentRenderSystem"};
+                                transparentRenderSystem.renderSorted(frameInfo);
+                            }
+                            GenGpuProfiler::Scope scope{gpuProfiler, commandBuffer, frameIndex, "PointLightSystem"};
+                            pointLightSystem.render(frameInfo);
+                        }
+                    }
+
+                    genRenderer.endSwapChainRenderPass(commandBuffer);
+                    gpuProfiler.endScope(commandBuffer, frameIndex, passScope);
+                });
+            // the render pass transitions its attachments itself
+            scene.attachment(sceneColor, GenRenderGraph::Access::ColorAttachment, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+                .attachment(depth, GenRenderGraph::Access::DepthAttachment, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
+                .attachment(pathTarget0, GenRenderGraph::Access::ColorAttachment, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+                .attachment(pathTarget1, GenRenderGraph::Access::ColorAttachment, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+                .read(clusters, GenRenderGraph::Access::FragmentStorageRead)
+                .read(lightIndices, GenRenderGraph::Access::FragmentStorageRead);
 
-                // update
-                GlobalUbo ubo{};
-                ubo.projection = camera.getProjection();
-                ubo.view = camera.getView();
-                ubo.inverseView = camera.getInverseView();
-                pointLightSystem.update(frameInfo, ubo);
-                uboBuffers[frameIndex]->writeToBuffer(&ubo);
-                uboBuffers[frameIndex]->flush();
+            // a plain copy while the scene is rendered at full resolution
+            renderGraph
+                .addPass(
+                    "upscale",
+                    [&](VkCommandBuffer)
+                    {
+                        GenGpuProfiler::Scope scope{gpuProfiler, commandBuffer, frameIndex, "UpscaleSystem"};
+                        genRenderer.beginUpscaleRenderPass(commandBuffer);
+                        upscaleSystem.render(
+                            frameInfo,
+                            renderGraph.getImageView(sceneColor),
+                            renderExtent,
+                            extent,
+                            frameSettings.upscaleFilter);
+                        genRenderer.endSwapChainRenderPass(commandBuffer);
+                    })
+                .read(sceneColor, GenRenderGraph::Access::FragmentSampled)
+                .attachment(swapChainImage, GenRenderGraph::Access::ColorAttachment, genRenderer.getFinalColorLayout());
 
-                // render
-                genRenderer.beginSwapChainRenderPass(commandBuffer);
+            renderGraph.compile();
+            renderGraph.execute(commandBuffer, frameIndex);
+            gpuProfiler.endScope(commandBuffer, frameIndex, frameScope);
+            genRenderer.endFrame();
 
-                //order here matters, first solid, then semi-transparent
-                simpleRenderSystem.renderGameObjects(frameInfo);
-                pointLightSystem.render(frameInfo);
+            // report each pacing setup once it's changed
+            if (!frameWaitReport.settings.samePacing(frameSettings))
+            {
+                frameWaitReport.print();
+                frameWaitReport = {};
+                frameWaitReport.settings = frameSettings;
+            }
+            frameWaitReport.presentMode = genRenderer.getPresentMode();
+            frameWaitReport.add(genRenderer.getLastFrameWaitTimes());
 
-                genRenderer.endSwapChainRenderPass(commandBuffer);
-                genRenderer.endFrame();
+            if (benchmark)
+            {
+                // the frame time is the interval between frame ends, so it includes the waits for the gpu
+                auto frameEnd = std::chrono::high_resolution_clock::now();
+                if (benchmark->isMeasuring(benchmarkFrame))
+                {
+                    BenchmarkFrame sample{};
+                    sample.cpuFrameMs = std::chrono::duration<double, std::milli>(frameEnd - benchmarkFrameStart).count();
+                    sample.deviceMemoryMb = genDevice.getAllocatedMemory() / (1024.0 * 1024.0);
+                    sample.drawCalls = frameInfo.drawCalls;
+                    benchmark->addFrame(sample);
+                }
+                benchmarkFrameStart = frameEnd;
+                benchmarkFrame++;
             }
+
+            if (!recordingBenchmark.done())
+            {
+                if (recordingBenchmark.addFrame(opaqueRecordMicros, recordingBenchmarkObjects))
+                {
+                    genWindow.requestClose();
+                }
+                else
+                {
+                    parallelRecorder.setActiveThreadCount(recordingBenchmark.threadCounts[recordingBenchmark.step]);
+                }
+            }
+        };
+
+        SnapshotPacer pacer{};
+        std::thread renderThread{};
+        std::exception_ptr renderError{};
+        if (pipelinedRendering)
+        {
+            renderThread = std::thread(
+                [&]
+                {
+                    GenCpuProfiler::setThreadName("render");
+                    try
+                    {
+                        while (pacer.waitForSnapshot())
+                        {
+                            snapshots.acquire();
+                            render(snapshots.readSlot());
+                        }
+                    }
+                    catch (...)
+                    {
+                        renderError = std::current_exception();
+                        pacer.close();
+                    }
+                });
+        }
+
+        // a headless run has no window to close
+        uint64_t maxFrames = frameLimit;
+        if (benchmark)
+        {
+            maxFrames = benchmark->getFrameCount();
+        }
+        else if (genWindow.isHeadless() && maxFrames == 0)
+        {
+            maxFrames = DEFAULT_HEADLESS_FRAMES;
+        }
+        if (!captureFilePath.empty() && genRenderer.isHeadless())
+        {
+            genRenderer.setFrameReadback(true);
+        }
+
+        uint64_t frameCount = 0;
+        auto runStart = std::chrono::high_resolution_clock::now();
+        while (!genWindow.shouldClose() && (maxFrames == 0 || frameCount < maxFrames))
+        {
+            // in serial mode the wait for the frame slot can happen before input is read instead of in
+            // beginFrame, so the frame is presented with the freshest input
+            if (settings.lowLatency && !pipelinedRendering)
+            {
+                genRenderer.waitForNextFrame();
+            }
+
+            // GLFW only allows event processing on the main thread, which is also the game thread
+            genWindow.pollEvents();
+
+            simulate(snapshots.writeSlot());
+            snapshots.publish();
+            frameCount++;
+
+            if (!pipelinedRendering)
+            {
+                snapshots.acquire();
+                render(snapshots.readSlot());
+                continue;
+            }
+
+            // the next frame is simulated while the render thread records this one, keep events flowing
+            // while waiting since the render thread may be waiting on a resize
+            pacer.publish();
+            GEN_PROFILE_SCOPE("wait for render thread");
+            while (!pacer.waitUntilConsumed(std::chrono::milliseconds(10)))
+            {
+                genWindow.pollEvents();
+            }
+            if (pacer.isClosed())
+            {
+                break;
+            }
+        }
+        double runSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - runStart).count();
+
+        if (renderThread.joinable())
+        {
+            pacer.close();
+            renderThread.join();
         }
 
         vkDeviceWaitIdle(genDevice.device()); // cpu will block till all gpu operations are finished
+
+        if (renderError)
+        {
+            std::rethrow_exception(renderError);
+        }
+
+        if (!captureFilePath.empty())
+        {
+            std::vector<uint8_t> pixels;
+            if (genRenderer.isHeadless() && genRenderer.readLastFrame(pixels))
+            {
+                VkExtent2D extent = genRenderer.getSwapChainExtent();
+                writePpm(captureFilePath, extent.width, extent.height, pixels);
+                std::cout << "Captured last frame to " << captureFilePath << std::endl;
+            }
+            else
+            {
+                std::cout << "Frame capture needs --headless" << std::endl;
+            }
+        }
+
+        frameWaitReport.print();
+        gpuProfiler.printStats();
+        if (!gpuProfileCsvPath.empty())
+        {
+            gpuProfiler.writeCsv(gpuProfileCsvPath);
+        }
+        auto printDescriptorStats = [](const char *name, const GenDescriptorAllocator::Stats &stats)
+        {
+            std::cout << name << " descriptor sets: " << stats.allocations << " allocated from " << stats.poolCount
+                      << " pool(s), " << stats.growths << " growth(s), " << stats.resets << " reset(s)" << std::endl;
+        };
+        printDescriptorStats("Global", globalDescriptorAllocator->getStats());
+        printDescriptorStats("Per frame", genRenderer.getFrameDescriptorAllocator().getStats());
+        const auto textureStats = GenTexture::getStats();
+        std::cout << "Textures: " << textureStats.textureCount << " using "
+                  << textureStats.memoryBytes / (1024.0 * 1024.0) << " MB with "
+                  << genRenderer.getSamplerCache().getSamplerCount() << " sampler(s), uploads at "
+                  << textureStats.uploadMegabytesPerSecond() << " MB/s" << std::endl;
+        const auto assetStats = assetManager->getStats();
+        std::cout << "Assets: " << assetStats.modelCount << " model(s) for " << assetStats.requests << " request(s), "
+                  << assetStats.pathHits << " path hit(s), " << assetStats.contentHits << " content hit(s), "
+                  << assetStats.failures << " failure(s), " << assetStats.averageLoadMs << " ms average load" << std::endl;
+        const auto residencyStats = modelResidency->getStats();
+        std::cout << "Model residency: " << residencyStats.residentCount << "/" << residencyStats.modelCount
+                  << " models using " << residencyStats.residentBytes / (1024.0 * 1024.0) << " of "
+                  << residencyStats.budgetBytes / (1024.0 * 1024.0) << " MB, " << residencyStats.evictions
+                  << " eviction(s), " << residencyStats.reuploads << " re-upload(s) of "
+                  << residencyStats.reuploadedBytes / (1024.0 * 1024.0) << " MB" << std::endl;
+        std::cout << "Device local memory (" << (residencyStats.memoryBudgetExtension ? "VK_EXT_memory_budget" : "engine allocations")
+                  << "): " << residencyStats.heapUsage / (1024.0 * 1024.0) << " of "
+                  << residencyStats.heapBudget / (1024.0 * 1024.0) << " MB budget" << std::endl;
+        std::cout << "Deferred deletions: " << genDevice.getDeferredDeletionCount() << " queued, "
+                  << genDevice.getPendingDeletionCount() << " still pending" << std::endl;
+        const auto &graphStats = genRenderer.getRenderGraph().getStats();
+        std::cout << "Render graph: " << graphStats.compiles << " compile(s) averaging "
+                  << (graphStats.compiles > 0 ? graphStats.totalCompileMicros / graphStats.compiles : 0.0) << " us, "
+                  << graphStats.cacheHits << " cache hit(s), " << graphStats.culledPasses << " culled and "
+                  << graphStats.barrierCount << " barrier(s) in the last frame ("
+                  << (genDevice.supportsSynchronization2() ? "VK_KHR_synchronization2" : "legacy barriers") << "), "
+                  << graphStats.transientBytes / (1024.0 * 1024.0) << " MB of transient images placed in "
+                  << graphStats.peakBytes / (1024.0 * 1024.0) << " MB in the last frame" << std::endl;
+        // every transient of the frame's graph is an attachment of the scene pass, so their lifetimes overlap and
+        // placing them saves nothing within a graph. The saving is in the graphs of the other render paths and
+        // light cluster modes sharing the heaps
+        std::cout << "Render graph heaps: " << graphStats.heapBytes / (1024.0 * 1024.0) << " MB shared by "
+                  << graphStats.cachedGraphs << " cached graph(s) whose transients peak at "
+                  << graphStats.cachedPeakBytes / (1024.0 * 1024.0) << " MB apart" << std::endl;
+        const auto &resolutionStats = dynamicResolution.getStats();
+        if (resolutionStats.samples > 0)
+        {
+            std::cout << "Dynamic resolution: " << resolutionStats.averageScale() * 100.0 << "% average and "
+                      << resolutionStats.lowestScale * 100.f << "% lowest scale over " << resolutionStats.samples
+                      << " gpu frame(s), " << resolutionStats.adjustments << " adjustment(s) targeting "
+                      << dynamicResolution.getSettings().targetGpuMs << " ms" << std::endl;
+        }
+        const auto streamStats = textureStreamer->getStats();
+        if (streamStats.textureCount > 0)
+        {
+            std::cout << "Texture streaming: " << streamStats.detailCount << "/" << streamStats.textureCount
+                      << " textures with detail mips using " << streamStats.detailBytes / (1024.0 * 1024.0) << " of "
+                      << streamStats.budgetBytes / (1024.0 * 1024.0) << " MB, " << streamStats.loads << " load(s) at "
+                      << streamStats.averageLoadMs << " ms, " << streamStats.evictions << " eviction(s), "
+                      << streamStats.rejections << " rejection(s)" << std::endl;
+        }
+        if (frameCount > 0)
+        {
+            std::cout << "Frames (" << (pipelinedRendering ? "pipelined" : "serial") << "): "
+                      << 1000.0 * runSeconds / frameCount << " ms/frame over " << frameCount << " frames" << std::endl;
+        }
+
+        for (const auto &kv : clusterBuildMicros)
+        {
+            bool cpu = kv.first.first == LightClusterSystem::Mode::CPU;
+            uint32_t lightCount = kv.first.second;
+            const ClusterBuildWindow &window = kv.second;
+            float median = window.median();
+            std::cout << "Light clustering (" << (cpu ? "cpu" : "compute") << "): " << lightCount << " lights, "
+                      << median << " us/frame median over the last " << window.samples.size() << " of "
+                      << window.frames << " frames, " << (lightCount > 0 ? 1000.0 * median / lightCount : 0.0)
+                      << " ns/light" << std::endl;
+        }
+
+        for (int prePass = 0; prePass < 2; prePass++)
+        {
+            if (fragmentFrames[prePass] > 0)
+            {
+                std::cout << "Fragment shader invocations with depth pre-pass " << (prePass ? "on" : "off") << ": "
+                          << fragmentInvocations[prePass] / fragmentFrames[prePass] << "/frame over "
+                          << fragmentFrames[prePass] << " frames" << std::endl;
+            }
+        }
     }
 
-    void App::loadGameObjects()
+    void App::enableRecordingBenchmark(uint32_t objectCount)
+    {
+        recordingBenchmarkObjects = objectCount;
+
+        // a grid of small quads, cheap on the gpu so recording dominates the frame
+        std::shared_ptr<GenModel> quadModel = assetManager->loadModel("models/quad.obj");
+        uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(objectCount))));
+        for (uint32_t i = 0; i < objectCount; i++)
+        {
+            auto quad = GenGameObject::createGameObject();
+            quad.model = quadModel;
+            quad.transform.translation = {
+                -2.f + 4.f * (i % side) / side,
+                .5f,
+                -2.f + 4.f * (i / side) / side};
+            quad.transform.scale = glm::vec3{2.f / side};
+            gameObjects.emplace(quad.getId(), std::move(quad));
+        }
+    }
+
+    void App::enableLightSweep(uint32_t maxLightCount)
     {
-        std::shared_ptr<GenModel> genModel = GenModel::createModelFromFile(genDevice, "models/armadillo.obj");
+        lightSweepMaxLights = maxLightCount;
+
+        uint32_t lightCount = 0;
+        for (const auto &kv : gameObjects)
+        {
+            lightCount += kv.second.pointLight != nullptr ? 1 : 0;
+        }
+
+        // a dim ring of lights above the scene, the same every run
+        BenchmarkRandom random{1};
+        for (uint32_t i = lightCount; i < maxLightCount; i++)
+        {
+            glm::vec3 color{random.uniform(.1f, 1.f), random.uniform(.1f, 1.f), random.uniform(.1f, 1.f)};
+            auto pointLight = GenGameObject::makePointLight(0.05f, 0.05f, color, 1.f);
+            float angle = random.uniform(0.f, glm::two_pi<float>());
+            float radius = random.uniform(.5f, 2.f);
+            pointLight.transform.translation = {radius * std::cos(angle), random.uniform(-1.f, -.2f), radius * std::sin(angle)};
+            gameObjects.emplace(pointLight.getId(), std::move(pointLight));
+        }
+    }
+
+    void App::enableDynamicResolution(double targetGpuMs)
+    {
+        if (targetGpuMs <= 0.0)
+        {
+            throw std::runtime_error("dynamic resolution target must be positive!");
+        }
+        auto resolutionSettings = dynamicResolution.getSettings();
+        resolutionSettings.targetGpuMs = targetGpuMs;
+        dynamicResolution.setSettings(resolutionSettings);
+        dynamicResolutionEnabled = true;
+    }
+
+    void App::enableBenchmark(const BenchmarkScene &scene)
+    {
+        benchmark = std::make_unique<GenBenchmark>(scene);
+        benchmark->setDeviceName(genDevice.properties.deviceName);
+        gameObjects.clear();
+
+        // every model gets its own buffers, unlike through the asset manager loading the same file twice doesn't
+        // share them
+        const char *modelFiles[] = {"models/armadillo.obj", "models/quad.obj"};
+        std::vector<std::shared_ptr<GenModel>> models;
+        for (uint32_t i = 0; i < std::max(scene.modelCount, 1u); i++)
+        {
+            models.push_back(modelResidency->createModelFromFile(modelFiles[i % std::size(modelFiles)]));
+        }
 
+        BenchmarkRandom random{scene.seed};
+        float extent = scene.extent();
+        for (uint32_t i = 0; i < scene.objectCount; i++)
+        {
+            auto object = GenGameObject::createGameObject();
+            object.model = models[i % models.size()];
+            object.transform.translation = {random.uniform(-extent, extent), 0.f, random.uniform(-extent, extent)};
+            object.transform.rotation = {0.f, random.uniform(0.f, glm::two_pi<float>()), 0.f};
+            float scale = random.uniform(.1f, .3f);
+            object.transform.scale = {scale, -scale, scale};
+            gameObjects.emplace(object.getId(), std::move(object));
+        }
+
+        auto floor = GenGameObject::createGameObject();
+        floor.model = assetManager->loadModel("models/quad.obj");
+        floor.transform.translation = {0.f, .5f, 0.f};
+        floor.transform.scale = {extent + 1.f, 1.f, extent + 1.f};
+        gameObjects.emplace(floor.getId(), std::move(floor));
+
+        for (uint32_t i = 0; i < scene.lightCount; i++)
+        {
+            glm::vec3 color{random.uniform(.1f, 1.f), random.uniform(.1f, 1.f), random.uniform(.1f, 1.f)};
+            auto pointLight = GenGameObject::makePointLight(0.2f, 0.1f, color, 2.f);
+            pointLight.transform.translation = {
+                random.uniform(-extent, extent),
+                random.uniform(-1.f, -.2f),
+                random.uniform(-extent, extent)};
+            gameObjects.emplace(pointLight.getId(), std::move(pointLight));
+        }
+    }
+
+    void App::loadGameObjects()
+    {
         auto armadillo = GenGameObject::createGameObject();
-        armadillo.model = genModel;
+        // loaded in the background, the objects are drawn from the first update after their model is ready
+        armadillo.modelHandle = assetManager->loadModelAsync("models/armadillo.obj");
         armadillo.transform.translation = {0.f, 0.f, 0.f};
         armadillo.transform.scale = {0.3f, -0.3f, 0.3f};
+        // stored with its mip chain, nothing is blitted at load
+        armadillo.texture = GenTexture::createTextureFromFile(genDevice, genRenderer.getSamplerCache(), "textures/marble.ktx2");
         gameObjects.emplace(armadillo.getId(), std::move(armadillo));
 
-        genModel = GenModel::createModelFromFile(genDevice, "models/quad.obj");
         auto floor = GenGameObject::createGameObject();
-        floor.model = genModel;
+        floor.modelHandle = assetManager->loadModelAsync("models/quad.obj");
         floor.transform.translation = {0.f, .5f, 0.f};
         floor.transform.scale = {3.f, 1.f, 3.f};
+        floor.texture = GenTexture::createTextureFromFile(genDevice, genRenderer.getSamplerCache(), "textures/checker.png");
         gameObjects.emplace(floor.getId(), std::move(floor));
 
+        // a wall behind the armadillo, close enough that its finest mips are streamed in after the first frames
+        auto wall = GenGameObject::createGameObject();
+        wall.modelHandle = assetManager->loadModelAsync("models/quad.obj");
+        wall.transform.translation = {0.f, -.5f, 1.5f};
+        wall.transform.rotation = {glm::half_pi<float>(), 0.f, 0.f};
+        wall.transform.scale = {2.f, 1.f, 1.f};
+        wall.streamedTexture = textureStreamer->load("textures/bricks.png");
+        gameObjects.emplace(wall.getId(), std::move(wall));
+
+        // overlapping glass panes around the armadillo
+        for (int i = 0; i < 3; i++)
+        {
+            auto pane = GenGameObject::createGameObject();
+            // the same file as the floor, the asset manager hands out its handle again
+            pane.modelHandle = assetManager->loadModelAsync("models/quad.obj");
+            pane.transform.translation = {-.6f + .6f * i, -.2f, -.4f + .3f * i};
+            pane.transform.rotation = {glm::half_pi<float>(), .3f * (i - 1), 0.f};
+            pane.transform.scale = {.4f, 1.f, .4f};
+            pane.transparency = std::make_unique<TransparencyComponent>();
+            pane.transparency->alpha = .4f;
+            gameObjects.emplace(pane.getId(), std::move(pane));
+        }
+
         std::vector<glm::vec3> lightColors{
             {1.f, .1f, .1f},
             {.1f, .1f, 1.f},
@@ -157,7 +1321,7 @@ namespace gen
 
         for (int i = 0; i < lightColors.size(); i++)
         {
-            auto pointLight = GenGameObject::makePointLight(0.2f);
+            auto pointLight = GenGameObject::makePointLight(0.2f, 0.1f, glm::vec3(1.f), 4.f);
             pointLight.color = lightColors[i];
             auto rotateLight = glm::rotate(glm::mat4(1.f), (i * glm::two_pi<float>()) / lightColors.size(), {0.1, -1.f, 0.f});
             pointLight.transform.translation = glm::vec3(rotateLight * glm::vec4(-1.f, -1.f, -1.f, 1.f));
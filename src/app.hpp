@@ -1,13 +1,20 @@
 #pragma once
 
+#include "gen_benchmark.hpp"
 #include "gen_device.hpp"
 #include "gen_game_object.hpp"
+#include "gen_job_system.hpp"
 #include "gen_window.hpp"
 #include "gen_renderer.hpp"
 #include "gen_descriptors.hpp"
+#include "gen_dynamic_resolution.hpp"
+#include "gen_asset_manager.hpp"
+#include "gen_model_residency.hpp"
+#include "gen_texture_streamer.hpp"
 
 // std
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace gen
@@ -18,24 +25,65 @@ namespace gen
     public:
         static constexpr int WIDTH = 800;
         static constexpr int HEIGHT = 600;
+        // frames rendered by a headless run without a frame limit
+        static constexpr uint32_t DEFAULT_HEADLESS_FRAMES = 1000;
 
-        App();
+        // headless renders offscreen without a window, for machines without a display
+        explicit App(bool headless = false);
         ~App();
 
         App(const App &) = delete;
         App &operator=(const App &) = delete;
 
         void run();
+        // adds objectCount objects and makes run() time the opaque pass recording from one thread up to
+        // all cores, then exit
+        void enableRecordingBenchmark(uint32_t objectCount = 100000);
+        // run() simulates on the main thread while a render thread records and submits the previous frame
+        void enablePipelinedRendering() { pipelinedRendering = true; }
+        // adds lights up to maxLightCount, then run() uploads 64, 128, ... maxLightCount of them for a fixed number of
+        // frames each, reports the light clustering cost of every count and exits
+        void enableLightSweep(uint32_t maxLightCount = 4096);
+        // writes the gpu timing statistics to filepath as csv when run() returns
+        void setGpuProfileCsv(const std::string &filepath) { gpuProfileCsvPath = filepath; }
+        // run() returns after frameCount frames, 0 runs until the window is closed
+        void setFrameLimit(uint32_t frameCount) { frameLimit = frameCount; }
+        // headless only: writes the last frame to filepath as binary PPM when run() returns
+        void setCaptureFile(const std::string &filepath) { captureFilePath = filepath; }
+        // replaces the scene with one generated from scene, then run() steps it with a fixed timestep along a
+        // scripted camera path for the scene's frame count and collects the samples
+        void enableBenchmark(const BenchmarkScene &scene);
+        // renders the scene at a resolution scaled to keep the gpu frame time at targetGpuMs and upscales it to the
+        // window, can also be toggled at runtime
+        void enableDynamicResolution(double targetGpuMs);
+        // nullptr unless enableBenchmark was called
+        const GenBenchmark *getBenchmark() const { return benchmark.get(); }
 
     private:
         void loadGameObjects();
 
-        GenWindow genWindow{WIDTH, HEIGHT, "Vulkan window"};
+        GenWindow genWindow;
         GenDevice genDevice{genWindow};
-        GenRenderer genRenderer{genWindow, genDevice};
+        // shared by everything that runs work in parallel, outlives the renderer that records on it
+        GenJobSystem jobSystem{};
+        GenRenderer genRenderer{genWindow, genDevice, jobSystem};
 
         // order matters (pool should be destroyed before the devices)
-        std::unique_ptr<GenDescriptorPool> globalPool{};
+        std::unique_ptr<GenDescriptorAllocator> globalDescriptorAllocator{};
+        // outlive the objects holding their models and textures
+        std::unique_ptr<GenModelResidency> modelResidency{};
+        std::unique_ptr<GenAssetManager> assetManager{};
+        std::unique_ptr<GenTextureStreamer> textureStreamer{};
         GenGameObject::Map gameObjects;
+        uint32_t recordingBenchmarkObjects = 0;
+        uint32_t lightSweepMaxLights = 0;
+        bool pipelinedRendering = false;
+        std::string gpuProfileCsvPath{};
+        uint32_t frameLimit = 0;
+        std::string captureFilePath{};
+        std::unique_ptr<GenBenchmark> benchmark{};
+        // driven by the render thread from the gpu frame times
+        GenDynamicResolution dynamicResolution{};
+        bool dynamicResolutionEnabled = false;
     };
 }
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace gen
+{
+    class GenAssetManager;
+
+    // Result of an asynchronous load by GenAssetManager, shared by everyone who requested the same asset. get
+    // returns nullptr until the asset is ready, so holders simply skip it until then.
+    template <typename T>
+    class GenAssetHandle
+    {
+    public:
+        enum class State
+        {
+            Loading,
+            Ready,
+            Failed
+        };
+
+        GenAssetHandle(const GenAssetHandle &) = delete;
+        GenAssetHandle &operator=(const GenAssetHandle &) = delete;
+
+        State getState() const { return state.load(std::memory_order_acquire); }
+        bool isReady() const { return getState() == State::Ready; }
+        bool hasFailed() const { return getState() == State::Failed; }
+
+        std::shared_ptr<T> get() const { return isReady() ? asset : nullptr; }
+        // canonical path of the file
+        const std::string &getPath() const { return path; }
+
+    private:
+        friend class GenAssetManager;
+
+        explicit GenAssetHandle(std::string path) : path{std::move(path)} {}
+
+        // written once before the state is published
+        std::shared_ptr<T> asset{};
+        std::string path;
+        std::atomic<State> state{State::Loading};
+    };
+}
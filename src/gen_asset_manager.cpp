@@ -0,0 +1,388 @@
+#include "gen_asset_manager.hpp"
+#include "gen_cpu_profiler.hpp"
+
+// std
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+#ifndef ENGINE_DIR
+#define ENGINE_DIR "../"
+#endif
+
+namespace gen
+{
+    namespace
+    {
+        // FNV-1a, only has to tell files apart, not resist collisions on purpose
+        uint64_t hashContents(const std::vector<char> &contents)
+        {
+            uint64_t hash = 14695981039346656037ull;
+            for (char c : contents)
+            {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+    }
+
+    GenAssetManager::GenAssetManager(GenModelResidency &modelResidency, GenJobSystem &jobSystem)
+        : modelResidency{modelResidency}, jobSystem{jobSystem}
+    {
+        loaderThread = std::thread{&GenAssetManager::loaderLoop, this};
+    }
+
+    GenAssetManager::~GenAssetManager()
+    {
+        {
+            std::lock_guard<std::mutex> lock{queueMutex};
+            stopping = true;
+        }
+        queueCondition.notify_all();
+        loaderThread.join();
+        jobSystem.wait(parseJobs);
+    }
+
+    std::string GenAssetManager::canonicalPath(const std::string &filepath)
+    {
+        // resolves "..", "." and symlinks, so different spellings of a path share one entry
+        return std::filesystem::weakly_canonical(std::filesystem::path{ENGINE_DIR + filepath}).string();
+    }
+
+    std::shared_ptr<GenModel> GenAssetManager::loadModel(const std::string &filepath)
+    {
+        GEN_PROFILE_SCOPE("GenAssetManager::loadModel");
+        auto handle = request(filepath, true);
+        while (handle->getState() == ModelHandle::State::Loading)
+        {
+            {
+                std::unique_lock<std::mutex> lock{queueMutex};
+                resultCondition.wait(lock, [this]
+                                     { return !results.empty(); });
+            }
+            processResults();
+        }
+
+        if (handle->hasFailed())
+        {
+            throw std::runtime_error{"Failed to load model: " + handle->getPath()};
+        }
+        return handle->get();
+    }
+
+    std::shared_ptr<GenAssetManager::ModelHandle> GenAssetManager::loadModelAsync(const std::string &filepath)
+    {
+        return request(filepath, false);
+    }
+
+    std::shared_ptr<GenAssetManager::ModelHandle> GenAssetManager::request(const std::string &filepath, bool immediate)
+    {
+        std::string path = canonicalPath(filepath);
+        std::shared_ptr<ModelHandle> handle{};
+        {
+            std::lock_guard<std::mutex> lock{cacheMutex};
+            requestCount++;
+            auto it = modelsByPath.find(path);
+            if (it != modelsByPath.end())
+            {
+                handle = it->second.handle.lock();
+                if (handle != nullptr)
+                {
+                    pathHits++;
+                    return handle;
+                }
+                // the earlier handles are gone but the model is still in use
+                auto model = it->second.model.lock();
+                if (model != nullptr)
+                {
+                    handle = std::shared_ptr<ModelHandle>{new ModelHandle(path)};
+                    handle->asset = std::move(model);
+                    handle->state.store(ModelHandle::State::Ready, std::memory_order_release);
+                    it->second.handle = handle;
+                    pathHits++;
+                    return handle;
+                }
+            }
+            handle = std::shared_ptr<ModelHandle>{new ModelHandle(path)};
+            modelsByPath[path] = PathEntry{handle, {}};
+            pending++;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{queueMutex};
+            LoadRequest loadRequest{handle, immediate, std::chrono::high_resolution_clock::now()};
+            // someone is waiting for it
+            if (immediate)
+            {
+                requests.push_front(std::move(loadRequest));
+            }
+            else
+            {
+                requests.push_back(std::move(loadRequest));
+            }
+        }
+        queueCondition.notify_one();
+        return handle;
+    }
+
+    void GenAssetManager::update(GenGameObject::Map &gameObjects)
+    {
+        GEN_PROFILE_SCOPE("GenAssetManager::update");
+        processResults();
+
+        auto reloads = modelResidency.takeReloadRequests();
+        if (!reloads.empty())
+        {
+            {
+                std::lock_guard<std::mutex> lock{queueMutex};
+                // something in view is waiting for them
+                for (auto &reload : reloads)
+                {
+                    requests.push_front(LoadRequest{nullptr, false, std::chrono::high_resolution_clock::now(), std::move(reload)});
+                }
+            }
+            queueCondition.notify_one();
+        }
+
+        for (auto &kv : gameObjects)
+        {
+            auto &obj = kv.second;
+            if (obj.modelHandle == nullptr || obj.modelHandle->getState() == ModelHandle::State::Loading)
+            {
+                continue;
+            }
+            // a failed load leaves the object without a model, it's reported when finished
+            obj.model = obj.modelHandle->get();
+            obj.modelHandle = nullptr;
+        }
+
+        dropExpired();
+    }
+
+    void GenAssetManager::dropExpired()
+    {
+        std::lock_guard<std::mutex> lock{cacheMutex};
+        for (auto it = modelsByContent.begin(); it != modelsByContent.end();)
+        {
+            if (!it->second.expired())
+            {
+                ++it;
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> queueLock{queueMutex};
+                knownContent.erase(it->first);
+            }
+            it = modelsByContent.erase(it);
+        }
+        for (auto it = modelsByPath.begin(); it != modelsByPath.end();)
+        {
+            if (it->second.handle.expired() && it->second.model.expired())
+            {
+                it = modelsByPath.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    void GenAssetManager::processResults()
+    {
+        std::vector<LoadResult> finished{};
+        {
+            std::lock_guard<std::mutex> lock{queueMutex};
+            finished.swap(results);
+        }
+        for (auto &result : finished)
+        {
+            finish(result);
+        }
+    }
+
+    void GenAssetManager::finish(LoadResult &result)
+    {
+        if (result.request.reload)
+        {
+            if (!result.error.empty())
+            {
+                std::cerr << "failed to reload model " << result.request.reload->sourcePath << ": " << result.error << std::endl;
+            }
+            modelResidency.finishReload(result.request.reload->model, std::move(result.builder));
+            return;
+        }
+
+        ModelHandle &handle = *result.request.handle;
+        std::lock_guard<std::mutex> lock{cacheMutex};
+
+        std::shared_ptr<GenModel> model{};
+        if (result.error.empty())
+        {
+            auto it = modelsByContent.find(result.contentHash);
+            if (it != modelsByContent.end())
+            {
+                model = it->second.lock();
+            }
+
+            if (model != nullptr)
+            {
+                contentHits++;
+            }
+            else if (result.builder == nullptr)
+            {
+                // the loader skipped parsing contents whose model expired since, it parses them this time
+                {
+                    std::lock_guard<std::mutex> queueLock{queueMutex};
+                    knownContent.erase(result.contentHash);
+                    requests.push_front(std::move(result.request));
+                }
+                queueCondition.notify_one();
+                return;
+            }
+            else
+            {
+                model = modelResidency.createModel(
+                    std::move(*result.builder),
+                    result.request.immediate ? GenModel::UploadMode::Immediate : GenModel::UploadMode::Deferred,
+                    handle.getPath());
+                modelsByContent[result.contentHash] = model;
+                {
+                    std::lock_guard<std::mutex> queueLock{queueMutex};
+                    knownContent.insert(result.contentHash);
+                }
+                loads++;
+            }
+        }
+        pending--;
+
+        // a later request for the path may have replaced the entry of an earlier one
+        auto pathIt = modelsByPath.find(handle.getPath());
+        bool ownsPath = pathIt != modelsByPath.end() && pathIt->second.handle.lock().get() == &handle;
+        if (model == nullptr)
+        {
+            std::cerr << "failed to load model " << handle.getPath() << ": " << result.error << std::endl;
+            failures++;
+            // not cached, the next request tries again
+            if (ownsPath)
+            {
+                modelsByPath.erase(pathIt);
+            }
+            handle.state.store(ModelHandle::State::Failed, std::memory_order_release);
+            return;
+        }
+
+        if (ownsPath)
+        {
+            pathIt->second.model = model;
+        }
+        handle.asset = std::move(model);
+        handle.state.store(ModelHandle::State::Ready, std::memory_order_release);
+        totalLoadMs += std::chrono::duration<double, std::milli>(
+                           std::chrono::high_resolution_clock::now() - result.request.requestTime)
+                           .count();
+    }
+
+    void GenAssetManager::loaderLoop()
+    {
+        while (true)
+        {
+            LoadRequest request;
+            {
+                std::unique_lock<std::mutex> lock{queueMutex};
+                queueCondition.wait(lock, [this]
+                                    { return stopping || !requests.empty(); });
+                if (stopping)
+                {
+                    return;
+                }
+                request = std::move(requests.front());
+                requests.pop_front();
+            }
+
+            std::string path = request.reload ? request.reload->sourcePath : request.handle->getPath();
+            LoadResult result{request};
+            std::vector<char> contents{};
+            bool known = false;
+            try
+            {
+                std::ifstream file{path, std::ios::binary};
+                if (!file.is_open())
+                {
+                    throw std::runtime_error{"Failed to open file: " + path};
+                }
+                contents.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+                // a reload only needs the builder, its model exists already
+                if (!request.reload)
+                {
+                    result.contentHash = hashContents(contents);
+                    std::lock_guard<std::mutex> lock{queueMutex};
+                    known = knownContent.count(result.contentHash) > 0;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                result.error = e.what();
+            }
+
+            if (known || !result.error.empty())
+            {
+                pushResult(std::move(result));
+                continue;
+            }
+
+            // only the read blocks this thread, the jobs are std::functions and have to be copyable
+            auto parse = std::make_shared<LoadResult>(std::move(result));
+            auto parseContents = std::make_shared<std::vector<char>>(std::move(contents));
+            jobSystem.submit(
+                [this, parse, parseContents, path]
+                {
+                    try
+                    {
+                        parse->builder = std::make_unique<GenModel::Builder>();
+                        parse->builder->parseModel(*parseContents, path);
+                    }
+                    catch (const std::exception &e)
+                    {
+                        parse->builder = nullptr;
+                        parse->error = e.what();
+                    }
+                    pushResult(std::move(*parse));
+                },
+                &parseJobs);
+        }
+    }
+
+    void GenAssetManager::pushResult(LoadResult result)
+    {
+        {
+            std::lock_guard<std::mutex> lock{queueMutex};
+            results.push_back(std::move(result));
+        }
+        resultCondition.notify_all();
+    }
+
+    GenAssetManager::Stats GenAssetManager::getStats()
+    {
+        std::lock_guard<std::mutex> lock{cacheMutex};
+        Stats stats{};
+        for (auto &kv : modelsByContent)
+        {
+            stats.modelCount += kv.second.expired() ? 0 : 1;
+        }
+        stats.requests = requestCount;
+        stats.pathHits = pathHits;
+        stats.contentHits = contentHits;
+        stats.loads = loads;
+        stats.failures = failures;
+        stats.pending = pending;
+        uint64_t completed = loads + contentHits;
+        stats.averageLoadMs = completed > 0 ? totalLoadMs / completed : 0.0;
+        return stats;
+    }
+
+}
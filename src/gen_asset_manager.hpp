@@ -0,0 +1,134 @@
+#pragma once
+
+#include "gen_asset_handle.hpp"
+#include "gen_game_object.hpp"
+#include "gen_job_system.hpp"
+#include "gen_model.hpp"
+#include "gen_model_residency.hpp"
+
+// std
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace gen
+{
+    // Shares every model while it's in use. Requests are deduplicated by canonical path, and files with identical
+    // contents under different paths share one model too. Files are read on a background loader thread and
+    // parsed as jobs, so several of them parse at once. The models are created through GenModelResidency, which
+    // also has evicted models parsed again this way. Nothing is cached past its last user, a model requested
+    // again after that is loaded again.
+    class GenAssetManager
+    {
+    public:
+        using ModelHandle = GenAssetHandle<GenModel>;
+
+        struct Stats
+        {
+            uint32_t modelCount = 0;
+            uint64_t requests = 0;
+            // requests answered by an earlier request for the same canonical path
+            uint64_t pathHits = 0;
+            // loads whose file contents matched an already loaded model
+            uint64_t contentHits = 0;
+            uint64_t loads = 0;
+            uint64_t failures = 0;
+            uint32_t pending = 0;
+            // from the request to the model being created, for loads and content hits
+            double averageLoadMs = 0.0;
+        };
+
+        // loadModel waits for the parse jobs, jobSystem needs workers
+        GenAssetManager(GenModelResidency &modelResidency, GenJobSystem &jobSystem);
+        ~GenAssetManager();
+
+        GenAssetManager(const GenAssetManager &) = delete;
+        GenAssetManager &operator=(const GenAssetManager &) = delete;
+
+        // waits for the model, uploading it right away. Throws if it can't be loaded. From the thread calling
+        // update
+        std::shared_ptr<GenModel> loadModel(const std::string &filepath);
+        // returns at once, from any thread. The model is created by a later update and only uploaded once
+        // something draws it
+        std::shared_ptr<ModelHandle> loadModelAsync(const std::string &filepath);
+
+        // from the thread that owns the game objects, once per frame before GenModelResidency::update. Creates
+        // the models of finished loads and hands them to the objects waiting for them in modelHandle, queues the
+        // reload requests of the residency, then drops the entries of models that are no longer used
+        void update(GenGameObject::Map &gameObjects);
+
+        Stats getStats();
+
+    private:
+        struct LoadRequest
+        {
+            std::shared_ptr<ModelHandle> handle;
+            bool immediate;
+            std::chrono::high_resolution_clock::time_point requestTime;
+            // set instead of handle when an evicted model is parsed again for GenModelResidency
+            std::optional<GenModelResidency::ReloadRequest> reload{};
+        };
+
+        struct LoadResult
+        {
+            LoadRequest request;
+            uint64_t contentHash = 0;
+            // nullptr if the contents were already loaded, or loading failed
+            std::unique_ptr<GenModel::Builder> builder{};
+            // empty on success
+            std::string error{};
+        };
+
+        struct PathEntry
+        {
+            // alive while the path is loading or someone still holds the handle
+            std::weak_ptr<ModelHandle> handle;
+            std::weak_ptr<GenModel> model;
+        };
+
+        static std::string canonicalPath(const std::string &filepath);
+        std::shared_ptr<ModelHandle> request(const std::string &filepath, bool immediate);
+        void processResults();
+        void dropExpired();
+        void finish(LoadResult &result);
+        void pushResult(LoadResult result);
+        void loaderLoop();
+
+        GenModelResidency &modelResidency;
+        GenJobSystem &jobSystem;
+
+        // guards the path map and the counters, requests may come from any thread
+        std::mutex cacheMutex;
+        // weak, the models are owned by their users. Failed loads are dropped right away so they can be retried
+        std::unordered_map<std::string, PathEntry> modelsByPath{};
+        std::unordered_map<uint64_t, std::weak_ptr<GenModel>> modelsByContent{};
+
+        std::mutex queueMutex;
+        std::condition_variable queueCondition;
+        std::condition_variable resultCondition;
+        std::deque<LoadRequest> requests{};
+        std::vector<LoadResult> results{};
+        // hashes in modelsByContent, lets the loader skip parsing them. May still name a model that expired since
+        std::unordered_set<uint64_t> knownContent{};
+        bool stopping = false;
+        std::thread loaderThread;
+        // the parse jobs in flight, they push to results
+        GenJobSystem::Counter parseJobs;
+
+        uint64_t requestCount = 0;
+        uint64_t pathHits = 0;
+        uint64_t contentHits = 0;
+        uint64_t loads = 0;
+        uint64_t failures = 0;
+        uint32_t pending = 0;
+        double totalLoadMs = 0.0;
+    };
+}
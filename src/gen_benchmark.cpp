@@ -0,0 +1,239 @@
+#include "gen_benchmark.hpp"
+#include "gen_json.hpp"
+
+// libs
+#include <glm/gtc/constants.hpp>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace gen
+{
+
+    namespace
+    {
+        // nearest rank percentile of sorted samples
+        double percentile(const std::vector<double> &sorted, double fraction)
+        {
+            size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+            return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+        }
+    }
+
+    float BenchmarkScene::extent() const
+    {
+        // roughly constant density, about four objects per square unit
+        return std::max(2.f, .25f * std::sqrt(static_cast<float>(objectCount)));
+    }
+
+    uint64_t BenchmarkRandom::next()
+    {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    float BenchmarkRandom::uniform(float min, float max)
+    {
+        // top 24 bits, exactly representable as a float
+        float unit = static_cast<float>(next() >> 40) / static_cast<float>(1u << 24);
+        return min + (max - min) * unit;
+    }
+
+    BenchmarkCameraPose benchmarkCameraPose(const BenchmarkScene &scene, float time)
+    {
+        constexpr float ORBIT_SECONDS = 20.f;
+        constexpr float BOB_SECONDS = 7.f;
+
+        float extent = scene.extent();
+        float angle = glm::two_pi<float>() * time / ORBIT_SECONDS;
+        float radius = 1.5f * extent + 1.f;
+        float height = .5f + .25f * extent * (1.f + .5f * std::sin(glm::two_pi<float>() * time / BOB_SECONDS));
+
+        // -y is up
+        BenchmarkCameraPose pose{};
+        pose.translation = {radius * std::sin(angle), -height, radius * std::cos(angle)};
+        // looking at the scene center
+        pose.rotation = {
+            std::atan2(pose.translation.y, radius),
+            std::atan2(-pose.translation.x, -pose.translation.z),
+            0.f};
+        return pose;
+    }
+
+    GenBenchmark::GenBenchmark(const BenchmarkScene &scene) : scene{scene}
+    {
+        cpuFrameMs.samples.reserve(scene.measuredFrames);
+        gpuFrameMs.samples.reserve(scene.measuredFrames);
+        drawCalls.samples.reserve(scene.measuredFrames);
+        deviceMemoryMb.samples.reserve(scene.measuredFrames);
+    }
+
+    void GenBenchmark::addFrame(const BenchmarkFrame &frame)
+    {
+        cpuFrameMs.samples.push_back(frame.cpuFrameMs);
+        drawCalls.samples.push_back(frame.drawCalls);
+        deviceMemoryMb.samples.push_back(frame.deviceMemoryMb);
+    }
+
+    void GenBenchmark::addGpuFrame(double frameMs)
+    {
+        gpuFrameMs.samples.push_back(frameMs);
+    }
+
+    GenBenchmark::Summary GenBenchmark::summarize(std::vector<double> samples)
+    {
+        Summary summary{};
+        summary.sampleCount = static_cast<uint32_t>(samples.size());
+        if (samples.empty())
+        {
+            return summary;
+        }
+
+        std::sort(samples.begin(), samples.end());
+        double sum = 0.0;
+        for (double sample : samples)
+        {
+            sum += sample;
+        }
+        summary.average = sum / samples.size();
+        summary.p50 = percentile(samples, 0.50);
+        summary.p95 = percentile(samples, 0.95);
+        summary.p99 = percentile(samples, 0.99);
+        summary.max = samples.back();
+        return summary;
+    }
+
+    void GenBenchmark::writeJson(const std::string &filepath) const
+    {
+        std::ofstream file{filepath};
+        if (!file.is_open())
+        {
+            throw std::runtime_error{"Failed to open file: " + filepath};
+        }
+
+        file << std::fixed << std::setprecision(4);
+        file << "{\n";
+        file << "  \"device\": ";
+        writeJsonString(file, deviceName);
+        file << ",\n";
+        file << "  \"scene\": {\"objects\": " << scene.objectCount << ", \"models\": " << scene.modelCount
+             << ", \"lights\": " << scene.lightCount << ", \"seed\": " << scene.seed
+             << ", \"warmup_frames\": " << scene.warmupFrames << ", \"frames\": " << scene.measuredFrames
+             << ", \"timestep\": " << scene.timestep << "},\n";
+        file << "  \"metrics\": {\n";
+
+        const Metric *metrics[] = {&cpuFrameMs, &gpuFrameMs, &drawCalls, &deviceMemoryMb};
+        for (size_t i = 0; i < std::size(metrics); i++)
+        {
+            Summary summary = summarize(metrics[i]->samples);
+            file << "    \"" << metrics[i]->name << "\": {\"samples\": " << summary.sampleCount
+                 << ", \"avg\": " << summary.average << ", \"p50\": " << summary.p50
+                 << ", \"p95\": " << summary.p95 << ", \"p99\": " << summary.p99
+                 << ", \"max\": " << summary.max << "}" << (i + 1 < std::size(metrics) ? "," : "") << "\n";
+        }
+        file << "  }\n}\n";
+    }
+
+    bool GenBenchmark::checkBaseline(const std::string &filepath, double tolerance) const
+    {
+        std::ifstream file{filepath};
+        if (!file.is_open())
+        {
+            throw std::runtime_error{"Failed to open file: " + filepath};
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        std::string text = buffer.str();
+        JsonValue baseline = parseJson(text, filepath);
+        const JsonValue *baselineMetrics = baseline.find("metrics");
+        if (baselineMetrics == nullptr || baselineMetrics->type != JsonValue::Type::Object)
+        {
+            throw std::runtime_error{"no metrics object in benchmark report " + filepath};
+        }
+
+        // numbers of a different scene say nothing about this one
+        const JsonValue *baselineScene = baseline.find("scene");
+        if (baselineScene == nullptr || baselineScene->type != JsonValue::Type::Object)
+        {
+            throw std::runtime_error{"no scene object in benchmark report " + filepath};
+        }
+        std::pair<const char *, double> parameters[] = {
+            {"objects", scene.objectCount},
+            {"models", scene.modelCount},
+            {"lights", scene.lightCount},
+            {"seed", static_cast<double>(scene.seed)},
+            {"warmup_frames", scene.warmupFrames},
+            {"frames", scene.measuredFrames},
+            {"timestep", scene.timestep}};
+        for (const auto &[key, value] : parameters)
+        {
+            const JsonValue *baselineEntry = baselineScene->find(key);
+            if (baselineEntry == nullptr || baselineEntry->type != JsonValue::Type::Number)
+            {
+                throw std::runtime_error{std::string{"no number for scene "} + key + " in " + filepath};
+            }
+            // written with 4 decimals
+            if (std::abs(baselineEntry->number - value) > 1e-4)
+            {
+                std::ostringstream message;
+                message << "benchmark report " << filepath << " is of a different scene, " << key << " "
+                        << baselineEntry->number << " vs " << value;
+                throw std::runtime_error{message.str()};
+            }
+        }
+
+        bool passed = true;
+        const Metric *metrics[] = {&cpuFrameMs, &gpuFrameMs, &drawCalls, &deviceMemoryMb};
+        for (const Metric *metric : metrics)
+        {
+            Summary summary = summarize(metric->samples);
+            // a metric the baseline has no samples of, like the gpu times of a device without timestamps, isn't
+            // compared
+            const JsonValue *baselineMetric = baselineMetrics->find(metric->name);
+            const JsonValue *baselineSamples = baselineMetric != nullptr ? baselineMetric->find("samples") : nullptr;
+            if (baselineSamples == nullptr || baselineSamples->type != JsonValue::Type::Number ||
+                baselineSamples->number == 0.0)
+            {
+                continue;
+            }
+            // nothing measured can't pass for no regression
+            if (summary.sampleCount == 0)
+            {
+                std::cout << "Regression: " << metric->name << " has no samples, the baseline has "
+                          << baselineSamples->number << std::endl;
+                passed = false;
+                continue;
+            }
+
+            std::pair<const char *, double> current[] = {{"p50", summary.p50}, {"p95", summary.p95}, {"p99", summary.p99}};
+            for (const auto &[key, value] : current)
+            {
+                const JsonValue *baselineEntry = baselineMetric->find(key);
+                if (baselineEntry == nullptr || baselineEntry->type != JsonValue::Type::Number)
+                {
+                    throw std::runtime_error{"no number for " + metric->name + " " + key + " in " + filepath};
+                }
+                double baselineValue = baselineEntry->number;
+                if (value > baselineValue * (1.0 + tolerance))
+                {
+                    std::cout << "Regression: " << metric->name << " " << key << " " << value << " vs baseline "
+                              << baselineValue << std::endl;
+                    passed = false;
+                }
+            }
+        }
+        return passed;
+    }
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+// libs
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gen
+{
+    // Parameters of a generated benchmark scene. The same parameters always produce the same scene, camera path
+    // and simulation, so runs of different builds can be compared.
+    struct BenchmarkScene
+    {
+        uint32_t objectCount = 1000;
+        // distinct models, each gets its own vertex and index buffers even when loaded from the same file
+        uint32_t modelCount = 4;
+        uint32_t lightCount = 64;
+        uint64_t seed = 1;
+        uint32_t warmupFrames = 60;
+        uint32_t measuredFrames = 600;
+        // simulation step per frame in seconds, independent of the actual frame time
+        float timestep = 1.f / 60.f;
+
+        // half the side length of the square the objects are scattered over
+        float extent() const;
+    };
+
+    // splitmix64, unlike the std distributions it produces the same sequence with every standard library
+    class BenchmarkRandom
+    {
+    public:
+        explicit BenchmarkRandom(uint64_t seed) : state{seed} {}
+
+        uint64_t next();
+        // uniform in [min, max)
+        float uniform(float min, float max);
+
+    private:
+        uint64_t state;
+    };
+
+    // camera pose at time seconds along the scripted path, an orbit around the scene that bobs up and down
+    struct BenchmarkCameraPose
+    {
+        glm::vec3 translation;
+        glm::vec3 rotation;
+    };
+    BenchmarkCameraPose benchmarkCameraPose(const BenchmarkScene &scene, float time);
+
+    struct BenchmarkFrame
+    {
+        double cpuFrameMs = 0.0;
+        double deviceMemoryMb = 0.0;
+        uint32_t drawCalls = 0;
+    };
+
+    // Collects per frame samples of a benchmark run and reports them as p50/p95/p99 in JSON. A stored report
+    // serves as the baseline a later run is checked against.
+    class GenBenchmark
+    {
+    public:
+        struct Metric
+        {
+            std::string name;
+            std::vector<double> samples;
+        };
+
+        struct Summary
+        {
+            uint32_t sampleCount = 0;
+            double average = 0.0;
+            double p50 = 0.0;
+            double p95 = 0.0;
+            double p99 = 0.0;
+            double max = 0.0;
+        };
+
+        explicit GenBenchmark(const BenchmarkScene &scene);
+
+        const BenchmarkScene &getScene() const { return scene; }
+        uint32_t getFrameCount() const { return scene.warmupFrames + scene.measuredFrames; }
+        // frames before the warmup ended are dropped
+        bool isMeasuring(uint64_t frame) const { return frame >= scene.warmupFrames; }
+
+        void addFrame(const BenchmarkFrame &frame);
+        // gpu samples arrive frames late, so they are added separately
+        void addGpuFrame(double gpuFrameMs);
+        void setDeviceName(const std::string &name) { deviceName = name; }
+
+        static Summary summarize(std::vector<double> samples);
+        void writeJson(const std::string &filepath) const;
+        // compares p50, p95 and p99 of every metric with the report at filepath, all metrics are lower is better.
+        // Prints each regression beyond tolerance (0.1 = 10%) and returns false if there was any, a metric the
+        // report has samples of but this run doesn't counts as one. Throws if the report isn't valid JSON, lacks a
+        // value of a metric it lists or was measured with different scene parameters
+        bool checkBaseline(const std::string &filepath, double tolerance) const;
+
+    private:
+        BenchmarkScene scene;
+        std::string deviceName;
+        Metric cpuFrameMs{"cpu_frame_ms", {}};
+        Metric gpuFrameMs{"gpu_frame_ms", {}};
+        Metric drawCalls{"draw_calls", {}};
+        Metric deviceMemoryMb{"device_memory_mb", {}};
+    };
+}
@@ -0,0 +1,242 @@
+#include "gen_bindless.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+namespace gen
+{
+    namespace
+    {
+        struct ArrayCapacities
+        {
+            uint32_t storageBuffers;
+            uint32_t sampledImages;
+        };
+
+        ArrayCapacities arrayCapacities(const GenDevice &device)
+        {
+            const auto &limits = device.descriptorIndexingProperties;
+            ArrayCapacities capacities{};
+            capacities.storageBuffers = std::min({GenBindlessDescriptors::MAX_STORAGE_BUFFERS,
+                                                  limits.maxDescriptorSetUpdateAfterBindStorageBuffers,
+                                                  limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers});
+            // a combined image sampler counts as a sampled image and as a sampler
+            capacities.sampledImages = std::min({GenBindlessDescriptors::MAX_SAMPLED_IMAGES,
+                                                 limits.maxDescriptorSetUpdateAfterBindSampledImages,
+                                                 limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                                                 limits.maxDescriptorSetUpdateAfterBindSamplers,
+                                                 limits.maxPerStageDescriptorUpdateAfterBindSamplers});
+
+            // both arrays are visible to every stage, so together they must fit the resources of one stage.
+            // Split in proportion to what each could have had
+            uint64_t total = static_cast<uint64_t>(capacities.storageBuffers) + capacities.sampledImages;
+            uint32_t resources = limits.maxPerStageUpdateAfterBindResources;
+            if (total > resources)
+            {
+                capacities.storageBuffers = static_cast<uint32_t>(capacities.storageBuffers * uint64_t{resources} / total);
+                capacities.sampledImages = resources - capacities.storageBuffers;
+            }
+            return capacities;
+        }
+    }
+
+    // *************** Slot Allocator *********************
+
+    uint32_t GenSlotAllocator::allocate()
+    {
+        uint32_t slot = INVALID_SLOT;
+        if (!freeSlots.empty())
+        {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else if (nextUnused < capacity)
+        {
+            slot = nextUnused++;
+        }
+        else
+        {
+            return INVALID_SLOT;
+        }
+        usedCount++;
+        return slot;
+    }
+
+    void GenSlotAllocator::release(uint32_t slot, uint64_t frame)
+    {
+        assert(slot < nextUnused && "Releasing a slot that was never allocated");
+        assert((pendingReleases.empty() || pendingReleases.back().frame <= frame) && "Releases out of frame order");
+        pendingReleases.push_back({frame, slot});
+    }
+
+    void GenSlotAllocator::completeFrame(uint64_t frame)
+    {
+        while (!pendingReleases.empty() && pendingReleases.front().frame <= frame)
+        {
+            freeSlots.push_back(pendingReleases.front().slot);
+            pendingReleases.pop_front();
+            usedCount--;
+        }
+    }
+
+    // *************** Bindless Descriptors *********************
+
+    GenBindlessDescriptors::GenBindlessDescriptors(GenDevice &device)
+        : genDevice{device},
+          storageBufferSlots{arrayCapacities(device).storageBuffers},
+          sampledImageSlots{arrayCapacities(device).sampledImages}
+    {
+        assert(genDevice.supportsBindless() && "Bindless descriptors need descriptor indexing");
+
+        std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+        bindings[0].binding = STORAGE_BUFFER_BINDING;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[0].descriptorCount = storageBufferSlots.getCapacity();
+        bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+        // only the last binding may have a variable count
+        bindings[1].binding = SAMPLED_IMAGE_BINDING;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[1].descriptorCount = sampledImageSlots.getCapacity();
+        bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+        // unused entries are never accessed, so the arrays don't need to be fully written, and entries can be
+        // written while frames sampling other entries are still executing
+        VkDescriptorBindingFlagsEXT arrayFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
+                                                 VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+                                                 VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+        std::array<VkDescriptorBindingFlagsEXT, 2> bindingFlags{
+            arrayFlags,
+            arrayFlags | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT_EXT};
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo{};
+        bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+        bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+        bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.pNext = &bindingFlagsInfo;
+        layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+
+        if (vkCreateDescriptorSetLayout(genDevice.device(), &layoutInfo, nullptr, &setLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create bindless descriptor set layout!");
+        }
+
+        std::array<VkDescriptorPoolSize, 2> poolSizes{{
+            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storageBufferSlots.getCapacity()},
+            {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, sampledImageSlots.getCapacity()}}};
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+        poolInfo.maxSets = 1;
+        poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolInfo.pPoolSizes = poolSizes.data();
+
+        if (vkCreateDescriptorPool(genDevice.device(), &poolInfo, nullptr, &pool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create bindless descriptor pool!");
+        }
+
+        uint32_t variableCount = sampledImageSlots.getCapacity();
+        VkDescriptorSetVariableDescriptorCountAllocateInfoEXT variableCountInfo{};
+        variableCountInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO_EXT;
+        variableCountInfo.descriptorSetCount = 1;
+        variableCountInfo.pDescriptorCounts = &variableCount;
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.pNext = &variableCountInfo;
+        allocInfo.descriptorPool = pool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &setLayout;
+
+        if (vkAllocateDescriptorSets(genDevice.device(), &allocInfo, &set) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate bindless descriptor set!");
+        }
+    }
+
+    GenBindlessDescriptors::~GenBindlessDescriptors()
+    {
+        // destroying the pool frees the set, once no frame in flight has it bound
+        genDevice.destroyDeferred(VK_OBJECT_TYPE_DESCRIPTOR_POOL, pool);
+        vkDestroyDescriptorSetLayout(genDevice.device(), setLayout, nullptr);
+    }
+
+    void GenBindlessDescriptors::bind(
+        VkCommandBuffer commandBuffer,
+        VkPipelineBindPoint bindPoint,
+        VkPipelineLayout pipelineLayout,
+        uint32_t setIndex) const
+    {
+        vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, setIndex, 1, &set, 0, nullptr);
+    }
+
+    uint32_t GenBindlessDescriptors::addStorageBuffer(const VkDescriptorBufferInfo &bufferInfo)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        uint32_t index = allocateSlot(storageBufferSlots, "storage buffer");
+        write(STORAGE_BUFFER_BINDING, index, &bufferInfo, nullptr);
+        return index;
+    }
+
+    uint32_t GenBindlessDescriptors::addSampledImage(const VkDescriptorImageInfo &imageInfo)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        uint32_t index = allocateSlot(sampledImageSlots, "sampled image");
+        write(SAMPLED_IMAGE_BINDING, index, nullptr, &imageInfo);
+        return index;
+    }
+
+    void GenBindlessDescriptors::removeStorageBuffer(uint32_t index)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        storageBufferSlots.release(index, genDevice.getRecordingFrame());
+    }
+
+    void GenBindlessDescriptors::removeSampledImage(uint32_t index)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        sampledImageSlots.release(index, genDevice.getRecordingFrame());
+    }
+
+    void GenBindlessDescriptors::completeFrame(uint64_t frame)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        storageBufferSlots.completeFrame(frame);
+        sampledImageSlots.completeFrame(frame);
+    }
+
+    uint32_t GenBindlessDescriptors::allocateSlot(GenSlotAllocator &slots, const char *arrayName)
+    {
+        uint32_t index = slots.allocate();
+        if (index == GenSlotAllocator::INVALID_SLOT)
+        {
+            throw std::runtime_error(std::string{"bindless "} + arrayName + " array is full!");
+        }
+        return index;
+    }
+
+    void GenBindlessDescriptors::write(
+        uint32_t binding, uint32_t index, const VkDescriptorBufferInfo *bufferInfo, const VkDescriptorImageInfo *imageInfo)
+    {
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = set;
+        write.dstBinding = binding;
+        write.dstArrayElement = index;
+        write.descriptorCount = 1;
+        write.descriptorType = binding == STORAGE_BUFFER_BINDING ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.pBufferInfo = bufferInfo;
+        write.pImageInfo = imageInfo;
+        vkUpdateDescriptorSets(genDevice.device(), 1, &write, 0, nullptr);
+    }
+
+}
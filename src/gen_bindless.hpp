@@ -0,0 +1,110 @@
+#pragma once
+
+#include "gen_device.hpp"
+
+// std
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace gen
+{
+    // Hands out stable indices into a fixed size array. A released index is only handed out again once the
+    // frame it was released in has completed, so frames in flight never see it change under them. Frames are
+    // the monotonic numbers of GenDevice::getRecordingFrame.
+    class GenSlotAllocator
+    {
+    public:
+        static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+        explicit GenSlotAllocator(uint32_t capacity) : capacity{capacity} {}
+
+        // INVALID_SLOT once every slot is taken
+        uint32_t allocate();
+        // the slot is reserved until frame has completed
+        void release(uint32_t slot, uint64_t frame);
+        // frees the slots released up to frame, which must have completed
+        void completeFrame(uint64_t frame);
+
+        uint32_t getCapacity() const { return capacity; }
+        uint32_t getUsedCount() const { return usedCount; }
+
+    private:
+        uint32_t capacity;
+        // slots above this were never handed out
+        uint32_t nextUnused = 0;
+        uint32_t usedCount = 0;
+        std::vector<uint32_t> freeSlots{};
+
+        struct PendingRelease
+        {
+            uint64_t frame;
+            uint32_t slot;
+        };
+
+        // ordered by frame, releases only come from the frame being recorded
+        std::deque<PendingRelease> pendingReleases{};
+    };
+
+    // A single descriptor set holding large arrays of storage buffers and sampled images, bound once per frame.
+    // Resources are registered once and addressed by their index from push constants or instance data, so a
+    // new resource type doesn't need its own set layout and bind. Built on descriptor indexing: the arrays
+    // are partially bound and update after bind, so registering never waits for frames in flight.
+    //
+    // In GLSL (GL_EXT_nonuniform_qualifier):
+    //   layout(set = N, binding = 0) readonly buffer Buffers { uint data[]; } storageBuffers[];
+    //   layout(set = N, binding = 1) uniform sampler2D sampledImages[];
+    class GenBindlessDescriptors
+    {
+    public:
+        static constexpr uint32_t STORAGE_BUFFER_BINDING = 0;
+        static constexpr uint32_t SAMPLED_IMAGE_BINDING = 1;
+        // upper bounds, lowered to the device limits
+        static constexpr uint32_t MAX_STORAGE_BUFFERS = 8192;
+        static constexpr uint32_t MAX_SAMPLED_IMAGES = 16384;
+
+        // the device must support bindless, see GenDevice::supportsBindless
+        explicit GenBindlessDescriptors(GenDevice &device);
+        ~GenBindlessDescriptors();
+
+        GenBindlessDescriptors(const GenBindlessDescriptors &) = delete;
+        GenBindlessDescriptors &operator=(const GenBindlessDescriptors &) = delete;
+
+        VkDescriptorSetLayout getSetLayout() const { return setLayout; }
+        VkDescriptorSet getSet() const { return set; }
+        void bind(
+            VkCommandBuffer commandBuffer,
+            VkPipelineBindPoint bindPoint,
+            VkPipelineLayout pipelineLayout,
+            uint32_t setIndex) const;
+
+        // from any thread, the returned index stays valid until it's removed. Throws once the array is full
+        uint32_t addStorageBuffer(const VkDescriptorBufferInfo &bufferInfo);
+        uint32_t addSampledImage(const VkDescriptorImageInfo &imageInfo);
+        // the resource must stay alive until the current frame has completed
+        void removeStorageBuffer(uint32_t index);
+        void removeSampledImage(uint32_t index);
+
+        // recycles the indices removed up to frame, a number of GenDevice::getRecordingFrame whose fence signaled
+        void completeFrame(uint64_t frame);
+
+        uint32_t getStorageBufferCount() const { return storageBufferSlots.getUsedCount(); }
+        uint32_t getSampledImageCount() const { return sampledImageSlots.getUsedCount(); }
+
+    private:
+        uint32_t allocateSlot(GenSlotAllocator &slots, const char *arrayName);
+        void write(uint32_t binding, uint32_t index, const VkDescriptorBufferInfo *bufferInfo, const VkDescriptorImageInfo *imageInfo);
+
+        GenDevice &genDevice;
+        VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+        VkDescriptorPool pool = VK_NULL_HANDLE;
+        VkDescriptorSet set = VK_NULL_HANDLE;
+
+        // descriptor updates of the same set must not race, the gpu reading it is fine with update after bind
+        std::mutex mutex;
+        GenSlotAllocator storageBufferSlots;
+        GenSlotAllocator sampledImageSlots;
+    };
+}
@@ -53,8 +53,9 @@ namespace gen
     GenBuffer::~GenBuffer()
     {
         unmap();
-        vkDestroyBuffer(genDevice.device(), buffer, nullptr);
-        vkFreeMemory(genDevice.device(), memory, nullptr);
+        // frames in flight may still read it
+        genDevice.destroyDeferred(VK_OBJECT_TYPE_BUFFER, buffer);
+        genDevice.destroyDeferred(VK_OBJECT_TYPE_DEVICE_MEMORY, memory);
     }
 
     /**
@@ -38,8 +38,20 @@ namespace gen
             return glm::vec3(inverseViewMatrix[3]);
         }
 
+        float getNearClip() const
+        {
+            return nearClip;
+        }
+
+        float getFarClip() const
+        {
+            return farClip;
+        }
+
     private:
         glm::mat4 projectionMatrix{1.f};
+        float nearClip{0.1f};
+        float farClip{1000.f};
         glm::mat4 viewMatrix{1.f};
         glm::mat4 inverseViewMatrix{1.f};
     };
@@ -0,0 +1,182 @@
+#include "gen_cpu_profiler.hpp"
+
+// std
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace gen
+{
+    namespace
+    {
+        struct ZoneEvent
+        {
+            const char *name;
+            uint64_t beginNanos;
+            uint64_t endNanos;
+        };
+
+        // a thread's events live in a list of chunks that are never moved, so the exporter can read them while
+        // the owner keeps appending. count and next are published with release stores
+        struct EventChunk
+        {
+            static constexpr uint32_t CAPACITY = 4096;
+
+            std::array<ZoneEvent, CAPACITY> events;
+            std::atomic<uint32_t> count{0};
+            std::atomic<EventChunk *> next{nullptr};
+        };
+
+        struct ThreadBuffer
+        {
+            uint32_t threadId;
+            std::atomic<const char *> name{nullptr};
+            // allocated by the first record, a thread that only names itself while disabled costs no chunk
+            std::atomic<EventChunk *> head{nullptr};
+            // only touched by the owning thread, chunks owns head and every chunk after it
+            EventChunk *tail = nullptr;
+            std::vector<std::unique_ptr<EventChunk>> chunks;
+        };
+
+        // buffers outlive their threads so the trace can still be written after a thread exits
+        struct Registry
+        {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+            std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+        };
+
+        Registry &registry()
+        {
+            static Registry instance;
+            return instance;
+        }
+
+        ThreadBuffer &threadBuffer()
+        {
+            thread_local ThreadBuffer *buffer = nullptr;
+            if (buffer == nullptr)
+            {
+                auto &reg = registry();
+                std::lock_guard<std::mutex> lock{reg.mutex};
+                reg.buffers.push_back(std::make_unique<ThreadBuffer>());
+                buffer = reg.buffers.back().get();
+                buffer->threadId = static_cast<uint32_t>(reg.buffers.size());
+            }
+            return *buffer;
+        }
+
+        void writeJsonString(std::ofstream &file, const char *text)
+        {
+            file << '"';
+            for (const char *c = text; *c != '\0'; c++)
+            {
+                if (*c == '"' || *c == '\\')
+                {
+                    file << '\\';
+                }
+                file << *c;
+            }
+            file << '"';
+        }
+    }
+
+    std::atomic<bool> GenCpuProfiler::enabledFlag{false};
+
+    void GenCpuProfiler::setThreadName(const char *name)
+    {
+        threadBuffer().name.store(name, std::memory_order_release);
+    }
+
+    uint64_t GenCpuProfiler::now()
+    {
+        auto elapsed = std::chrono::steady_clock::now() - registry().epoch;
+        // +1 keeps 0 free as the disabled marker of Zone
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) + 1;
+    }
+
+    void GenCpuProfiler::record(const char *name, uint64_t beginNanos, uint64_t endNanos)
+    {
+        auto &buffer = threadBuffer();
+        EventChunk *chunk = buffer.tail;
+        uint32_t count = chunk != nullptr ? chunk->count.load(std::memory_order_relaxed) : 0;
+        if (chunk == nullptr || count == EventChunk::CAPACITY)
+        {
+            buffer.chunks.push_back(std::make_unique<EventChunk>());
+            EventChunk *next = buffer.chunks.back().get();
+            if (chunk == nullptr)
+            {
+                buffer.head.store(next, std::memory_order_release);
+            }
+            else
+            {
+                chunk->next.store(next, std::memory_order_release);
+            }
+            buffer.tail = chunk = next;
+            count = 0;
+        }
+
+        chunk->events[count] = {name, beginNanos, endNanos};
+        chunk->count.store(count + 1, std::memory_order_release);
+    }
+
+    void GenCpuProfiler::writeChromeTrace(const std::string &filepath)
+    {
+        std::ofstream file{filepath};
+        if (!file.is_open())
+        {
+            throw std::runtime_error{"Failed to open file: " + filepath};
+        }
+
+        // snapshot the buffer list, the buffers themselves are read without the lock
+        std::vector<ThreadBuffer *> buffers;
+        {
+            auto &reg = registry();
+            std::lock_guard<std::mutex> lock{reg.mutex};
+            for (auto &buffer : reg.buffers)
+            {
+                buffers.push_back(buffer.get());
+            }
+        }
+
+        // complete events ("ph":"X") in microseconds, nesting on a thread is derived from the time ranges
+        file << std::fixed << std::setprecision(3);
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for (auto *buffer : buffers)
+        {
+            const char *name = buffer->name.load(std::memory_order_acquire);
+            if (name != nullptr)
+            {
+                file << (first ? "" : ",") << "\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":"
+                     << buffer->threadId << ",\"args\":{\"name\":";
+                writeJsonString(file, name);
+                file << "}}";
+                first = false;
+            }
+
+            for (EventChunk *chunk = buffer->head.load(std::memory_order_acquire); chunk != nullptr;
+                 chunk = chunk->next.load(std::memory_order_acquire))
+            {
+                uint32_t count = chunk->count.load(std::memory_order_acquire);
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    const auto &event = chunk->events[i];
+                    file << (first ? "" : ",") << "\n{\"ph\":\"X\",\"name\":";
+                    writeJsonString(file, event.name);
+                    file << ",\"pid\":1,\"tid\":" << buffer->threadId
+                         << ",\"ts\":" << event.beginNanos / 1000.0
+                         << ",\"dur\":" << (event.endNanos - event.beginNanos) / 1000.0 << "}";
+                    first = false;
+                }
+            }
+        }
+        file << "\n]}\n";
+    }
+
+}
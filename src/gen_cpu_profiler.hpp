@@ -0,0 +1,66 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace gen
+{
+    // Scoped CPU zones recorded into per-thread buffers and exported as Chrome trace JSON, which
+    // chrome://tracing and Perfetto open directly. Only the owning thread appends to a buffer, so recording
+    // takes no locks. While disabled a zone costs a single relaxed load. Zone names must be string literals
+    // or otherwise outlive the profiler, only the pointer is stored.
+    class GenCpuProfiler
+    {
+    public:
+        static void setEnabled(bool enabled) { enabledFlag.store(enabled, std::memory_order_relaxed); }
+        static bool isEnabled() { return enabledFlag.load(std::memory_order_relaxed); }
+
+        // names the calling thread in the trace, name must outlive the profiler like zone names
+        static void setThreadName(const char *name);
+
+        // nanoseconds since the profiler's epoch
+        static uint64_t now();
+        static void record(const char *name, uint64_t beginNanos, uint64_t endNanos);
+
+        // writes every zone recorded so far, zones still open are left out. Safe while other threads record
+        static void writeChromeTrace(const std::string &filepath);
+
+        class Zone
+        {
+        public:
+            explicit Zone(const char *name) : name{name}, beginNanos{isEnabled() ? now() : 0} {}
+            ~Zone()
+            {
+                if (beginNanos != 0)
+                {
+                    record(name, beginNanos, now());
+                }
+            }
+
+            Zone(const Zone &) = delete;
+            Zone &operator=(const Zone &) = delete;
+
+        private:
+            const char *name;
+            // 0 if the profiler was disabled when the zone began
+            uint64_t beginNanos;
+        };
+
+    private:
+        static std::atomic<bool> enabledFlag;
+    };
+}
+
+#define GEN_PROFILE_CONCAT_IMPL(a, b) a##b
+#define GEN_PROFILE_CONCAT(a, b) GEN_PROFILE_CONCAT_IMPL(a, b)
+
+// define GEN_DISABLE_PROFILER to compile the zones out entirely
+#ifdef GEN_DISABLE_PROFILER
+#define GEN_PROFILE_SCOPE(name)
+#define GEN_PROFILE_FUNCTION()
+#else
+#define GEN_PROFILE_SCOPE(name) ::gen::GenCpuProfiler::Zone GEN_PROFILE_CONCAT(genProfileZone, __LINE__){name}
+#define GEN_PROFILE_FUNCTION() GEN_PROFILE_SCOPE(__func__)
+#endif
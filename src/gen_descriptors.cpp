@@ -1,7 +1,9 @@
 #include "gen_descriptors.hpp"
 
 // std
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <stdexcept>
 
 namespace gen
@@ -112,7 +114,8 @@ namespace gen
 
     GenDescriptorPool::~GenDescriptorPool()
     {
-        vkDestroyDescriptorPool(genDevice.device(), descriptorPool, nullptr);
+        // takes its sets along, which frames in flight may still have bound
+        genDevice.destroyDeferred(VK_OBJECT_TYPE_DESCRIPTOR_POOL, descriptorPool);
     }
 
     bool GenDescriptorPool::allocateDescriptor(
@@ -124,8 +127,6 @@ namespace gen
         allocInfo.pSetLayouts = &descriptorSetLayout;
         allocInfo.descriptorSetCount = 1;
 
-        // Might want to create a "DescriptorPoolManager" class that handles this case, and builds
-        // a new pool whenever an old pool fills up. But this is beyond our current scope
         if (vkAllocateDescriptorSets(genDevice.device(), &allocInfo, &descriptor) != VK_SUCCESS)
         {
             return false;
@@ -147,10 +148,140 @@ namespace gen
         vkResetDescriptorPool(genDevice.device(), descriptorPool, 0);
     }
 
+    // *************** Descriptor Allocator *********************
+
+    GenDescriptorAllocator::GenDescriptorAllocator(
+        GenDevice &genDevice, uint32_t initialSetsPerPool, const std::vector<PoolSizeRatio> &ratios)
+        : genDevice{genDevice}, ratios{ratios}, nextPoolSets{std::clamp(initialSetsPerPool, 1u, MAX_SETS_PER_POOL)} {}
+
+    VkDescriptorSet GenDescriptorAllocator::allocate(VkDescriptorSetLayout descriptorSetLayout)
+    {
+        if (currentPool == nullptr)
+        {
+            currentPool = takePool();
+        }
+
+        // VK_ERROR_OUT_OF_POOL_MEMORY and VK_ERROR_FRAGMENTED_POOL both mean this pool is done for now
+        VkDescriptorSet set;
+        if (!currentPool->allocateDescriptor(descriptorSetLayout, set))
+        {
+            fullPools.push_back(std::move(currentPool));
+            currentPool = takePool();
+            if (!currentPool->allocateDescriptor(descriptorSetLayout, set))
+            {
+                throw std::runtime_error("failed to allocate descriptor set!");
+            }
+        }
+        stats.allocations++;
+        return set;
+    }
+
+    void GenDescriptorAllocator::reset()
+    {
+        // nothing was allocated since the last reset, most per-thread allocators never allocate at all
+        if (currentPool == nullptr && fullPools.empty())
+        {
+            return;
+        }
+        if (currentPool != nullptr)
+        {
+            fullPools.push_back(std::move(currentPool));
+        }
+        for (auto &pool : fullPools)
+        {
+            pool->resetPool();
+            readyPools.push_back(std::move(pool));
+        }
+        fullPools.clear();
+        stats.resets++;
+    }
+
+    std::unique_ptr<GenDescriptorPool> GenDescriptorAllocator::takePool()
+    {
+        if (!readyPools.empty())
+        {
+            auto pool = std::move(readyPools.back());
+            readyPools.pop_back();
+            return pool;
+        }
+
+        GenDescriptorPool::Builder builder{genDevice};
+        builder.setMaxSets(nextPoolSets);
+        for (const auto &ratio : ratios)
+        {
+            builder.addPoolSize(ratio.type, std::max(static_cast<uint32_t>(std::ceil(ratio.ratio * nextPoolSets)), 1u));
+        }
+
+        if (stats.poolCount > 0)
+        {
+            stats.growths++;
+        }
+        stats.poolCount++;
+        nextPoolSets = std::min(nextPoolSets * 2, MAX_SETS_PER_POOL);
+        return builder.build();
+    }
+
+    // *************** Frame Descriptor Allocator *********************
+
+    GenFrameDescriptorAllocator::GenFrameDescriptorAllocator(
+        GenDevice &genDevice,
+        GenJobSystem &jobSystem,
+        uint32_t initialSetsPerPool,
+        const std::vector<GenDescriptorAllocator::PoolSizeRatio> &ratios)
+        : jobSystem{jobSystem}
+    {
+        // pools are only created on a thread's first allocation in a frame slot
+        allocators.resize(jobSystem.getThreadSlotCount());
+        for (auto &thread : allocators)
+        {
+            for (auto &allocator : thread)
+            {
+                allocator = std::make_unique<GenDescriptorAllocator>(genDevice, initialSetsPerPool, ratios);
+            }
+        }
+    }
+
+    void GenFrameDescriptorAllocator::beginFrame(int newFrameIndex)
+    {
+        frameIndex = newFrameIndex;
+        for (auto &thread : allocators)
+        {
+            thread[frameIndex]->reset();
+        }
+    }
+
+    VkDescriptorSet GenFrameDescriptorAllocator::allocate(VkDescriptorSetLayout descriptorSetLayout)
+    {
+        return allocators[jobSystem.getThreadIndex()][frameIndex]->allocate(descriptorSetLayout);
+    }
+
+    GenDescriptorAllocator::Stats GenFrameDescriptorAllocator::getStats() const
+    {
+        GenDescriptorAllocator::Stats total{};
+        for (const auto &thread : allocators)
+        {
+            for (const auto &allocator : thread)
+            {
+                const auto &stats = allocator->getStats();
+                total.allocations += stats.allocations;
+                total.poolCount += stats.poolCount;
+                total.growths += stats.growths;
+                total.resets += stats.resets;
+            }
+        }
+        return total;
+    }
+
     // *************** Descriptor Writer *********************
 
     GenDescriptorWriter::GenDescriptorWriter(GenDescriptorSetLayout &setLayout, GenDescriptorPool &pool)
-        : setLayout{setLayout}, pool{pool} {}
+        : setLayout{setLayout}, pool{&pool} {}
+
+    GenDescriptorWriter::GenDescriptorWriter(GenDescriptorSetLayout &setLayout, GenDescriptorAllocator &allocator)
+        : setLayout{setLayout}, allocator{&allocator} {}
+
+    GenDescriptorWriter::GenDescriptorWriter(GenDescriptorSetLayout &setLayout, GenFrameDescriptorAllocator &frameAllocator)
+        : setLayout{setLayout}, frameAllocator{&frameAllocator} {}
 
     GenDescriptorWriter &GenDescriptorWriter::writeBuffer(
         uint32_t binding, VkDescriptorBufferInfo *bufferInfo)
@@ -198,8 +329,15 @@ namespace gen
 
     bool GenDescriptorWriter::build(VkDescriptorSet &set)
     {
-        bool success = pool.allocateDescriptor(setLayout.getDescriptorSetLayout(), set);
-        if (!success)
+        if (allocator != nullptr)
+        {
+            set = allocator->allocate(setLayout.getDescriptorSetLayout());
+        }
+        else if (frameAllocator != nullptr)
+        {
+            set = frameAllocator->allocate(setLayout.getDescriptorSetLayout());
+        }
+        else if (!pool->allocateDescriptor(setLayout.getDescriptorSetLayout(), set))
         {
             return false;
         }
@@ -213,7 +351,7 @@ namespace gen
         {
             write.dstSet = set;
         }
-        vkUpdateDescriptorSets(pool.genDevice.device(), writes.size(), writes.data(), 0, nullptr);
+        vkUpdateDescriptorSets(setLayout.genDevice.device(), writes.size(), writes.data(), 0, nullptr);
     }
 
 } // namespace gen
\ No newline at end of file
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "gen_device.hpp"
+#include "gen_job_system.hpp"
+#include "gen_swap_chain.hpp"
 
 // std
+#include <array>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -74,6 +77,7 @@ namespace gen
         GenDescriptorPool(const GenDescriptorPool &) = delete;
         GenDescriptorPool &operator=(const GenDescriptorPool &) = delete;
 
+        // false once the pool is exhausted or too fragmented, GenDescriptorAllocator chains pools to handle that
         bool allocateDescriptor(
             const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet &descriptor) const;
 
@@ -88,10 +92,94 @@ namespace gen
         friend class GenDescriptorWriter;
     };
 
+    // Allocates descriptor sets from a chain of pools. When the current pool runs out of memory or is too
+    // fragmented the next one is taken, or created with twice the sets of the last. reset returns every set
+    // at once and keeps the pools for reuse. Not thread safe.
+    class GenDescriptorAllocator
+    {
+    public:
+        // descriptors of a type per set, a pool for n sets holds ratio * n of them
+        struct PoolSizeRatio
+        {
+            VkDescriptorType type;
+            float ratio;
+        };
+
+        struct Stats
+        {
+            uint64_t allocations = 0;
+            uint32_t poolCount = 0;
+            // pools created because the existing ones ran out
+            uint32_t growths = 0;
+            // of allocators holding sets, resetting an unused one is free and not counted
+            uint64_t resets = 0;
+        };
+
+        static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
+        // no pool is created before the first allocation
+        GenDescriptorAllocator(GenDevice &genDevice, uint32_t initialSetsPerPool, const std::vector<PoolSizeRatio> &ratios);
+        GenDescriptorAllocator(const GenDescriptorAllocator &) = delete;
+        GenDescriptorAllocator &operator=(const GenDescriptorAllocator &) = delete;
+
+        // throws if the set doesn't fit even into a fresh pool
+        VkDescriptorSet allocate(VkDescriptorSetLayout descriptorSetLayout);
+        // every set allocated so far becomes invalid, none of them may still be in use by the gpu
+        void reset();
+
+        const Stats &getStats() const { return stats; }
+
+    private:
+        std::unique_ptr<GenDescriptorPool> takePool();
+
+        GenDevice &genDevice;
+        std::vector<PoolSizeRatio> ratios;
+        uint32_t nextPoolSets;
+        std::unique_ptr<GenDescriptorPool> currentPool{};
+        std::vector<std::unique_ptr<GenDescriptorPool>> fullPools{};
+        // reset pools waiting to be used again
+        std::vector<std::unique_ptr<GenDescriptorPool>> readyPools{};
+        Stats stats{};
+    };
+
+    // Transient descriptor sets that live for one frame. Every job system thread owns one allocator per frame in
+    // flight, like the parallel recorder's command pools, so allocating while recording on several threads needs
+    // no locking. beginFrame resets a frame's allocators in bulk once its fence has signaled.
+    class GenFrameDescriptorAllocator
+    {
+    public:
+        GenFrameDescriptorAllocator(
+            GenDevice &genDevice,
+            GenJobSystem &jobSystem,
+            uint32_t initialSetsPerPool,
+            const std::vector<GenDescriptorAllocator::PoolSizeRatio> &ratios);
+
+        GenFrameDescriptorAllocator(const GenFrameDescriptorAllocator &) = delete;
+        GenFrameDescriptorAllocator &operator=(const GenFrameDescriptorAllocator &) = delete;
+
+        // the frame's previous submission must have completed
+        void beginFrame(int frameIndex);
+        // from any job system thread, the set is valid until this frame index begins again
+        VkDescriptorSet allocate(VkDescriptorSetLayout descriptorSetLayout);
+
+        // summed over every thread and frame, call while no thread allocates
+        GenDescriptorAllocator::Stats getStats() const;
+
+    private:
+        GenJobSystem &jobSystem;
+        // indexed by job system thread index, then frame index
+        std::vector<std::array<std::unique_ptr<GenDescriptorAllocator>, GenSwapChain::MAX_FRAMES_IN_FLIGHT>> allocators;
+        int frameIndex = 0;
+    };
+
     class GenDescriptorWriter
     {
     public:
         GenDescriptorWriter(GenDescriptorSetLayout &setLayout, GenDescriptorPool &pool);
+        // build allocates from allocator, it only fails by throwing
+        GenDescriptorWriter(GenDescriptorSetLayout &setLayout, GenDescriptorAllocator &allocator);
+        // build allocates a set valid for the current frame
+        GenDescriptorWriter(GenDescriptorSetLayout &setLayout, GenFrameDescriptorAllocator &frameAllocator);
 
         GenDescriptorWriter &writeBuffer(uint32_t binding, VkDescriptorBufferInfo *bufferInfo);
         GenDescriptorWriter &writeImage(uint32_t binding, VkDescriptorImageInfo *imageInfo);
@@ -101,7 +189,10 @@ namespace gen
 
     private:
         GenDescriptorSetLayout &setLayout;
-        GenDescriptorPool &pool;
+        // exactly one of them is set
+        GenDescriptorPool *pool = nullptr;
+        GenDescriptorAllocator *allocator = nullptr;
+        GenFrameDescriptorAllocator *frameAllocator = nullptr;
         std::vector<VkWriteDescriptorSet> writes;
     };
 
@@ -1,9 +1,12 @@
 #include "gen_device.hpp"
 
 // std headers
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <limits>
 #include <set>
+#include <stdexcept>
 #include <unordered_set>
 
 namespace gen
@@ -67,6 +70,10 @@ namespace gen
 
   GenDevice::~GenDevice()
   {
+    // everything else is gone by now, nothing will complete the frames still queued
+    vkDeviceWaitIdle(device_);
+    completeFrame(std::numeric_limits<uint64_t>::max());
+
     vkDestroyCommandPool(device_, commandPool, nullptr);
     vkDestroyDevice(device_, nullptr);
 
@@ -75,7 +82,10 @@ namespace gen
       DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
     }
 
-    vkDestroySurfaceKHR(instance, surface_, nullptr);
+    if (surface_ != VK_NULL_HANDLE)
+    {
+      vkDestroySurfaceKHR(instance, surface_, nullptr);
+    }
     vkDestroyInstance(instance, nullptr);
   }
 
@@ -92,7 +102,8 @@ namespace gen
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "GurbeEngine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    // 1.1 for vkGetPhysicalDeviceFeatures2 and maintenance3, which descriptor indexing builds on
+    appInfo.apiVersion = VK_API_VERSION_1_1;
 
     VkInstanceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -175,16 +186,99 @@ namespace gen
       queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
     VkPhysicalDeviceFeatures deviceFeatures = {};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
+    // optional, only used for profiling
+    deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+    // optional, GenTexture only accepts BC compressed data if enabled
+    deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+    enabledFeatures = deviceFeatures;
+
+    // optional, bindless resources need runtime sized, partially bound arrays that can be updated while bound
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT supportedIndexing{};
+    supportedIndexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    // optional, barriers recorded by cmdPipelineBarrier2 are translated to the original entry point without it
+    VkPhysicalDeviceSynchronization2FeaturesKHR supportedSynchronization2{};
+    supportedSynchronization2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+    supportedSynchronization2.pNext = &supportedIndexing;
+    VkPhysicalDeviceFeatures2 supportedFeatures2{};
+    supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures2.pNext = &supportedSynchronization2;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures2);
+    bindlessSupported =
+        isDeviceExtensionSupported(physicalDevice, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) &&
+        supportedIndexing.runtimeDescriptorArray &&
+        supportedIndexing.descriptorBindingPartiallyBound &&
+        supportedIndexing.descriptorBindingVariableDescriptorCount &&
+        supportedIndexing.descriptorBindingStorageBufferUpdateAfterBind &&
+        supportedIndexing.descriptorBindingSampledImageUpdateAfterBind &&
+        supportedIndexing.descriptorBindingUpdateUnusedWhilePending &&
+        supportedIndexing.shaderStorageBufferArrayNonUniformIndexing &&
+        supportedIndexing.shaderSampledImageArrayNonUniformIndexing;
+
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures{};
+    indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    indexingFeatures.runtimeDescriptorArray = bindlessSupported;
+    indexingFeatures.descriptorBindingPartiallyBound = bindlessSupported;
+    indexingFeatures.descriptorBindingVariableDescriptorCount = bindlessSupported;
+    indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = bindlessSupported;
+    indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = bindlessSupported;
+    indexingFeatures.descriptorBindingUpdateUnusedWhilePending = bindlessSupported;
+    indexingFeatures.shaderStorageBufferArrayNonUniformIndexing = bindlessSupported;
+    indexingFeatures.shaderSampledImageArrayNonUniformIndexing = bindlessSupported;
+
+    if (bindlessSupported)
+    {
+      descriptorIndexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+      VkPhysicalDeviceProperties2 properties2{};
+      properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+      properties2.pNext = &descriptorIndexingProperties;
+      vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+      descriptorIndexingProperties.pNext = nullptr;
+    }
+
+    synchronization2Supported =
+        isDeviceExtensionSupported(physicalDevice, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME) &&
+        supportedSynchronization2.synchronization2;
+    VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features{};
+    synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+    synchronization2Features.synchronization2 = synchronization2Supported;
+    synchronization2Features.pNext = bindlessSupported ? &indexingFeatures : nullptr;
 
     VkDeviceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    if (synchronization2Supported)
+    {
+      createInfo.pNext = &synchronization2Features;
+    }
+    else
+    {
+      createInfo.pNext = bindlessSupported ? &indexingFeatures : nullptr;
+    }
 
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
     createInfo.pEnabledFeatures = &deviceFeatures;
+    auto deviceExtensions = getRequiredDeviceExtensions();
+    if (bindlessSupported)
+    {
+      deviceExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+    }
+    if (synchronization2Supported)
+    {
+      deviceExtensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+    }
+    // optional, only queried by getMemoryBudgets
+    memoryBudgetSupported = isDeviceExtensionSupported(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (memoryBudgetSupported)
+    {
+      deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
     createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
     createInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
@@ -207,6 +301,14 @@ namespace gen
 
     vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
     vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+    // an extension entry point, the loader doesn't export it
+    if (synchronization2Supported)
+    {
+      cmdPipelineBarrier2KHR = reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(
+          vkGetDeviceProcAddr(device_, "vkCmdPipelineBarrier2KHR"));
+      synchronization2Supported = cmdPipelineBarrier2KHR != nullptr;
+    }
   }
 
   void GenDevice::createCommandPool()
@@ -225,7 +327,13 @@ namespace gen
     }
   }
 
-  void GenDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
+  void GenDevice::createSurface()
+  {
+    if (!isHeadless())
+    {
+      window.createWindowSurface(instance, &surface_);
+    }
+  }
 
   bool GenDevice::isDeviceSuitable(VkPhysicalDevice device)
   {
@@ -233,8 +341,9 @@ namespace gen
 
     bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-    bool swapChainAdequate = false;
-    if (extensionsSupported)
+    // headless rendering never presents
+    bool swapChainAdequate = isHeadless();
+    if (extensionsSupported && !isHeadless())
     {
       SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
       swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
@@ -305,11 +414,15 @@ namespace gen
 
   std::vector<const char *> GenDevice::getRequiredExtensions()
   {
-    uint32_t glfwExtensionCount = 0;
-    const char **glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-    std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    std::vector<const char *> extensions;
+    // GLFW isn't initialized when headless
+    if (!isHeadless())
+    {
+      uint32_t glfwExtensionCount = 0;
+      const char **glfwExtensions;
+      glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+      extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
 
     if (enableValidationLayers)
     {
@@ -346,6 +459,15 @@ namespace gen
     }
   }
 
+  std::vector<const char *> GenDevice::getRequiredDeviceExtensions()
+  {
+    if (isHeadless())
+    {
+      return {};
+    }
+    return {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+  }
+
   bool GenDevice::checkDeviceExtensionSupport(VkPhysicalDevice device)
   {
     uint32_t extensionCount;
@@ -358,6 +480,7 @@ namespace gen
         &extensionCount,
         availableExtensions.data());
 
+    auto deviceExtensions = getRequiredDeviceExtensions();
     std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
 
     for (const auto &extension : availableExtensions)
@@ -368,6 +491,24 @@ namespace gen
     return requiredExtensions.empty();
   }
 
+  bool GenDevice::isDeviceExtensionSupported(VkPhysicalDevice device, const char *extensionName)
+  {
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+    for (const auto &extension : availableExtensions)
+    {
+      if (std::string{extension.extensionName} == extensionName)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
   QueueFamilyIndices GenDevice::findQueueFamilies(VkPhysicalDevice device)
   {
     QueueFamilyIndices indices;
@@ -384,10 +525,19 @@ namespace gen
       if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
       {
         indices.graphicsFamily = i;
+        indices.graphicsTimestampValidBits = queueFamily.timestampValidBits;
         indices.graphicsFamilyHasValue = true;
       }
       VkBool32 presentSupport = false;
-      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+      if (isHeadless())
+      {
+        // nothing is presented, the graphics queue stands in for the present queue
+        presentSupport = indices.graphicsFamilyHasValue && indices.graphicsFamily == static_cast<uint32_t>(i);
+      }
+      else
+      {
+        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+      }
       if (queueFamily.queueCount > 0 && presentSupport)
       {
         indices.presentFamily = i;
@@ -454,6 +604,13 @@ namespace gen
     throw std::runtime_error("failed to find supported format!");
   }
 
+  VkFormatProperties GenDevice::getFormatProperties(VkFormat format)
+  {
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+    return props;
+  }
+
   uint32_t GenDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
   {
     VkPhysicalDeviceMemoryProperties memProperties;
@@ -491,12 +648,8 @@ namespace gen
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
+    bufferMemory = allocateMemory(memRequirements, properties);
+    if (bufferMemory == VK_NULL_HANDLE)
     {
       throw std::runtime_error("failed to allocate vertex buffer memory!");
     }
@@ -536,6 +689,8 @@ namespace gen
     vkQueueWaitIdle(graphicsQueue_);
 
     vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
+    // the queue is idle, so every frame submitted so far has completed
+    completeFrame(getRecordingFrame() - 1);
   }
 
   void GenDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
@@ -593,12 +748,8 @@ namespace gen
     VkMemoryRequirements memRequirements;
     vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
+    imageMemory = allocateMemory(memRequirements, properties);
+    if (imageMemory == VK_NULL_HANDLE)
     {
       throw std::runtime_error("failed to allocate image memory!");
     }
@@ -609,4 +760,274 @@ namespace gen
     }
   }
 
-} // namespace gen
\ No newline at end of file
+  VkDeviceMemory GenDevice::allocateMemory(
+      const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties)
+  {
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+
+    VkDeviceMemory memory;
+    if (vkAllocateMemory(device_, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+    {
+      return VK_NULL_HANDLE;
+    }
+
+    uint32_t heapIndex = memoryProperties.memoryTypes[allocInfo.memoryTypeIndex].heapIndex;
+    {
+      std::lock_guard<std::mutex> lock{allocationMutex};
+      allocations[memory] = {requirements.size, heapIndex};
+    }
+    allocatedMemory += requirements.size;
+    heapAllocatedMemory[heapIndex] += requirements.size;
+    allocationCount++;
+    return memory;
+  }
+
+  void GenDevice::freeMemory(VkDeviceMemory memory)
+  {
+    if (memory == VK_NULL_HANDLE)
+    {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock{allocationMutex};
+      auto it = allocations.find(memory);
+      if (it != allocations.end())
+      {
+        allocatedMemory -= it->second.size;
+        heapAllocatedMemory[it->second.heapIndex] -= it->second.size;
+        allocationCount--;
+        allocations.erase(it);
+      }
+    }
+    vkFreeMemory(device_, memory, nullptr);
+  }
+
+  void GenDevice::cmdPipelineBarrier2(VkCommandBuffer commandBuffer, const VkDependencyInfoKHR &dependencyInfo)
+  {
+    if (synchronization2Supported)
+    {
+      cmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+      return;
+    }
+
+    // the original entry point takes one pair of stage masks for all barriers. The stage and access bits it knows
+    // have the same values in the 64 bit flags
+    VkPipelineStageFlags srcStageMask = 0;
+    VkPipelineStageFlags dstStageMask = 0;
+    std::vector<VkMemoryBarrier> memoryBarriers(dependencyInfo.memoryBarrierCount);
+    for (uint32_t i = 0; i < dependencyInfo.memoryBarrierCount; i++)
+    {
+      const auto &barrier = dependencyInfo.pMemoryBarriers[i];
+      srcStageMask |= static_cast<VkPipelineStageFlags>(barrier.srcStageMask);
+      dstStageMask |= static_cast<VkPipelineStageFlags>(barrier.dstStageMask);
+      memoryBarriers[i].sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+      memoryBarriers[i].srcAccessMask = static_cast<VkAccessFlags>(barrier.srcAccessMask);
+      memoryBarriers[i].dstAccessMask = static_cast<VkAccessFlags>(barrier.dstAccessMask);
+    }
+    std::vector<VkBufferMemoryBarrier> bufferBarriers(dependencyInfo.bufferMemoryBarrierCount);
+    for (uint32_t i = 0; i < dependencyInfo.bufferMemoryBarrierCount; i++)
+    {
+      const auto &barrier = dependencyInfo.pBufferMemoryBarriers[i];
+      srcStageMask |= static_cast<VkPipelineStageFlags>(barrier.srcStageMask);
+      dstStageMask |= static_cast<VkPipelineStageFlags>(barrier.dstStageMask);
+      bufferBarriers[i].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+      bufferBarriers[i].srcAccessMask = static_cast<VkAccessFlags>(barrier.srcAccessMask);
+      bufferBarriers[i].dstAccessMask = static_cast<VkAccessFlags>(barrier.dstAccessMask);
+      bufferBarriers[i].srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+      bufferBarriers[i].dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+      bufferBarriers[i].buffer = barrier.buffer;
+      bufferBarriers[i].offset = barrier.offset;
+      bufferBarriers[i].size = barrier.size;
+    }
+    std::vector<VkImageMemoryBarrier> imageBarriers(dependencyInfo.imageMemoryBarrierCount);
+    for (uint32_t i = 0; i < dependencyInfo.imageMemoryBarrierCount; i++)
+    {
+      const auto &barrier = dependencyInfo.pImageMemoryBarriers[i];
+      srcStageMask |= static_cast<VkPipelineStageFlags>(barrier.srcStageMask);
+      dstStageMask |= static_cast<VkPipelineStageFlags>(barrier.dstStageMask);
+      imageBarriers[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+      imageBarriers[i].srcAccessMask = static_cast<VkAccessFlags>(barrier.srcAccessMask);
+      imageBarriers[i].dstAccessMask = static_cast<VkAccessFlags>(barrier.dstAccessMask);
+      imageBarriers[i].oldLayout = barrier.oldLayout;
+      imageBarriers[i].newLayout = barrier.newLayout;
+      imageBarriers[i].srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+      imageBarriers[i].dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+      imageBarriers[i].image = barrier.image;
+      imageBarriers[i].subresourceRange = barrier.subresourceRange;
+    }
+
+    // no stages means nothing to wait for, or nothing waiting
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        srcStageMask != 0 ? srcStageMask : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        dstStageMask != 0 ? dstStageMask : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        dependencyInfo.dependencyFlags,
+        static_cast<uint32_t>(memoryBarriers.size()),
+        memoryBarriers.data(),
+        static_cast<uint32_t>(bufferBarriers.size()),
+        bufferBarriers.data(),
+        static_cast<uint32_t>(imageBarriers.size()),
+        imageBarriers.data());
+  }
+
+  void GenDevice::destroyDeferred(VkObjectType type, uint64_t handle)
+  {
+    if (handle == 0)
+    {
+      return;
+    }
+
+    if (type == VK_OBJECT_TYPE_DEVICE_MEMORY)
+    {
+      std::lock_guard<std::mutex> lock{allocationMutex};
+      auto it = allocations.find(reinterpret_cast<VkDeviceMemory>(handle));
+      if (it != allocations.end())
+      {
+        heapPendingFree[it->second.heapIndex] += it->second.size;
+      }
+    }
+
+    std::lock_guard<std::mutex> lock{deletionMutex};
+    pendingDeletions.push_back({getRecordingFrame(), type, handle});
+    deferredDeletions++;
+  }
+
+  void GenDevice::advanceRecordingFrame()
+  {
+    // under the lock, so deletions queued concurrently keep the queue ordered
+    std::lock_guard<std::mutex> lock{deletionMutex};
+    recordingFrame++;
+  }
+
+  void GenDevice::completeFrame(uint64_t frame)
+  {
+    std::vector<PendingDeletion> ready{};
+    {
+      std::lock_guard<std::mutex> lock{deletionMutex};
+      if (frame <= completedFrame)
+      {
+        return;
+      }
+      completedFrame = frame;
+      while (!pendingDeletions.empty() && pendingDeletions.front().frame <= frame)
+      {
+        ready.push_back(pendingDeletions.front());
+        pendingDeletions.pop_front();
+      }
+    }
+
+    for (const auto &deletion : ready)
+    {
+      destroyHandle(deletion.type, deletion.handle);
+    }
+  }
+
+  size_t GenDevice::getPendingDeletionCount()
+  {
+    std::lock_guard<std::mutex> lock{deletionMutex};
+    return pendingDeletions.size();
+  }
+
+  void GenDevice::destroyHandle(VkObjectType type, uint64_t handle)
+  {
+    switch (type)
+    {
+    case VK_OBJECT_TYPE_BUFFER:
+      vkDestroyBuffer(device_, reinterpret_cast<VkBuffer>(handle), nullptr);
+      break;
+    case VK_OBJECT_TYPE_IMAGE:
+      vkDestroyImage(device_, reinterpret_cast<VkImage>(handle), nullptr);
+      break;
+    case VK_OBJECT_TYPE_IMAGE_VIEW:
+      vkDestroyImageView(device_, reinterpret_cast<VkImageView>(handle), nullptr);
+      break;
+    case VK_OBJECT_TYPE_DEVICE_MEMORY:
+    {
+      auto memory = reinterpret_cast<VkDeviceMemory>(handle);
+      {
+        std::lock_guard<std::mutex> lock{allocationMutex};
+        auto it = allocations.find(memory);
+        if (it != allocations.end())
+        {
+          heapPendingFree[it->second.heapIndex] -= it->second.size;
+        }
+      }
+      freeMemory(memory);
+      break;
+    }
+    case VK_OBJECT_TYPE_PIPELINE:
+      vkDestroyPipeline(device_, reinterpret_cast<VkPipeline>(handle), nullptr);
+      break;
+    case VK_OBJECT_TYPE_DESCRIPTOR_POOL:
+      vkDestroyDescriptorPool(device_, reinterpret_cast<VkDescriptorPool>(handle), nullptr);
+      break;
+    case VK_OBJECT_TYPE_FRAMEBUFFER:
+      vkDestroyFramebuffer(device_, reinterpret_cast<VkFramebuffer>(handle), nullptr);
+      break;
+    case VK_OBJECT_TYPE_RENDER_PASS:
+      vkDestroyRenderPass(device_, reinterpret_cast<VkRenderPass>(handle), nullptr);
+      break;
+    case VK_OBJECT_TYPE_SWAPCHAIN_KHR:
+      vkDestroySwapchainKHR(device_, reinterpret_cast<VkSwapchainKHR>(handle), nullptr);
+      break;
+    default:
+      throw std::runtime_error("unsupported object type for deferred destruction!");
+    }
+  }
+
+  std::vector<MemoryHeapBudget> GenDevice::getMemoryBudgets()
+  {
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    if (memoryBudgetSupported)
+    {
+      VkPhysicalDeviceMemoryProperties2 properties2{};
+      properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+      properties2.pNext = &budgetProperties;
+      vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &properties2);
+    }
+
+    std::vector<MemoryHeapBudget> budgets(memoryProperties.memoryHeapCount);
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+    {
+      auto &budget = budgets[i];
+      budget.size = memoryProperties.memoryHeaps[i].size;
+      budget.deviceLocal = (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+      if (memoryBudgetSupported)
+      {
+        budget.budget = budgetProperties.heapBudget[i];
+        budget.usage = budgetProperties.heapUsage[i];
+      }
+      else
+      {
+        // the driver, other processes and the os need some of it too
+        budget.budget = budget.size / 10 * 8;
+        budget.usage = heapAllocatedMemory[i].load(std::memory_order_relaxed);
+      }
+      budget.pendingFree = std::min(budget.usage, heapPendingFree[i].load(std::memory_order_relaxed));
+    }
+    return budgets;
+  }
+
+  MemoryHeapBudget GenDevice::getDeviceLocalBudget()
+  {
+    MemoryHeapBudget total{};
+    total.deviceLocal = true;
+    for (const auto &budget : getMemoryBudgets())
+    {
+      if (budget.deviceLocal)
+      {
+        total.size += budget.size;
+        total.budget += budget.budget;
+        total.usage += budget.usage;
+        total.pendingFree += budget.pendingFree;
+      }
+    }
+    return total;
+  }
+
+} // namespace gen
@@ -3,7 +3,12 @@
 #include "gen_window.hpp"
 
 // std lib headers
+#include <array>
+#include <atomic>
+#include <deque>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace gen
@@ -20,11 +25,23 @@ namespace gen
   {
     uint32_t graphicsFamily;
     uint32_t presentFamily;
+    uint32_t graphicsTimestampValidBits = 0; // 0 if the graphics queue can't write timestamps
     bool graphicsFamilyHasValue = false;
     bool presentFamilyHasValue = false;
     bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
   };
 
+  struct MemoryHeapBudget
+  {
+    VkDeviceSize size = 0;
+    // how much this process can allocate from the heap without risking failures or paging
+    VkDeviceSize budget = 0;
+    VkDeviceSize usage = 0;
+    // queued for deferred destruction, still part of usage until its frame completes
+    VkDeviceSize pendingFree = 0;
+    bool deviceLocal = false;
+  };
+
   class GenDevice
   {
   public:
@@ -43,10 +60,22 @@ namespace gen
     GenDevice(GenDevice &&) = delete;
     GenDevice &operator=(GenDevice &&) = delete;
 
+    // no surface and no swap chain extension, any device with a graphics queue will do, including software
+    // implementations like lavapipe
+    bool isHeadless() const { return window.isHeadless(); }
+
+    // descriptor indexing with partially bound, update after bind arrays, see GenBindlessDescriptors
+    bool supportsBindless() const { return bindlessSupported; }
+    // VK_EXT_memory_budget, without it getMemoryBudgets estimates from the engine's own allocation totals
+    bool supportsMemoryBudget() const { return memoryBudgetSupported; }
+    // VK_KHR_synchronization2, see cmdPipelineBarrier2
+    bool supportsSynchronization2() const { return synchronization2Supported; }
+
     VkCommandPool getCommandPool() { return commandPool; }
     VkDevice device() { return device_; }
     VkSurfaceKHR surface() { return surface_; }
     VkQueue graphicsQueue() { return graphicsQueue_; }
+    // the graphics queue when headless
     VkQueue presentQueue() { return presentQueue_; }
 
     SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
@@ -54,6 +83,7 @@ namespace gen
     QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
     VkFormat findSupportedFormat(
         const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
+    VkFormatProperties getFormatProperties(VkFormat format);
 
     // Buffer Helper Functions
     void createBuffer(
@@ -73,8 +103,48 @@ namespace gen
         VkMemoryPropertyFlags properties,
         VkImage &image,
         VkDeviceMemory &imageMemory);
+    // for memory shared by several resources, VK_NULL_HANDLE if the allocation failed. Free with freeMemory
+    VkDeviceMemory allocateMemory(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties);
+
+    // records the barriers with vkCmdPipelineBarrier2KHR, or translated to vkCmdPipelineBarrier on devices without
+    // VK_KHR_synchronization2. Only stage and access flags the original entry point knows can be translated
+    void cmdPipelineBarrier2(VkCommandBuffer commandBuffer, const VkDependencyInfoKHR &dependencyInfo);
+
+    // frees memory allocated by createBuffer or createImageWithInfo and keeps the allocation totals current
+    void freeMemory(VkDeviceMemory memory);
+    // device memory currently allocated through this device, in bytes
+    VkDeviceSize getAllocatedMemory() const { return allocatedMemory.load(std::memory_order_relaxed); }
+    uint32_t getAllocationCount() const { return allocationCount.load(std::memory_order_relaxed); }
+    // one entry per memory heap. Queried from the driver when VK_EXT_memory_budget is supported, which also
+    // sees memory not allocated through this device. Otherwise the usage is what this device allocated and the
+    // budget a fixed share of the heap size
+    std::vector<MemoryHeapBudget> getMemoryBudgets();
+    // summed over all device local heaps
+    MemoryHeapBudget getDeviceLocalBudget();
+
+    // Deferred destruction. Handles may still be used by frames in flight, so they are queued with the frame
+    // being recorded and destroyed once that frame has completed; resources can go away during gameplay without
+    // waiting for the device. Supports buffers, images, image views, device memory, pipelines, descriptor pools,
+    // framebuffers, render passes and swap chains. From any thread
+    void destroyDeferred(VkObjectType type, uint64_t handle);
+    template <typename Handle>
+    void destroyDeferred(VkObjectType type, Handle handle)
+    {
+      destroyDeferred(type, reinterpret_cast<uint64_t>(handle));
+    }
+    // frames are numbered by GenRenderer, every frame recorded so far has a number up to this one
+    uint64_t getRecordingFrame() const { return recordingFrame.load(std::memory_order_acquire); }
+    // once the recording frame was submitted
+    void advanceRecordingFrame();
+    // once the fence of frame signaled, destroys everything queued up to it
+    void completeFrame(uint64_t frame);
+    size_t getPendingDeletionCount();
+    uint64_t getDeferredDeletionCount() const { return deferredDeletions.load(std::memory_order_relaxed); }
 
     VkPhysicalDeviceProperties properties;
+    VkPhysicalDeviceFeatures enabledFeatures{};
+    // limits of the update after bind descriptor arrays, only filled in if bindless is supported
+    VkPhysicalDeviceDescriptorIndexingPropertiesEXT descriptorIndexingProperties{};
 
   private:
     void createInstance();
@@ -87,12 +157,15 @@ namespace gen
     // helper functions
     bool isDeviceSuitable(VkPhysicalDevice device);
     std::vector<const char *> getRequiredExtensions();
+    std::vector<const char *> getRequiredDeviceExtensions();
     bool checkValidationLayerSupport();
     QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
     void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
     void hasGflwRequiredInstanceExtensions();
     bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+    bool isDeviceExtensionSupported(VkPhysicalDevice device, const char *extensionName);
     SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
+    void destroyHandle(VkObjectType type, uint64_t handle);
 
     VkInstance instance;
     VkDebugUtilsMessengerEXT debugMessenger;
@@ -101,12 +174,44 @@ namespace gen
     VkCommandPool commandPool;
 
     VkDevice device_;
-    VkSurfaceKHR surface_;
+    VkSurfaceKHR surface_ = VK_NULL_HANDLE;
     VkQueue graphicsQueue_;
     VkQueue presentQueue_;
+    bool bindlessSupported = false;
+    bool memoryBudgetSupported = false;
+    bool synchronization2Supported = false;
+    PFN_vkCmdPipelineBarrier2KHR cmdPipelineBarrier2KHR = nullptr;
+    VkPhysicalDeviceMemoryProperties memoryProperties{};
+
+    struct Allocation
+    {
+      VkDeviceSize size;
+      uint32_t heapIndex;
+    };
+
+    // sizes of live allocations, buffers and images may be created from several threads
+    std::mutex allocationMutex;
+    std::unordered_map<VkDeviceMemory, Allocation> allocations;
+    std::atomic<VkDeviceSize> allocatedMemory{0};
+    std::array<std::atomic<VkDeviceSize>, VK_MAX_MEMORY_HEAPS> heapAllocatedMemory{};
+    std::array<std::atomic<VkDeviceSize>, VK_MAX_MEMORY_HEAPS> heapPendingFree{};
+
+    struct PendingDeletion
+    {
+      uint64_t frame;
+      VkObjectType type;
+      uint64_t handle;
+    };
+
+    // ordered by frame, the recording frame only grows
+    std::mutex deletionMutex;
+    std::deque<PendingDeletion> pendingDeletions;
+    std::atomic<uint64_t> recordingFrame{1};
+    uint64_t completedFrame = 0;
+    std::atomic<uint64_t> deferredDeletions{0};
+    std::atomic<uint32_t> allocationCount{0};
 
     const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
-    const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
   };
 
 } // namespace gen
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "gen_dynamic_resolution.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+
+namespace gen
+{
+    GenDynamicResolution::GenDynamicResolution(const Settings &settings)
+    {
+        setSettings(settings);
+    }
+
+    void GenDynamicResolution::setSettings(const Settings &newSettings)
+    {
+        settings = newSettings;
+        scale = clampScale(scale);
+    }
+
+    bool GenDynamicResolution::addGpuFrameTime(double gpuMs, double fixedMs)
+    {
+        // exponential moving average, a single slow frame doesn't drop the resolution
+        constexpr double smoothing = 0.2;
+        double scaledMs = std::max(gpuMs - fixedMs, 0.0);
+        bool first = stats.samples == 0;
+        smoothedScaledMs = first ? scaledMs : smoothedScaledMs + (scaledMs - smoothedScaledMs) * smoothing;
+        smoothedFixedMs = first ? fixedMs : smoothedFixedMs + (fixedMs - smoothedFixedMs) * smoothing;
+        stats.samples++;
+        stats.scaleSum += scale;
+
+        if (settleSamples > 0)
+        {
+            settleSamples--;
+            return false;
+        }
+
+        double target = settings.targetGpuMs;
+        double smoothedGpuMs = smoothedScaledMs + smoothedFixedMs;
+        bool tooSlow = smoothedGpuMs > target;
+        bool headroom = smoothedGpuMs < target * settings.raiseThreshold;
+        if (!tooSlow && !headroom)
+        {
+            return false;
+        }
+
+        // growing aims between the threshold and the target, so the next frames don't land right above it. Only
+        // what's left after the fixed cost is spread over the pixels
+        double aim = tooSlow ? target : target * (1.0 + settings.raiseThreshold) * 0.5;
+        double scaledAim = std::max(aim - smoothedFixedMs, 0.01);
+        float wanted = scale * static_cast<float>(std::sqrt(scaledAim / std::max(smoothedScaledMs, 0.01)));
+        wanted = std::clamp(wanted, scale * (1.f - settings.maxStep), scale * (1.f + settings.maxStep));
+        float newScale = clampScale(wanted);
+        if (newScale == scale)
+        {
+            return false;
+        }
+
+        // the time measured at the old scale, converted to the estimate for the new one
+        smoothedScaledMs *= static_cast<double>(newScale * newScale) / static_cast<double>(scale * scale);
+        scale = newScale;
+        settleSamples = SETTLE_SAMPLES;
+        stats.adjustments++;
+        stats.lowestScale = std::min(stats.lowestScale, scale);
+        return true;
+    }
+
+    float GenDynamicResolution::clampScale(float value) const
+    {
+        // rounded down, a scale that is too slow always drops by at least one step
+        float stepped = std::floor(value / SCALE_STEP) * SCALE_STEP;
+        return std::clamp(stepped, settings.minScale, settings.maxScale);
+    }
+}
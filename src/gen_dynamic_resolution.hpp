@@ -0,0 +1,69 @@
+#pragma once
+
+// std
+#include <cstdint>
+
+namespace gen
+{
+    // Picks the fraction of the output resolution the scene is rendered at from measured gpu frame times.
+    // Shading cost grows with the pixel count, so the scale moves by the square root of how far the smoothed frame
+    // time is from the target. Work at the output resolution, like the upscale, is reported apart and left out of
+    // that estimate. Frame times are only reported once a frame slot comes around again, so after every
+    // change the controller waits a few samples for the new scale to show up in them.
+    class GenDynamicResolution
+    {
+    public:
+        struct Settings
+        {
+            float minScale = 0.5f;
+            float maxScale = 1.f;
+            double targetGpuMs = 1000.0 / 60.0;
+            // the scale only grows again once frames are this much faster than the target, which keeps it from
+            // oscillating around the target
+            double raiseThreshold = 0.85;
+            // largest relative change of one adjustment
+            float maxStep = 0.1f;
+        };
+
+        struct Stats
+        {
+            uint64_t samples = 0;
+            uint64_t adjustments = 0;
+            float lowestScale = 1.f;
+            // sum of the scale at every sample, for the average
+            double scaleSum = 0.0;
+
+            double averageScale() const { return samples > 0 ? scaleSum / samples : 1.0; }
+        };
+
+        // samples ignored after an adjustment, more than the frames in flight
+        static constexpr uint32_t SETTLE_SAMPLES = 6;
+        // scales are multiples of this, small frame time noise doesn't cause changes
+        static constexpr float SCALE_STEP = 1.f / 64.f;
+
+        GenDynamicResolution() = default;
+        explicit GenDynamicResolution(const Settings &settings);
+
+        // clamps the current scale to the new bounds
+        void setSettings(const Settings &newSettings);
+        const Settings &getSettings() const { return settings; }
+
+        // one gpu frame time, returns true if the scale changed. fixedMs is the part of gpuMs that doesn't depend
+        // on the scale
+        bool addGpuFrameTime(double gpuMs, double fixedMs = 0.0);
+
+        float getScale() const { return scale; }
+        double getSmoothedGpuMs() const { return smoothedScaledMs + smoothedFixedMs; }
+        const Stats &getStats() const { return stats; }
+
+    private:
+        float clampScale(float value) const;
+
+        Settings settings{};
+        float scale = 1.f;
+        double smoothedScaledMs = 0.0;
+        double smoothedFixedMs = 0.0;
+        uint32_t settleSamples = 0;
+        Stats stats{};
+    };
+}
@@ -0,0 +1,46 @@
+#include "gen_frame_allocator.hpp"
+
+// std
+#include <algorithm>
+#include <stdexcept>
+
+namespace gen
+{
+
+    GenFrameAllocator::GenFrameAllocator(GenDevice &device, VkDeviceSize regionSize)
+        : offsetAlignment{std::max<VkDeviceSize>(device.properties.limits.minUniformBufferOffsetAlignment, 1)}
+    {
+        // one instance per frame in flight, padded by GenBuffer so every region starts aligned
+        buffer = std::make_unique<GenBuffer>(
+            device,
+            regionSize,
+            GenSwapChain::MAX_FRAMES_IN_FLIGHT,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            offsetAlignment);
+        this->regionSize = buffer->getAlignmentSize();
+        // coherent, so writes never need a flush
+        buffer->map();
+    }
+
+    void GenFrameAllocator::beginFrame(int frameIndex)
+    {
+        peakUsedBytes = std::max(peakUsedBytes, head.load(std::memory_order_relaxed));
+        regionBegin = regionSize * frameIndex;
+        head.store(0, std::memory_order_relaxed);
+    }
+
+    GenFrameAllocator::Allocation GenFrameAllocator::allocate(VkDeviceSize size)
+    {
+        VkDeviceSize alignedSize = GenBuffer::getAlignment(size, offsetAlignment);
+        VkDeviceSize offset = head.fetch_add(alignedSize, std::memory_order_relaxed);
+        if (offset + alignedSize > regionSize)
+        {
+            throw std::runtime_error("frame allocator region is full!");
+        }
+
+        VkDeviceSize bufferOffset = regionBegin + offset;
+        return {static_cast<char *>(buffer->getMappedMemory()) + bufferOffset, static_cast<uint32_t>(bufferOffset)};
+    }
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "gen_buffer.hpp"
+#include "gen_device.hpp"
+#include "gen_swap_chain.hpp"
+
+// std
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+namespace gen
+{
+    // Bump allocator for uniform data that only lives for one frame. A single persistently mapped buffer holds
+    // one region per frame in flight. Allocations are aligned to minUniformBufferOffsetAlignment and read
+    // through a VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC binding with the returned offset. A region is
+    // recycled as a whole in beginFrame, once its fence has signaled.
+    class GenFrameAllocator
+    {
+    public:
+        struct Allocation
+        {
+            void *data;
+            // pass to vkCmdBindDescriptorSets, includes the frame's region
+            uint32_t dynamicOffset;
+        };
+
+        static constexpr VkDeviceSize DEFAULT_REGION_SIZE = 4 * 1024 * 1024;
+
+        explicit GenFrameAllocator(GenDevice &device, VkDeviceSize regionSize = DEFAULT_REGION_SIZE);
+
+        GenFrameAllocator(const GenFrameAllocator &) = delete;
+        GenFrameAllocator &operator=(const GenFrameAllocator &) = delete;
+
+        // the frame's previous submission must have completed
+        void beginFrame(int frameIndex);
+
+        // from any thread, valid until this frame index begins again. Throws when the region is full
+        Allocation allocate(VkDeviceSize size);
+
+        template <typename T>
+        Allocation push(const T &value)
+        {
+            Allocation allocation = allocate(sizeof(T));
+            std::memcpy(allocation.data, &value, sizeof(T));
+            return allocation;
+        }
+
+        // for the dynamic uniform buffer binding, range is the size of what the shader reads at one offset
+        VkDescriptorBufferInfo descriptorInfo(VkDeviceSize range) const { return {buffer->getBuffer(), 0, range}; }
+
+        VkDeviceSize getRegionSize() const { return regionSize; }
+        // bytes used by the current frame so far and the most any frame has used
+        VkDeviceSize getUsedBytes() const { return head.load(std::memory_order_relaxed); }
+        VkDeviceSize getPeakUsedBytes() const { return peakUsedBytes; }
+
+    private:
+        std::unique_ptr<GenBuffer> buffer;
+        VkDeviceSize regionSize;
+        VkDeviceSize offsetAlignment;
+        std::atomic<VkDeviceSize> head{0};
+        VkDeviceSize regionBegin = 0;
+        VkDeviceSize peakUsedBytes = 0;
+    };
+}
@@ -2,6 +2,7 @@
 
 #include "gen_camera.hpp"
 #include "gen_game_object.hpp"
+#include "gen_job_system.hpp"
 
 // vulkan
 #include <vulkan/vulkan.h>
@@ -9,11 +10,12 @@
 namespace gen
 {
 
-#define MAX_LIGHTS 10
+// starting size of the per-frame light and billboard buffers, they grow to whatever light count a frame has
+#define INITIAL_LIGHT_CAPACITY 1024
 
     struct PointLight
     {
-        glm::vec4 position{}; // ignore w
+        glm::vec4 position{}; // w is range
         glm::vec4 color{};    // w is intensity
     };
     struct GlobalUbo
@@ -22,7 +24,9 @@ namespace gen
         glm::mat4 view{1.f};
         glm::mat4 inverseView{1.f};
         glm::vec4 ambientLightColor{1.f, 1.f, 1.f, .02f};
-        PointLight pointLights[MAX_LIGHTS];
+        glm::uvec4 clusterGrid{}; // xyz: number of clusters per axis, w: unused
+        glm::vec4 clusterDepth{}; // x: near, y: far, z: depth slice scale, w: depth slice bias
+        glm::vec2 screenSize{};
         int numLights;
     };
 
@@ -34,5 +38,12 @@ namespace gen
         GenCamera &camera;
         VkDescriptorSet globalDescriptorSet;
         GenGameObject::Map &gameObjects;
+        GenJobSystem &jobSystem;
+        // dynamic offset of this frame's GlobalUbo, binding 0 of the global set
+        uint32_t globalUboOffset = 0;
+        // of the scene's render targets
+        VkExtent2D extent{};
+        // draw commands recorded this frame, render systems add to it from the recording thread
+        uint32_t drawCalls = 0;
     };
-}
\ No newline at end of file
+}
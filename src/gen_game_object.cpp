@@ -61,13 +61,14 @@ namespace gen
         };
     }
 
-    GenGameObject GenGameObject::makePointLight(float intensity, float radius, glm::vec3 color)
+    GenGameObject GenGameObject::makePointLight(float intensity, float radius, glm::vec3 color, float range)
     {
         GenGameObject gameObj = GenGameObject::createGameObject();
         gameObj.color = color;
         gameObj.transform.scale.x = radius;
         gameObj.pointLight = std::make_unique<PointLightComponent>();
         gameObj.pointLight->lightIntensity = intensity;
+        gameObj.pointLight->range = range;
         return gameObj;
     }
 
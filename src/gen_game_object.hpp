@@ -1,6 +1,9 @@
 #pragma once
 
+#include "gen_asset_handle.hpp"
 #include "gen_model.hpp"
+#include "gen_texture.hpp"
+#include "gen_texture_streamer.hpp"
 
 // glm
 #include <glm/gtc/matrix_transform.hpp>
@@ -30,6 +33,13 @@ namespace gen
     struct PointLightComponent
     {
         float lightIntensity = 1.f;
+        float range = 5.f; // distance at which the light's contribution reaches zero, used for culling
+    };
+
+    // the object's model is drawn blended with this opacity instead of with the opaque geometry
+    struct TransparencyComponent
+    {
+        float alpha = 0.5f;
     };
 
     class GenGameObject
@@ -44,7 +54,7 @@ namespace gen
             return GenGameObject{currentId++};
         }
 
-        static GenGameObject makePointLight(float intensity = 10.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f));
+        static GenGameObject makePointLight(float intensity = 10.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f), float range = 5.f);
 
         GenGameObject(const GenGameObject &) = delete;
         GenGameObject &operator=(const GenGameObject &) = delete;
@@ -61,7 +71,15 @@ namespace gen
 
         // optional pointer components
         std::shared_ptr<GenModel> model{};
+        // an asynchronously loading model, moved into model by GenAssetManager::update once it's ready. Render
+        // systems skip objects without a model, so the object shows up when it is
+        std::shared_ptr<GenAssetHandle<GenModel>> modelHandle{};
+        // albedo multiplied with the vertex color by the opaque pass, white if not set
+        std::shared_ptr<GenTexture> texture{};
+        // takes the place of texture, its mips are streamed in by how large the object appears on screen
+        std::shared_ptr<GenStreamedTexture> streamedTexture{};
         std::unique_ptr<PointLightComponent> pointLight = nullptr;
+        std::unique_ptr<TransparencyComponent> transparency = nullptr;
 
     private:
         GenGameObject(id_t objId) : id{objId} {}
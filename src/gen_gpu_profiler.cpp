@@ -0,0 +1,250 @@
+#include "gen_gpu_profiler.hpp"
+
+#include "gen_swap_chain.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+namespace gen
+{
+
+    namespace
+    {
+        // nearest rank percentile of sorted samples
+        double percentile(const std::vector<double> &sorted, double fraction)
+        {
+            size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+            return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+        }
+    }
+
+    GenGpuProfiler::GenGpuProfiler(GenDevice &device) : genDevice{device}
+    {
+        uint32_t validBits = genDevice.findPhysicalQueueFamilies().graphicsTimestampValidBits;
+        if (validBits == 0)
+        {
+            return;
+        }
+
+        timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+        nanosecondsPerTick = genDevice.properties.limits.timestampPeriod;
+        frames.resize(GenSwapChain::MAX_FRAMES_IN_FLIGHT);
+        timestamps.resize(2 * MAX_QUERIES_PER_FRAME);
+
+        VkQueryPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = GenSwapChain::MAX_FRAMES_IN_FLIGHT * MAX_QUERIES_PER_FRAME;
+        if (vkCreateQueryPool(genDevice.device(), &poolInfo, nullptr, &queryPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create timestamp query pool!");
+        }
+    }
+
+    GenGpuProfiler::~GenGpuProfiler()
+    {
+        if (queryPool != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(genDevice.device(), queryPool, nullptr);
+        }
+    }
+
+    void GenGpuProfiler::collect(VkCommandBuffer commandBuffer, int frameIndex)
+    {
+        if (!isSupported())
+        {
+            return;
+        }
+
+        auto &frame = frames[frameIndex];
+        uint32_t firstQuery = static_cast<uint32_t>(frameIndex) * MAX_QUERIES_PER_FRAME;
+
+        if (frame.usedQueries > 0)
+        {
+            // each result is followed by its availability, so a frame that never executed is skipped
+            // instead of waited on
+            vkGetQueryPoolResults(
+                genDevice.device(),
+                queryPool,
+                firstQuery,
+                frame.usedQueries,
+                2 * sizeof(uint64_t) * frame.usedQueries,
+                timestamps.data(),
+                2 * sizeof(uint64_t),
+                VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+            for (const auto &scope : frame.scopes)
+            {
+                uint32_t begin = 2 * scope.beginQuery;
+                uint32_t end = begin + 2;
+                if (!scope.ended || timestamps[begin + 1] == 0 || timestamps[end + 1] == 0)
+                {
+                    continue;
+                }
+
+                uint64_t ticks = (timestamps[end] - timestamps[begin]) & timestampMask;
+                auto &history = histories[scope.history];
+                double milliseconds = ticks * nanosecondsPerTick / 1e6;
+                if (history.samplesMs.size() < SAMPLE_WINDOW)
+                {
+                    history.samplesMs.push_back(milliseconds);
+                }
+                else
+                {
+                    history.samplesMs[history.nextSample] = milliseconds;
+                }
+                history.nextSample = (history.nextSample + 1) % SAMPLE_WINDOW;
+                history.totalSamples++;
+            }
+        }
+
+        vkCmdResetQueryPool(commandBuffer, queryPool, firstQuery, MAX_QUERIES_PER_FRAME);
+        frame.scopes.clear();
+        frame.usedQueries = 0;
+        frame.reset = true;
+    }
+
+    uint32_t GenGpuProfiler::beginScope(VkCommandBuffer commandBuffer, int frameIndex, const char *name)
+    {
+        if (!isSupported())
+        {
+            return INVALID_SCOPE;
+        }
+
+        auto &frame = frames[frameIndex];
+        if (!frame.reset || frame.usedQueries + 2 > MAX_QUERIES_PER_FRAME)
+        {
+            return INVALID_SCOPE;
+        }
+
+        uint32_t query = frame.usedQueries;
+        frame.usedQueries += 2;
+        frame.scopes.push_back({findHistory(name), query, false});
+
+        vkCmdWriteTimestamp(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            queryPool,
+            static_cast<uint32_t>(frameIndex) * MAX_QUERIES_PER_FRAME + query);
+        return static_cast<uint32_t>(frame.scopes.size() - 1);
+    }
+
+    void GenGpuProfiler::endScope(VkCommandBuffer commandBuffer, int frameIndex, uint32_t scope)
+    {
+        if (scope == INVALID_SCOPE)
+        {
+            return;
+        }
+
+        auto &recorded = frames[frameIndex].scopes[scope];
+        // written once all earlier commands completed, so the range covers the whole scope
+        vkCmdWriteTimestamp(
+            commandBuffer,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            queryPool,
+            static_cast<uint32_t>(frameIndex) * MAX_QUERIES_PER_FRAME + recorded.beginQuery + 1);
+        recorded.ended = true;
+    }
+
+    uint32_t GenGpuProfiler::findHistory(const char *name)
+    {
+        auto it = historyIndices.find(name);
+        if (it != historyIndices.end())
+        {
+            return it->second;
+        }
+
+        uint32_t index = static_cast<uint32_t>(histories.size());
+        histories.push_back({name, {}, 0, 0});
+        histories.back().samplesMs.reserve(SAMPLE_WINDOW);
+        historyIndices.emplace(name, index);
+        return index;
+    }
+
+    bool GenGpuProfiler::getLatestSample(const std::string &name, uint64_t &totalSamples, double &latestMs) const
+    {
+        auto it = historyIndices.find(name);
+        if (it == historyIndices.end() || histories[it->second].totalSamples == 0)
+        {
+            return false;
+        }
+
+        const auto &history = histories[it->second];
+        totalSamples = history.totalSamples;
+        latestMs = history.samplesMs[(history.nextSample + SAMPLE_WINDOW - 1) % SAMPLE_WINDOW];
+        return true;
+    }
+
+    std::vector<GenGpuProfiler::ScopeStats> GenGpuProfiler::getStats() const
+    {
+        std::vector<ScopeStats> stats;
+        std::vector<double> sorted;
+        for (const auto &history : histories)
+        {
+            ScopeStats scopeStats{};
+            scopeStats.name = history.name;
+            scopeStats.sampleCount = static_cast<uint32_t>(history.samplesMs.size());
+            if (!history.samplesMs.empty())
+            {
+                sorted = history.samplesMs;
+                std::sort(sorted.begin(), sorted.end());
+                double sum = 0.0;
+                for (double sample : sorted)
+                {
+                    sum += sample;
+                }
+                scopeStats.averageMs = sum / sorted.size();
+                scopeStats.p50Ms = percentile(sorted, 0.50);
+                scopeStats.p95Ms = percentile(sorted, 0.95);
+                scopeStats.p99Ms = percentile(sorted, 0.99);
+                scopeStats.maxMs = sorted.back();
+            }
+            stats.push_back(scopeStats);
+        }
+        return stats;
+    }
+
+    void GenGpuProfiler::printStats() const
+    {
+        if (!isSupported())
+        {
+            std::cout << "GPU timestamps not supported on the graphics queue" << std::endl;
+            return;
+        }
+
+        std::cout << "GPU time over the last " << SAMPLE_WINDOW << " frames (ms):" << std::endl;
+        std::cout << std::left << std::setw(24) << "scope" << std::right
+                  << std::setw(10) << "avg" << std::setw(10) << "p50" << std::setw(10) << "p95"
+                  << std::setw(10) << "p99" << std::setw(10) << "max" << std::endl;
+        for (const auto &stats : getStats())
+        {
+            std::cout << std::left << std::setw(24) << stats.name << std::right << std::fixed << std::setprecision(3)
+                      << std::setw(10) << stats.averageMs << std::setw(10) << stats.p50Ms
+                      << std::setw(10) << stats.p95Ms << std::setw(10) << stats.p99Ms
+                      << std::setw(10) << stats.maxMs << std::endl;
+        }
+        std::cout << std::defaultfloat;
+    }
+
+    void GenGpuProfiler::writeCsv(const std::string &filepath) const
+    {
+        std::ofstream file{filepath};
+        if (!file.is_open())
+        {
+            throw std::runtime_error{"Failed to open file: " + filepath};
+        }
+
+        file << "scope,samples,avg_ms,p50_ms,p95_ms,p99_ms,max_ms\n";
+        for (const auto &stats : getStats())
+        {
+            file << stats.name << ',' << stats.sampleCount << ',' << stats.averageMs << ',' << stats.p50Ms << ','
+                 << stats.p95Ms << ',' << stats.p99Ms << ',' << stats.maxMs << '\n';
+        }
+    }
+
+} // namespace gen
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "gen_device.hpp"
+
+// std
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gen
+{
+    // GPU timings of named scopes from timestamp queries, with a block of queries per frame in flight.
+    // A frame's timestamps are read back when its slot comes around again, after beginFrame waited on its
+    // fence, so reading never stalls. Every scope keeps a rolling window of samples for its statistics.
+    class GenGpuProfiler
+    {
+    public:
+        // timestamps per frame, two per scope
+        static constexpr uint32_t MAX_QUERIES_PER_FRAME = 64;
+        // samples the rolling statistics are computed over
+        static constexpr uint32_t SAMPLE_WINDOW = 256;
+        static constexpr uint32_t INVALID_SCOPE = ~0u;
+
+        struct ScopeStats
+        {
+            std::string name;
+            uint32_t sampleCount = 0;
+            double averageMs = 0.0;
+            double p50Ms = 0.0;
+            double p95Ms = 0.0;
+            double p99Ms = 0.0;
+            double maxMs = 0.0;
+        };
+
+        // writes a begin timestamp on construction and the matching end timestamp when it goes out of scope
+        class Scope
+        {
+        public:
+            Scope(GenGpuProfiler &profiler, VkCommandBuffer commandBuffer, int frameIndex, const char *name)
+                : profiler{profiler}, commandBuffer{commandBuffer}, frameIndex{frameIndex},
+                  scope{profiler.beginScope(commandBuffer, frameIndex, name)} {}
+            ~Scope() { profiler.endScope(commandBuffer, frameIndex, scope); }
+
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+
+        private:
+            GenGpuProfiler &profiler;
+            VkCommandBuffer commandBuffer;
+            int frameIndex;
+            uint32_t scope;
+        };
+
+        explicit GenGpuProfiler(GenDevice &device);
+        ~GenGpuProfiler();
+
+        GenGpuProfiler(const GenGpuProfiler &) = delete;
+        GenGpuProfiler &operator=(const GenGpuProfiler &) = delete;
+
+        // false if the graphics queue doesn't support timestamps, all other calls are no-ops then
+        bool isSupported() const { return queryPool != VK_NULL_HANDLE; }
+
+        // adds the timings of the last frame recorded with frameIndex to the statistics and resets its
+        // queries, must be recorded every frame outside of a render pass before any scope
+        void collect(VkCommandBuffer commandBuffer, int frameIndex);
+
+        // returns INVALID_SCOPE once the frame's queries are used up, endScope ignores it. Scopes may nest,
+        // but must not begin in a subpass recorded with secondary command buffers
+        uint32_t beginScope(VkCommandBuffer commandBuffer, int frameIndex, const char *name);
+        void endScope(VkCommandBuffer commandBuffer, int frameIndex, uint32_t scope);
+
+        // statistics of every scope seen so far, in order of first use
+        std::vector<ScopeStats> getStats() const;
+        void printStats() const;
+        // one line per scope: name, samples, average, p50, p95, p99 and max in milliseconds
+        void writeCsv(const std::string &filepath) const;
+        // newest sample of the scope called name and how many samples it has had in total, for callers that
+        // keep every sample instead of the window. False if the scope has no samples yet
+        bool getLatestSample(const std::string &name, uint64_t &totalSamples, double &latestMs) const;
+
+    private:
+        struct ScopeHistory
+        {
+            std::string name;
+            std::vector<double> samplesMs; // ring buffer of up to SAMPLE_WINDOW samples
+            uint32_t nextSample = 0;
+            uint64_t totalSamples = 0;
+        };
+
+        struct RecordedScope
+        {
+            uint32_t history;
+            uint32_t beginQuery;
+            bool ended;
+        };
+
+        struct FrameQueries
+        {
+            std::vector<RecordedScope> scopes;
+            uint32_t usedQueries = 0;
+            bool reset = false;
+        };
+
+        uint32_t findHistory(const char *name);
+
+        GenDevice &genDevice;
+        VkQueryPool queryPool = VK_NULL_HANDLE;
+        double nanosecondsPerTick = 1.0;
+        uint64_t timestampMask = ~0ull;
+
+        std::vector<FrameQueries> frames;
+        std::vector<ScopeHistory> histories;
+        std::unordered_map<std::string, uint32_t> historyIndices;
+        std::vector<uint64_t> timestamps;
+    };
+}
@@ -0,0 +1,243 @@
+#include "gen_job_system.hpp"
+#include "gen_cpu_profiler.hpp"
+
+// std
+#include <stdexcept>
+
+namespace gen
+{
+    namespace
+    {
+        // ids instead of pointers, a new job system may reuse the address of a destroyed one
+        std::atomic<uint64_t> nextSystemId{1};
+    }
+
+    struct GenJobSystem::ThreadSlot
+    {
+        uint64_t systemId = 0;
+        uint32_t index = 0;
+        // empty for workers, their slots are theirs for the lifetime of the job system
+        std::weak_ptr<ExternalSlots> owner{};
+
+        ~ThreadSlot() { release(); }
+
+        void release()
+        {
+            if (auto slots = owner.lock())
+            {
+                std::lock_guard<std::mutex> lock{slots->mutex};
+                slots->free.push_back(index);
+            }
+            owner.reset();
+            systemId = 0;
+        }
+    };
+
+    thread_local GenJobSystem::ThreadSlot GenJobSystem::threadSlot{};
+
+    GenJobSystem::GenJobSystem(uint32_t threadCount)
+        : workerCount{threadCount}, systemId{nextSystemId.fetch_add(1)}, externalSlots{std::make_shared<ExternalSlots>()}
+    {
+        for (uint32_t i = 0; i < workerCount + MAX_EXTERNAL_THREADS; i++)
+        {
+            queues.push_back(std::make_unique<WorkQueue>());
+        }
+        // handed out from the back, lowest first
+        for (uint32_t i = workerCount + MAX_EXTERNAL_THREADS; i > workerCount; i--)
+        {
+            externalSlots->free.push_back(i - 1);
+        }
+
+        for (uint32_t i = 0; i < workerCount; i++)
+        {
+            workers.emplace_back(&GenJobSystem::workerLoop, this, i);
+        }
+    }
+
+    GenJobSystem::~GenJobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock{sleepMutex};
+            stopping = true;
+        }
+        wakeCondition.notify_all();
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    uint32_t GenJobSystem::getThreadIndex()
+    {
+        if (threadSlot.systemId != systemId)
+        {
+            // a thread moving on from another job system gives its slot there back
+            threadSlot.release();
+            uint32_t index;
+            {
+                std::lock_guard<std::mutex> lock{externalSlots->mutex};
+                if (externalSlots->free.empty())
+                {
+                    throw std::runtime_error("too many threads using the job system at once!");
+                }
+                index = externalSlots->free.back();
+                externalSlots->free.pop_back();
+            }
+            threadSlot.systemId = systemId;
+            threadSlot.index = index;
+            threadSlot.owner = externalSlots;
+        }
+        return threadSlot.index;
+    }
+
+    void GenJobSystem::submit(Job job, Counter *counter)
+    {
+        if (counter != nullptr)
+        {
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+        }
+        push(getThreadIndex(), {std::move(job), counter});
+    }
+
+    void GenJobSystem::submitAfter(Counter &dependency, Job job, Counter *counter)
+    {
+        if (counter != nullptr)
+        {
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        {
+            // finish() flushes continuations under the same lock, so the job can't be missed
+            std::lock_guard<std::mutex> lock{dependency.continuationMutex};
+            if (!dependency.isDone())
+            {
+                dependency.continuations.emplace_back(std::move(job), counter);
+                return;
+            }
+        }
+        push(getThreadIndex(), {std::move(job), counter});
+    }
+
+    void GenJobSystem::wait(Counter &counter)
+    {
+        uint32_t index = getThreadIndex();
+        while (!counter.isDone())
+        {
+            if (!tryRunJob(index))
+            {
+                // the remaining jobs are running elsewhere
+                std::this_thread::yield();
+            }
+        }
+        // the last finish() may still hold the lock while flushing continuations, the counter must outlive that
+        std::lock_guard<std::mutex> lock{counter.continuationMutex};
+    }
+
+    void GenJobSystem::workerLoop(uint32_t index)
+    {
+        threadSlot.systemId = systemId;
+        threadSlot.index = index;
+        GenCpuProfiler::setThreadName("job worker");
+
+        while (true)
+        {
+            if (tryRunJob(index))
+            {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock{sleepMutex};
+            wakeCondition.wait(lock, [this]
+                               { return stopping || queuedJobs.load() > 0; });
+            if (stopping)
+            {
+                return;
+            }
+        }
+    }
+
+    void GenJobSystem::push(uint32_t index, QueuedJob job)
+    {
+        {
+            std::lock_guard<std::mutex> lock{queues[index]->mutex};
+            queues[index]->jobs.push_back(std::move(job));
+        }
+        {
+            // under the sleep lock so a worker can't miss the wake up between its check and going to sleep
+            std::lock_guard<std::mutex> lock{sleepMutex};
+            queuedJobs.fetch_add(1);
+        }
+        wakeCondition.notify_one();
+    }
+
+    bool GenJobSystem::tryRunJob(uint32_t index)
+    {
+        QueuedJob job;
+        if (!popOrSteal(index, job))
+        {
+            return false;
+        }
+        {
+            GEN_PROFILE_SCOPE("job");
+            job.job();
+        }
+        finish(job.counter);
+        return true;
+    }
+
+    bool GenJobSystem::popOrSteal(uint32_t index, QueuedJob &job)
+    {
+        // own queue newest first
+        {
+            auto &queue = *queues[index];
+            std::lock_guard<std::mutex> lock{queue.mutex};
+            if (!queue.jobs.empty())
+            {
+                job = std::move(queue.jobs.back());
+                queue.jobs.pop_back();
+                queuedJobs.fetch_sub(1);
+                return true;
+            }
+        }
+
+        // steal the oldest job from the others, starting at the next queue so thieves spread out
+        for (size_t offset = 1; offset < queues.size(); offset++)
+        {
+            auto &victim = *queues[(index + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock{victim.mutex};
+            if (!victim.jobs.empty())
+            {
+                job = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+                queuedJobs.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void GenJobSystem::finish(Counter *counter)
+    {
+        if (counter == nullptr)
+        {
+            return;
+        }
+
+        std::vector<std::pair<Job, Counter *>> ready;
+        {
+            std::lock_guard<std::mutex> lock{counter->continuationMutex};
+            if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            {
+                return;
+            }
+            ready.swap(counter->continuations);
+        }
+
+        uint32_t index = getThreadIndex();
+        for (auto &continuation : ready)
+        {
+            push(index, {std::move(continuation.first), continuation.second});
+        }
+    }
+
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gen
+{
+    // Work stealing job system shared by the whole engine. Every worker owns a deque: it pushes and pops its own
+    // jobs LIFO for cache locality, idle workers steal FIFO from the others. Threads outside the pool (main,
+    // render) get their own slot on first use, so they can submit and help out while they wait, and give it back
+    // when they exit.
+    // Completion is tracked with counters, which also express dependencies between jobs.
+    class GenJobSystem
+    {
+    public:
+        using Job = std::function<void()>;
+
+        // number of unfinished jobs, jobs submitted after a counter only start once it reaches zero
+        class Counter
+        {
+        public:
+            Counter() = default;
+            Counter(const Counter &) = delete;
+            Counter &operator=(const Counter &) = delete;
+
+            bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+        private:
+            friend class GenJobSystem;
+
+            std::atomic<uint32_t> pending{0};
+            std::mutex continuationMutex;
+            std::vector<std::pair<Job, Counter *>> continuations;
+        };
+
+        // threads outside the pool that may submit or wait at the same time, more throw
+        static constexpr uint32_t MAX_EXTERNAL_THREADS = 4;
+
+        // one worker per core besides the submitting thread, which runs jobs itself while it waits
+        static uint32_t defaultWorkerCount() { return std::max(std::thread::hardware_concurrency(), 2u) - 1; }
+
+        // without workers jobs only run while a thread waits
+        explicit GenJobSystem(uint32_t workerCount = defaultWorkerCount());
+        ~GenJobSystem();
+
+        GenJobSystem(const GenJobSystem &) = delete;
+        GenJobSystem &operator=(const GenJobSystem &) = delete;
+
+        uint32_t getWorkerCount() const { return workerCount; }
+        // upper bound for getThreadIndex, for sizing per-thread data
+        uint32_t getThreadSlotCount() const { return static_cast<uint32_t>(queues.size()); }
+        // stable index of the calling thread, workers first followed by external threads. The index of an external
+        // thread that exited is handed to the next one
+        uint32_t getThreadIndex();
+
+        // counter, if given, is incremented now and decremented once the job finished
+        void submit(Job job, Counter *counter = nullptr);
+        // job runs once dependency reached zero, immediately queued if it already has
+        void submitAfter(Counter &dependency, Job job, Counter *counter = nullptr);
+        // runs queued jobs on the calling thread until counter reaches zero
+        void wait(Counter &counter);
+
+        // calls function(begin, end) over [0, count) in batches of at most batchSize and waits for all of them,
+        // batches run concurrently so they must only write to their own range
+        template <typename Function>
+        void parallelFor(uint32_t count, uint32_t batchSize, Function &&function)
+        {
+            if (count == 0)
+            {
+                return;
+            }
+            batchSize = std::max(batchSize, 1u);
+            if (count <= batchSize)
+            {
+                function(0u, count);
+                return;
+            }
+
+            Counter counter;
+            for (uint32_t begin = batchSize; begin < count; begin += batchSize)
+            {
+                uint32_t end = std::min(begin + batchSize, count);
+                submit([&function, begin, end]
+                       { function(begin, end); },
+                       &counter);
+            }
+            // the first batch runs here instead of idling
+            function(0u, std::min(batchSize, count));
+            wait(counter);
+        }
+
+    private:
+        struct QueuedJob
+        {
+            Job job;
+            Counter *counter;
+        };
+
+        struct WorkQueue
+        {
+            std::mutex mutex;
+            std::deque<QueuedJob> jobs;
+        };
+
+        // indices of external slots no thread holds. Shared with the threads holding one, which give it back on
+        // exit even if that's after the job system was destroyed
+        struct ExternalSlots
+        {
+            std::mutex mutex;
+            std::vector<uint32_t> free;
+        };
+
+        // the calling thread's slot in the job system it used last
+        struct ThreadSlot;
+        static thread_local ThreadSlot threadSlot;
+
+        void workerLoop(uint32_t threadIndex);
+        void push(uint32_t threadIndex, QueuedJob job);
+        bool tryRunJob(uint32_t threadIndex);
+        bool popOrSteal(uint32_t threadIndex, QueuedJob &job);
+        void finish(Counter *counter);
+
+        uint32_t workerCount;
+        uint64_t systemId;
+        std::vector<std::unique_ptr<WorkQueue>> queues;
+        std::vector<std::thread> workers;
+        std::shared_ptr<ExternalSlots> externalSlots;
+
+        // idle workers sleep until jobs are queued
+        std::mutex sleepMutex;
+        std::condition_variable wakeCondition;
+        // signed, a pop can briefly run ahead of the matching push's increment
+        std::atomic<int32_t> queuedJobs{0};
+        std::atomic<bool> stopping{false};
+    };
+}
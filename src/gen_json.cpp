@@ -0,0 +1,358 @@
+#include "gen_json.hpp"
+
+// std
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <stdexcept>
+
+namespace gen
+{
+    namespace
+    {
+        // recursive descent, pos is the offset of the next character in text
+        class JsonParser
+        {
+        public:
+            JsonParser(const std::string &text, const std::string &source) : text{text}, source{source} {}
+
+            JsonValue parseDocument()
+            {
+                JsonValue value = parseValue();
+                skipWhitespace();
+                if (pos != text.size())
+                {
+                    fail("trailing characters");
+                }
+                return value;
+            }
+
+        private:
+            // deep enough for any file the engine reads, keeps malformed input from overflowing the stack
+            static constexpr uint32_t MAX_DEPTH = 64;
+
+            [[noreturn]] void fail(const std::string &what) const
+            {
+                throw std::runtime_error{
+                    "invalid JSON in " + source + " at offset " + std::to_string(pos) + ": " + what};
+            }
+
+            void skipWhitespace()
+            {
+                while (pos < text.size() &&
+                       (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r'))
+                {
+                    pos++;
+                }
+            }
+
+            bool consume(char c)
+            {
+                skipWhitespace();
+                if (pos < text.size() && text[pos] == c)
+                {
+                    pos++;
+                    return true;
+                }
+                return false;
+            }
+
+            void expect(char c)
+            {
+                if (!consume(c))
+                {
+                    fail(std::string{"expected '"} + c + "'");
+                }
+            }
+
+            bool isDigit(size_t at) const { return at < text.size() && text[at] >= '0' && text[at] <= '9'; }
+
+            void skipDigits()
+            {
+                while (isDigit(pos))
+                {
+                    pos++;
+                }
+            }
+
+            JsonValue parseValue()
+            {
+                if (++depth > MAX_DEPTH)
+                {
+                    fail("nested too deeply");
+                }
+                skipWhitespace();
+                if (pos == text.size())
+                {
+                    fail("unexpected end");
+                }
+
+                JsonValue value{};
+                char c = text[pos];
+                if (c == '{')
+                {
+                    pos++;
+                    value.type = JsonValue::Type::Object;
+                    if (!consume('}'))
+                    {
+                        do
+                        {
+                            skipWhitespace();
+                            value.keys.push_back(parseString());
+                            expect(':');
+                            value.values.push_back(parseValue());
+                        } while (consume(','));
+                        expect('}');
+                    }
+                }
+                else if (c == '[')
+                {
+                    pos++;
+                    value.type = JsonValue::Type::Array;
+                    if (!consume(']'))
+                    {
+                        do
+                        {
+                            value.values.push_back(parseValue());
+                        } while (consume(','));
+                        expect(']');
+                    }
+                }
+                else if (c == '"')
+                {
+                    value.type = JsonValue::Type::String;
+                    value.string = parseString();
+                }
+                else if (c == '-' || isDigit(pos))
+                {
+                    value.type = JsonValue::Type::Number;
+                    value.number = parseNumber();
+                }
+                else if (text.compare(pos, 4, "true") == 0 || text.compare(pos, 5, "false") == 0)
+                {
+                    value.type = JsonValue::Type::Bool;
+                    value.boolean = c == 't';
+                    pos += value.boolean ? 4 : 5;
+                }
+                else if (text.compare(pos, 4, "null") == 0)
+                {
+                    pos += 4;
+                }
+                else
+                {
+                    fail(std::string{"unexpected '"} + c + "'");
+                }
+                depth--;
+                return value;
+            }
+
+            std::string parseString()
+            {
+                if (pos == text.size() || text[pos] != '"')
+                {
+                    fail("expected a string");
+                }
+                pos++;
+
+                std::string result;
+                while (true)
+                {
+                    if (pos == text.size())
+                    {
+                        fail("unterminated string");
+                    }
+                    char c = text[pos++];
+                    if (c == '"')
+                    {
+                        return result;
+                    }
+                    if (static_cast<unsigned char>(c) < 0x20)
+                    {
+                        fail("control character in string");
+                    }
+                    if (c != '\\')
+                    {
+                        result += c;
+                        continue;
+                    }
+
+                    if (pos == text.size())
+                    {
+                        fail("unterminated string");
+                    }
+                    char escape = text[pos++];
+                    switch (escape)
+                    {
+                    case '"':
+                    case '\\':
+                    case '/':
+                        result += escape;
+                        break;
+                    case 'b':
+                        result += '\b';
+                        break;
+                    case 'f':
+                        result += '\f';
+                        break;
+                    case 'n':
+                        result += '\n';
+                        break;
+                    case 'r':
+                        result += '\r';
+                        break;
+                    case 't':
+                        result += '\t';
+                        break;
+                    case 'u':
+                        appendCodePoint(result, parseHex4());
+                        break;
+                    default:
+                        fail(std::string{"unknown escape '\\"} + escape + "'");
+                    }
+                }
+            }
+
+            uint32_t parseHex4()
+            {
+                if (pos + 4 > text.size())
+                {
+                    fail("truncated \\u escape");
+                }
+                uint32_t codePoint = 0;
+                for (int i = 0; i < 4; i++)
+                {
+                    char c = text[pos++];
+                    uint32_t digit;
+                    if (c >= '0' && c <= '9')
+                    {
+                        digit = c - '0';
+                    }
+                    else if (c >= 'a' && c <= 'f')
+                    {
+                        digit = c - 'a' + 10;
+                    }
+                    else if (c >= 'A' && c <= 'F')
+                    {
+                        digit = c - 'A' + 10;
+                    }
+                    else
+                    {
+                        fail("invalid \\u escape");
+                    }
+                    codePoint = codePoint * 16 + digit;
+                }
+                return codePoint;
+            }
+
+            static void appendCodePoint(std::string &result, uint32_t codePoint)
+            {
+                // utf-8
+                if (codePoint < 0x80)
+                {
+                    result += static_cast<char>(codePoint);
+                }
+                else if (codePoint < 0x800)
+                {
+                    result += static_cast<char>(0xc0 | (codePoint >> 6));
+                    result += static_cast<char>(0x80 | (codePoint & 0x3f));
+                }
+                else
+                {
+                    result += static_cast<char>(0xe0 | (codePoint >> 12));
+                    result += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+                    result += static_cast<char>(0x80 | (codePoint & 0x3f));
+                }
+            }
+
+            // -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?, strtod alone would also take hex, inf and nan
+            double parseNumber()
+            {
+                size_t begin = pos;
+                if (text[pos] == '-')
+                {
+                    pos++;
+                }
+                if (!isDigit(pos))
+                {
+                    fail("expected a digit");
+                }
+                if (text[pos] == '0')
+                {
+                    pos++;
+                }
+                else
+                {
+                    skipDigits();
+                }
+                if (pos < text.size() && text[pos] == '.')
+                {
+                    pos++;
+                    if (!isDigit(pos))
+                    {
+                        fail("expected a digit after '.'");
+                    }
+                    skipDigits();
+                }
+                if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E'))
+                {
+                    pos++;
+                    if (pos < text.size() && (text[pos] == '+' || text[pos] == '-'))
+                    {
+                        pos++;
+                    }
+                    if (!isDigit(pos))
+                    {
+                        fail("expected a digit in the exponent");
+                    }
+                    skipDigits();
+                }
+                return std::strtod(text.substr(begin, pos - begin).c_str(), nullptr);
+            }
+
+            const std::string &text;
+            const std::string &source;
+            size_t pos = 0;
+            uint32_t depth = 0;
+        };
+    }
+
+    const JsonValue *JsonValue::find(const std::string &key) const
+    {
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            if (keys[i] == key)
+            {
+                return &values[i];
+            }
+        }
+        return nullptr;
+    }
+
+    JsonValue parseJson(const std::string &text, const std::string &source)
+    {
+        return JsonParser{text, source}.parseDocument();
+    }
+
+    void writeJsonString(std::ostream &file, const std::string &text)
+    {
+        file << '"';
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                file << '\\' << c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                file << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c)
+                     << std::dec << std::setfill(' ');
+            }
+            else
+            {
+                file << c;
+            }
+        }
+        file << '"';
+    }
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+// std
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace gen
+{
+    // A parsed JSON document, read by parseJson. RFC 8259 without surrogate pairs, \u escapes are encoded as
+    // single code points.
+    struct JsonValue
+    {
+        enum class Type
+        {
+            Null,
+            Bool,
+            Number,
+            String,
+            Array,
+            Object
+        };
+
+        Type type = Type::Null;
+        bool boolean = false;
+        double number = 0.0;
+        std::string string{};
+        // elements of an array, or the values of an object in the order of keys
+        std::vector<JsonValue> values{};
+        std::vector<std::string> keys{};
+
+        // the member called key of an object, nullptr if there is none or this isn't an object
+        const JsonValue *find(const std::string &key) const;
+    };
+
+    // the single value text holds. Throws on anything else, naming source and the offset, so a file that can't be
+    // read never passes for a valid one
+    JsonValue parseJson(const std::string &text, const std::string &source);
+    // text quoted and escaped as a JSON string
+    void writeJsonString(std::ostream &file, const std::string &text);
+}
@@ -1,48 +1,49 @@
 #include "gen_model.hpp"
-#include "gen_utils.hpp"
+#include "gen_cpu_profiler.hpp"
 
 // tiny
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
 
-// glm
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
-
 // std
+#include <algorithm>
 #include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
 #include <unordered_map>
 
 #ifndef ENGINE_DIR
 #define ENGINE_DIR "../"
 #endif
 
-namespace std
-{
-    template <>
-    struct hash<gen::GenModel::Vertex>
-    {
-        size_t operator()(gen::GenModel::Vertex const &vertex) const
-        {
-            size_t seed = 0;
-            gen::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
-            return seed;
-        }
-    };
-}
-
 namespace gen
 {
-    GenModel::GenModel(GenDevice &device, const GenModel::Builder &builder)
+    GenModel::GenModel(GenDevice &device, const GenModel::Builder &builder, UploadMode uploadMode)
         : genDevice{device}
     {
-        createVertexBuffers(builder.vertices);
-        createIndexBuffers(builder.indices);
+        vertexCount = static_cast<uint32_t>(builder.vertices.size());
+        indexCount = static_cast<uint32_t>(builder.indices.size());
+        hasIndexBuffer = indexCount > 0;
+        if (uploadMode == UploadMode::Immediate)
+        {
+            createVertexBuffers(builder.vertices);
+            createIndexBuffers(builder.indices);
+        }
+        for (const auto &vertex : builder.vertices)
+        {
+            boundingRadius = std::max(boundingRadius, glm::length(vertex.position));
+        }
+        memorySize = sizeof(Vertex) * static_cast<VkDeviceSize>(vertexCount) +
+                     sizeof(uint32_t) * static_cast<VkDeviceSize>(indexCount);
     }
     GenModel::~GenModel() {}
 
     std::unique_ptr<GenModel> GenModel::createModelFromFile(GenDevice &device, const std::string &filepath)
     {
+        GEN_PROFILE_SCOPE("GenModel::createModelFromFile");
         Builder builder{};
         builder.loadModel(ENGINE_DIR + filepath);
         return std::make_unique<GenModel>(device, builder);
@@ -112,6 +113,88 @@ namespace gen
         genDevice.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
     }
 
+    void GenModel::evictBuffers()
+    {
+        // GenBuffer defers destroying its buffer and memory
+        vertexBuffer = nullptr;
+        indexBuffer = nullptr;
+    }
+
+    void GenModel::recordUpload(const Builder &builder, VkCommandBuffer commandBuffer)
+    {
+        assert(!isResident() && "model buffers are already resident");
+        assert(builder.vertices.size() == vertexCount && builder.indices.size() == indexCount &&
+               "builder doesn't match the model");
+
+        // go out of scope on return, GenBuffer defers destroying them until this frame has completed
+        std::vector<std::unique_ptr<GenBuffer>> stagingBuffers{};
+        vertexBuffer = recordBufferUpload(
+            builder.vertices.data(),
+            sizeof(Vertex),
+            vertexCount,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            commandBuffer,
+            stagingBuffers);
+        if (hasIndexBuffer)
+        {
+            indexBuffer = recordBufferUpload(
+                builder.indices.data(),
+                sizeof(uint32_t),
+                indexCount,
+                VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                commandBuffer,
+                stagingBuffers);
+        }
+
+        // the copies have to land before any draw of the frame fetches vertices
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            0,
+            1,
+            &barrier,
+            0,
+            nullptr,
+            0,
+            nullptr);
+    }
+
+    std::unique_ptr<GenBuffer> GenModel::recordBufferUpload(
+        const void *data,
+        uint32_t elementSize,
+        uint32_t elementCount,
+        VkBufferUsageFlags usage,
+        VkCommandBuffer commandBuffer,
+        std::vector<std::unique_ptr<GenBuffer>> &stagingBuffers)
+    {
+        auto stagingBuffer = std::make_unique<GenBuffer>(
+            genDevice,
+            elementSize,
+            elementCount,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        stagingBuffer->map();
+        stagingBuffer->writeToBuffer(const_cast<void *>(data));
+
+        auto buffer = std::make_unique<GenBuffer>(
+            genDevice,
+            elementSize,
+            elementCount,
+            usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        VkBufferCopy copyRegion{};
+        copyRegion.size = static_cast<VkDeviceSize>(elementSize) * elementCount;
+        vkCmdCopyBuffer(commandBuffer, stagingBuffer->getBuffer(), buffer->getBuffer(), 1, &copyRegion);
+        stagingBuffers.push_back(std::move(stagingBuffer));
+        return buffer;
+    }
+
     void GenModel::draw(VkCommandBuffer commandBuffer)
     {
         if (hasIndexBuffer)
@@ -157,14 +240,39 @@ namespace gen
 
         return attributeDescriptions;
     }
+
+    std::vector<VkVertexInputAttributeDescription> GenModel::Vertex::getPositionAttributeDescriptions()
+    {
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+        attributeDescriptions.push_back({0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position)});
+        return attributeDescriptions;
+    }
+
     void GenModel::Builder::loadModel(const std::string &filepath)
     {
+        GEN_PROFILE_SCOPE("GenModel::Builder::loadModel");
+        std::ifstream file{filepath, std::ios::binary};
+        if (!file.is_open())
+        {
+            throw std::runtime_error{"Failed to open file: " + filepath};
+        }
+        std::vector<char> contents{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+        parseModel(contents, filepath);
+    }
+
+    void GenModel::Builder::parseModel(const std::vector<char> &contents, const std::string &filepath)
+    {
+        GEN_PROFILE_SCOPE("GenModel::Builder::parseModel");
         tinyobj::attrib_t attrib;             // stores position, color, normal and texturecoordinate data
         std::vector<tinyobj::shape_t> shapes; // contains the index values for each face element
         std::vector<tinyobj::material_t> materials;
         std::string warn, err;
 
-        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str()))
+        std::istringstream stream{std::string{contents.begin(), contents.end()}};
+        // like loading from the path, which also looks for the .mtl files next to the .obj
+        std::string directory = std::filesystem::path{filepath}.parent_path().string();
+        tinyobj::MaterialFileReader materialReader{directory.empty() ? std::string{} : directory + "/"};
+        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &stream, &materialReader))
         {
             throw std::runtime_error(warn + err);
         }
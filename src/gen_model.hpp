@@ -2,11 +2,14 @@
 
 #include "gen_device.hpp"
 #include "gen_buffer.hpp"
+#include "gen_utils.hpp"
 
 // glm
 #define GLM_FORCE_RADIANS           // glm functions will except values in radians, not degrees
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE // glm functions will expect depth values to be in range [0, 1]
 #include <glm/glm.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
 
 // std
 #include <vector>
@@ -27,6 +30,7 @@ namespace gen
 
             static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
             static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+            static std::vector<VkVertexInputAttributeDescription> getPositionAttributeDescriptions();
 
             bool operator==(const Vertex &other) const
             {
@@ -40,9 +44,19 @@ namespace gen
             std::vector<uint32_t> indices{};
 
             void loadModel(const std::string &filepath);
+            // the contents of the .obj file at filepath, read by the caller. Materials are read from its directory
+            void parseModel(const std::vector<char> &contents, const std::string &filepath);
         };
 
-        GenModel(GenDevice &device, const GenModel::Builder &builder);
+        enum class UploadMode
+        {
+            // uploaded before the constructor returns, waits for the graphics queue
+            Immediate,
+            // created without buffers, as if evicted, recordUpload creates them
+            Deferred
+        };
+
+        GenModel(GenDevice &device, const GenModel::Builder &builder, UploadMode uploadMode = UploadMode::Immediate);
         ~GenModel();
 
         GenModel(const GenModel &) = delete;
@@ -53,9 +67,29 @@ namespace gen
         void bind(VkCommandBuffer commandBuffer);
         void draw(VkCommandBuffer commandBuffer);
 
+        // of the sphere around the model's origin that contains every vertex
+        float getBoundingRadius() const { return boundingRadius; }
+
+        // false once the buffers were evicted, bind and draw need them uploaded again first
+        bool isResident() const { return vertexBuffer != nullptr; }
+        // device local memory of the vertex and index buffers
+        VkDeviceSize getMemorySize() const { return memorySize; }
+        // frees the vertex and index buffers once the frames in flight that may still read them have completed
+        void evictBuffers();
+        // recreates the evicted buffers from the builder the model was created from. The copies are recorded
+        // into commandBuffer outside a render pass
+        void recordUpload(const Builder &builder, VkCommandBuffer commandBuffer);
+
     private:
         void createVertexBuffers(const std::vector<Vertex> &vertices);
         void createIndexBuffers(const std::vector<uint32_t> &indices);
+        std::unique_ptr<GenBuffer> recordBufferUpload(
+            const void *data,
+            uint32_t elementSize,
+            uint32_t elementCount,
+            VkBufferUsageFlags usage,
+            VkCommandBuffer commandBuffer,
+            std::vector<std::unique_ptr<GenBuffer>> &stagingBuffers);
 
         GenDevice &genDevice;
 
@@ -65,5 +99,23 @@ namespace gen
         bool hasIndexBuffer = false;
         std::unique_ptr<GenBuffer> indexBuffer;
         uint32_t indexCount;
+
+        float boundingRadius = 0.f;
+        VkDeviceSize memorySize = 0;
     };
 } // namespace gen
+
+// vertex deduplication while loading, also measured by the micro-benchmarks
+namespace std
+{
+    template <>
+    struct hash<gen::GenModel::Vertex>
+    {
+        size_t operator()(gen::GenModel::Vertex const &vertex) const
+        {
+            size_t seed = 0;
+            gen::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
+            return seed;
+        }
+    };
+}
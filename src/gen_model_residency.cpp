@@ -0,0 +1,239 @@
+#include "gen_model_residency.hpp"
+#include "gen_cpu_profiler.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#ifndef ENGINE_DIR
+#define ENGINE_DIR "../"
+#endif
+
+namespace gen
+{
+    namespace
+    {
+        // normalized, pointing inwards. Clip space spans -w to w in x and y and 0 to w in depth
+        std::array<glm::vec4, 6> frustumPlanes(const glm::mat4 &viewProjection)
+        {
+            glm::mat4 rows = glm::transpose(viewProjection);
+            std::array<glm::vec4, 6> planes{
+                rows[3] + rows[0],
+                rows[3] - rows[0],
+                rows[3] + rows[1],
+                rows[3] - rows[1],
+                rows[2],
+                rows[3] - rows[2]};
+            for (auto &plane : planes)
+            {
+                plane /= glm::length(glm::vec3{plane});
+            }
+            return planes;
+        }
+
+        bool isSphereVisible(const std::array<glm::vec4, 6> &planes, const glm::vec3 &center, float radius)
+        {
+            for (const auto &plane : planes)
+            {
+                if (glm::dot(glm::vec3{plane}, center) + plane.w < -radius)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    GenModelResidency::GenModelResidency(GenDevice &device, VkDeviceSize budgetBytes)
+        : genDevice{device}, budgetBytes{budgetBytes}
+    {
+    }
+
+    std::shared_ptr<GenModel> GenModelResidency::createModelFromFile(const std::string &filepath)
+    {
+        GEN_PROFILE_SCOPE("GenModelResidency::createModelFromFile");
+        std::string path = ENGINE_DIR + filepath;
+        GenModel::Builder builder{};
+        builder.loadModel(path);
+        return createModel(std::move(builder), GenModel::UploadMode::Immediate, path);
+    }
+
+    std::shared_ptr<GenModel> GenModelResidency::createModel(
+        GenModel::Builder builder, GenModel::UploadMode uploadMode, std::string sourcePath)
+    {
+        auto model = std::make_shared<GenModel>(genDevice, builder, uploadMode);
+        residentBytes += model->isResident() ? model->getMemorySize() : 0;
+        Entry entry{model, nullptr, std::move(sourcePath), frameNumber, model->isResident()};
+        if (entry.sourcePath.empty() || !entry.uploaded)
+        {
+            entry.builder = std::make_unique<GenModel::Builder>(std::move(builder));
+        }
+        // a new model may reuse the address of an expired one
+        entries[model.get()] = std::move(entry);
+        return model;
+    }
+
+    void GenModelResidency::update(VkCommandBuffer commandBuffer, GenGameObject::Map &gameObjects, const GenCamera &camera)
+    {
+        GEN_PROFILE_SCOPE("GenModelResidency::update");
+        frameNumber++;
+
+        const auto planes = frustumPlanes(camera.getProjection() * camera.getView());
+        for (auto &kv : gameObjects)
+        {
+            const auto &obj = kv.second;
+            const auto &model = obj.model;
+            if (model == nullptr)
+            {
+                continue;
+            }
+            auto it = entries.find(model.get());
+            if (it == entries.end() || it->second.model.expired())
+            {
+                continue;
+            }
+
+            // the bounding sphere is around the model's origin, which the transform moves to the translation
+            const auto &scale = obj.transform.scale;
+            float radius = model->getBoundingRadius() *
+                           std::max({std::abs(scale.x), std::abs(scale.y), std::abs(scale.z)});
+            if (!isSphereVisible(planes, obj.transform.translation, radius))
+            {
+                continue;
+            }
+
+            Entry &entry = it->second;
+            entry.lastUsedFrame = frameNumber;
+            if (!model->isResident())
+            {
+                // parsing would stall the frame, the object isn't drawn until the builder arrives
+                if (entry.builder == nullptr)
+                {
+                    if (!entry.reloadRequested)
+                    {
+                        reloadRequests.push_back({model, entry.sourcePath});
+                        entry.reloadRequested = true;
+                    }
+                    continue;
+                }
+                model->recordUpload(*entry.builder, commandBuffer);
+                if (entry.uploaded)
+                {
+                    reuploadedBytes += model->getMemorySize();
+                    reuploads++;
+                }
+                entry.uploaded = true;
+                // recordUpload copied it into staging buffers
+                if (!entry.sourcePath.empty())
+                {
+                    entry.builder = nullptr;
+                    entry.reloadRequested = false;
+                }
+            }
+        }
+
+        // models whose last reference is gone freed their buffers on the way out
+        residentBytes = 0;
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            auto model = it->second.model.lock();
+            if (model == nullptr)
+            {
+                it = entries.erase(it);
+                continue;
+            }
+            residentBytes += model->isResident() ? model->getMemorySize() : 0;
+            ++it;
+        }
+
+        // memory queued for deferred destruction still counts towards the heap until its frame completes, but is
+        // as good as freed
+        heapBudget = genDevice.getDeviceLocalBudget();
+        VkDeviceSize heapUsage = heapBudget.usage - heapBudget.pendingFree;
+
+        while (residentBytes > budgetBytes || heapUsage > heapBudget.budget)
+        {
+            Entry *victim = findEvictionCandidate();
+            if (victim == nullptr)
+            {
+                break;
+            }
+
+            auto model = victim->model.lock();
+            VkDeviceSize size = model->getMemorySize();
+            // frames in flight may still draw it, the device frees the buffers once they completed
+            model->evictBuffers();
+            residentBytes -= size;
+            heapUsage -= std::min(heapUsage, size);
+            evictions++;
+        }
+    }
+
+    std::vector<GenModelResidency::ReloadRequest> GenModelResidency::takeReloadRequests()
+    {
+        std::vector<ReloadRequest> taken{};
+        taken.swap(reloadRequests);
+        return taken;
+    }
+
+    void GenModelResidency::finishReload(const std::weak_ptr<GenModel> &model, std::unique_ptr<GenModel::Builder> builder)
+    {
+        // expired while parsing, its entry may belong to a new model at the same address by now
+        auto locked = model.lock();
+        if (locked == nullptr || builder == nullptr)
+        {
+            return;
+        }
+        auto it = entries.find(locked.get());
+        if (it != entries.end() && it->second.builder == nullptr)
+        {
+            it->second.builder = std::move(builder);
+        }
+    }
+
+    GenModelResidency::Entry *GenModelResidency::findEvictionCandidate()
+    {
+        Entry *victim = nullptr;
+        for (auto &kv : entries)
+        {
+            Entry &entry = kv.second;
+            auto model = entry.model.lock();
+            // seen this frame, evicting it would only upload it again next frame
+            if (model == nullptr || !model->isResident() || entry.lastUsedFrame >= frameNumber)
+            {
+                continue;
+            }
+            if (victim == nullptr || entry.lastUsedFrame < victim->lastUsedFrame)
+            {
+                victim = &entry;
+            }
+        }
+        return victim;
+    }
+
+    GenModelResidency::Stats GenModelResidency::getStats()
+    {
+        Stats stats{};
+        for (auto &kv : entries)
+        {
+            auto model = kv.second.model.lock();
+            if (model == nullptr)
+            {
+                continue;
+            }
+            stats.modelCount++;
+            stats.residentCount += model->isResident() ? 1 : 0;
+        }
+        stats.residentBytes = residentBytes;
+        stats.budgetBytes = budgetBytes;
+        stats.heapUsage = heapBudget.usage;
+        stats.heapBudget = heapBudget.budget;
+        stats.memoryBudgetExtension = genDevice.supportsMemoryBudget();
+        stats.evictions = evictions;
+        stats.reuploads = reuploads;
+        stats.reuploadedBytes = reuploadedBytes;
+        return stats;
+    }
+
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "gen_camera.hpp"
+#include "gen_device.hpp"
+#include "gen_game_object.hpp"
+#include "gen_model.hpp"
+
+// std
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gen
+{
+    // Keeps the device local buffers of its models within a budget. Models are created through it; when over
+    // budget the buffers of the models least recently seen by the camera are evicted, and uploaded again as soon
+    // as an object using the model comes into view. Models created from a file drop their vertex and index data
+    // on the cpu once uploaded and have the file parsed again by whoever takes the reload requests, others keep it.
+    // Callers keep holding the same shared_ptr throughout.
+    class GenModelResidency
+    {
+    public:
+        struct Stats
+        {
+            uint32_t modelCount = 0;
+            uint32_t residentCount = 0;
+            VkDeviceSize residentBytes = 0;
+            VkDeviceSize budgetBytes = 0;
+            // of the device local heaps, as reported by GenDevice::getDeviceLocalBudget
+            VkDeviceSize heapUsage = 0;
+            VkDeviceSize heapBudget = 0;
+            bool memoryBudgetExtension = false;
+            uint64_t evictions = 0;
+            // of evicted models, not counting the first upload of deferred ones
+            uint64_t reuploads = 0;
+            VkDeviceSize reuploadedBytes = 0;
+        };
+
+        struct ReloadRequest
+        {
+            std::weak_ptr<GenModel> model;
+            std::string sourcePath;
+        };
+
+        static constexpr VkDeviceSize DEFAULT_BUDGET = 512 * 1024 * 1024;
+
+        GenModelResidency(GenDevice &device, VkDeviceSize budgetBytes = DEFAULT_BUDGET);
+        // every frame using the models must have completed
+        ~GenModelResidency() = default;
+
+        GenModelResidency(const GenModelResidency &) = delete;
+        GenModelResidency &operator=(const GenModelResidency &) = delete;
+
+        // uploads right away, like GenModel::createModelFromFile. Not thread safe with update
+        std::shared_ptr<GenModel> createModelFromFile(const std::string &filepath);
+        // a deferred model is uploaded by the update of the first frame that sees it. builder is kept for
+        // re-uploads unless sourcePath names the file it was loaded from
+        std::shared_ptr<GenModel> createModel(
+            GenModel::Builder builder,
+            GenModel::UploadMode uploadMode = GenModel::UploadMode::Immediate,
+            std::string sourcePath = {});
+
+        // from the render thread once per frame, after the frame's fence wait and before recording draws.
+        // Re-uploads the evicted models of the objects in camera's view into commandBuffer outside a render
+        // pass, then evicts models not seen this frame while over the budget or the device local heap budget.
+        // Objects outside the view may be left with an evicted model, draws skip models that aren't resident.
+        // Evicted models without a builder are skipped until finishReload hands one over
+        void update(VkCommandBuffer commandBuffer, GenGameObject::Map &gameObjects, const GenCamera &camera);
+
+        // the evicted models that came into view without a builder since the last call, each is requested once.
+        // From the thread calling update
+        std::vector<ReloadRequest> takeReloadRequests();
+        // the parsed sourcePath of a reload request, uploaded by the next update that sees the model. nullptr if
+        // parsing failed, the model then stays evicted. From the thread calling update
+        void finishReload(const std::weak_ptr<GenModel> &model, std::unique_ptr<GenModel::Builder> builder);
+
+        Stats getStats();
+
+    private:
+        struct Entry
+        {
+            std::weak_ptr<GenModel> model;
+            // nullptr between uploads of a model that can be parsed from sourcePath again
+            std::unique_ptr<GenModel::Builder> builder;
+            std::string sourcePath;
+            uint64_t lastUsedFrame = 0;
+            bool uploaded = false;
+            // requested for parsing, stays set if parsing failed
+            bool reloadRequested = false;
+        };
+
+        // the resident model least recently used before this frame, nullptr if there is none
+        Entry *findEvictionCandidate();
+
+        GenDevice &genDevice;
+        VkDeviceSize budgetBytes;
+
+        // dropped once the model expires, its buffers are freed with the last reference as usual
+        std::unordered_map<const GenModel *, Entry> entries{};
+        std::vector<ReloadRequest> reloadRequests{};
+        uint64_t frameNumber = 0;
+        VkDeviceSize residentBytes = 0;
+        MemoryHeapBudget heapBudget{};
+
+        uint64_t evictions = 0;
+        uint64_t reuploads = 0;
+        VkDeviceSize reuploadedBytes = 0;
+    };
+}
@@ -0,0 +1,181 @@
+#include "gen_parallel_recorder.hpp"
+#include "gen_cpu_profiler.hpp"
+
+// std
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+
+namespace gen
+{
+
+    GenParallelRecorder::GenParallelRecorder(GenDevice &device, GenJobSystem &jobSystem)
+        : genDevice{device}, jobSystem{jobSystem}
+    {
+        threads.resize(jobSystem.getThreadSlotCount());
+        activeThreadCount = getThreadCount();
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = genDevice.findPhysicalQueueFamilies().graphicsFamily;
+        // no VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, buffers are only ever reset with their pool
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        for (auto &thread : threads)
+        {
+            for (auto &pool : thread.commandPools)
+            {
+                if (vkCreateCommandPool(genDevice.device(), &poolInfo, nullptr, &pool) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("failed to create thread command pool!");
+                }
+            }
+        }
+    }
+
+    GenParallelRecorder::~GenParallelRecorder()
+    {
+        // destroying a pool frees its command buffers
+        for (auto &thread : threads)
+        {
+            for (auto pool : thread.commandPools)
+            {
+                vkDestroyCommandPool(genDevice.device(), pool, nullptr);
+            }
+        }
+    }
+
+    void GenParallelRecorder::setActiveThreadCount(uint32_t count)
+    {
+        activeThreadCount = std::clamp(count, 1u, getThreadCount());
+    }
+
+    void GenParallelRecorder::beginFrame(int newFrameIndex)
+    {
+        frameIndex = newFrameIndex;
+        for (auto &thread : threads)
+        {
+            vkResetCommandPool(genDevice.device(), thread.commandPools[frameIndex], 0);
+            thread.usedCommandBuffers[frameIndex] = 0;
+        }
+    }
+
+    void GenParallelRecorder::record(
+        VkCommandBuffer primaryCommandBuffer,
+        const VkCommandBufferInheritanceInfo &inheritanceInfo,
+        VkExtent2D extent,
+        uint32_t itemCount,
+        const RecordFunction &recordFunction)
+    {
+        GEN_PROFILE_SCOPE("GenParallelRecorder::record");
+        if (itemCount == 0)
+        {
+            return;
+        }
+
+        uint32_t rangeCount = std::min(activeThreadCount, itemCount);
+        rangeCommandBuffers.resize(rangeCount);
+
+        // a job can't throw across threads, the first failure is rethrown here
+        std::exception_ptr error;
+        std::mutex errorMutex;
+        auto recordRangeJob = [&](uint32_t range)
+        {
+            uint32_t begin = static_cast<uint32_t>(uint64_t{itemCount} * range / rangeCount);
+            uint32_t end = static_cast<uint32_t>(uint64_t{itemCount} * (range + 1) / rangeCount);
+            try
+            {
+                rangeCommandBuffers[range] = recordRange(inheritanceInfo, extent, begin, end, recordFunction);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock{errorMutex};
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+        };
+
+        // ranges finish in any order, the slots keep the secondaries in range order
+        jobSystem.parallelFor(rangeCount, 1, [&](uint32_t begin, uint32_t end)
+                              {
+                                  for (uint32_t range = begin; range < end; range++)
+                                  {
+                                      recordRangeJob(range);
+                                  } });
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+
+        vkCmdExecuteCommands(primaryCommandBuffer, rangeCount, rangeCommandBuffers.data());
+    }
+
+    VkCommandBuffer GenParallelRecorder::recordRange(
+        const VkCommandBufferInheritanceInfo &inheritanceInfo,
+        VkExtent2D extent,
+        uint32_t begin,
+        uint32_t end,
+        const RecordFunction &recordFunction)
+    {
+        GEN_PROFILE_SCOPE("GenParallelRecorder::recordRange");
+        VkCommandBuffer commandBuffer = acquireCommandBuffer(jobSystem.getThreadIndex());
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to begin recording secondary command buffer!");
+        }
+
+        // dynamic state isn't inherited from the primary
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(extent.width);
+        viewport.height = static_cast<float>(extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        VkRect2D scissor{{0, 0}, extent};
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+        recordFunction(commandBuffer, begin, end);
+
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to record secondary command buffer!");
+        }
+        return commandBuffer;
+    }
+
+    VkCommandBuffer GenParallelRecorder::acquireCommandBuffer(uint32_t threadIndex)
+    {
+        auto &thread = threads[threadIndex];
+        auto &commandBuffers = thread.commandBuffers[frameIndex];
+        uint32_t &used = thread.usedCommandBuffers[frameIndex];
+
+        if (used == commandBuffers.size())
+        {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandPool = thread.commandPools[frameIndex];
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer;
+            if (vkAllocateCommandBuffers(genDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate secondary command buffer!");
+            }
+            commandBuffers.push_back(commandBuffer);
+        }
+        return commandBuffers[used++];
+    }
+
+} // namespace gen
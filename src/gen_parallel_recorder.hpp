@@ -0,0 +1,74 @@
+#pragma once
+
+#include "gen_device.hpp"
+#include "gen_job_system.hpp"
+#include "gen_swap_chain.hpp"
+
+// std
+#include <array>
+#include <functional>
+#include <vector>
+
+namespace gen
+{
+    // Records draw work as jobs into secondary command buffers that are then executed by the frame's primary
+    // command buffer. Every job system thread owns one command pool per frame in flight, so recording needs
+    // no locking and a frame's pools are reset wholesale once its fence has signaled.
+    class GenParallelRecorder
+    {
+    public:
+        // records commands for items [begin, end) into commandBuffer, called once per range
+        using RecordFunction = std::function<void(VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end)>;
+
+        GenParallelRecorder(GenDevice &device, GenJobSystem &jobSystem);
+        ~GenParallelRecorder();
+
+        GenParallelRecorder(const GenParallelRecorder &) = delete;
+        GenParallelRecorder &operator=(const GenParallelRecorder &) = delete;
+
+        // workers plus the recording thread
+        uint32_t getThreadCount() const { return jobSystem.getWorkerCount() + 1; }
+        uint32_t getActiveThreadCount() const { return activeThreadCount; }
+        // limits how many ranges the work is split into, mainly for measuring scaling
+        void setActiveThreadCount(uint32_t count);
+
+        // resets every thread's pool for this frame, the frame's previous submission must have completed
+        void beginFrame(int frameIndex);
+
+        // splits [0, itemCount) into one contiguous range per active thread and executes the resulting secondary
+        // command buffers in range order, so the draw order matches recording everything on one thread.
+        // The primary must be inside a subpass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+        void record(
+            VkCommandBuffer primaryCommandBuffer,
+            const VkCommandBufferInheritanceInfo &inheritanceInfo,
+            VkExtent2D extent,
+            uint32_t itemCount,
+            const RecordFunction &recordFunction);
+
+    private:
+        struct ThreadState
+        {
+            std::array<VkCommandPool, GenSwapChain::MAX_FRAMES_IN_FLIGHT> commandPools{};
+            // allocated on demand and reused after the pool reset
+            std::array<std::vector<VkCommandBuffer>, GenSwapChain::MAX_FRAMES_IN_FLIGHT> commandBuffers{};
+            std::array<uint32_t, GenSwapChain::MAX_FRAMES_IN_FLIGHT> usedCommandBuffers{};
+        };
+
+        VkCommandBuffer recordRange(
+            const VkCommandBufferInheritanceInfo &inheritanceInfo,
+            VkExtent2D extent,
+            uint32_t begin,
+            uint32_t end,
+            const RecordFunction &recordFunction);
+        VkCommandBuffer acquireCommandBuffer(uint32_t threadIndex);
+
+        GenDevice &genDevice;
+        GenJobSystem &jobSystem;
+        // indexed by job system thread index
+        std::vector<ThreadState> threads;
+        uint32_t activeThreadCount;
+        int frameIndex = 0;
+
+        std::vector<VkCommandBuffer> rangeCommandBuffers;
+    };
+}
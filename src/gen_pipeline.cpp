@@ -1,4 +1,5 @@
 #include "gen_pipeline.hpp"
+#include "gen_cpu_profiler.hpp"
 #include "gen_model.hpp"
 
 // std
@@ -22,11 +23,22 @@ namespace gen
     {
         createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
     }
+
+    GenPipeline::GenPipeline(
+        GenDevice &device,
+        const std::string &compFilepath,
+        VkPipelineLayout pipelineLayout) : genDevice{device}, bindPoint{VK_PIPELINE_BIND_POINT_COMPUTE}
+    {
+        createComputePipeline(compFilepath, pipelineLayout);
+    }
+
     GenPipeline::~GenPipeline()
     {
         vkDestroyShaderModule(genDevice.device(), vertShaderModule, nullptr);
         vkDestroyShaderModule(genDevice.device(), fragShaderModule, nullptr);
-        vkDestroyPipeline(genDevice.device(), graphicsPipeline, nullptr);
+        vkDestroyShaderModule(genDevice.device(), compShaderModule, nullptr);
+        // only needed to create it, but frames in flight may still have the pipeline bound
+        genDevice.destroyDeferred(VK_OBJECT_TYPE_PIPELINE, graphicsPipeline);
     }
 
     std::vector<char> GenPipeline::readFile(const std::string &filepath)
@@ -54,14 +66,19 @@ namespace gen
         const std::string &fragFilepath,
         const PipelineConfigInfo &configInfo)
     {
+        GEN_PROFILE_SCOPE("GenPipeline::createGraphicsPipeline");
         assert(configInfo.pipelineLayout != VK_NULL_HANDLE && "Cannot create graphics pipeline:: no pipelineLayout provided in configInfo");
         assert(configInfo.renderPass != VK_NULL_HANDLE && "Cannot create graphics pipeline:: no pipelineLayout provided in configInfo");
 
         auto vertCode = readFile(vertFilepath);
-        auto fragCode = readFile(fragFilepath);
-
         createShaderModule(vertCode, &vertShaderModule);
-        createShaderModule(fragCode, &fragShaderModule);
+
+        bool hasFragmentStage = !fragFilepath.empty();
+        if (hasFragmentStage)
+        {
+            auto fragCode = readFile(fragFilepath);
+            createShaderModule(fragCode, &fragShaderModule);
+        }
 
         VkPipelineShaderStageCreateInfo shaderStages[2];
         // vertex shader
@@ -92,7 +109,7 @@ namespace gen
 
         VkGraphicsPipelineCreateInfo pipelineInfo{};
         pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipelineInfo.stageCount = 2;
+        pipelineInfo.stageCount = hasFragmentStage ? 2 : 1;
         pipelineInfo.pStages = shaderStages;
         pipelineInfo.pVertexInputState = &vertexInputInfo;
         pipelineInfo.pInputAssemblyState = &configInfo.inputAssemblyInfo;
@@ -116,6 +133,33 @@ namespace gen
         }
     }
 
+    void GenPipeline::createComputePipeline(const std::string &compFilepath, VkPipelineLayout pipelineLayout)
+    {
+        GEN_PROFILE_SCOPE("GenPipeline::createComputePipeline");
+        assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline:: no pipelineLayout provided");
+
+        auto compCode = readFile(compFilepath);
+        createShaderModule(compCode, &compShaderModule);
+
+        VkPipelineShaderStageCreateInfo shaderStage{};
+        shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        shaderStage.module = compShaderModule;
+        shaderStage.pName = "main";
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage = shaderStage;
+        pipelineInfo.layout = pipelineLayout;
+        pipelineInfo.basePipelineIndex = -1;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+        if (vkCreateComputePipelines(genDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS)
+        {
+            throw std::runtime_error{"Failed to create compute pipeline"};
+        }
+    }
+
     void GenPipeline::createShaderModule(const std::vector<char> &code, VkShaderModule *shaderModule)
     {
         VkShaderModuleCreateInfo createInfo{};
@@ -131,10 +175,13 @@ namespace gen
 
     void GenPipeline::bind(VkCommandBuffer commandBuffer)
     {
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+        vkCmdBindPipeline(commandBuffer, bindPoint, graphicsPipeline);
     }
 
-    void GenPipeline::defaultPipelineConfigInfo(PipelineConfigInfo &configInfo)
+    void GenPipeline::defaultPipelineConfigInfo(
+        PipelineConfigInfo &configInfo,
+        VkCompareOp depthCompareOp,
+        VkBool32 depthWriteEnable)
     {
 
         configInfo.inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -193,8 +240,8 @@ namespace gen
 
         configInfo.depthStencilInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
         configInfo.depthStencilInfo.depthTestEnable = VK_TRUE;
-        configInfo.depthStencilInfo.depthWriteEnable = VK_TRUE;
-        configInfo.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+        configInfo.depthStencilInfo.depthWriteEnable = depthWriteEnable; // disable for passes after a depth pre-pass
+        configInfo.depthStencilInfo.depthCompareOp = depthCompareOp;     // VK_COMPARE_OP_EQUAL to only shade the visible fragments after a depth pre-pass
         configInfo.depthStencilInfo.depthBoundsTestEnable = VK_FALSE;
         configInfo.depthStencilInfo.minDepthBounds = 0.0f; // Optional
         configInfo.depthStencilInfo.maxDepthBounds = 1.0f; // Optional
@@ -229,4 +276,49 @@ namespace gen
         configInfo.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
         configInfo.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
     }
+
+    void GenPipeline::enableWeightedBlendedAccumulation(PipelineConfigInfo &configInfo)
+    {
+        setColorAttachmentCount(configInfo, 2);
+
+        // accumulation: sum of weighted premultiplied color and weighted alpha
+        auto &accum = configInfo.colorBlendAttachments[0];
+        accum.blendEnable = VK_TRUE;
+        accum.colorWriteMask =
+            VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT |
+            VK_COLOR_COMPONENT_A_BIT;
+        accum.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+        accum.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+        accum.colorBlendOp = VK_BLEND_OP_ADD;
+        accum.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        accum.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        accum.alphaBlendOp = VK_BLEND_OP_ADD;
+
+        // revealage: product of (1 - alpha), the shader writes alpha to the red channel
+        auto &revealage = configInfo.colorBlendAttachments[1];
+        revealage.blendEnable = VK_TRUE;
+        revealage.colorWriteMask = VK_COLOR_COMPONENT_R_BIT;
+        revealage.srcColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+        revealage.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_COLOR;
+        revealage.colorBlendOp = VK_BLEND_OP_ADD;
+        revealage.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+        revealage.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        revealage.alphaBlendOp = VK_BLEND_OP_ADD;
+
+        configInfo.depthStencilInfo.depthWriteEnable = VK_FALSE;
+    }
+
+    void GenPipeline::enableDepthOnly(PipelineConfigInfo &configInfo)
+    {
+        configInfo.attributeDescriptions = GenModel::Vertex::getPositionAttributeDescriptions();
+        configInfo.colorBlendAttachment.blendEnable = VK_FALSE;
+        configInfo.colorBlendAttachment.colorWriteMask = 0;
+    }
+
+    void GenPipeline::setColorAttachmentCount(PipelineConfigInfo &configInfo, uint32_t count)
+    {
+        configInfo.colorBlendAttachments.assign(count, configInfo.colorBlendAttachment);
+        configInfo.colorBlendInfo.attachmentCount = count;
+        configInfo.colorBlendInfo.pAttachments = configInfo.colorBlendAttachments.data();
+    }
 }
\ No newline at end of file
@@ -24,6 +24,7 @@ namespace gen
         VkPipelineRasterizationStateCreateInfo rasterizationInfo;
         VkPipelineMultisampleStateCreateInfo multisampleInfo;
         VkPipelineColorBlendAttachmentState colorBlendAttachment;
+        std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments{}; // only used for subpasses with multiple color attachments
         VkPipelineColorBlendStateCreateInfo colorBlendInfo;
         VkPipelineDepthStencilStateCreateInfo depthStencilInfo;
         std::vector<VkDynamicState> dynamicStatesEnables;
@@ -36,7 +37,10 @@ namespace gen
     class GenPipeline
     {
     public:
+        // an empty fragFilepath creates a pipeline without fragment stage, e.g. for depth only passes
         GenPipeline(GenDevice &device, const std::string &vertFilepath, const std::string &fragFilepath, const PipelineConfigInfo &configInfo);
+        // compute pipeline, the layout is owned by the caller just like for graphics pipelines
+        GenPipeline(GenDevice &device, const std::string &compFilepath, VkPipelineLayout pipelineLayout);
         ~GenPipeline();
 
         // delete copy constructors
@@ -45,19 +49,32 @@ namespace gen
 
         void bind(VkCommandBuffer commandBuffer);
 
-        static void defaultPipelineConfigInfo(PipelineConfigInfo &configInfo);
+        static void defaultPipelineConfigInfo(
+            PipelineConfigInfo &configInfo,
+            VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS,
+            VkBool32 depthWriteEnable = VK_TRUE);
         static void enableAlphaBlending(PipelineConfigInfo &configInfo);
+        // two additive targets for weighted blended order independent transparency: accumulation and revealage,
+        // depth is tested but not written so transparent geometry can be drawn in any order
+        static void enableWeightedBlendedAccumulation(PipelineConfigInfo &configInfo);
+        // position only vertex input and no color writes, for depth pre-passes
+        static void enableDepthOnly(PipelineConfigInfo &configInfo);
+        // replicates colorBlendAttachment for every color attachment of the subpass, call after configuring blending
+        static void setColorAttachmentCount(PipelineConfigInfo &configInfo, uint32_t count);
 
     private:
         static std::vector<char> readFile(const std::string &filepath);
 
         void createGraphicsPipeline(const std::string &vertFilepath, const std::string &fragFilepath, const PipelineConfigInfo &configInfo);
+        void createComputePipeline(const std::string &compFilepath, VkPipelineLayout pipelineLayout);
 
         void createShaderModule(const std::vector<char> &code, VkShaderModule *shaderModule);
 
         GenDevice &genDevice;
         VkPipeline graphicsPipeline;
-        VkShaderModule vertShaderModule;
-        VkShaderModule fragShaderModule;
+        VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        VkShaderModule vertShaderModule = VK_NULL_HANDLE;
+        VkShaderModule fragShaderModule = VK_NULL_HANDLE;
+        VkShaderModule compShaderModule = VK_NULL_HANDLE;
     };
 }
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "gen_pipeline_statistics.hpp"
+
+#include "gen_swap_chain.hpp"
+
+// std
+#include <bitset>
+#include <stdexcept>
+
+namespace gen
+{
+
+    GenPipelineStatistics::GenPipelineStatistics(GenDevice &device, VkQueryPipelineStatisticFlags statistics)
+        : genDevice{device}
+    {
+        if (!genDevice.enabledFeatures.pipelineStatisticsQuery)
+        {
+            return;
+        }
+
+        statisticCount = static_cast<uint32_t>(std::bitset<32>(statistics).count());
+        queryRecorded.resize(GenSwapChain::MAX_FRAMES_IN_FLIGHT, false);
+
+        VkQueryPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        poolInfo.queryCount = GenSwapChain::MAX_FRAMES_IN_FLIGHT;
+        poolInfo.pipelineStatistics = statistics;
+        if (vkCreateQueryPool(genDevice.device(), &poolInfo, nullptr, &queryPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline statistics query pool!");
+        }
+    }
+
+    GenPipelineStatistics::~GenPipelineStatistics()
+    {
+        if (queryPool != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(genDevice.device(), queryPool, nullptr);
+        }
+    }
+
+    bool GenPipelineStatistics::collect(VkCommandBuffer commandBuffer, int frameIndex, std::vector<uint64_t> &results)
+    {
+        if (!isSupported())
+        {
+            return false;
+        }
+
+        bool available = false;
+        if (queryRecorded[frameIndex])
+        {
+            results.resize(statisticCount);
+            // no VK_QUERY_RESULT_WAIT_BIT, the frame's fence has been signaled so this doesn't stall
+            available = vkGetQueryPoolResults(
+                            genDevice.device(),
+                            queryPool,
+                            static_cast<uint32_t>(frameIndex),
+                            1,
+                            results.size() * sizeof(uint64_t),
+                            results.data(),
+                            sizeof(uint64_t) * statisticCount,
+                            VK_QUERY_RESULT_64_BIT) == VK_SUCCESS;
+        }
+
+        vkCmdResetQueryPool(commandBuffer, queryPool, static_cast<uint32_t>(frameIndex), 1);
+        queryRecorded[frameIndex] = false;
+        return available;
+    }
+
+    void GenPipelineStatistics::begin(VkCommandBuffer commandBuffer, int frameIndex)
+    {
+        if (!isSupported())
+        {
+            return;
+        }
+        vkCmdBeginQuery(commandBuffer, queryPool, static_cast<uint32_t>(frameIndex), 0);
+    }
+
+    void GenPipelineStatistics::end(VkCommandBuffer commandBuffer, int frameIndex)
+    {
+        if (!isSupported())
+        {
+            return;
+        }
+        vkCmdEndQuery(commandBuffer, queryPool, static_cast<uint32_t>(frameIndex));
+        queryRecorded[frameIndex] = true;
+    }
+
+} // namespace gen
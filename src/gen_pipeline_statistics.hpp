@@ -0,0 +1,40 @@
+#pragma once
+
+#include "gen_device.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace gen
+{
+    // Pipeline statistics query with one query per frame in flight. Results are read back without
+    // waiting: a frame's query is only read after its fence was waited on, which beginFrame already does.
+    class GenPipelineStatistics
+    {
+    public:
+        GenPipelineStatistics(GenDevice &device, VkQueryPipelineStatisticFlags statistics);
+        ~GenPipelineStatistics();
+
+        GenPipelineStatistics(const GenPipelineStatistics &) = delete;
+        GenPipelineStatistics &operator=(const GenPipelineStatistics &) = delete;
+
+        // false if the device doesn't support pipeline statistics queries, all other calls are no-ops then
+        bool isSupported() const { return queryPool != VK_NULL_HANDLE; }
+
+        // reads back the results of the last query recorded for frameIndex and resets it,
+        // must be recorded outside of a render pass. Returns false if there was nothing to read.
+        bool collect(VkCommandBuffer commandBuffer, int frameIndex, std::vector<uint64_t> &results);
+        void begin(VkCommandBuffer commandBuffer, int frameIndex);
+        void end(VkCommandBuffer commandBuffer, int frameIndex);
+
+        // number of values collect writes, one per bit in the statistics flags
+        uint32_t getStatisticCount() const { return statisticCount; }
+
+    private:
+        GenDevice &genDevice;
+        VkQueryPool queryPool = VK_NULL_HANDLE;
+        uint32_t statisticCount = 0;
+        std::vector<bool> queryRecorded;
+    };
+}
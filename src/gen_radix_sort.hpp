@@ -0,0 +1,67 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace gen
+{
+
+    struct RadixSortEntry
+    {
+        uint32_t key;
+        uint32_t value;
+    };
+
+    // monotonic key for non-negative floats, their bit patterns already compare like unsigned integers
+    inline uint32_t radixKeyFromFloat(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    // Stable LSD radix sort of count entries by ascending key, one 8 bit digit per pass.
+    // scratch must hold count entries; nothing is allocated, the sorted result ends up in entries.
+    // Passes where every key has the same digit are skipped.
+    inline void radixSort(RadixSortEntry *entries, RadixSortEntry *scratch, uint32_t count)
+    {
+        RadixSortEntry *src = entries;
+        RadixSortEntry *dst = scratch;
+
+        for (uint32_t shift = 0; shift < 32; shift += 8)
+        {
+            uint32_t histogram[256] = {};
+            for (uint32_t i = 0; i < count; i++)
+            {
+                histogram[(src[i].key >> shift) & 0xff]++;
+            }
+
+            if (count == 0 || histogram[(src[0].key >> shift) & 0xff] == count)
+            {
+                continue;
+            }
+
+            uint32_t offset = 0;
+            for (uint32_t &bucket : histogram)
+            {
+                uint32_t bucketCount = bucket;
+                bucket = offset;
+                offset += bucketCount;
+            }
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                dst[histogram[(src[i].key >> shift) & 0xff]++] = src[i];
+            }
+            std::swap(src, dst);
+        }
+
+        if (src != entries)
+        {
+            std::memcpy(entries, src, count * sizeof(RadixSortEntry));
+        }
+    }
+
+}
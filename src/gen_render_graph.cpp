@@ -0,0 +1,844 @@
+#include "gen_render_graph.hpp"
+#include "gen_cpu_profiler.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <numeric>
+#include <stdexcept>
+
+namespace gen
+{
+    namespace
+    {
+        struct AccessInfo
+        {
+            VkPipelineStageFlags2KHR stages;
+            VkAccessFlags2KHR accesses;
+            VkImageLayout layout;
+        };
+
+        // only flags vkCmdPipelineBarrier knows as well, so GenDevice::cmdPipelineBarrier2 can translate them
+        AccessInfo accessInfo(GenRenderGraph::Access access)
+        {
+            switch (access)
+            {
+            case GenRenderGraph::Access::ColorAttachment:
+                return {
+                    VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR,
+                    VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR,
+                    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+            case GenRenderGraph::Access::DepthAttachment:
+                return {
+                    VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR,
+                    VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR,
+                    VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+            case GenRenderGraph::Access::InputAttachment:
+                return {
+                    VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR,
+                    VK_ACCESS_2_INPUT_ATTACHMENT_READ_BIT_KHR,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+            case GenRenderGraph::Access::FragmentSampled:
+                return {
+                    VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR,
+                    VK_ACCESS_2_SHADER_READ_BIT_KHR,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+            case GenRenderGraph::Access::FragmentStorageRead:
+                return {
+                    VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR,
+                    VK_ACCESS_2_SHADER_READ_BIT_KHR,
+                    VK_IMAGE_LAYOUT_GENERAL};
+            case GenRenderGraph::Access::ComputeStorageRead:
+                return {
+                    VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
+                    VK_ACCESS_2_SHADER_READ_BIT_KHR,
+                    VK_IMAGE_LAYOUT_GENERAL};
+            case GenRenderGraph::Access::ComputeStorageWrite:
+                return {
+                    VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
+                    VK_ACCESS_2_SHADER_WRITE_BIT_KHR,
+                    VK_IMAGE_LAYOUT_GENERAL};
+            case GenRenderGraph::Access::TransferRead:
+                return {
+                    VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR,
+                    VK_ACCESS_2_TRANSFER_READ_BIT_KHR,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL};
+            case GenRenderGraph::Access::TransferWrite:
+                return {
+                    VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR,
+                    VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL};
+            }
+            throw std::runtime_error("unknown render graph access!");
+        }
+
+        // FNV-1a, field by field so padding never ends up in the hash
+        constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+        constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+        template <typename T>
+        void hashValue(uint64_t &hash, const T &value)
+        {
+            const auto *bytes = reinterpret_cast<const uint8_t *>(&value);
+            for (size_t i = 0; i < sizeof(T); i++)
+            {
+                hash ^= bytes[i];
+                hash *= FNV_PRIME;
+            }
+        }
+
+        bool livesOverlap(uint32_t firstA, uint32_t lastA, uint32_t firstB, uint32_t lastB)
+        {
+            return firstA <= lastB && firstB <= lastA;
+        }
+
+        bool memoryOverlaps(VkDeviceSize offsetA, VkDeviceSize sizeA, VkDeviceSize offsetB, VkDeviceSize sizeB)
+        {
+            return offsetA < offsetB + sizeB && offsetB < offsetA + sizeA;
+        }
+    }
+
+    GenRenderGraph::PassBuilder &GenRenderGraph::PassBuilder::read(ResourceId resource, Access access)
+    {
+        return use(resource, access, false, VK_IMAGE_LAYOUT_UNDEFINED);
+    }
+
+    GenRenderGraph::PassBuilder &GenRenderGraph::PassBuilder::write(ResourceId resource, Access access)
+    {
+        return use(resource, access, true, VK_IMAGE_LAYOUT_UNDEFINED);
+    }
+
+    GenRenderGraph::PassBuilder &GenRenderGraph::PassBuilder::attachment(
+        ResourceId resource,
+        Access access,
+        VkImageLayout finalLayout)
+    {
+        assert(graph.resources[resource].isImage && "Only images can be attachments");
+        assert(finalLayout != VK_IMAGE_LAYOUT_UNDEFINED && "Attachments need a final layout");
+        return use(resource, access, true, finalLayout);
+    }
+
+    GenRenderGraph::PassBuilder &GenRenderGraph::PassBuilder::sideEffect()
+    {
+        graph.passes[pass].sideEffect = true;
+        return *this;
+    }
+
+    GenRenderGraph::PassBuilder &GenRenderGraph::PassBuilder::use(
+        ResourceId resource,
+        Access access,
+        bool write,
+        VkImageLayout finalLayout)
+    {
+        assert(resource < graph.resources.size() && "Unknown render graph resource");
+        const Resource &declared = graph.resources[resource];
+        AccessInfo info = accessInfo(access);
+        VkImageLayout layout = declared.isImage ? info.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+
+        auto &uses = graph.passes[pass].uses;
+        auto existing = std::find_if(
+            uses.begin(),
+            uses.end(),
+            [resource](const Use &use)
+            { return use.resource == resource; });
+        if (existing == uses.end())
+        {
+            uses.push_back({resource, info.stages, info.accesses, layout, write, finalLayout});
+            return *this;
+        }
+
+        // the render pass moves the attachment between the layouts of its subpasses itself
+        existing->stages |= info.stages;
+        existing->accesses |= info.accesses;
+        existing->write |= write;
+        if (finalLayout != VK_IMAGE_LAYOUT_UNDEFINED)
+        {
+            existing->layout = layout;
+            existing->renderPassFinalLayout = finalLayout;
+        }
+        else if (existing->renderPassFinalLayout == VK_IMAGE_LAYOUT_UNDEFINED && existing->layout != layout)
+        {
+            throw std::runtime_error("failed to merge uses of '" + declared.name + "' needing different layouts!");
+        }
+        return *this;
+    }
+
+    GenRenderGraph::GenRenderGraph(GenDevice &device) : genDevice{device} {}
+
+    GenRenderGraph::~GenRenderGraph()
+    {
+        for (auto &entry : compiledGraphs)
+        {
+            destroyTransients(entry.second);
+        }
+        for (auto heap : heaps)
+        {
+            genDevice.destroyDeferred(VK_OBJECT_TYPE_DEVICE_MEMORY, heap);
+        }
+    }
+
+    void GenRenderGraph::reset()
+    {
+        assert(executingFrame < 0 && "Can't reset the render graph while it executes");
+        resources.clear();
+        passes.clear();
+        current = nullptr;
+    }
+
+    GenRenderGraph::ResourceId GenRenderGraph::importImage(
+        const std::string &name,
+        VkImage image,
+        VkImageView view,
+        VkImageAspectFlags aspect,
+        const ResourceState &initialState)
+    {
+        Resource resource{};
+        resource.name = name;
+        resource.isImage = true;
+        resource.imported = true;
+        resource.desc.aspect = aspect;
+        resource.initialState = initialState;
+        resource.image = image;
+        resource.view = view;
+        resources.push_back(resource);
+        return static_cast<ResourceId>(resources.size() - 1);
+    }
+
+    GenRenderGraph::ResourceId GenRenderGraph::importBuffer(
+        const std::string &name,
+        VkBuffer buffer,
+        const ResourceState &initialState)
+    {
+        Resource resource{};
+        resource.name = name;
+        resource.imported = true;
+        resource.initialState = initialState;
+        resource.buffer = buffer;
+        resources.push_back(resource);
+        return static_cast<ResourceId>(resources.size() - 1);
+    }
+
+    GenRenderGraph::ResourceId GenRenderGraph::createImage(const std::string &name, const ImageDesc &desc)
+    {
+        Resource resource{};
+        resource.name = name;
+        resource.isImage = true;
+        resource.desc = desc;
+        resources.push_back(resource);
+        return static_cast<ResourceId>(resources.size() - 1);
+    }
+
+    void GenRenderGraph::markOutput(ResourceId resource)
+    {
+        assert(resource < resources.size() && "Unknown render graph resource");
+        resources[resource].output = true;
+    }
+
+    GenRenderGraph::PassBuilder GenRenderGraph::addPass(const std::string &name, ExecuteFn execute)
+    {
+        Pass pass{};
+        pass.name = name;
+        pass.execute = std::move(execute);
+        passes.push_back(std::move(pass));
+        return PassBuilder{*this, static_cast<uint32_t>(passes.size() - 1)};
+    }
+
+    void GenRenderGraph::compile()
+    {
+        GEN_PROFILE_SCOPE("GenRenderGraph::compile");
+        frameNumber++;
+
+        uint64_t key = hashDeclarations();
+        auto cached = compiledGraphs.find(key);
+        if (cached != compiledGraphs.end())
+        {
+            current = &cached->second;
+            current->lastUsedFrame = frameNumber;
+            stats.cacheHits++;
+            updateStats();
+            return;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        CompiledGraph graph{};
+        std::vector<uint32_t> order{};
+        cull(order, graph.culledPasses);
+        for (uint32_t pass : order)
+        {
+            graph.passes.push_back({pass, {}});
+        }
+        createTransients(graph);
+        computeBarriers(graph);
+
+        if (compiledGraphs.size() >= MAX_CACHED_GRAPHS)
+        {
+            evictLeastRecentlyUsed();
+        }
+        graph.lastUsedFrame = frameNumber;
+        current = &compiledGraphs.emplace(key, std::move(graph)).first->second;
+
+        double micros = std::chrono::duration<double, std::micro>(
+                            std::chrono::high_resolution_clock::now() - start)
+                            .count();
+        stats.compiles++;
+        stats.lastCompileMicros = micros;
+        stats.totalCompileMicros += micros;
+        updateStats();
+    }
+
+    void GenRenderGraph::execute(VkCommandBuffer commandBuffer, int frameIndex)
+    {
+        GEN_PROFILE_SCOPE("GenRenderGraph::execute");
+        assert(current != nullptr && "Render graph executed before it was compiled");
+        executingFrame = frameIndex;
+
+        for (const CompiledPass &compiled : current->passes)
+        {
+            if (!compiled.barriers.empty())
+            {
+                memoryBarriers.clear();
+                bufferBarriers.clear();
+                imageBarriers.clear();
+
+                for (const Barrier &barrier : compiled.barriers)
+                {
+                    const Resource &resource = resources[barrier.resource];
+                    if (!resource.isImage)
+                    {
+                        VkBufferMemoryBarrier2KHR bufferBarrier{};
+                        bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+                        bufferBarrier.srcStageMask = barrier.src.stages;
+                        bufferBarrier.srcAccessMask = barrier.src.accesses;
+                        bufferBarrier.dstStageMask = barrier.dst.stages;
+                        bufferBarrier.dstAccessMask = barrier.dst.accesses;
+                        bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                        bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                        bufferBarrier.buffer = resource.buffer;
+                        bufferBarrier.offset = 0;
+                        bufferBarrier.size = VK_WHOLE_SIZE;
+                        bufferBarriers.push_back(bufferBarrier);
+                    }
+                    else if (barrier.memoryOnly)
+                    {
+                        VkMemoryBarrier2KHR memoryBarrier{};
+                        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+                        memoryBarrier.srcStageMask = barrier.src.stages;
+                        memoryBarrier.srcAccessMask = barrier.src.accesses;
+                        memoryBarrier.dstStageMask = barrier.dst.stages;
+                        memoryBarrier.dstAccessMask = barrier.dst.accesses;
+                        memoryBarriers.push_back(memoryBarrier);
+                    }
+                    else
+                    {
+                        VkImageMemoryBarrier2KHR imageBarrier{};
+                        imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+                        imageBarrier.srcStageMask = barrier.src.stages;
+                        imageBarrier.srcAccessMask = barrier.src.accesses;
+                        imageBarrier.dstStageMask = barrier.dst.stages;
+                        imageBarrier.dstAccessMask = barrier.dst.accesses;
+                        imageBarrier.oldLayout = barrier.src.layout;
+                        imageBarrier.newLayout = barrier.dst.layout;
+                        imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                        imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                        imageBarrier.image = getImage(barrier.resource);
+                        imageBarrier.subresourceRange.aspectMask = resource.desc.aspect;
+                        imageBarrier.subresourceRange.baseMipLevel = 0;
+                        imageBarrier.subresourceRange.levelCount = 1;
+                        imageBarrier.subresourceRange.baseArrayLayer = 0;
+                        imageBarrier.subresourceRange.layerCount = 1;
+                        imageBarriers.push_back(imageBarrier);
+                    }
+                }
+
+                VkDependencyInfoKHR dependencyInfo{};
+                dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+                dependencyInfo.memoryBarrierCount = static_cast<uint32_t>(memoryBarriers.size());
+                dependencyInfo.pMemoryBarriers = memoryBarriers.data();
+                dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferBarriers.size());
+                dependencyInfo.pBufferMemoryBarriers = bufferBarriers.data();
+                dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+                dependencyInfo.pImageMemoryBarriers = imageBarriers.data();
+                genDevice.cmdPipelineBarrier2(commandBuffer, dependencyInfo);
+            }
+
+            passes[compiled.pass].execute(commandBuffer);
+        }
+
+        executingFrame = -1;
+    }
+
+    VkImage GenRenderGraph::getImage(ResourceId resource) const
+    {
+        const Resource &declared = resources[resource];
+        if (declared.imported)
+        {
+            return declared.image;
+        }
+        assert(executingFrame >= 0 && "Transient images only exist while the graph executes");
+        uint32_t transient = current->transientOfResource[resource];
+        assert(transient != NO_TRANSIENT && "Image isn't used by any pass left after culling");
+        return current->transients[transient].images[executingFrame];
+    }
+
+    VkImageView GenRenderGraph::getImageView(ResourceId resource) const
+    {
+        const Resource &declared = resources[resource];
+        if (declared.imported)
+        {
+            return declared.view;
+        }
+        assert(executingFrame >= 0 && "Transient images only exist while the graph executes");
+        uint32_t transient = current->transientOfResource[resource];
+        assert(transient != NO_TRANSIENT && "Image isn't used by any pass left after culling");
+        return current->transients[transient].views[executingFrame];
+    }
+
+    VkBuffer GenRenderGraph::getBuffer(ResourceId resource) const
+    {
+        assert(!resources[resource].isImage && "Resource isn't a buffer");
+        return resources[resource].buffer;
+    }
+
+    uint64_t GenRenderGraph::hashDeclarations() const
+    {
+        uint64_t hash = FNV_OFFSET_BASIS;
+        hashValue(hash, resources.size());
+        for (const Resource &resource : resources)
+        {
+            hashValue(hash, resource.isImage);
+            hashValue(hash, resource.imported);
+            hashValue(hash, resource.output);
+            hashValue(hash, resource.desc.format);
+            hashValue(hash, resource.desc.extent.width);
+            hashValue(hash, resource.desc.extent.height);
+            hashValue(hash, resource.desc.usage);
+            hashValue(hash, resource.desc.aspect);
+            hashValue(hash, resource.initialState.stages);
+            hashValue(hash, resource.initialState.accesses);
+            hashValue(hash, resource.initialState.layout);
+        }
+
+        hashValue(hash, passes.size());
+        for (const Pass &pass : passes)
+        {
+            hashValue(hash, pass.sideEffect);
+            hashValue(hash, pass.uses.size());
+            for (const Use &use : pass.uses)
+            {
+                hashValue(hash, use.resource);
+                hashValue(hash, use.stages);
+                hashValue(hash, use.accesses);
+                hashValue(hash, use.layout);
+                hashValue(hash, use.write);
+                hashValue(hash, use.renderPassFinalLayout);
+            }
+        }
+        return hash;
+    }
+
+    void GenRenderGraph::cull(std::vector<uint32_t> &order, uint32_t &culledPasses) const
+    {
+        // walks back from the outputs, a pass is needed if a later needed pass reads what it writes
+        std::vector<bool> needed(resources.size());
+        for (size_t i = 0; i < resources.size(); i++)
+        {
+            needed[i] = resources[i].output;
+        }
+
+        std::vector<bool> kept(passes.size());
+        for (size_t i = passes.size(); i-- > 0;)
+        {
+            const Pass &pass = passes[i];
+            bool keep = pass.sideEffect || std::any_of(
+                                               pass.uses.begin(),
+                                               pass.uses.end(),
+                                               [&needed](const Use &use)
+                                               { return use.write && needed[use.resource]; });
+            if (!keep)
+            {
+                continue;
+            }
+
+            kept[i] = true;
+            for (const Use &use : pass.uses)
+            {
+                if (!use.write)
+                {
+                    needed[use.resource] = true;
+                }
+            }
+        }
+
+        for (uint32_t i = 0; i < passes.size(); i++)
+        {
+            if (kept[i])
+            {
+                order.push_back(i);
+            }
+        }
+        culledPasses = static_cast<uint32_t>(passes.size() - order.size());
+    }
+
+    void GenRenderGraph::createTransients(CompiledGraph &graph)
+    {
+        graph.transientOfResource.assign(resources.size(), NO_TRANSIENT);
+        for (uint32_t position = 0; position < graph.passes.size(); position++)
+        {
+            for (const Use &use : passes[graph.passes[position].pass].uses)
+            {
+                if (resources[use.resource].imported)
+                {
+                    continue;
+                }
+
+                uint32_t &transient = graph.transientOfResource[use.resource];
+                if (transient == NO_TRANSIENT)
+                {
+                    transient = static_cast<uint32_t>(graph.transients.size());
+                    TransientImage image{};
+                    image.resource = use.resource;
+                    image.firstUse = position;
+                    graph.transients.push_back(image);
+                }
+                graph.transients[transient].lastUse = position;
+            }
+        }
+
+        if (graph.transients.empty())
+        {
+            return;
+        }
+
+        VkDevice device = genDevice.device();
+        std::vector<VkMemoryRequirements> requirements(graph.transients.size());
+        for (size_t i = 0; i < graph.transients.size(); i++)
+        {
+            TransientImage &transient = graph.transients[i];
+            const ImageDesc &desc = resources[transient.resource].desc;
+
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.format = desc.format;
+            imageInfo.extent.width = desc.extent.width;
+            imageInfo.extent.height = desc.extent.height;
+            imageInfo.extent.depth = 1;
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.usage = desc.usage;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            for (auto &image : transient.images)
+            {
+                if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("failed to create render graph image!");
+                }
+            }
+
+            // identical images, the first one stands for all frames in flight
+            vkGetImageMemoryRequirements(device, transient.images[0], &requirements[i]);
+            transient.size = requirements[i].size;
+            graph.transientBytes += requirements[i].size * GenSwapChain::MAX_FRAMES_IN_FLIGHT;
+        }
+
+        placeTransients(graph, requirements);
+
+        VkDeviceSize size = 0;
+        uint32_t typeBits = ~0u;
+        for (size_t i = 0; i < graph.transients.size(); i++)
+        {
+            size = std::max(size, graph.transients[i].offset + graph.transients[i].size);
+            typeBits &= requirements[i].memoryTypeBits;
+        }
+        graph.peakBytes = size * GenSwapChain::MAX_FRAMES_IN_FLIGHT;
+        reserveHeaps(size, typeBits);
+
+        for (TransientImage &transient : graph.transients)
+        {
+            const ImageDesc &desc = resources[transient.resource].desc;
+            for (int slot = 0; slot < GenSwapChain::MAX_FRAMES_IN_FLIGHT; slot++)
+            {
+                if (vkBindImageMemory(device, transient.images[slot], heaps[slot], transient.offset) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("failed to bind render graph image memory!");
+                }
+
+                VkImageViewCreateInfo viewInfo{};
+                viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+                viewInfo.image = transient.images[slot];
+                viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+                viewInfo.format = desc.format;
+                viewInfo.subresourceRange.aspectMask = desc.aspect;
+                viewInfo.subresourceRange.baseMipLevel = 0;
+                viewInfo.subresourceRange.levelCount = 1;
+                viewInfo.subresourceRange.baseArrayLayer = 0;
+                viewInfo.subresourceRange.layerCount = 1;
+
+                if (vkCreateImageView(device, &viewInfo, nullptr, &transient.views[slot]) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("failed to create render graph image view!");
+                }
+            }
+        }
+    }
+
+    void GenRenderGraph::placeTransients(CompiledGraph &graph, const std::vector<VkMemoryRequirements> &requirements)
+    {
+        // largest first, each at the lowest offset clear of the images already placed that are alive at the same
+        // time. Images whose lifetimes don't overlap end up sharing memory
+        std::vector<uint32_t> bySize(graph.transients.size());
+        std::iota(bySize.begin(), bySize.end(), 0);
+        std::stable_sort(
+            bySize.begin(),
+            bySize.end(),
+            [&graph](uint32_t a, uint32_t b)
+            { return graph.transients[a].size > graph.transients[b].size; });
+
+        std::vector<uint32_t> placed{};
+        for (uint32_t index : bySize)
+        {
+            TransientImage &image = graph.transients[index];
+            VkDeviceSize alignment = requirements[index].alignment;
+            VkDeviceSize offset = 0;
+
+            // moving past one image can run into another, repeat until nothing overlaps
+            bool moved = true;
+            while (moved)
+            {
+                moved = false;
+                for (uint32_t other : placed)
+                {
+                    const TransientImage &placedImage = graph.transients[other];
+                    if (livesOverlap(image.firstUse, image.lastUse, placedImage.firstUse, placedImage.lastUse) &&
+                        memoryOverlaps(offset, image.size, placedImage.offset, placedImage.size))
+                    {
+                        offset = (placedImage.offset + placedImage.size + alignment - 1) / alignment * alignment;
+                        moved = true;
+                    }
+                }
+            }
+
+            image.offset = offset;
+            placed.push_back(index);
+        }
+    }
+
+    void GenRenderGraph::computeBarriers(CompiledGraph &graph) const
+    {
+        struct Tracked
+        {
+            VkPipelineStageFlags2KHR writeStages;
+            VkAccessFlags2KHR writeAccesses;
+            // accesses since the last write that already wait for it
+            VkPipelineStageFlags2KHR readStages;
+            VkAccessFlags2KHR readAccesses;
+            VkImageLayout layout;
+        };
+
+        std::vector<Tracked> tracked(resources.size());
+        for (size_t i = 0; i < resources.size(); i++)
+        {
+            const ResourceState &initial = resources[i].initialState;
+            tracked[i] = {initial.stages, initial.accesses, 0, 0, initial.layout};
+        }
+
+        // every stage touching each transient, what a later image placed in the same memory has to wait for
+        std::vector<VkPipelineStageFlags2KHR> transientStages(graph.transients.size());
+        for (const CompiledPass &compiled : graph.passes)
+        {
+            for (const Use &use : passes[compiled.pass].uses)
+            {
+                uint32_t transient = graph.transientOfResource[use.resource];
+                if (transient != NO_TRANSIENT)
+                {
+                    transientStages[transient] |= use.stages;
+                }
+            }
+        }
+
+        graph.barrierCount = 0;
+        for (uint32_t position = 0; position < graph.passes.size(); position++)
+        {
+            CompiledPass &compiled = graph.passes[position];
+            const Pass &pass = passes[compiled.pass];
+            for (const Use &use : pass.uses)
+            {
+                const Resource &resource = resources[use.resource];
+                Tracked &state = tracked[use.resource];
+                bool renderPassManaged = use.renderPassFinalLayout != VK_IMAGE_LAYOUT_UNDEFINED;
+                bool transition = false;
+                ResourceState dst{use.stages, use.accesses, use.layout};
+                uint32_t transient = graph.transientOfResource[use.resource];
+
+                if (transient != NO_TRANSIENT && graph.transients[transient].firstUse == position)
+                {
+                    if (!use.write)
+                    {
+                        throw std::runtime_error(
+                            "failed to compile render graph, pass '" + pass.name + "' reads '" + resource.name +
+                            "' before anything writes it!");
+                    }
+
+                    // the images that used the same memory earlier in the frame have to be done with it
+                    const TransientImage &image = graph.transients[transient];
+                    VkPipelineStageFlags2KHR aliasStages = 0;
+                    for (size_t other = 0; other < graph.transients.size(); other++)
+                    {
+                        const TransientImage &earlier = graph.transients[other];
+                        if (earlier.lastUse < position &&
+                            memoryOverlaps(image.offset, image.size, earlier.offset, earlier.size))
+                        {
+                            aliasStages |= transientStages[other];
+                        }
+                    }
+
+                    transition = !renderPassManaged;
+                    if (transition || aliasStages != 0)
+                    {
+                        compiled.barriers.push_back(
+                            {use.resource, {aliasStages, VK_ACCESS_2_NONE_KHR, VK_IMAGE_LAYOUT_UNDEFINED}, dst, renderPassManaged});
+                    }
+                }
+                else
+                {
+                    transition = resource.isImage && !renderPassManaged && use.layout != state.layout;
+                    if (use.write || transition)
+                    {
+                        // writes and layout transitions wait for every earlier access
+                        VkPipelineStageFlags2KHR srcStages = state.writeStages | state.readStages;
+                        if (srcStages != 0 || transition)
+                        {
+                            compiled.barriers.push_back(
+                                {use.resource, {srcStages, state.writeAccesses, state.layout}, dst, renderPassManaged});
+                        }
+                    }
+                    else if (state.writeStages != 0 &&
+                             ((use.stages & ~state.readStages) != 0 || (use.accesses & ~state.readAccesses) != 0))
+                    {
+                        // reads only wait for the last write, once per stage and access
+                        compiled.barriers.push_back(
+                            {use.resource, {state.writeStages, state.writeAccesses, state.layout}, dst, false});
+                    }
+                }
+
+                if (use.write)
+                {
+                    state.writeStages = use.stages;
+                    state.writeAccesses = use.accesses;
+                    state.readStages = 0;
+                    state.readAccesses = 0;
+                    state.layout = renderPassManaged ? use.renderPassFinalLayout : use.layout;
+                }
+                else if (transition)
+                {
+                    // the transition waited for the earlier reads, later writes only have to wait for this one
+                    state.readStages = use.stages;
+                    state.readAccesses = use.accesses;
+                    state.layout = use.layout;
+                }
+                else
+                {
+                    state.readStages |= use.stages;
+                    state.readAccesses |= use.accesses;
+                }
+            }
+            graph.barrierCount += static_cast<uint32_t>(compiled.barriers.size());
+        }
+    }
+
+    void GenRenderGraph::reserveHeaps(VkDeviceSize size, uint32_t typeBits)
+    {
+        if (typeBits == 0)
+        {
+            throw std::runtime_error("failed to find a memory type every render graph image can use!");
+        }
+
+        bool compatible = heaps[0] != VK_NULL_HANDLE && (typeBits & (1u << heapMemoryType)) != 0;
+        if (compatible && size <= heapSize)
+        {
+            return;
+        }
+
+        // the cached graphs' images are bound to the old heaps. Frames still using them finish first, see
+        // GenDevice::destroyDeferred
+        for (auto &entry : compiledGraphs)
+        {
+            destroyTransients(entry.second);
+        }
+        compiledGraphs.clear();
+        current = nullptr;
+        for (auto &heap : heaps)
+        {
+            genDevice.destroyDeferred(VK_OBJECT_TYPE_DEVICE_MEMORY, heap);
+            heap = VK_NULL_HANDLE;
+        }
+
+        // never shrinks, a graph switching back shouldn't have to reallocate again
+        heapSize = std::max(size, heapSize);
+        heapMemoryType = genDevice.findMemoryType(typeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        VkMemoryRequirements requirements{};
+        requirements.size = heapSize;
+        requirements.memoryTypeBits = 1u << heapMemoryType;
+        for (auto &heap : heaps)
+        {
+            heap = genDevice.allocateMemory(requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            if (heap == VK_NULL_HANDLE)
+            {
+                throw std::runtime_error("failed to allocate render graph memory!");
+            }
+        }
+    }
+
+    void GenRenderGraph::destroyTransients(CompiledGraph &graph)
+    {
+        for (TransientImage &transient : graph.transients)
+        {
+            for (int slot = 0; slot < GenSwapChain::MAX_FRAMES_IN_FLIGHT; slot++)
+            {
+                genDevice.destroyDeferred(VK_OBJECT_TYPE_IMAGE_VIEW, transient.views[slot]);
+                genDevice.destroyDeferred(VK_OBJECT_TYPE_IMAGE, transient.images[slot]);
+            }
+        }
+        if (!graph.transients.empty())
+        {
+            generation++;
+        }
+        graph.transients.clear();
+    }
+
+    void GenRenderGraph::evictLeastRecentlyUsed()
+    {
+        auto oldest = std::min_element(
+            compiledGraphs.begin(),
+            compiledGraphs.end(),
+            [](const auto &a, const auto &b)
+            { return a.second.lastUsedFrame < b.second.lastUsedFrame; });
+        destroyTransients(oldest->second);
+        compiledGraphs.erase(oldest);
+    }
+
+    void GenRenderGraph::updateStats()
+    {
+        stats.passCount = static_cast<uint32_t>(current->passes.size());
+        stats.culledPasses = current->culledPasses;
+        stats.barrierCount = current->barrierCount;
+        stats.transientImages = static_cast<uint32_t>(current->transients.size());
+        stats.cachedGraphs = static_cast<uint32_t>(compiledGraphs.size());
+
+        stats.transientBytes = current->transientBytes;
+        stats.peakBytes = current->peakBytes;
+        stats.cachedPeakBytes = 0;
+        for (const auto &entry : compiledGraphs)
+        {
+            stats.cachedPeakBytes += entry.second.peakBytes;
+        }
+        stats.heapBytes = heaps[0] != VK_NULL_HANDLE ? heapSize * GenSwapChain::MAX_FRAMES_IN_FLIGHT : 0;
+    }
+}
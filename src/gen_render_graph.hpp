@@ -0,0 +1,256 @@
+#pragma once
+
+#include "gen_device.hpp"
+#include "gen_swap_chain.hpp"
+
+// std
+#include <array>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gen
+{
+    // Frame graph. Every frame the passes are declared again together with the images and buffers they read and
+    // write. compile culls the passes whose results nothing uses, places the transient images of the remaining
+    // passes in memory shared with every image whose lifetime doesn't overlap theirs, and works out the barriers
+    // between the passes; execute records the passes in declaration order.
+    // Compiled graphs are cached by their declarations, a frame declaring the same passes and resources as an
+    // earlier one skips straight to recording. All cached graphs place their transient images in the same
+    // memory, one heap per frame in flight, since only one of them runs per frame.
+    class GenRenderGraph
+    {
+    public:
+        using ResourceId = uint32_t;
+        using ExecuteFn = std::function<void(VkCommandBuffer commandBuffer)>;
+
+        // compiled graphs kept with their transient images, a render path switch doesn't have to compile again
+        static constexpr uint32_t MAX_CACHED_GRAPHS = 4;
+
+        // how a pass uses a resource, each maps to the stages, accesses and image layout it needs
+        enum class Access
+        {
+            ColorAttachment,
+            DepthAttachment,
+            InputAttachment,
+            FragmentSampled,
+            FragmentStorageRead,
+            ComputeStorageRead,
+            ComputeStorageWrite,
+            TransferRead,
+            TransferWrite
+        };
+
+        // 2d, single mip and layer. Only lives within the frame, the contents are undefined at its first use
+        struct ImageDesc
+        {
+            VkFormat format = VK_FORMAT_UNDEFINED;
+            VkExtent2D extent{};
+            VkImageUsageFlags usage = 0;
+            VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        };
+
+        // last access to an imported resource before the graph, the first pass using it waits for it
+        struct ResourceState
+        {
+            VkPipelineStageFlags2KHR stages = VK_PIPELINE_STAGE_2_NONE_KHR;
+            VkAccessFlags2KHR accesses = VK_ACCESS_2_NONE_KHR;
+            VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        };
+
+        struct Stats
+        {
+            // of the graph executed last
+            uint32_t passCount = 0;
+            uint32_t culledPasses = 0;
+            uint32_t barrierCount = 0;
+            uint32_t transientImages = 0;
+            uint64_t compiles = 0;
+            // frames whose declarations matched a cached graph
+            uint64_t cacheHits = 0;
+            double lastCompileMicros = 0.0;
+            double totalCompileMicros = 0.0;
+            uint32_t cachedGraphs = 0;
+            // all of these count every frame in flight. The transient images of the graph executed last as
+            // separate allocations, and the peak of its images alive at the same time it's placed in instead
+            VkDeviceSize transientBytes = 0;
+            VkDeviceSize peakBytes = 0;
+            // the peaks of all cached graphs added up, and the heaps they share instead since only one of them
+            // executes at a time
+            VkDeviceSize cachedPeakBytes = 0;
+            VkDeviceSize heapBytes = 0;
+        };
+
+        class PassBuilder
+        {
+        public:
+            PassBuilder &read(ResourceId resource, Access access);
+            PassBuilder &write(ResourceId resource, Access access);
+            // attachment of a VkRenderPass begun by the pass, which transitions it from UNDEFINED to finalLayout
+            // itself. The graph only orders the pass after earlier accesses
+            PassBuilder &attachment(ResourceId resource, Access access, VkImageLayout finalLayout);
+            // keeps the pass even if nothing uses what it writes
+            PassBuilder &sideEffect();
+
+        private:
+            friend class GenRenderGraph;
+
+            PassBuilder(GenRenderGraph &graph, uint32_t pass) : graph{graph}, pass{pass} {}
+            PassBuilder &use(ResourceId resource, Access access, bool write, VkImageLayout finalLayout);
+
+            GenRenderGraph &graph;
+            uint32_t pass;
+        };
+
+        GenRenderGraph(GenDevice &device);
+        // queues the transient images and their heaps for GenDevice::destroyDeferred
+        ~GenRenderGraph();
+
+        GenRenderGraph(const GenRenderGraph &) = delete;
+        GenRenderGraph &operator=(const GenRenderGraph &) = delete;
+
+        // drops the passes and resources declared for the previous frame
+        void reset();
+
+        ResourceId importImage(
+            const std::string &name,
+            VkImage image,
+            VkImageView view,
+            VkImageAspectFlags aspect,
+            const ResourceState &initialState);
+        ResourceId importBuffer(const std::string &name, VkBuffer buffer, const ResourceState &initialState = {});
+        ResourceId createImage(const std::string &name, const ImageDesc &desc);
+        // its contents are used after the frame, so the passes writing it are never culled
+        void markOutput(ResourceId resource);
+
+        // passes run in the order they were added, a pass may only read what earlier passes wrote
+        PassBuilder addPass(const std::string &name, ExecuteFn execute);
+
+        void compile();
+        // records the passes left after culling with the barriers they need. frameIndex picks the transient
+        // images, which exist once per frame in flight
+        void execute(VkCommandBuffer commandBuffer, int frameIndex);
+
+        // during execute
+        VkImage getImage(ResourceId resource) const;
+        VkImageView getImageView(ResourceId resource) const;
+        VkBuffer getBuffer(ResourceId resource) const;
+
+        // changes whenever transient images were destroyed, caches of their views have to be dropped
+        uint64_t getGeneration() const { return generation; }
+        const Stats &getStats() const { return stats; }
+
+    private:
+        static constexpr uint32_t NO_TRANSIENT = ~0u;
+
+        struct Resource
+        {
+            std::string name;
+            bool isImage = false;
+            bool imported = false;
+            bool output = false;
+            ImageDesc desc{};
+            ResourceState initialState{};
+            VkImage image = VK_NULL_HANDLE;
+            VkImageView view = VK_NULL_HANDLE;
+            VkBuffer buffer = VK_NULL_HANDLE;
+        };
+
+        // every use of one resource by a pass, merged
+        struct Use
+        {
+            ResourceId resource;
+            VkPipelineStageFlags2KHR stages;
+            VkAccessFlags2KHR accesses;
+            VkImageLayout layout;
+            bool write;
+            // VK_IMAGE_LAYOUT_UNDEFINED unless the pass's render pass transitions the attachment itself
+            VkImageLayout renderPassFinalLayout;
+        };
+
+        struct Pass
+        {
+            std::string name;
+            ExecuteFn execute;
+            std::vector<Use> uses;
+            bool sideEffect = false;
+        };
+
+        struct Barrier
+        {
+            ResourceId resource;
+            ResourceState src;
+            ResourceState dst;
+            // no layout transition, for attachments whose layout the render pass manages
+            bool memoryOnly;
+        };
+
+        struct CompiledPass
+        {
+            uint32_t pass;
+            std::vector<Barrier> barriers;
+        };
+
+        struct TransientImage
+        {
+            ResourceId resource;
+            VkDeviceSize offset = 0;
+            VkDeviceSize size = 0;
+            // positions in the compiled pass order
+            uint32_t firstUse = 0;
+            uint32_t lastUse = 0;
+            std::array<VkImage, GenSwapChain::MAX_FRAMES_IN_FLIGHT> images{};
+            std::array<VkImageView, GenSwapChain::MAX_FRAMES_IN_FLIGHT> views{};
+        };
+
+        struct CompiledGraph
+        {
+            std::vector<CompiledPass> passes;
+            std::vector<TransientImage> transients;
+            // indexed by resource id
+            std::vector<uint32_t> transientOfResource;
+            uint32_t culledPasses = 0;
+            uint32_t barrierCount = 0;
+            VkDeviceSize transientBytes = 0;
+            // of the heap range its images are placed in
+            VkDeviceSize peakBytes = 0;
+            uint64_t lastUsedFrame = 0;
+        };
+
+        // 64 bit hash of everything compile depends on, which leaves out the handles of imported resources
+        uint64_t hashDeclarations() const;
+        void cull(std::vector<uint32_t> &order, uint32_t &culledPasses) const;
+        void createTransients(CompiledGraph &graph);
+        void placeTransients(CompiledGraph &graph, const std::vector<VkMemoryRequirements> &requirements);
+        void computeBarriers(CompiledGraph &graph) const;
+        // makes the heaps at least size bytes of a type in typeBits, dropping every cached graph if they have to
+        // be reallocated
+        void reserveHeaps(VkDeviceSize size, uint32_t typeBits);
+        void destroyTransients(CompiledGraph &graph);
+        void evictLeastRecentlyUsed();
+        void updateStats();
+
+        GenDevice &genDevice;
+
+        std::vector<Resource> resources{};
+        std::vector<Pass> passes{};
+
+        std::unordered_map<uint64_t, CompiledGraph> compiledGraphs{};
+        CompiledGraph *current = nullptr;
+        uint64_t frameNumber = 0;
+        int executingFrame = -1;
+        uint64_t generation = 0;
+
+        std::array<VkDeviceMemory, GenSwapChain::MAX_FRAMES_IN_FLIGHT> heaps{};
+        VkDeviceSize heapSize = 0;
+        uint32_t heapMemoryType = 0;
+
+        // reused by execute so recording doesn't allocate
+        std::vector<VkMemoryBarrier2KHR> memoryBarriers{};
+        std::vector<VkBufferMemoryBarrier2KHR> bufferBarriers{};
+        std::vector<VkImageMemoryBarrier2KHR> imageBarriers{};
+
+        Stats stats{};
+    };
+}
@@ -1,43 +1,73 @@
 #include "gen_renderer.hpp"
+#include "gen_cpu_profiler.hpp"
 
 // std
 #include <stdexcept>
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cmath>
 
 namespace gen
 {
 
-    GenRenderer::GenRenderer(GenWindow &window, GenDevice &device) : genWindow{window}, genDevice{device}
+    GenRenderer::GenRenderer(GenWindow &window, GenDevice &device, GenJobSystem &jobSystem)
+        : genWindow{window}, genDevice{device}
     {
         recreateSwapChain();
         createCommandBuffers();
+        parallelRecorder = std::make_unique<GenParallelRecorder>(genDevice, jobSystem);
+        // per thread pools start small, most threads never allocate a transient set
+        frameDescriptorAllocator = std::make_unique<GenFrameDescriptorAllocator>(
+            genDevice,
+            jobSystem,
+            16,
+            std::vector<GenDescriptorAllocator::PoolSizeRatio>{
+                {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.f},
+                {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.f},
+                {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2.f},
+                {VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1.f}});
+        if (genDevice.supportsBindless())
+        {
+            bindlessDescriptors = std::make_unique<GenBindlessDescriptors>(genDevice);
+        }
+        frameAllocator = std::make_unique<GenFrameAllocator>(genDevice);
+        samplerCache = std::make_unique<GenSamplerCache>(genDevice);
+        renderGraph = std::make_unique<GenRenderGraph>(genDevice);
     }
 
     GenRenderer::~GenRenderer()
     {
+        releaseFramebuffers();
+        renderGraph = nullptr;
+        samplerCache = nullptr;
+        frameAllocator = nullptr;
+        bindlessDescriptors = nullptr;
+        frameDescriptorAllocator = nullptr;
+        parallelRecorder = nullptr;
         freeCommandBuffers();
     }
 
     void GenRenderer::recreateSwapChain()
     {
+        GEN_PROFILE_SCOPE("GenRenderer::recreateSwapChain");
         auto extent = genWindow.getExtent();
         while (extent.width == 0 || extent.height == 0)
         {
             extent = genWindow.getExtent();
-            glfwWaitEvents();
+            genWindow.waitEvents();
         }
 
-        vkDeviceWaitIdle(genDevice.device());
-        genSwapChain = nullptr;
         if (genSwapChain == nullptr)
         {
-            genSwapChain = std::make_unique<GenSwapChain>(genDevice, extent);
+            genSwapChain = std::make_unique<GenSwapChain>(genDevice, extent, presentMode);
         }
         else
         {
+            // no device wait, the frames still in flight render to the old swap chain's images and attachments,
+            // which it hands to the device's deferred deletion queue
             std::shared_ptr<GenSwapChain> oldSwapChain = std::move(genSwapChain);
-            genSwapChain = std::make_unique<GenSwapChain>(genDevice, extent, oldSwapChain);
+            genSwapChain = std::make_unique<GenSwapChain>(genDevice, extent, oldSwapChain, presentMode);
 
             if (!oldSwapChain->compareSwapFormats(*genSwapChain.get()))
             {
@@ -45,35 +75,128 @@ namespace gen
                 // instead of throwing an error, setup a callback notifying the app that a new incompatable renderpass has been created
             }
         }
+        genSwapChain->setFramesInFlight(framesInFlight);
+        releaseFramebuffers();
+        presentModeChanged = false;
+        // the readback buffers went with the old swap chain
+        hasReadback = false;
     }
 
-    void GenRenderer::createCommandBuffers()
+    VkExtent2D GenRenderer::getRenderExtent() const
+    {
+        // rounded, at least one pixel
+        VkExtent2D extent = genSwapChain->getSwapChainExtent();
+        return {
+            std::max(1u, static_cast<uint32_t>(std::lround(extent.width * renderScale))),
+            std::max(1u, static_cast<uint32_t>(std::lround(extent.height * renderScale)))};
+    }
+
+    void GenRenderer::releaseFramebuffers()
+    {
+        // frames still in flight may use them
+        for (auto &entry : framebuffers)
+        {
+            genDevice.destroyDeferred(VK_OBJECT_TYPE_FRAMEBUFFER, entry.second);
+        }
+        framebuffers.clear();
+    }
+
+    VkFramebuffer GenRenderer::getFramebuffer(
+        VkRenderPass renderPass,
+        const VkImageView *attachments,
+        uint32_t attachmentCount)
     {
+        assert(attachmentCount <= 4 && "Framebuffer cache keys hold up to four attachments");
+        // destroyed transient views may come back as new views with the same handle
+        if (renderGraph->getGeneration() != framebufferGeneration)
+        {
+            releaseFramebuffers();
+            framebufferGeneration = renderGraph->getGeneration();
+        }
+
+        std::array<uint64_t, 5> key = {reinterpret_cast<uint64_t>(renderPass)};
+        for (uint32_t i = 0; i < attachmentCount; i++)
+        {
+            key[i + 1] = reinterpret_cast<uint64_t>(attachments[i]);
+        }
+
+        auto cached = framebuffers.find(key);
+        if (cached != framebuffers.end())
+        {
+            return cached->second;
+        }
+
+        VkExtent2D extent = genSwapChain->getSwapChainExtent();
+        VkFramebufferCreateInfo framebufferInfo = {};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = renderPass;
+        framebufferInfo.attachmentCount = attachmentCount;
+        framebufferInfo.pAttachments = attachments;
+        framebufferInfo.width = extent.width;
+        framebufferInfo.height = extent.height;
+        framebufferInfo.layers = 1;
 
+        VkFramebuffer framebuffer;
+        if (vkCreateFramebuffer(genDevice.device(), &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create framebuffer!");
+        }
+        framebuffers[key] = framebuffer;
+        return framebuffer;
+    }
+
+    void GenRenderer::createCommandBuffers()
+    {
+        // one pool per frame in flight, reset as a whole once the frame's fence has signaled
+        commandPools.resize(GenSwapChain::MAX_FRAMES_IN_FLIGHT);
         commandBuffers.resize(GenSwapChain::MAX_FRAMES_IN_FLIGHT);
 
-        VkCommandBufferAllocateInfo allocInfo = {};
-        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool = genDevice.getCommandPool();
-        allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = genDevice.findPhysicalQueueFamilies().graphicsFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
 
-        if (vkAllocateCommandBuffers(genDevice.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS)
+        for (size_t i = 0; i < commandPools.size(); i++)
         {
-            throw std::runtime_error("failed to allocate command buffers!");
+            if (vkCreateCommandPool(genDevice.device(), &poolInfo, nullptr, &commandPools[i]) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create frame command pool!");
+            }
+
+            VkCommandBufferAllocateInfo allocInfo = {};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = commandPools[i];
+            allocInfo.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(genDevice.device(), &allocInfo, &commandBuffers[i]) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate command buffers!");
+            }
         }
     }
 
     void GenRenderer::freeCommandBuffers()
     {
-        vkFreeCommandBuffers(genDevice.device(), genDevice.getCommandPool(), static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+        // destroying the pools frees their command buffers
+        for (auto pool : commandPools)
+        {
+            vkDestroyCommandPool(genDevice.device(), pool, nullptr);
+        }
+        commandPools.clear();
         commandBuffers.clear();
     }
 
     VkCommandBuffer GenRenderer::beginFrame()
     {
+        GEN_PROFILE_SCOPE("GenRenderer::beginFrame");
         assert(!isFrameStarted && "Can't call beginFrame while already in progress");
 
+        if (presentModeChanged)
+        {
+            recreateSwapChain();
+        }
+
         auto result = genSwapChain->acquireNextImage(&currentImageIndex); // fetches the index of the frame we should render to next
 
         if (result == VK_ERROR_OUT_OF_DATE_KHR) // error can occur after the window had been resized
@@ -88,6 +211,20 @@ namespace gen
         }
 
         isFrameStarted = true;
+        // follow the swap chain's slot, a recreated swap chain continues where the previous one left off
+        currentFrameIndex = static_cast<int>(genSwapChain->getCurrentFrame());
+
+        // acquireNextImage waited for this frame's fence, so nothing recorded from its pools is still in use, and
+        // neither is anything queued for deletion up to the frame last submitted from this slot
+        genDevice.completeFrame(slotFrames[currentFrameIndex]);
+        vkResetCommandPool(genDevice.device(), commandPools[currentFrameIndex], 0);
+        parallelRecorder->beginFrame(currentFrameIndex);
+        frameDescriptorAllocator->beginFrame(currentFrameIndex);
+        frameAllocator->beginFrame(currentFrameIndex);
+        if (bindlessDescriptors != nullptr)
+        {
+            bindlessDescriptors->completeFrame(slotFrames[currentFrameIndex]);
+        }
 
         auto commandBuffer = getCurrentCommandBuffer();
         VkCommandBufferBeginInfo beginInfo{};
@@ -101,14 +238,24 @@ namespace gen
     }
     void GenRenderer::endFrame()
     {
+        GEN_PROFILE_SCOPE("GenRenderer::endFrame");
         assert(isFrameStarted && "Can't call endFrame while frame is not in progress");
         auto commandBuffer = getCurrentCommandBuffer();
+        if (frameReadback)
+        {
+            genSwapChain->recordReadback(commandBuffer, currentImageIndex);
+            readbackImageIndex = currentImageIndex;
+            hasReadback = true;
+        }
         if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
         {
             std::runtime_error("failed to record command buffer!");
         }
 
+        slotFrames[currentFrameIndex] = genDevice.getRecordingFrame();
         auto result = genSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex); // submit the provided command buffer to our device graphics queue, while handeling cpu and gpu synchronization
+        // destroyed after the submission, the old swap chain's resources belong to the next frame
+        genDevice.advanceRecordingFrame();
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || genWindow.wasWindowResized())
         {
             genWindow.resetWindowResizedFlag();
@@ -120,40 +267,120 @@ namespace gen
         }
 
         isFrameStarted = false;
-        currentFrameIndex = (currentFrameIndex + 1) % GenSwapChain::MAX_FRAMES_IN_FLIGHT;
     }
-    void GenRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer)
+    bool GenRenderer::readLastFrame(std::vector<uint8_t> &rgba)
+    {
+        assert(!isFrameStarted && "Can't read back a frame while a frame is in progress");
+        if (!hasReadback)
+        {
+            return false;
+        }
+        genSwapChain->readPixels(readbackImageIndex, rgba);
+        return true;
+    }
+
+    void GenRenderer::beginSwapChainRenderPass(
+        VkCommandBuffer commandBuffer,
+        const std::array<VkImageView, 4> &attachments,
+        VkSubpassContents contents)
     {
         assert(isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress");
         assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on command buffer from a diffrent frame");
 
         VkRenderPassBeginInfo renderpassInfo{};
         renderpassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderpassInfo.renderPass = genSwapChain->getRenderPass();
-        renderpassInfo.framebuffer = genSwapChain->getFrameBuffer(currentImageIndex);
 
         renderpassInfo.renderArea.offset = {0, 0};
-        renderpassInfo.renderArea.extent = genSwapChain->getSwapChainExtent();
+        renderpassInfo.renderArea.extent = getRenderExtent();
 
-        std::array<VkClearValue, 2> clearValues{};
+        // attachment order: scene color, depth, followed by the g-buffer for the deferred path
+        // or the transparency accumulation and revealage targets for the forward path
+        std::array<VkClearValue, 4> clearValues{};
         clearValues[0].color = {0.01f, 0.01f, 0.01f, 1.0f};
         clearValues[1].depthStencil = {1.0f, 0};
+        clearValues[2].color = {0.0f, 0.0f, 0.0f, 0.0f};
+        clearValues[3].color = {0.0f, 0.0f, 0.0f, 0.0f};
+
+        if (renderPath == RenderPath::Deferred)
+        {
+            renderpassInfo.renderPass = genSwapChain->getDeferredRenderPass();
+        }
+        else
+        {
+            renderpassInfo.renderPass = genSwapChain->getRenderPass();
+            // nothing revealed behind transparent surfaces yet
+            clearValues[3].color = {1.0f, 0.0f, 0.0f, 0.0f};
+        }
+        renderpassInfo.framebuffer =
+            getFramebuffer(renderpassInfo.renderPass, attachments.data(), static_cast<uint32_t>(attachments.size()));
         renderpassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderpassInfo.pClearValues = clearValues.data();
 
+        // set before the render pass begins, a subpass with secondary command buffer contents can't record it
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(renderpassInfo.renderArea.extent.width);
+        viewport.height = static_cast<float>(renderpassInfo.renderArea.extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        VkRect2D scissor{{0, 0}, renderpassInfo.renderArea.extent};
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
         // record to command buffer
-        vkCmdBeginRenderPass(commandBuffer, &renderpassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBeginRenderPass(commandBuffer, &renderpassInfo, contents);
+        currentRenderPass = renderpassInfo.renderPass;
+        currentFramebuffer = renderpassInfo.framebuffer;
+        currentSubpass = 0;
+    }
+
+    void GenRenderer::beginUpscaleRenderPass(VkCommandBuffer commandBuffer)
+    {
+        assert(isFrameStarted && "Can't call beginUpscaleRenderPass if frame is not in progress");
+        assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on command buffer from a diffrent frame");
+
+        VkImageView swapChainView = genSwapChain->getImageView(currentImageIndex);
+        VkRenderPassBeginInfo renderpassInfo{};
+        renderpassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderpassInfo.renderPass = genSwapChain->getUpscaleRenderPass();
+        renderpassInfo.framebuffer = getFramebuffer(renderpassInfo.renderPass, &swapChainView, 1);
+        renderpassInfo.renderArea.offset = {0, 0};
+        renderpassInfo.renderArea.extent = genSwapChain->getSwapChainExtent();
 
         VkViewport viewport{};
         viewport.x = 0.0f;
         viewport.y = 0.0f;
-        viewport.width = static_cast<float>(genSwapChain->getSwapChainExtent().width);
-        viewport.height = static_cast<float>(genSwapChain->getSwapChainExtent().height);
+        viewport.width = static_cast<float>(renderpassInfo.renderArea.extent.width);
+        viewport.height = static_cast<float>(renderpassInfo.renderArea.extent.height);
         viewport.minDepth = 0.0f;
         viewport.maxDepth = 1.0f;
-        VkRect2D scissor{{0, 0}, genSwapChain->getSwapChainExtent()};
+        VkRect2D scissor{{0, 0}, renderpassInfo.renderArea.extent};
         vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
         vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+        vkCmdBeginRenderPass(commandBuffer, &renderpassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        currentRenderPass = renderpassInfo.renderPass;
+        currentFramebuffer = renderpassInfo.framebuffer;
+        currentSubpass = 0;
+    }
+    void GenRenderer::nextSubpass(VkCommandBuffer commandBuffer, VkSubpassContents contents)
+    {
+        assert(isFrameStarted && "Can't call nextSubpass if frame is not in progress");
+        assert(commandBuffer == getCurrentCommandBuffer() && "Can't advance render pass on command buffer from a diffrent frame");
+        vkCmdNextSubpass(commandBuffer, contents);
+        currentSubpass++;
+    }
+    VkCommandBufferInheritanceInfo GenRenderer::getInheritanceInfo() const
+    {
+        assert(isFrameStarted && "Cannot get inheritance info when frame not in progress");
+
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = currentRenderPass;
+        inheritanceInfo.subpass = currentSubpass;
+        inheritanceInfo.framebuffer = currentFramebuffer;
+        return inheritanceInfo;
     }
     void GenRenderer::endSwapChainRenderPass(VkCommandBuffer commandBuffer)
     {
@@ -1,10 +1,19 @@
 #pragma once
 
+#include "gen_bindless.hpp"
+#include "gen_descriptors.hpp"
 #include "gen_device.hpp"
+#include "gen_frame_allocator.hpp"
+#include "gen_job_system.hpp"
+#include "gen_parallel_recorder.hpp"
+#include "gen_render_graph.hpp"
 #include "gen_swap_chain.hpp"
+#include "gen_texture.hpp"
 #include "gen_window.hpp"
 
 // std
+#include <array>
+#include <map>
 #include <memory>
 #include <vector>
 #include <cassert>
@@ -15,7 +24,7 @@ namespace gen
     {
 
     public:
-        GenRenderer(GenWindow &window, GenDevice &device);
+        GenRenderer(GenWindow &window, GenDevice &device, GenJobSystem &jobSystem);
         ~GenRenderer();
 
         GenRenderer(const GenRenderer &) = delete;
@@ -26,11 +35,50 @@ namespace gen
             return genSwapChain->getRenderPass();
         }
 
+        VkRenderPass getDeferredRenderPass() const
+        {
+            return genSwapChain->getDeferredRenderPass();
+        }
+
+        VkRenderPass getUpscaleRenderPass() const
+        {
+            return genSwapChain->getUpscaleRenderPass();
+        }
+
+        // of the swap chain extent, the render extent keeps it up to rounding, so the projection doesn't depend on
+        // the render scale
         float getAspectRatio() const
         {
             return genSwapChain->extentAspectRatio();
         }
 
+        VkExtent2D getSwapChainExtent() const
+        {
+            return genSwapChain->getSwapChainExtent();
+        }
+
+        VkFormat getSwapChainImageFormat() const
+        {
+            return genSwapChain->getSwapChainImageFormat();
+        }
+
+        // fraction of the swap chain extent the scene render passes draw to. Their attachments keep the full
+        // extent, the scene only covers the top left of them, so changing the scale never reallocates anything
+        float getRenderScale() const
+        {
+            return renderScale;
+        }
+
+        // takes effect at the next beginSwapChainRenderPass
+        void setRenderScale(float scale)
+        {
+            assert(!isFrameStarted && "Can't change the render scale while a frame is in progress");
+            assert(scale > 0.f && scale <= 1.f && "Render scale must be in (0, 1]");
+            renderScale = scale;
+        }
+
+        VkExtent2D getRenderExtent() const;
+
         bool isFrameInProgress() const
         {
             return isFrameStarted;
@@ -48,23 +96,194 @@ namespace gen
             return currentFrameIndex;
         }
 
+        uint32_t getImageIndex() const
+        {
+            assert(isFrameStarted && "Cannot get image index when frame not in progress");
+            return currentImageIndex;
+        }
+
+        VkImage getSwapChainImage() const
+        {
+            assert(isFrameStarted && "Cannot get swap chain image when frame not in progress");
+            return genSwapChain->getImage(currentImageIndex);
+        }
+
+        VkImageView getSwapChainImageView() const
+        {
+            assert(isFrameStarted && "Cannot get swap chain image when frame not in progress");
+            return genSwapChain->getImageView(currentImageIndex);
+        }
+
+        VkFormat getDepthFormat() const
+        {
+            return genSwapChain->getDepthFormat();
+        }
+
+        // layout both render passes leave the swap chain image in
+        VkImageLayout getFinalColorLayout() const
+        {
+            return genSwapChain->finalColorLayout();
+        }
+
+        // declares the frame's passes, its transient images hold the depth, g-buffer and transparency attachments
+        GenRenderGraph &getRenderGraph()
+        {
+            return *renderGraph;
+        }
+
+        RenderPath getRenderPath() const
+        {
+            return renderPath;
+        }
+
+        // takes effect at the next beginSwapChainRenderPass
+        void setRenderPath(RenderPath path)
+        {
+            assert(!isFrameStarted && "Can't change the render path while a frame is in progress");
+            renderPath = path;
+        }
+
+        GenParallelRecorder &getParallelRecorder()
+        {
+            return *parallelRecorder;
+        }
+
+        // descriptor sets that only live for the current frame, allocated from any recording thread
+        GenFrameDescriptorAllocator &getFrameDescriptorAllocator()
+        {
+            return *frameDescriptorAllocator;
+        }
+
+        // shared by every texture, see GenTexture
+        GenSamplerCache &getSamplerCache()
+        {
+            return *samplerCache;
+        }
+
+        // transient uniform data of the current frame, bound with dynamic offsets
+        GenFrameAllocator &getFrameAllocator()
+        {
+            return *frameAllocator;
+        }
+
+        // the global bindless set, nullptr if the device doesn't support descriptor indexing
+        GenBindlessDescriptors *getBindlessDescriptors()
+        {
+            return bindlessDescriptors.get();
+        }
+
+        // fewer frames in flight lower latency, more keep the gpu busy when cpu frame times vary
+        uint32_t getFramesInFlight() const
+        {
+            return framesInFlight;
+        }
+
+        void setFramesInFlight(uint32_t count)
+        {
+            assert(!isFrameStarted && "Can't change frames in flight while a frame is in progress");
+            framesInFlight = count;
+            genSwapChain->setFramesInFlight(count);
+        }
+
+        // the mode actually in use, which falls back to FIFO if the requested one isn't supported
+        VkPresentModeKHR getPresentMode() const
+        {
+            return genSwapChain->getPresentMode();
+        }
+
+        // recreates the swap chain at the next beginFrame
+        void setPresentMode(VkPresentModeKHR mode)
+        {
+            presentModeChanged |= mode != presentMode;
+            presentMode = mode;
+        }
+
+        // blocks until the next frame's slot is free, call before sampling input to keep input to present
+        // latency low, beginFrame otherwise does the same wait
+        void waitForNextFrame()
+        {
+            assert(!isFrameStarted && "Can't wait for the next frame while a frame is in progress");
+            genSwapChain->waitForCurrentFrame();
+        }
+
+        // cpu time the last submitted frame spent blocked in the swap chain
+        const FrameWaitTimes &getLastFrameWaitTimes() const
+        {
+            return genSwapChain->getLastFrameWaitTimes();
+        }
+
+        bool isHeadless() const
+        {
+            return genDevice.isHeadless();
+        }
+
+        // headless only: copies every frame's color image to host memory so readLastFrame can return it
+        void setFrameReadback(bool enabled)
+        {
+            assert(genDevice.isHeadless() && "Frame readback needs a headless device");
+            frameReadback = enabled;
+        }
+
+        // waits for the last frame submitted with readback enabled and returns its pixels as RGBA8 rows,
+        // false if there is none
+        bool readLastFrame(std::vector<uint8_t> &rgba);
+
         VkCommandBuffer beginFrame();
         void endFrame();
-        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        // begins the render pass of the render path, drawing to the render extent. Attachments: scene color, depth,
+        // followed by the g-buffer albedo and normal for the deferred path or the transparency accumulation and
+        // revealage targets for the forward path, all with the swap chain extent.
+        // contents VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS for subpasses recorded with the parallel recorder
+        void beginSwapChainRenderPass(
+            VkCommandBuffer commandBuffer,
+            const std::array<VkImageView, 4> &attachments,
+            VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+        // begins the upscale render pass drawing to the whole swap chain image, end it with endSwapChainRenderPass
+        void beginUpscaleRenderPass(VkCommandBuffer commandBuffer);
+        void nextSubpass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        // render pass, subpass and framebuffer secondary command buffers for the current subpass have to inherit
+        VkCommandBufferInheritanceInfo getInheritanceInfo() const;
 
     private:
         void createCommandBuffers();
         void freeCommandBuffers();
+        // doesn't wait for the device, frames in flight finish on the replaced swap chain
         void recreateSwapChain();
+        // the views of the cached framebuffers are about to be destroyed
+        void releaseFramebuffers();
+        VkFramebuffer getFramebuffer(VkRenderPass renderPass, const VkImageView *attachments, uint32_t attachmentCount);
 
         GenWindow &genWindow;
         GenDevice &genDevice;
         std::unique_ptr<GenSwapChain> genSwapChain;
+        // GenDevice frame number last submitted from each slot, completed once the slot's fence was waited on
+        std::array<uint64_t, GenSwapChain::MAX_FRAMES_IN_FLIGHT> slotFrames{};
+        std::vector<VkCommandPool> commandPools;
         std::vector<VkCommandBuffer> commandBuffers;
+        std::unique_ptr<GenParallelRecorder> parallelRecorder;
+        std::unique_ptr<GenFrameDescriptorAllocator> frameDescriptorAllocator;
+        std::unique_ptr<GenBindlessDescriptors> bindlessDescriptors;
+        std::unique_ptr<GenFrameAllocator> frameAllocator;
+        std::unique_ptr<GenSamplerCache> samplerCache;
+        std::unique_ptr<GenRenderGraph> renderGraph;
+        // keyed by render pass and attachment views, the graph's transient views repeat every few frames
+        std::map<std::array<uint64_t, 5>, VkFramebuffer> framebuffers;
+        uint64_t framebufferGeneration = 0;
 
         uint32_t currentImageIndex;
         int currentFrameIndex = 0;
         bool isFrameStarted;
+        VkRenderPass currentRenderPass = VK_NULL_HANDLE;
+        VkFramebuffer currentFramebuffer = VK_NULL_HANDLE;
+        uint32_t currentSubpass = 0;
+        RenderPath renderPath = RenderPath::Forward;
+        float renderScale = 1.f;
+        uint32_t framesInFlight = GenSwapChain::DEFAULT_FRAMES_IN_FLIGHT;
+        VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+        bool presentModeChanged = false;
+        bool frameReadback = false;
+        bool hasReadback = false;
+        uint32_t readbackImageIndex = 0;
     };
 }
\ No newline at end of file
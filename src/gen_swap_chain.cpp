@@ -1,7 +1,10 @@
 #include "gen_swap_chain.hpp"
+#include "gen_cpu_profiler.hpp"
 
 // std
 #include <array>
+#include <cassert>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
@@ -12,61 +15,92 @@
 namespace gen
 {
 
-  GenSwapChain::GenSwapChain(GenDevice &deviceRef, VkExtent2D extent)
-      : device{deviceRef}, windowExtent{extent}
+  namespace
+  {
+    float microsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+      return std::chrono::duration<float, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+  }
+
+  GenSwapChain::GenSwapChain(GenDevice &deviceRef, VkExtent2D extent, VkPresentModeKHR preferredPresentMode)
+      : device{deviceRef}, windowExtent{extent}, presentMode{preferredPresentMode}
   {
     init();
   }
 
-  GenSwapChain::GenSwapChain(GenDevice &deviceRef, VkExtent2D extent, std::shared_ptr<GenSwapChain> previous)
-      : device{deviceRef}, windowExtent{extent}, oldSwapChain{previous}
+  GenSwapChain::GenSwapChain(
+      GenDevice &deviceRef,
+      VkExtent2D extent,
+      std::shared_ptr<GenSwapChain> previous,
+      VkPresentModeKHR preferredPresentMode)
+      : device{deviceRef}, windowExtent{extent}, presentMode{preferredPresentMode}, oldSwapChain{previous}
   {
+    // the fences still track the frames in flight on the previous swap chain, and the slot keeps counting so
+    // per frame resources indexed by it stay guarded by the same fence
+    imageAvailableSemaphores = std::move(previous->imageAvailableSemaphores);
+    renderFinishedSemaphores = std::move(previous->renderFinishedSemaphores);
+    inFlightFences = std::move(previous->inFlightFences);
+    previous->imageAvailableSemaphores.clear();
+    previous->renderFinishedSemaphores.clear();
+    previous->inFlightFences.clear();
+    currentFrame = previous->currentFrame;
+    framesInFlight = previous->framesInFlight;
+    frameWaitTimes = previous->frameWaitTimes;
+    lastFrameWaitTimes = previous->lastFrameWaitTimes;
+
     init();
 
-    // clean up old swap chain since it's no longer needed
+    // only needed as oldSwapchain, the caller decides when the previous one can be destroyed
     oldSwapChain = nullptr;
   }
 
   void GenSwapChain::init()
   {
-    createSwapChain();
+    if (isHeadless())
+    {
+      createOffscreenImages();
+    }
+    else
+    {
+      createSwapChain();
+    }
     createImageViews();
+    swapChainDepthFormat = findDepthFormat();
     createRenderPass();
-    createDepthResources();
-    createFramebuffers();
+    createDeferredRenderPass();
+    createUpscaleRenderPass();
     createSyncObjects();
   }
 
   GenSwapChain::~GenSwapChain()
   {
+    // frames still in flight may render to these, a replaced swap chain is destroyed right after its successor
+    // was created
     for (auto imageView : swapChainImageViews)
     {
-      vkDestroyImageView(device.device(), imageView, nullptr);
+      device.destroyDeferred(VK_OBJECT_TYPE_IMAGE_VIEW, imageView);
     }
     swapChainImageViews.clear();
 
     if (swapChain != nullptr)
     {
-      vkDestroySwapchainKHR(device.device(), swapChain, nullptr);
+      device.destroyDeferred(VK_OBJECT_TYPE_SWAPCHAIN_KHR, swapChain);
       swapChain = nullptr;
     }
 
-    for (int i = 0; i < depthImages.size(); i++)
+    for (size_t i = 0; i < offscreenImageMemorys.size(); i++)
     {
-      vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-      vkDestroyImage(device.device(), depthImages[i], nullptr);
-      vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+      device.destroyDeferred(VK_OBJECT_TYPE_IMAGE, swapChainImages[i]);
+      device.destroyDeferred(VK_OBJECT_TYPE_DEVICE_MEMORY, offscreenImageMemorys[i]);
     }
 
-    for (auto framebuffer : swapChainFramebuffers)
-    {
-      vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
-    }
-
-    vkDestroyRenderPass(device.device(), renderPass, nullptr);
+    device.destroyDeferred(VK_OBJECT_TYPE_RENDER_PASS, renderPass);
+    device.destroyDeferred(VK_OBJECT_TYPE_RENDER_PASS, deferredRenderPass);
+    device.destroyDeferred(VK_OBJECT_TYPE_RENDER_PASS, upscaleRenderPass);
 
-    // cleanup synchronization objects
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    // cleanup synchronization objects, unless a newer swap chain took them over
+    for (size_t i = 0; i < inFlightFences.size(); i++)
     {
       vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
       vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
@@ -74,15 +108,39 @@ namespace gen
     }
   }
 
-  VkResult GenSwapChain::acquireNextImage(uint32_t *imageIndex)
+  void GenSwapChain::waitForCurrentFrame()
   {
+    GEN_PROFILE_SCOPE("GenSwapChain::waitForCurrentFrame");
+    auto start = std::chrono::high_resolution_clock::now();
     vkWaitForFences(
         device.device(),
         1,
         &inFlightFences[currentFrame],
         VK_TRUE,
         std::numeric_limits<uint64_t>::max());
+    frameWaitTimes.fenceMicros += microsSince(start);
+  }
 
+  void GenSwapChain::setFramesInFlight(uint32_t count)
+  {
+    assert(count >= 1 && count <= MAX_FRAMES_IN_FLIGHT && "Frames in flight must be between 1 and MAX_FRAMES_IN_FLIGHT");
+    // the slot in use keeps its index until the frame is submitted, the next one wraps to the new count
+    framesInFlight = count;
+  }
+
+  VkResult GenSwapChain::acquireNextImage(uint32_t *imageIndex)
+  {
+    // returns immediately if the caller already waited
+    waitForCurrentFrame();
+
+    if (isHeadless())
+    {
+      // one offscreen image per frame slot, the fence wait above already made it available
+      *imageIndex = static_cast<uint32_t>(currentFrame);
+      return VK_SUCCESS;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
     VkResult result = vkAcquireNextImageKHR(
         device.device(),
         swapChain,
@@ -90,6 +148,7 @@ namespace gen
         imageAvailableSemaphores[currentFrame], // must be a not signaled semaphore
         VK_NULL_HANDLE,
         imageIndex);
+    frameWaitTimes.acquireMicros += microsSince(start);
 
     return result;
   }
@@ -97,6 +156,8 @@ namespace gen
   VkResult GenSwapChain::submitCommandBuffers(
       const VkCommandBuffer *buffers, uint32_t *imageIndex)
   {
+    GEN_PROFILE_SCOPE("GenSwapChain::submitCommandBuffers");
+    auto start = std::chrono::high_resolution_clock::now();
     if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE)
     {
       vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
@@ -106,9 +167,10 @@ namespace gen
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
+    // nothing to acquire or present when headless, the fence alone tracks the frame
     VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
     VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.waitSemaphoreCount = isHeadless() ? 0 : 1;
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
 
@@ -116,7 +178,7 @@ namespace gen
     submitInfo.pCommandBuffers = buffers;
 
     VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
-    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.signalSemaphoreCount = isHeadless() ? 0 : 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
     vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
@@ -126,6 +188,15 @@ namespace gen
       throw std::runtime_error("failed to submit draw command buffer!");
     }
 
+    if (isHeadless())
+    {
+      frameWaitTimes.submitMicros += microsSince(start);
+      lastFrameWaitTimes = frameWaitTimes;
+      frameWaitTimes = {};
+      currentFrame = (currentFrame + 1) % framesInFlight;
+      return VK_SUCCESS;
+    }
+
     VkPresentInfoKHR presentInfo = {};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
@@ -139,8 +210,11 @@ namespace gen
     presentInfo.pImageIndices = imageIndex;
 
     auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+    frameWaitTimes.submitMicros += microsSince(start);
 
-    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    lastFrameWaitTimes = frameWaitTimes;
+    frameWaitTimes = {};
+    currentFrame = (currentFrame + 1) % framesInFlight;
 
     return result;
   }
@@ -150,7 +224,7 @@ namespace gen
     SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport();
 
     VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-    VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+    presentMode = chooseSwapPresentMode(swapChainSupport.presentModes, presentMode);
     VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
     uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
@@ -212,6 +286,139 @@ namespace gen
     swapChainExtent = extent;
   }
 
+  void GenSwapChain::createOffscreenImages()
+  {
+    swapChainImageFormat = HEADLESS_COLOR_FORMAT;
+    swapChainExtent = windowExtent;
+    // nothing paces the frames besides the fences
+    presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+
+    swapChainImages.resize(MAX_FRAMES_IN_FLIGHT);
+    offscreenImageMemorys.resize(MAX_FRAMES_IN_FLIGHT);
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+      VkImageCreateInfo imageInfo{};
+      imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+      imageInfo.imageType = VK_IMAGE_TYPE_2D;
+      imageInfo.extent.width = swapChainExtent.width;
+      imageInfo.extent.height = swapChainExtent.height;
+      imageInfo.extent.depth = 1;
+      imageInfo.mipLevels = 1;
+      imageInfo.arrayLayers = 1;
+      imageInfo.format = swapChainImageFormat;
+      imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+      imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+      imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+      imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+      imageInfo.flags = 0;
+
+      device.createImageWithInfo(
+          imageInfo,
+          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+          swapChainImages[i],
+          offscreenImageMemorys[i]);
+    }
+  }
+
+  void GenSwapChain::recordReadback(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+  {
+    assert(isHeadless() && "Only offscreen images can be read back");
+
+    if (readbackBuffers.empty())
+    {
+      readbackBuffers.resize(imageCount());
+    }
+    if (readbackBuffers[imageIndex] == nullptr)
+    {
+      readbackBuffers[imageIndex] = std::make_unique<GenBuffer>(
+          device,
+          4,
+          swapChainExtent.width * swapChainExtent.height,
+          VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+      readbackBuffers[imageIndex]->map();
+    }
+
+    // the render pass already left the image in TRANSFER_SRC_OPTIMAL, this only orders the copy after it
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = swapChainImages[imageIndex];
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0,
+        nullptr,
+        0,
+        nullptr,
+        1,
+        &barrier);
+
+    VkBufferImageCopy region{};
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageExtent = {swapChainExtent.width, swapChainExtent.height, 1};
+    vkCmdCopyImageToBuffer(
+        commandBuffer,
+        swapChainImages[imageIndex],
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        readbackBuffers[imageIndex]->getBuffer(),
+        1,
+        &region);
+
+    // make the copy visible to the host once the frame's fence signals
+    VkBufferMemoryBarrier hostBarrier{};
+    hostBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    hostBarrier.buffer = readbackBuffers[imageIndex]->getBuffer();
+    hostBarrier.offset = 0;
+    hostBarrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT,
+        0,
+        0,
+        nullptr,
+        1,
+        &hostBarrier,
+        0,
+        nullptr);
+  }
+
+  void GenSwapChain::readPixels(uint32_t imageIndex, std::vector<uint8_t> &rgba)
+  {
+    assert(imageIndex < readbackBuffers.size() && readbackBuffers[imageIndex] != nullptr && "Image was never read back");
+
+    if (imagesInFlight[imageIndex] != VK_NULL_HANDLE)
+    {
+      vkWaitForFences(device.device(), 1, &imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+    }
+
+    // the offscreen images are BGRA
+    size_t pixelCount = static_cast<size_t>(swapChainExtent.width) * swapChainExtent.height;
+    const auto *bgra = static_cast<const uint8_t *>(readbackBuffers[imageIndex]->getMappedMemory());
+    rgba.resize(4 * pixelCount);
+    for (size_t i = 0; i < pixelCount; i++)
+    {
+      rgba[4 * i + 0] = bgra[4 * i + 2];
+      rgba[4 * i + 1] = bgra[4 * i + 1];
+      rgba[4 * i + 2] = bgra[4 * i + 0];
+      rgba[4 * i + 3] = bgra[4 * i + 3];
+    }
+  }
+
   void GenSwapChain::createImageViews()
   {
     swapChainImageViews.resize(swapChainImages.size());
@@ -238,62 +445,127 @@ namespace gen
 
   void GenSwapChain::createRenderPass()
   {
-    VkAttachmentDescription depthAttachment{};
-    depthAttachment.format = findDepthFormat();
-    depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    VkAttachmentReference depthAttachmentRef{};
-    depthAttachmentRef.attachment = 1;
-    depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    VkAttachmentDescription colorAttachment = {};
-    colorAttachment.format = getSwapChainImageFormat();
-    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    VkAttachmentReference colorAttachmentRef = {};
-    colorAttachmentRef.attachment = 0;
-    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    VkSubpassDescription subpass = {};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &colorAttachmentRef;
-    subpass.pDepthStencilAttachment = &depthAttachmentRef;
+    // attachments: 0 scene color, 1 depth, 2 transparency accumulation, 3 revealage
+    std::array<VkAttachmentDescription, 4> attachments{};
+
+    // sampled by the upscale render pass afterwards
+    attachments[0].format = getSwapChainImageFormat();
+    attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[0].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    attachments[1].format = swapChainDepthFormat;
+    attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    // like the g-buffer the transparency targets only live inside the render pass
+    for (int i = 2; i < 4; i++)
+    {
+      attachments[i].format = i == 2 ? ACCUM_FORMAT : REVEALAGE_FORMAT;
+      attachments[i].samples = VK_SAMPLE_COUNT_1_BIT;
+      attachments[i].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+      attachments[i].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+      attachments[i].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+      attachments[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+      attachments[i].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      attachments[i].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
 
-    VkSubpassDependency dependency = {};
-    dependency.dstSubpass = 0;
-    dependency.dstAccessMask =
-        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-    dependency.dstStageMask =
+    VkAttachmentReference colorAttachmentRef{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    VkAttachmentReference depthAttachmentRef{1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+    // subpass 1: transparent geometry accumulates into its own targets, depth tested against the opaque scene
+    std::array<VkAttachmentReference, 2> oitColorRefs = {{
+        {2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
+        {3, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
+    }};
+
+    // subpass 2: resolve the accumulated transparency onto the scene color, then composite sorted geometry
+    std::array<VkAttachmentReference, 2> oitInputRefs = {{
+        {2, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+        {3, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+    }};
+
+    std::array<VkSubpassDescription, 3> subpasses{};
+    subpasses[OPAQUE_SUBPASS].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpasses[OPAQUE_SUBPASS].colorAttachmentCount = 1;
+    subpasses[OPAQUE_SUBPASS].pColorAttachments = &colorAttachmentRef;
+    subpasses[OPAQUE_SUBPASS].pDepthStencilAttachment = &depthAttachmentRef;
+
+    uint32_t preservedSceneColor = 0;
+    subpasses[TRANSPARENT_SUBPASS].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpasses[TRANSPARENT_SUBPASS].colorAttachmentCount = static_cast<uint32_t>(oitColorRefs.size());
+    subpasses[TRANSPARENT_SUBPASS].pColorAttachments = oitColorRefs.data();
+    subpasses[TRANSPARENT_SUBPASS].pDepthStencilAttachment = &depthAttachmentRef;
+    subpasses[TRANSPARENT_SUBPASS].preserveAttachmentCount = 1;
+    subpasses[TRANSPARENT_SUBPASS].pPreserveAttachments = &preservedSceneColor;
+
+    subpasses[COMPOSITE_SUBPASS].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpasses[COMPOSITE_SUBPASS].inputAttachmentCount = static_cast<uint32_t>(oitInputRefs.size());
+    subpasses[COMPOSITE_SUBPASS].pInputAttachments = oitInputRefs.data();
+    subpasses[COMPOSITE_SUBPASS].colorAttachmentCount = 1;
+    subpasses[COMPOSITE_SUBPASS].pColorAttachments = &colorAttachmentRef;
+    subpasses[COMPOSITE_SUBPASS].pDepthStencilAttachment = &depthAttachmentRef;
+
+    std::array<VkSubpassDependency, 4> dependencies{};
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = OPAQUE_SUBPASS;
+    dependencies[0].srcStageMask =
         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.srcAccessMask = 0;
-    dependency.srcStageMask =
+    dependencies[0].srcAccessMask = 0;
+    dependencies[0].dstStageMask =
         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependencies[0].dstAccessMask =
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
+    // opaque depth has to be complete before transparent fragments test against it
+    dependencies[1].srcSubpass = OPAQUE_SUBPASS;
+    dependencies[1].dstSubpass = TRANSPARENT_SUBPASS;
+    dependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependencies[1].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+    dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+    // the composite subpass blends onto the opaque color and tests against the opaque depth
+    dependencies[2].srcSubpass = OPAQUE_SUBPASS;
+    dependencies[2].dstSubpass = COMPOSITE_SUBPASS;
+    dependencies[2].srcStageMask =
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependencies[2].srcAccessMask =
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[2].dstStageMask =
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependencies[2].dstAccessMask =
+        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[2].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+    dependencies[3].srcSubpass = TRANSPARENT_SUBPASS;
+    dependencies[3].dstSubpass = COMPOSITE_SUBPASS;
+    dependencies[3].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[3].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[3].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    dependencies[3].dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+    dependencies[3].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
 
-
-    std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
     VkRenderPassCreateInfo renderPassInfo = {};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
     renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
     renderPassInfo.pAttachments = attachments.data();
-    renderPassInfo.subpassCount = 1;
-    renderPassInfo.pSubpasses = &subpass;
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies = &dependency;
+    renderPassInfo.subpassCount = static_cast<uint32_t>(subpasses.size());
+    renderPassInfo.pSubpasses = subpasses.data();
+    renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+    renderPassInfo.pDependencies = dependencies.data();
 
     if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
     {
@@ -301,92 +573,181 @@ namespace gen
     }
   }
 
-  void GenSwapChain::createFramebuffers()
+  void GenSwapChain::createDeferredRenderPass()
   {
-    swapChainFramebuffers.resize(imageCount());
-    for (size_t i = 0; i < imageCount(); i++)
-    {
-      std::array<VkImageView, 2> attachments = {swapChainImageViews[i], depthImageViews[i]};
-
-      VkExtent2D swapChainExtent = getSwapChainExtent();
-      VkFramebufferCreateInfo framebufferInfo = {};
-      framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-      framebufferInfo.renderPass = renderPass;
-      framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-      framebufferInfo.pAttachments = attachments.data();
-      framebufferInfo.width = swapChainExtent.width;
-      framebufferInfo.height = swapChainExtent.height;
-      framebufferInfo.layers = 1;
-
-      if (vkCreateFramebuffer(
-              device.device(),
-              &framebufferInfo,
-              nullptr,
-              &swapChainFramebuffers[i]) != VK_SUCCESS)
-      {
-        throw std::runtime_error("failed to create framebuffer!");
-      }
+    // attachments: 0 scene color, 1 depth, 2 albedo, 3 normal
+    std::array<VkAttachmentDescription, 4> attachments{};
+
+    attachments[0].format = getSwapChainImageFormat();
+    attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[0].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    attachments[1].format = swapChainDepthFormat;
+    attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    // the g-buffer only lives inside the render pass, so its contents never have to be stored
+    for (int i = 2; i < 4; i++)
+    {
+      attachments[i].format = i == 2 ? ALBEDO_FORMAT : NORMAL_FORMAT;
+      attachments[i].samples = VK_SAMPLE_COUNT_1_BIT;
+      attachments[i].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+      attachments[i].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+      attachments[i].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+      attachments[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+      attachments[i].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      attachments[i].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+
+    // subpass 0: fill the g-buffer
+    std::array<VkAttachmentReference, 2> gBufferColorRefs = {{
+        {2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
+        {3, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL},
+    }};
+    VkAttachmentReference gBufferDepthRef{1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+    // subpass 1: light the scene color from the g-buffer
+    std::array<VkAttachmentReference, 3> lightingInputRefs = {{
+        {2, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+        {3, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+        {1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL},
+    }};
+    VkAttachmentReference sceneColorRef{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+
+    // subpass 2: forward rendered geometry (light billboards) composited on top, depth tested against the g-buffer depth
+    VkAttachmentReference compositeDepthRef{1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+    std::array<VkSubpassDescription, 3> subpasses{};
+    subpasses[GBUFFER_SUBPASS].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpasses[GBUFFER_SUBPASS].colorAttachmentCount = static_cast<uint32_t>(gBufferColorRefs.size());
+    subpasses[GBUFFER_SUBPASS].pColorAttachments = gBufferColorRefs.data();
+    subpasses[GBUFFER_SUBPASS].pDepthStencilAttachment = &gBufferDepthRef;
+
+    subpasses[LIGHTING_SUBPASS].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpasses[LIGHTING_SUBPASS].inputAttachmentCount = static_cast<uint32_t>(lightingInputRefs.size());
+    subpasses[LIGHTING_SUBPASS].pInputAttachments = lightingInputRefs.data();
+    subpasses[LIGHTING_SUBPASS].colorAttachmentCount = 1;
+    subpasses[LIGHTING_SUBPASS].pColorAttachments = &sceneColorRef;
+
+    subpasses[COMPOSITE_SUBPASS].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpasses[COMPOSITE_SUBPASS].colorAttachmentCount = 1;
+    subpasses[COMPOSITE_SUBPASS].pColorAttachments = &sceneColorRef;
+    subpasses[COMPOSITE_SUBPASS].pDepthStencilAttachment = &compositeDepthRef;
+
+    std::array<VkSubpassDependency, 3> dependencies{};
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = GBUFFER_SUBPASS;
+    dependencies[0].srcStageMask =
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependencies[0].srcAccessMask = 0;
+    dependencies[0].dstStageMask =
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependencies[0].dstAccessMask =
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+    dependencies[1].srcSubpass = GBUFFER_SUBPASS;
+    dependencies[1].dstSubpass = LIGHTING_SUBPASS;
+    dependencies[1].srcStageMask =
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependencies[1].srcAccessMask =
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    dependencies[1].dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+    dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+    dependencies[2].srcSubpass = LIGHTING_SUBPASS;
+    dependencies[2].dstSubpass = COMPOSITE_SUBPASS;
+    dependencies[2].srcStageMask =
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[2].srcAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[2].dstStageMask =
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[2].dstAccessMask =
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[2].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+    VkRenderPassCreateInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = static_cast<uint32_t>(subpasses.size());
+    renderPassInfo.pSubpasses = subpasses.data();
+    renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+    renderPassInfo.pDependencies = dependencies.data();
+
+    if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &deferredRenderPass) != VK_SUCCESS)
+    {
+      throw std::runtime_error("failed to create deferred render pass!");
     }
   }
 
-  void GenSwapChain::createDepthResources()
+  void GenSwapChain::createUpscaleRenderPass()
   {
-    VkFormat depthFormat = findDepthFormat();
-    swapChainDepthFormat = depthFormat;
-    VkExtent2D swapChainExtent = getSwapChainExtent();
+    // every pixel is written, so the previous contents don't have to be loaded
+    VkAttachmentDescription colorAttachment{};
+    colorAttachment.format = getSwapChainImageFormat();
+    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    colorAttachment.finalLayout = finalColorLayout();
 
-    depthImages.resize(imageCount());
-    depthImageMemorys.resize(imageCount());
-    depthImageViews.resize(imageCount());
+    VkAttachmentReference colorAttachmentRef{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
 
-    for (int i = 0; i < depthImages.size(); i++)
-    {
-      VkImageCreateInfo imageInfo{};
-      imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-      imageInfo.imageType = VK_IMAGE_TYPE_2D;
-      imageInfo.extent.width = swapChainExtent.width;
-      imageInfo.extent.height = swapChainExtent.height;
-      imageInfo.extent.depth = 1;
-      imageInfo.mipLevels = 1;
-      imageInfo.arrayLayers = 1;
-      imageInfo.format = depthFormat;
-      imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-      imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-      imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-      imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-      imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-      imageInfo.flags = 0;
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorAttachmentRef;
 
-      device.createImageWithInfo(
-          imageInfo,
-          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-          depthImages[i],
-          depthImageMemorys[i]);
+    VkSubpassDependency dependency{};
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = 0;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.srcAccessMask = 0;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 
-      VkImageViewCreateInfo viewInfo{};
-      viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-      viewInfo.image = depthImages[i];
-      viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-      viewInfo.format = depthFormat;
-      viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-      viewInfo.subresourceRange.baseMipLevel = 0;
-      viewInfo.subresourceRange.levelCount = 1;
-      viewInfo.subresourceRange.baseArrayLayer = 0;
-      viewInfo.subresourceRange.layerCount = 1;
+    VkRenderPassCreateInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = 1;
+    renderPassInfo.pAttachments = &colorAttachment;
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = 1;
+    renderPassInfo.pDependencies = &dependency;
 
-      if (vkCreateImageView(device.device(), &viewInfo, nullptr, &depthImageViews[i]) != VK_SUCCESS)
-      {
-        throw std::runtime_error("failed to create texture image view!");
-      }
+    if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &upscaleRenderPass) != VK_SUCCESS)
+    {
+      throw std::runtime_error("failed to create upscale render pass!");
     }
   }
 
   void GenSwapChain::createSyncObjects()
   {
+    // the images are new either way, no frame has rendered to them yet
+    imagesInFlight.assign(imageCount(), VK_NULL_HANDLE);
+    if (!inFlightFences.empty())
+    {
+      // taken over from the previous swap chain
+      return;
+    }
+
     imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
     renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
     inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-    imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
 
     VkSemaphoreCreateInfo semaphoreInfo = {};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -424,28 +785,39 @@ namespace gen
   }
 
   VkPresentModeKHR GenSwapChain::chooseSwapPresentMode(
-      const std::vector<VkPresentModeKHR> &availablePresentModes)
+      const std::vector<VkPresentModeKHR> &availablePresentModes, VkPresentModeKHR preferredPresentMode)
   {
     for (const auto &availablePresentMode : availablePresentModes)
     {
-      if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+      if (availablePresentMode == preferredPresentMode)
       {
-        std::cout << "Present mode: Mailbox" << std::endl;
+        std::cout << "Present mode: " << presentModeName(availablePresentMode) << std::endl;
         return availablePresentMode;
       }
     }
 
-    // for (const auto &availablePresentMode : availablePresentModes) {
-    //   if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-    //     std::cout << "Present mode: Immediate" << std::endl;
-    //     return availablePresentMode;
-    //   }
-    // }
-
-    std::cout << "Present mode: V-Sync" << std::endl;
+    // FIFO is the only mode every surface has to support
+    std::cout << "Present mode: " << presentModeName(VK_PRESENT_MODE_FIFO_KHR) << std::endl;
     return VK_PRESENT_MODE_FIFO_KHR;
   }
 
+  const char *GenSwapChain::presentModeName(VkPresentModeKHR mode)
+  {
+    switch (mode)
+    {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:
+      return "Immediate";
+    case VK_PRESENT_MODE_MAILBOX_KHR:
+      return "Mailbox";
+    case VK_PRESENT_MODE_FIFO_KHR:
+      return "V-Sync";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+      return "Relaxed V-Sync";
+    default:
+      return "Unknown";
+    }
+  }
+
   VkExtent2D GenSwapChain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities)
   {
     if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max())
@@ -466,6 +838,12 @@ namespace gen
     }
   }
 
+  VkImageLayout GenSwapChain::finalColorLayout() const
+  {
+    // PRESENT_SRC_KHR belongs to the swap chain extension, which headless devices don't enable
+    return isHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  }
+
   VkFormat GenSwapChain::findDepthFormat()
   {
     return device.findSupportedFormat(
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "gen_buffer.hpp"
 #include "gen_device.hpp"
 
 // vulkan headers
@@ -13,23 +14,98 @@
 namespace gen
 {
 
+  enum class RenderPath
+  {
+    Forward,
+    Deferred
+  };
+
+  // attachments of the deferred render pass that the lighting subpass reads as input attachments
+  struct GBufferViews
+  {
+    VkImageView albedo = VK_NULL_HANDLE;
+    VkImageView normal = VK_NULL_HANDLE;
+    VkImageView depth = VK_NULL_HANDLE;
+
+    bool operator==(const GBufferViews &other) const
+    {
+      return albedo == other.albedo && normal == other.normal && depth == other.depth;
+    }
+    bool operator!=(const GBufferViews &other) const { return !(*this == other); }
+  };
+
+  // weighted blended transparency targets of the forward render pass, read by the resolve as input attachments
+  struct OitViews
+  {
+    VkImageView accum = VK_NULL_HANDLE;
+    VkImageView revealage = VK_NULL_HANDLE;
+
+    bool operator==(const OitViews &other) const
+    {
+      return accum == other.accum && revealage == other.revealage;
+    }
+    bool operator!=(const OitViews &other) const { return !(*this == other); }
+  };
+
+  // cpu time spent blocked in the swap chain during one frame
+  struct FrameWaitTimes
+  {
+    float fenceMicros = 0.f;   // waiting for the frame's previous submission to finish
+    float acquireMicros = 0.f; // vkAcquireNextImageKHR
+    float submitMicros = 0.f;  // waiting for the image's previous frame, submitting and presenting
+  };
+
+  // On a headless device the swap chain images are replaced by offscreen color images, one per frame in flight,
+  // that are handed out round robin and never presented.
+  // The scene render passes draw into an offscreen scene color image, which the upscale render pass samples onto
+  // the swap chain image. Scene color, depth, g-buffer and transparency attachments only live within a frame,
+  // they are transient images of GenRenderGraph, and GenRenderer creates the framebuffers for them.
   class GenSwapChain
   {
   public:
-    static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
-    GenSwapChain(GenDevice &deviceRef, VkExtent2D windowExtent);
-    GenSwapChain(GenDevice &deviceRef, VkExtent2D windowExtent, std::shared_ptr<GenSwapChain> previous);
+    // per frame resources are allocated for this many frames, how many are actually used is a runtime setting
+    static constexpr int MAX_FRAMES_IN_FLIGHT = 3;
+    static constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+
+    // subpasses of the deferred render pass
+    static constexpr uint32_t GBUFFER_SUBPASS = 0;
+    static constexpr uint32_t LIGHTING_SUBPASS = 1;
+    // subpasses of the forward render pass
+    static constexpr uint32_t OPAQUE_SUBPASS = 0;
+    static constexpr uint32_t TRANSPARENT_SUBPASS = 1;
+    // last subpass of both scene render passes
+    static constexpr uint32_t COMPOSITE_SUBPASS = 2;
+
+    // preferredPresentMode is used when the surface supports it, FIFO otherwise.
+    // With a previous swap chain, it's passed as oldSwapchain and its frame fences, semaphores and slot are taken
+    // over, so frames still in flight on it keep being waited for. Its destructor queues its own resources for
+    // GenDevice::destroyDeferred, so it can go right away
+    GenSwapChain(
+        GenDevice &deviceRef,
+        VkExtent2D windowExtent,
+        VkPresentModeKHR preferredPresentMode = VK_PRESENT_MODE_MAILBOX_KHR);
+    GenSwapChain(
+        GenDevice &deviceRef,
+        VkExtent2D windowExtent,
+        std::shared_ptr<GenSwapChain> previous,
+        VkPresentModeKHR preferredPresentMode = VK_PRESENT_MODE_MAILBOX_KHR);
     ~GenSwapChain();
 
     GenSwapChain(const GenSwapChain &) = delete;
     GenSwapChain &operator=(const GenSwapChain &) = delete;
 
-    VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
+    // attachments: 0 scene color, 1 depth, 2 transparency accumulation, 3 revealage. The scene color has the
+    // swap chain image format and ends up in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
     VkRenderPass getRenderPass() { return renderPass; }
+    // attachments: 0 scene color, 1 depth, 2 albedo, 3 normal
+    VkRenderPass getDeferredRenderPass() { return deferredRenderPass; }
+    // attachment: 0 swap chain image, left in finalColorLayout
+    VkRenderPass getUpscaleRenderPass() { return upscaleRenderPass; }
+    VkImage getImage(int index) { return swapChainImages[index]; }
     VkImageView getImageView(int index) { return swapChainImageViews[index]; }
     size_t imageCount() { return swapChainImages.size(); }
     VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
+    VkFormat getDepthFormat() { return swapChainDepthFormat; }
     VkExtent2D getSwapChainExtent() { return swapChainExtent; }
     uint32_t width() { return swapChainExtent.width; }
     uint32_t height() { return swapChainExtent.height; }
@@ -39,10 +115,39 @@ namespace gen
       return static_cast<float>(swapChainExtent.width) / static_cast<float>(swapChainExtent.height);
     }
     VkFormat findDepthFormat();
-
+    // layout the upscale render pass leaves the swap chain image in
+    VkImageLayout finalColorLayout() const;
+
+    static constexpr VkFormat ALBEDO_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+    static constexpr VkFormat NORMAL_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+    static constexpr VkFormat ACCUM_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+    static constexpr VkFormat REVEALAGE_FORMAT = VK_FORMAT_R16_SFLOAT;
+    // matches the surface format preferred when presenting, so headless frames look the same
+    static constexpr VkFormat HEADLESS_COLOR_FORMAT = VK_FORMAT_B8G8R8A8_SRGB;
+
+    // waits until the current frame's previous submission finished, acquireNextImage does this as well,
+    // calling it earlier lets the caller sample input as late as possible
+    void waitForCurrentFrame();
     VkResult acquireNextImage(uint32_t *imageIndex);
     VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
 
+    // frame slot the next acquireNextImage and submitCommandBuffers use
+    uint32_t getCurrentFrame() const { return currentFrame; }
+    uint32_t getFramesInFlight() const { return framesInFlight; }
+    // takes effect after the current frame, must be between 1 and MAX_FRAMES_IN_FLIGHT
+    void setFramesInFlight(uint32_t count);
+    VkPresentModeKHR getPresentMode() const { return presentMode; }
+    const FrameWaitTimes &getLastFrameWaitTimes() const { return lastFrameWaitTimes; }
+
+    static const char *presentModeName(VkPresentModeKHR mode);
+
+    bool isHeadless() const { return device.isHeadless(); }
+    // headless only: copies the image into its readback buffer, record after the render pass ended
+    void recordReadback(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+    // waits for the frame that last rendered to imageIndex and returns its pixels as tightly packed RGBA8 rows,
+    // top row first. Only valid after recordReadback was submitted for that image
+    void readPixels(uint32_t imageIndex, std::vector<uint8_t> &rgba);
+
     bool compareSwapFormats(const GenSwapChain &swapChain) const
     {
       return swapChain.swapChainDepthFormat == swapChainDepthFormat &&
@@ -52,36 +157,39 @@ namespace gen
   private:
     void init();
     void createSwapChain();
+    void createOffscreenImages();
     void createImageViews();
-    void createDepthResources();
     void createRenderPass();
-    void createFramebuffers();
+    void createDeferredRenderPass();
+    void createUpscaleRenderPass();
     void createSyncObjects();
 
     // Helper functions
     VkSurfaceFormatKHR chooseSwapSurfaceFormat(
         const std::vector<VkSurfaceFormatKHR> &availableFormats);
     VkPresentModeKHR chooseSwapPresentMode(
-        const std::vector<VkPresentModeKHR> &availablePresentModes);
+        const std::vector<VkPresentModeKHR> &availablePresentModes, VkPresentModeKHR preferredPresentMode);
     VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities);
 
     VkFormat swapChainImageFormat;
     VkFormat swapChainDepthFormat;
     VkExtent2D swapChainExtent;
 
-    std::vector<VkFramebuffer> swapChainFramebuffers;
     VkRenderPass renderPass;
+    VkRenderPass deferredRenderPass;
+    VkRenderPass upscaleRenderPass;
 
-    std::vector<VkImage> depthImages;
-    std::vector<VkDeviceMemory> depthImageMemorys;
-    std::vector<VkImageView> depthImageViews;
     std::vector<VkImage> swapChainImages;
     std::vector<VkImageView> swapChainImageViews;
+    // headless only, owned unlike swap chain images
+    std::vector<VkDeviceMemory> offscreenImageMemorys;
+    std::vector<std::unique_ptr<GenBuffer>> readbackBuffers;
 
     GenDevice &device;
     VkExtent2D windowExtent;
+    VkPresentModeKHR presentMode;
 
-    VkSwapchainKHR swapChain;
+    VkSwapchainKHR swapChain = VK_NULL_HANDLE;
     std::shared_ptr<GenSwapChain> oldSwapChain;
 
     std::vector<VkSemaphore> imageAvailableSemaphores;
@@ -89,6 +197,9 @@ namespace gen
     std::vector<VkFence> inFlightFences;
     std::vector<VkFence> imagesInFlight;
     size_t currentFrame = 0;
+    uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+    FrameWaitTimes frameWaitTimes{};
+    FrameWaitTimes lastFrameWaitTimes{};
   };
 
 } // namespace gen
@@ -0,0 +1,554 @@
+#include "gen_texture.hpp"
+#include "gen_buffer.hpp"
+#include "gen_cpu_profiler.hpp"
+#include "gen_utils.hpp"
+
+// stb
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifndef ENGINE_DIR
+#define ENGINE_DIR "../"
+#endif
+
+namespace gen
+{
+    namespace
+    {
+        std::atomic<uint64_t> nextTextureId{0};
+        std::atomic<uint32_t> liveTextureCount{0};
+        std::atomic<VkDeviceSize> liveMemoryBytes{0};
+        std::atomic<VkDeviceSize> totalUploadedBytes{0};
+        std::atomic<int64_t> totalUploadNanos{0};
+
+        bool isBlockCompressed(VkFormat format)
+        {
+            return format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK;
+        }
+
+        template <typename T>
+        T readValue(const std::vector<uint8_t> &bytes, size_t offset)
+        {
+            T value;
+            std::memcpy(&value, bytes.data() + offset, sizeof(T));
+            return value;
+        }
+    }
+
+    // *************** Sampler Cache *********************
+
+    size_t GenSamplerCache::KeyHash::operator()(const SamplerKey &key) const
+    {
+        size_t seed = 0;
+        hashCombine(
+            seed,
+            static_cast<int>(key.filter),
+            static_cast<int>(key.mipmapMode),
+            static_cast<int>(key.addressMode),
+            key.anisotropy);
+        return seed;
+    }
+
+    GenSamplerCache::~GenSamplerCache()
+    {
+        for (auto &kv : samplers)
+        {
+            vkDestroySampler(genDevice.device(), kv.second, nullptr);
+        }
+    }
+
+    VkSampler GenSamplerCache::getSampler(const SamplerKey &key)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto it = samplers.find(key);
+        if (it != samplers.end())
+        {
+            return it->second;
+        }
+
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = key.filter;
+        samplerInfo.minFilter = key.filter;
+        samplerInfo.mipmapMode = key.mipmapMode;
+        samplerInfo.addressModeU = key.addressMode;
+        samplerInfo.addressModeV = key.addressMode;
+        samplerInfo.addressModeW = key.addressMode;
+        samplerInfo.anisotropyEnable = key.anisotropy ? VK_TRUE : VK_FALSE;
+        samplerInfo.maxAnisotropy = key.anisotropy ? genDevice.properties.limits.maxSamplerAnisotropy : 1.f;
+        samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+        samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+        samplerInfo.minLod = 0.f;
+        samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+        VkSampler sampler;
+        if (vkCreateSampler(genDevice.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create texture sampler!");
+        }
+        samplers.emplace(key, sampler);
+        return sampler;
+    }
+
+    uint32_t GenSamplerCache::getSamplerCount()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return static_cast<uint32_t>(samplers.size());
+    }
+
+    // *************** Texture Builder *********************
+
+    void GenTexture::Builder::loadTexture(const std::string &filepath)
+    {
+        GEN_PROFILE_SCOPE("GenTexture::Builder::loadTexture");
+        std::ifstream file{filepath, std::ios::ate | std::ios::binary};
+        if (!file.is_open())
+        {
+            throw std::runtime_error{"Failed to open file: " + filepath};
+        }
+        std::vector<uint8_t> contents(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char *>(contents.data()), contents.size());
+        decodeTexture(contents, filepath);
+    }
+
+    void GenTexture::Builder::decodeTexture(const std::vector<uint8_t> &contents, const std::string &filepath)
+    {
+        GEN_PROFILE_SCOPE("GenTexture::Builder::decodeTexture");
+        const std::string extension = ".ktx2";
+        if (filepath.size() >= extension.size() &&
+            filepath.compare(filepath.size() - extension.size(), extension.size(), extension) == 0)
+        {
+            parseKtx2(contents, filepath);
+            return;
+        }
+
+        int imageWidth, imageHeight, channels;
+        stbi_uc *pixels = stbi_load_from_memory(
+            contents.data(), static_cast<int>(contents.size()), &imageWidth, &imageHeight, &channels, STBI_rgb_alpha);
+        if (pixels == nullptr)
+        {
+            throw std::runtime_error("failed to load texture image " + filepath + ": " + stbi_failure_reason());
+        }
+        setPixels(static_cast<uint32_t>(imageWidth), static_cast<uint32_t>(imageHeight), pixels);
+        stbi_image_free(pixels);
+    }
+
+    void GenTexture::Builder::setPixels(uint32_t pixelWidth, uint32_t pixelHeight, const uint8_t *rgba, VkFormat pixelFormat)
+    {
+        width = pixelWidth;
+        height = pixelHeight;
+        format = pixelFormat;
+        VkDeviceSize size = static_cast<VkDeviceSize>(width) * height * 4;
+        data.assign(rgba, rgba + size);
+        levels = {{0, size}};
+        generateMipmaps = true;
+    }
+
+    uint32_t GenTexture::Builder::skipLevels(uint32_t count)
+    {
+        if (levels.empty())
+        {
+            return 0;
+        }
+        uint32_t skipped = std::min(count, static_cast<uint32_t>(levels.size()) - 1);
+        if (skipped > 0)
+        {
+            // level offsets are 16 byte aligned, so they stay aligned after moving down together
+            VkDeviceSize begin = levels[skipped].offset;
+            data.erase(data.begin(), data.begin() + begin);
+            levels.erase(levels.begin(), levels.begin() + skipped);
+            for (auto &level : levels)
+            {
+                level.offset -= begin;
+            }
+            width = std::max(width >> skipped, 1u);
+            height = std::max(height >> skipped, 1u);
+        }
+
+        bool rgba8 = format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_R8G8B8A8_UNORM;
+        if (!rgba8 || levels.size() != 1)
+        {
+            return skipped;
+        }
+
+        // averaged as stored, which is close enough to filtering in linear space for distant mips
+        for (; skipped < count && (width > 1 || height > 1); skipped++)
+        {
+            uint32_t halfWidth = std::max(width / 2, 1u);
+            uint32_t halfHeight = std::max(height / 2, 1u);
+            std::vector<uint8_t> half(static_cast<size_t>(halfWidth) * halfHeight * 4);
+            for (uint32_t y = 0; y < halfHeight; y++)
+            {
+                uint32_t y0 = std::min(2 * y, height - 1);
+                uint32_t y1 = std::min(2 * y + 1, height - 1);
+                for (uint32_t x = 0; x < halfWidth; x++)
+                {
+                    uint32_t x0 = std::min(2 * x, width - 1);
+                    uint32_t x1 = std::min(2 * x + 1, width - 1);
+                    for (uint32_t c = 0; c < 4; c++)
+                    {
+                        uint32_t sum = data[(y0 * width + x0) * 4 + c] + data[(y0 * width + x1) * 4 + c] +
+                                       data[(y1 * width + x0) * 4 + c] + data[(y1 * width + x1) * 4 + c];
+                        half[(y * halfWidth + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+                    }
+                }
+            }
+            data = std::move(half);
+            width = halfWidth;
+            height = halfHeight;
+        }
+        levels = {{0, data.size()}};
+        return skipped;
+    }
+
+    uint32_t GenTexture::Builder::getMipCount() const
+    {
+        if (!generateMipmaps)
+        {
+            return static_cast<uint32_t>(levels.size());
+        }
+        return static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+    }
+
+    // https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html, only plain 2d textures without supercompression
+    void GenTexture::Builder::parseKtx2(const std::vector<uint8_t> &bytes, const std::string &filepath)
+    {
+        static constexpr uint8_t identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+        static constexpr size_t HEADER_SIZE = 80;
+        static constexpr size_t LEVEL_INDEX_ENTRY_SIZE = 24;
+
+        if (bytes.size() < HEADER_SIZE || std::memcmp(bytes.data(), identifier, sizeof(identifier)) != 0)
+        {
+            throw std::runtime_error("not a KTX2 file: " + filepath);
+        }
+
+        auto vkFormat = readValue<uint32_t>(bytes, 12);
+        auto pixelWidth = readValue<uint32_t>(bytes, 20);
+        auto pixelHeight = readValue<uint32_t>(bytes, 24);
+        auto pixelDepth = readValue<uint32_t>(bytes, 28);
+        auto layerCount = readValue<uint32_t>(bytes, 32);
+        auto faceCount = readValue<uint32_t>(bytes, 36);
+        auto levelCount = readValue<uint32_t>(bytes, 40);
+        auto supercompressionScheme = readValue<uint32_t>(bytes, 44);
+
+        // VK_FORMAT_UNDEFINED means basis universal data, which would need transcoding first
+        if (vkFormat == VK_FORMAT_UNDEFINED || supercompressionScheme != 0)
+        {
+            throw std::runtime_error("unsupported KTX2 encoding, only raw vulkan formats can be loaded: " + filepath);
+        }
+        if (pixelHeight == 0 || pixelDepth != 0 || layerCount > 1 || faceCount != 1)
+        {
+            throw std::runtime_error("only 2d KTX2 textures can be loaded: " + filepath);
+        }
+
+        // a level count of 0 asks for the mips to be generated at load
+        uint32_t storedLevels = std::max(levelCount, 1u);
+        if (bytes.size() < HEADER_SIZE + storedLevels * LEVEL_INDEX_ENTRY_SIZE)
+        {
+            throw std::runtime_error("truncated KTX2 level index: " + filepath);
+        }
+
+        width = pixelWidth;
+        height = pixelHeight;
+        format = static_cast<VkFormat>(vkFormat);
+        generateMipmaps = levelCount == 0;
+        data.clear();
+        levels.clear();
+        // the file stores the smallest level first, levels here go from the full resolution one down
+        for (uint32_t level = 0; level < storedLevels; level++)
+        {
+            size_t entry = HEADER_SIZE + level * LEVEL_INDEX_ENTRY_SIZE;
+            auto byteOffset = readValue<uint64_t>(bytes, entry);
+            auto byteLength = readValue<uint64_t>(bytes, entry + 8);
+            if (byteOffset + byteLength > bytes.size())
+            {
+                throw std::runtime_error("truncated KTX2 level data: " + filepath);
+            }
+            // copy offsets must be multiples of the texel block size and of 4, 16 covers every format
+            data.resize((data.size() + 15) & ~size_t{15});
+            levels.push_back({data.size(), byteLength});
+            data.insert(data.end(), bytes.begin() + byteOffset, bytes.begin() + byteOffset + byteLength);
+        }
+    }
+
+    // *************** Texture *********************
+
+    GenTexture::GenTexture(GenDevice &device, GenSamplerCache &samplerCache, const Builder &builder, UploadMode uploadMode)
+        : genDevice{device}, id{nextTextureId++}, format{builder.format}, extent{builder.width, builder.height}
+    {
+        assert(!builder.levels.empty() && "Texture builder has no pixel data");
+        if (!isFormatSupported(genDevice, format))
+        {
+            throw std::runtime_error("texture format " + std::to_string(format) + " can't be sampled on this device!");
+        }
+
+        // blits need a format the device can blit from and to, which never includes compressed ones
+        VkFormatProperties formatProperties = genDevice.getFormatProperties(format);
+        VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+        generateMipmaps =
+            builder.generateMipmaps && (formatProperties.optimalTilingFeatures & blitFeatures) == blitFeatures;
+        // software implementations may only filter some formats linearly, nearest mips still beat none
+        linearBlit = formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+        createImage(builder);
+        stage(builder);
+        createImageView();
+        sampler = samplerCache.getSampler();
+
+        liveTextureCount++;
+        liveMemoryBytes += memorySize;
+
+        if (uploadMode == UploadMode::Immediate)
+        {
+            VkCommandBuffer commandBuffer = genDevice.beginSingleTimeCommands();
+            recordUpload(commandBuffer);
+            genDevice.endSingleTimeCommands(commandBuffer);
+            releaseStagingBuffer();
+
+            auto endTime = std::chrono::high_resolution_clock::now();
+            totalUploadedBytes += builder.data.size();
+            totalUploadNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+        }
+    }
+
+    GenTexture::~GenTexture()
+    {
+        liveTextureCount--;
+        liveMemoryBytes -= memorySize;
+        // frames in flight may still sample it
+        genDevice.destroyDeferred(VK_OBJECT_TYPE_IMAGE_VIEW, imageView);
+        genDevice.destroyDeferred(VK_OBJECT_TYPE_IMAGE, image);
+        genDevice.destroyDeferred(VK_OBJECT_TYPE_DEVICE_MEMORY, memory);
+    }
+
+    std::unique_ptr<GenTexture> GenTexture::createTextureFromFile(
+        GenDevice &device, GenSamplerCache &samplerCache, const std::string &filepath)
+    {
+        GEN_PROFILE_SCOPE("GenTexture::createTextureFromFile");
+        Builder builder{};
+        builder.loadTexture(ENGINE_DIR + filepath);
+        return std::make_unique<GenTexture>(device, samplerCache, builder);
+    }
+
+    std::unique_ptr<GenTexture> GenTexture::createSolidColor(GenDevice &device, GenSamplerCache &samplerCache, uint32_t rgba)
+    {
+        uint8_t pixel[4] = {
+            static_cast<uint8_t>(rgba >> 24),
+            static_cast<uint8_t>(rgba >> 16),
+            static_cast<uint8_t>(rgba >> 8),
+            static_cast<uint8_t>(rgba)};
+        Builder builder{};
+        builder.setPixels(1, 1, pixel, VK_FORMAT_R8G8B8A8_UNORM);
+        return std::make_unique<GenTexture>(device, samplerCache, builder);
+    }
+
+    bool GenTexture::isFormatSupported(GenDevice &device, VkFormat format)
+    {
+        // compressed formats report features even when the device feature isn't enabled
+        if (isBlockCompressed(format) && !device.enabledFeatures.textureCompressionBC)
+        {
+            return false;
+        }
+        VkFormatProperties formatProperties = device.getFormatProperties(format);
+        return formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+    }
+
+    GenTexture::Stats GenTexture::getStats()
+    {
+        Stats stats{};
+        stats.textureCount = liveTextureCount.load(std::memory_order_relaxed);
+        stats.memoryBytes = liveMemoryBytes.load(std::memory_order_relaxed);
+        stats.uploadedBytes = totalUploadedBytes.load(std::memory_order_relaxed);
+        stats.uploadSeconds = totalUploadNanos.load(std::memory_order_relaxed) * 1e-9;
+        return stats;
+    }
+
+    void GenTexture::createImage(const Builder &builder)
+    {
+        mipLevels = generateMipmaps ? builder.getMipCount() : static_cast<uint32_t>(builder.levels.size());
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = format;
+        imageInfo.extent = {extent.width, extent.height, 1};
+        imageInfo.mipLevels = mipLevels;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        genDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory);
+
+        VkMemoryRequirements memRequirements;
+        vkGetImageMemoryRequirements(genDevice.device(), image, &memRequirements);
+        memorySize = memRequirements.size;
+    }
+
+    void GenTexture::stage(const Builder &builder)
+    {
+        stagingBuffer = std::make_unique<GenBuffer>(
+            genDevice,
+            1,
+            static_cast<uint32_t>(builder.data.size()),
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        stagingBuffer->map();
+        stagingBuffer->writeToBuffer((void *)builder.data.data());
+
+        copyRegions.resize(builder.levels.size());
+        for (uint32_t level = 0; level < copyRegions.size(); level++)
+        {
+            copyRegions[level] = {};
+            copyRegions[level].bufferOffset = builder.levels[level].offset;
+            copyRegions[level].imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+            copyRegions[level].imageExtent = {std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u), 1};
+        }
+    }
+
+    void GenTexture::releaseStagingBuffer()
+    {
+        stagingBuffer = nullptr;
+        copyRegions.clear();
+    }
+
+    void GenTexture::recordUpload(VkCommandBuffer commandBuffer)
+    {
+        GEN_PROFILE_SCOPE("GenTexture::recordUpload");
+        assert(stagingBuffer != nullptr && "Texture upload was already recorded");
+
+        auto transition = [&](uint32_t baseLevel,
+                              uint32_t levelCount,
+                              VkImageLayout oldLayout,
+                              VkImageLayout newLayout,
+                              VkAccessFlags srcAccess,
+                              VkAccessFlags dstAccess,
+                              VkPipelineStageFlags srcStage,
+                              VkPipelineStageFlags dstStage)
+        {
+            VkImageMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask = srcAccess;
+            barrier.dstAccessMask = dstAccess;
+            barrier.oldLayout = oldLayout;
+            barrier.newLayout = newLayout;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = image;
+            barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, baseLevel, levelCount, 0, 1};
+            vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        };
+        auto toShaderRead = [&](uint32_t baseLevel, uint32_t levelCount, VkImageLayout oldLayout, VkAccessFlags srcAccess)
+        {
+            transition(
+                baseLevel,
+                levelCount,
+                oldLayout,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                srcAccess,
+                VK_ACCESS_SHADER_READ_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+        };
+
+        transition(
+            0,
+            mipLevels,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            0,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+        uint32_t storedLevels = static_cast<uint32_t>(copyRegions.size());
+        vkCmdCopyBufferToImage(
+            commandBuffer,
+            stagingBuffer->getBuffer(),
+            image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            storedLevels,
+            copyRegions.data());
+
+        if (!generateMipmaps || storedLevels >= mipLevels)
+        {
+            toShaderRead(0, mipLevels, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT);
+        }
+        else
+        {
+            // the stored levels above the last one are final as they are
+            if (storedLevels > 1)
+            {
+                toShaderRead(0, storedLevels - 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT);
+            }
+
+            // every level is blitted from the previous one, which becomes readable by shaders once it's been used
+            for (uint32_t level = storedLevels; level < mipLevels; level++)
+            {
+                transition(
+                    level - 1,
+                    1,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    VK_ACCESS_TRANSFER_WRITE_BIT,
+                    VK_ACCESS_TRANSFER_READ_BIT,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+                VkImageBlit blit{};
+                blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1};
+                blit.srcOffsets[1] = {
+                    static_cast<int32_t>(std::max(extent.width >> (level - 1), 1u)),
+                    static_cast<int32_t>(std::max(extent.height >> (level - 1), 1u)),
+                    1};
+                blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+                blit.dstOffsets[1] = {
+                    static_cast<int32_t>(std::max(extent.width >> level, 1u)),
+                    static_cast<int32_t>(std::max(extent.height >> level, 1u)),
+                    1};
+                vkCmdBlitImage(
+                    commandBuffer,
+                    image,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    image,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    1,
+                    &blit,
+                    linearBlit ? VK_FILTER_LINEAR : VK_FILTER_NEAREST);
+
+                toShaderRead(level - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT);
+            }
+            toShaderRead(mipLevels - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT);
+        }
+    }
+
+    void GenTexture::createImageView()
+    {
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = format;
+        viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1};
+
+        if (vkCreateImageView(genDevice.device(), &viewInfo, nullptr, &imageView) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create texture image view!");
+        }
+    }
+
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "gen_buffer.hpp"
+#include "gen_device.hpp"
+
+// std
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gen
+{
+    // Hands out shared samplers, one per distinct configuration. Samplers don't clamp the lod, so the same
+    // sampler serves textures of any mip count. Thread safe.
+    class GenSamplerCache
+    {
+    public:
+        struct SamplerKey
+        {
+            VkFilter filter = VK_FILTER_LINEAR;
+            VkSamplerMipmapMode mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+            VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+            bool anisotropy = true;
+
+            bool operator==(const SamplerKey &other) const
+            {
+                return filter == other.filter && mipmapMode == other.mipmapMode && addressMode == other.addressMode &&
+                       anisotropy == other.anisotropy;
+            }
+        };
+
+        explicit GenSamplerCache(GenDevice &device) : genDevice{device} {}
+        ~GenSamplerCache();
+
+        GenSamplerCache(const GenSamplerCache &) = delete;
+        GenSamplerCache &operator=(const GenSamplerCache &) = delete;
+
+        // created on first use, lives as long as the cache
+        VkSampler getSampler(const SamplerKey &key = SamplerKey{});
+
+        uint32_t getSamplerCount();
+
+    private:
+        struct KeyHash
+        {
+            size_t operator()(const SamplerKey &key) const;
+        };
+
+        GenDevice &genDevice;
+        std::mutex mutex;
+        std::unordered_map<SamplerKey, VkSampler, KeyHash> samplers{};
+    };
+
+    // A sampled 2d image with its mip chain in device local memory. Pixels go through a staging buffer, missing
+    // mips are generated on the gpu by blitting each level from the one above it. Pre-compressed formats like
+    // BC1-7 are uploaded as they are, with the mips they come with, if the device can sample them.
+    class GenTexture
+    {
+    public:
+        // a mip level inside Builder::data, level i is max(1, width >> i) by max(1, height >> i)
+        struct MipLevel
+        {
+            VkDeviceSize offset;
+            VkDeviceSize size;
+        };
+
+        struct Builder
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+            std::vector<uint8_t> data{};
+            // the levels present in data, starting at the full resolution one
+            std::vector<MipLevel> levels{};
+            // blit the rest of the chain from the last level in data, ignored for formats the device can't blit
+            bool generateMipmaps = true;
+
+            // .ktx2 files are taken as they are, other images are decoded to 8 bit sRGB
+            void loadTexture(const std::string &filepath);
+            // the contents of the file at filepath, read by the caller. The path only tells the format and names it
+            // in errors
+            void decodeTexture(const std::vector<uint8_t> &contents, const std::string &filepath);
+            // a single level of uncompressed 8 bit rgba pixels
+            void setPixels(uint32_t width, uint32_t height, const uint8_t *rgba, VkFormat format = VK_FORMAT_R8G8B8A8_SRGB);
+            // drops up to count of the most detailed levels, stored ones as they are. A single level of 8 bit rgba
+            // is box filtered down instead. Returns how many levels were dropped
+            uint32_t skipLevels(uint32_t count);
+            // levels of the complete chain, which is only generated if generateMipmaps is set
+            uint32_t getMipCount() const;
+
+        private:
+            void parseKtx2(const std::vector<uint8_t> &bytes, const std::string &filepath);
+        };
+
+        enum class UploadMode
+        {
+            // uploaded before the constructor returns, waits for the graphics queue
+            Immediate,
+            // only staged, the owner records the upload into one of its command buffers. Constructing never
+            // touches a queue, so this works from any thread
+            Deferred
+        };
+
+        struct Stats
+        {
+            // of the textures alive
+            uint32_t textureCount = 0;
+            VkDeviceSize memoryBytes = 0;
+            // sent through staging by every immediate upload so far, and the time those took including the gpu
+            // copies and mip generation
+            VkDeviceSize uploadedBytes = 0;
+            double uploadSeconds = 0.0;
+
+            double uploadMegabytesPerSecond() const
+            {
+                return uploadSeconds > 0.0 ? uploadedBytes / (1024.0 * 1024.0) / uploadSeconds : 0.0;
+            }
+        };
+
+        // throws if the device can't sample the builder's format
+        GenTexture(
+            GenDevice &device,
+            GenSamplerCache &samplerCache,
+            const Builder &builder,
+            UploadMode uploadMode = UploadMode::Immediate);
+        ~GenTexture();
+
+        GenTexture(const GenTexture &) = delete;
+        GenTexture &operator=(const GenTexture &) = delete;
+
+        static std::unique_ptr<GenTexture> createTextureFromFile(
+            GenDevice &device, GenSamplerCache &samplerCache, const std::string &filepath);
+        // a 1x1 texture, white leaves whatever it's multiplied with unchanged
+        static std::unique_ptr<GenTexture> createSolidColor(
+            GenDevice &device, GenSamplerCache &samplerCache, uint32_t rgba = 0xffffffff);
+
+        // sampled with optimal tiling, BC formats also need the device feature
+        static bool isFormatSupported(GenDevice &device, VkFormat format);
+        static Stats getStats();
+
+        // unique over the program's lifetime, unlike the handles that may be reused after destruction
+        uint64_t getId() const { return id; }
+        VkImage getImage() const { return image; }
+        VkImageView getImageView() const { return imageView; }
+        VkSampler getSampler() const { return sampler; }
+        VkFormat getFormat() const { return format; }
+        VkExtent2D getExtent() const { return extent; }
+        uint32_t getMipLevels() const { return mipLevels; }
+        VkDeviceSize getMemorySize() const { return memorySize; }
+
+        VkDescriptorImageInfo descriptorInfo() const
+        {
+            return {sampler, imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+        }
+
+        // deferred uploads only: copies the staged levels, generates the rest and leaves every level readable by
+        // fragment shaders. Record once, outside a render pass, before the texture is sampled
+        void recordUpload(VkCommandBuffer commandBuffer);
+        // right after recordUpload, the staging buffer is destroyed once the recording frame has completed
+        void releaseStagingBuffer();
+        bool isStaged() const { return stagingBuffer != nullptr; }
+
+    private:
+        void createImage(const Builder &builder);
+        void stage(const Builder &builder);
+        void createImageView();
+
+        GenDevice &genDevice;
+        uint64_t id;
+        VkImage image = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkImageView imageView = VK_NULL_HANDLE;
+        VkSampler sampler = VK_NULL_HANDLE;
+        VkFormat format;
+        VkExtent2D extent;
+        uint32_t mipLevels = 1;
+        VkDeviceSize memorySize = 0;
+
+        bool generateMipmaps = false;
+        bool linearBlit = false;
+        std::unique_ptr<GenBuffer> stagingBuffer{};
+        std::vector<VkBufferImageCopy> copyRegions{};
+    };
+}
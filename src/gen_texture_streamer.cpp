@@ -0,0 +1,290 @@
+#include "gen_texture_streamer.hpp"
+#include "gen_cpu_profiler.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#ifndef ENGINE_DIR
+#define ENGINE_DIR "../"
+#endif
+
+namespace gen
+{
+
+    // *************** Streamed Texture *********************
+
+    GenStreamedTexture::GenStreamedTexture(
+        std::string filepath, std::unique_ptr<GenTexture> base, uint32_t baseMip, uint32_t mipCount, VkExtent2D extent)
+        : filepath{std::move(filepath)},
+          extent{extent},
+          mipCount{mipCount},
+          base{std::move(base)},
+          baseMip{baseMip},
+          wantedMip{baseMip}
+    {
+    }
+
+    void GenStreamedTexture::requestPixels(float pixels)
+    {
+        // one texel per pixel, every mip halves the texels along the larger side
+        float size = static_cast<float>(std::max(extent.width, extent.height));
+        uint32_t mip = pixels >= size ? 0 : static_cast<uint32_t>(std::log2(size / std::max(pixels, 1.f)));
+        wantedMip = std::min({wantedMip, mip, baseMip});
+        requested = true;
+    }
+
+    // *************** Texture Streamer *********************
+
+    GenTextureStreamer::GenTextureStreamer(
+        GenDevice &device,
+        GenSamplerCache &samplerCache,
+        GenJobSystem &jobSystem,
+        VkDeviceSize budgetBytes,
+        uint32_t residentSize)
+        : genDevice{device},
+          samplerCache{samplerCache},
+          jobSystem{jobSystem},
+          budgetBytes{budgetBytes},
+          residentSize{residentSize}
+    {
+        loaderThread = std::thread{&GenTextureStreamer::loaderLoop, this};
+    }
+
+    GenTextureStreamer::~GenTextureStreamer()
+    {
+        {
+            std::lock_guard<std::mutex> lock{queueMutex};
+            stopping = true;
+        }
+        queueCondition.notify_all();
+        loaderThread.join();
+        jobSystem.wait(decodeJobs);
+    }
+
+    std::shared_ptr<GenStreamedTexture> GenTextureStreamer::load(const std::string &filepath)
+    {
+        GEN_PROFILE_SCOPE("GenTextureStreamer::load");
+        auto it = textures.find(filepath);
+        if (it != textures.end())
+        {
+            return it->second;
+        }
+
+        std::string path = ENGINE_DIR + filepath;
+        GenTexture::Builder builder{};
+        builder.loadTexture(path);
+        VkExtent2D extent{builder.width, builder.height};
+        uint32_t mipCount = builder.getMipCount();
+
+        uint32_t baseMip = 0;
+        while (baseMip + 1 < mipCount && std::max(extent.width >> baseMip, extent.height >> baseMip) > residentSize)
+        {
+            baseMip++;
+        }
+        baseMip = builder.skipLevels(baseMip);
+        auto base = std::make_unique<GenTexture>(genDevice, samplerCache, builder);
+
+        std::shared_ptr<GenStreamedTexture> texture{
+            new GenStreamedTexture(path, std::move(base), baseMip, mipCount, extent)};
+        textures.emplace(filepath, texture);
+        return texture;
+    }
+
+    void GenTextureStreamer::update(VkCommandBuffer commandBuffer)
+    {
+        GEN_PROFILE_SCOPE("GenTextureStreamer::update");
+        frameNumber++;
+
+        // drawn during the last frame, so not worth evicting for a new load
+        for (auto &kv : textures)
+        {
+            if (kv.second->requested)
+            {
+                kv.second->lastUsedFrame = frameNumber;
+            }
+        }
+
+        std::vector<LoadResult> finished{};
+        {
+            std::lock_guard<std::mutex> lock{queueMutex};
+            finished.swap(results);
+        }
+        for (auto &result : finished)
+        {
+            applyResult(result, commandBuffer);
+        }
+
+        std::vector<LoadRequest> newRequests{};
+        auto now = std::chrono::high_resolution_clock::now();
+        for (auto &kv : textures)
+        {
+            auto &texture = *kv.second;
+            if (texture.requested && !texture.loadPending && texture.wantedMip < texture.getResidentMip() &&
+                frameNumber >= texture.retryFrame)
+            {
+                texture.loadPending = true;
+                newRequests.push_back({&texture, texture.filepath, texture.wantedMip, now});
+            }
+            texture.requested = false;
+            texture.wantedMip = texture.baseMip;
+        }
+
+        if (!newRequests.empty())
+        {
+            {
+                std::lock_guard<std::mutex> lock{queueMutex};
+                requests.insert(requests.end(), newRequests.begin(), newRequests.end());
+            }
+            queueCondition.notify_one();
+        }
+    }
+
+    void GenTextureStreamer::applyResult(LoadResult &result, VkCommandBuffer commandBuffer)
+    {
+        GenStreamedTexture &texture = *result.texture;
+        texture.loadPending = false;
+        if (result.detail == nullptr)
+        {
+            texture.retryFrame = frameNumber + RETRY_FRAMES;
+            return;
+        }
+        // a finer mip landed in the meantime
+        if (result.mip >= texture.getResidentMip())
+        {
+            return;
+        }
+
+        VkDeviceSize size = result.detail->getMemorySize();
+        VkDeviceSize replaced = texture.detail != nullptr ? texture.detail->getMemorySize() : 0;
+        while (detailBytes - replaced + size > budgetBytes)
+        {
+            if (!evictLeastRecentlyUsed(&texture))
+            {
+                rejections++;
+                texture.retryFrame = frameNumber + RETRY_FRAMES;
+                return;
+            }
+        }
+
+        result.detail->recordUpload(commandBuffer);
+        result.detail->releaseStagingBuffer();
+        // frames in flight may still sample the replaced one, GenTexture defers destroying it
+        detailBytes -= replaced;
+        texture.detail = std::move(result.detail);
+        texture.detailMip = result.mip;
+        detailBytes += size;
+
+        loads++;
+        totalLoadMs += std::chrono::duration<double, std::milli>(
+                           std::chrono::high_resolution_clock::now() - result.requestTime)
+                           .count();
+    }
+
+    bool GenTextureStreamer::evictLeastRecentlyUsed(const GenStreamedTexture *keep)
+    {
+        GenStreamedTexture *victim = nullptr;
+        for (auto &kv : textures)
+        {
+            auto *texture = kv.second.get();
+            // textures drawn last frame stay, evicting them would only load them again
+            if (texture == keep || texture->detail == nullptr || texture->lastUsedFrame >= frameNumber)
+            {
+                continue;
+            }
+            if (victim == nullptr || texture->lastUsedFrame < victim->lastUsedFrame)
+            {
+                victim = texture;
+            }
+        }
+        if (victim == nullptr)
+        {
+            return false;
+        }
+
+        // frames in flight may still sample it, GenTexture defers destroying it
+        detailBytes -= victim->detail->getMemorySize();
+        victim->detail = nullptr;
+        evictions++;
+        return true;
+    }
+
+    void GenTextureStreamer::loaderLoop()
+    {
+        while (true)
+        {
+            LoadRequest request;
+            {
+                std::unique_lock<std::mutex> lock{queueMutex};
+                queueCondition.wait(lock, [this]
+                                    { return stopping || !requests.empty(); });
+                if (stopping)
+                {
+                    return;
+                }
+                request = std::move(requests.front());
+                requests.pop_front();
+            }
+
+            std::ifstream file{request.filepath, std::ios::ate | std::ios::binary};
+            if (!file.is_open())
+            {
+                std::cerr << "texture streaming failed for " << request.filepath << ": failed to open file!" << std::endl;
+                std::lock_guard<std::mutex> lock{queueMutex};
+                results.push_back({request.texture, nullptr, request.mip, request.requestTime});
+                continue;
+            }
+            auto contents = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(reinterpret_cast<char *>(contents->data()), contents->size());
+
+            // only the read blocks this thread, the textures decode in parallel
+            jobSystem.submit([this, request, contents]
+                             { decode(request, *contents); },
+                             &decodeJobs);
+        }
+    }
+
+    void GenTextureStreamer::decode(const LoadRequest &request, const std::vector<uint8_t> &contents)
+    {
+        LoadResult result{request.texture, nullptr, request.mip, request.requestTime};
+        try
+        {
+            GenTexture::Builder builder{};
+            builder.decodeTexture(contents, request.filepath);
+            result.mip = builder.skipLevels(request.mip);
+            // creating and staging needs no queue, the render thread records the upload
+            result.detail = std::make_unique<GenTexture>(
+                genDevice, samplerCache, builder, GenTexture::UploadMode::Deferred);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "texture streaming failed for " << request.filepath << ": " << e.what() << std::endl;
+        }
+
+        std::lock_guard<std::mutex> lock{queueMutex};
+        results.push_back(std::move(result));
+    }
+
+    GenTextureStreamer::Stats GenTextureStreamer::getStats()
+    {
+        Stats stats{};
+        stats.textureCount = static_cast<uint32_t>(textures.size());
+        for (auto &kv : textures)
+        {
+            stats.detailCount += kv.second->detail != nullptr ? 1 : 0;
+        }
+        stats.detailBytes = detailBytes;
+        stats.budgetBytes = budgetBytes;
+        stats.loads = loads;
+        stats.evictions = evictions;
+        stats.rejections = rejections;
+        stats.averageLoadMs = loads > 0 ? totalLoadMs / loads : 0.0;
+        return stats;
+    }
+
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "gen_device.hpp"
+#include "gen_job_system.hpp"
+#include "gen_texture.hpp"
+
+// std
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace gen
+{
+    class GenTextureStreamer;
+
+    // A texture whose detailed mips are streamed in while it's seen up close. The small levels are always
+    // resident; a detail texture holding the chain from a finer level down is loaded on demand and evicted again
+    // when the streamer runs out of budget. Drawing always samples the most detailed one that is resident.
+    class GenStreamedTexture
+    {
+    public:
+        GenStreamedTexture(const GenStreamedTexture &) = delete;
+        GenStreamedTexture &operator=(const GenStreamedTexture &) = delete;
+
+        // the texture to sample this frame, never waits for a load
+        const GenTexture &getResident() const { return detail != nullptr ? *detail : *base; }
+        // the level of the full chain that the resident texture starts at
+        uint32_t getResidentMip() const { return detail != nullptr ? detailMip : baseMip; }
+        uint32_t getMipCount() const { return mipCount; }
+        VkExtent2D getExtent() const { return extent; }
+
+        // from the render thread while recording. pixels is how large the texture appears on screen, the most
+        // detailed mip needed by any request of a frame is loaded
+        void requestPixels(float pixels);
+
+    private:
+        friend class GenTextureStreamer;
+
+        GenStreamedTexture(std::string filepath, std::unique_ptr<GenTexture> base, uint32_t baseMip, uint32_t mipCount, VkExtent2D extent);
+
+        std::string filepath;
+        VkExtent2D extent;
+        uint32_t mipCount;
+
+        std::unique_ptr<GenTexture> base;
+        uint32_t baseMip;
+        std::unique_ptr<GenTexture> detail{};
+        uint32_t detailMip = 0;
+
+        // demand since the streamer's last update, baseMip when nothing asked for more
+        uint32_t wantedMip;
+        bool requested = false;
+        uint64_t lastUsedFrame = 0;
+        bool loadPending = false;
+        // a load that didn't fit the budget isn't retried before this frame
+        uint64_t retryFrame = 0;
+    };
+
+    // Streams the detailed mips of GenStreamedTextures. Files are read on a background loader thread, then
+    // decoded and staged as jobs; update records the finished uploads into the frame's command buffer, so
+    // nothing waits for a load. Detail textures share a fixed budget, the least recently drawn ones are evicted to make room.
+    class GenTextureStreamer
+    {
+    public:
+        struct Stats
+        {
+            uint32_t textureCount = 0;
+            uint32_t detailCount = 0;
+            VkDeviceSize detailBytes = 0;
+            VkDeviceSize budgetBytes = 0;
+            uint64_t loads = 0;
+            uint64_t evictions = 0;
+            // finished loads dropped because nothing could be evicted to fit them
+            uint64_t rejections = 0;
+            // from the request to the upload being recorded
+            double averageLoadMs = 0.0;
+        };
+
+        static constexpr VkDeviceSize DEFAULT_BUDGET = 256 * 1024 * 1024;
+        // largest dimension of the always resident levels
+        static constexpr uint32_t DEFAULT_RESIDENT_SIZE = 64;
+        static constexpr uint64_t RETRY_FRAMES = 60;
+
+        GenTextureStreamer(
+            GenDevice &device,
+            GenSamplerCache &samplerCache,
+            GenJobSystem &jobSystem,
+            VkDeviceSize budgetBytes = DEFAULT_BUDGET,
+            uint32_t residentSize = DEFAULT_RESIDENT_SIZE);
+        // every frame using the textures must have completed
+        ~GenTextureStreamer();
+
+        GenTextureStreamer(const GenTextureStreamer &) = delete;
+        GenTextureStreamer &operator=(const GenTextureStreamer &) = delete;
+
+        // decodes the file and uploads its resident levels before returning. Loading a path again returns the
+        // same texture
+        std::shared_ptr<GenStreamedTexture> load(const std::string &filepath);
+
+        // from the render thread once per frame, after the frame's fence wait and before recording draws.
+        // Records finished uploads into commandBuffer outside a render pass and queues loads for the mips
+        // requested since the last update
+        void update(VkCommandBuffer commandBuffer);
+
+        Stats getStats();
+
+    private:
+        struct LoadRequest
+        {
+            GenStreamedTexture *texture;
+            std::string filepath;
+            uint32_t mip;
+            std::chrono::high_resolution_clock::time_point requestTime;
+        };
+
+        struct LoadResult
+        {
+            GenStreamedTexture *texture;
+            // nullptr if loading failed
+            std::unique_ptr<GenTexture> detail;
+            uint32_t mip;
+            std::chrono::high_resolution_clock::time_point requestTime;
+        };
+
+        void loaderLoop();
+        void decode(const LoadRequest &request, const std::vector<uint8_t> &contents);
+        void applyResult(LoadResult &result, VkCommandBuffer commandBuffer);
+        // evicts the least recently used detail texture other than keep, false if there is none
+        bool evictLeastRecentlyUsed(const GenStreamedTexture *keep);
+
+        GenDevice &genDevice;
+        GenSamplerCache &samplerCache;
+        GenJobSystem &jobSystem;
+        VkDeviceSize budgetBytes;
+        uint32_t residentSize;
+
+        std::unordered_map<std::string, std::shared_ptr<GenStreamedTexture>> textures{};
+        uint64_t frameNumber = 0;
+        VkDeviceSize detailBytes = 0;
+
+        std::mutex queueMutex;
+        std::condition_variable queueCondition;
+        std::deque<LoadRequest> requests{};
+        std::vector<LoadResult> results{};
+        bool stopping = false;
+        std::thread loaderThread;
+        // the decode jobs in flight, they push to results
+        GenJobSystem::Counter decodeJobs;
+
+        uint64_t loads = 0;
+        uint64_t evictions = 0;
+        uint64_t rejections = 0;
+        double totalLoadMs = 0.0;
+    };
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace gen
+{
+    // Lock free handoff of the latest value from one writer thread to one reader thread. Writer and reader
+    // each own one of three slots and swap it with the shared middle slot, so neither ever waits on the other.
+    // The reader always gets the most recently published value, values it never acquired are overwritten.
+    template <typename T>
+    class GenTripleBuffer
+    {
+    public:
+        GenTripleBuffer() = default;
+
+        GenTripleBuffer(const GenTripleBuffer &) = delete;
+        GenTripleBuffer &operator=(const GenTripleBuffer &) = delete;
+
+        // writer only, the slot stays the writer's until publish()
+        T &writeSlot() { return slots[writeIndex]; }
+
+        // writer only, hands the written slot to the reader and takes over the shared slot to write next
+        void publish()
+        {
+            writeIndex = shared.exchange(writeIndex | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+        }
+
+        // reader only, returns false if nothing was published since the last acquire, readSlot() keeps the
+        // previous value in that case
+        bool acquire()
+        {
+            if ((shared.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+            {
+                return false;
+            }
+            // only the reader clears the bit, so the slot taken here is always the freshest one
+            readIndex = shared.exchange(readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+            return true;
+        }
+
+        // reader only
+        T &readSlot() { return slots[readIndex]; }
+
+    private:
+        static constexpr uint8_t INDEX_MASK = 0x3;
+        // set in the shared index while it holds a value the reader hasn't acquired yet
+        static constexpr uint8_t FRESH_BIT = 0x4;
+
+        std::array<T, 3> slots{};
+        uint8_t writeIndex = 0;
+        std::atomic<uint8_t> shared{1};
+        uint8_t readIndex = 2;
+    };
+}
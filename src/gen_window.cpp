@@ -1,18 +1,27 @@
 #include "gen_window.hpp"
+#include <chrono>
 #include <stdexcept>
 
 namespace gen
 {
 
-    GenWindow::GenWindow(int width, int height, std::string name) : width{width}, height{height}, windowName{name}
+    GenWindow::GenWindow(int width, int height, std::string name, bool headless)
+        : width{width}, height{height}, windowName{name}, headless{headless}
     {
-        initWindow();
+        // without a display glfwInit fails, so headless runs don't touch GLFW at all
+        if (!headless)
+        {
+            initWindow();
+        }
     }
 
     GenWindow::~GenWindow()
     {
-        glfwDestroyWindow(window);
-        glfwTerminate();
+        if (!headless)
+        {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+        }
     }
 
     void GenWindow::initWindow()
@@ -23,11 +32,40 @@ namespace gen
         // don't resize after creation
         glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
-        window = glfwCreateWindow(width, height, windowName.c_str(), nullptr, nullptr);
+        window = glfwCreateWindow(width.load(), height.load(), windowName.c_str(), nullptr, nullptr);
         glfwSetWindowUserPointer(window, this);
         glfwSetFramebufferSizeCallback(window, framebufferresizeCallback);
     }
 
+    void GenWindow::requestClose()
+    {
+        closeRequested = true;
+        if (!headless)
+        {
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
+        }
+    }
+
+    void GenWindow::pollEvents()
+    {
+        if (!headless)
+        {
+            glfwPollEvents();
+        }
+    }
+
+    void GenWindow::waitEvents()
+    {
+        if (!headless && std::this_thread::get_id() == mainThreadId)
+        {
+            glfwWaitEvents();
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
     void GenWindow::createWindowSurface(VkInstance instance, VkSurfaceKHR *surface)
     {
         if (glfwCreateWindowSurface(instance, window, nullptr, surface) != VK_SUCCESS)
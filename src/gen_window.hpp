@@ -2,28 +2,39 @@
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
+#include <atomic>
 #include <string>
+#include <thread>
 namespace gen
 {
     class GenWindow
     {
 
     public:
-        GenWindow(int width, int height, std::string name);
+        // a headless window has no GLFW window or surface, it only provides the extent to render offscreen at
+        GenWindow(int width, int height, std::string name, bool headless = false);
         ~GenWindow();
 
         // delete copy constructor and copy operator from window class to prevent dangling pointer
         GenWindow(const GenWindow &) = delete;
         GenWindow &operator=(const GenWindow &) = delete;
 
+        // may be called from any thread, glfwWindowShouldClose isn't tied to the main thread
         bool shouldClose()
         {
-            return glfwWindowShouldClose(window);
+            return headless ? closeRequested.load() : glfwWindowShouldClose(window);
+        }
+
+        void requestClose();
+
+        bool isHeadless() const
+        {
+            return headless;
         }
 
         VkExtent2D getExtent()
         {
-            return {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+            return {static_cast<uint32_t>(width.load()), static_cast<uint32_t>(height.load())};
         }
 
         bool wasWindowResized()
@@ -36,22 +47,34 @@ namespace gen
             frameBufferResized = false;
         }
 
+        // nullptr when headless
         GLFWwindow *getGLFWWindow() const
         {
             return window;
         }
 
+        // main thread only, does nothing when headless
+        void pollEvents();
+
+        // blocks until events arrive, only the main thread may process them so other threads just back off
+        // while the main thread keeps polling
+        void waitEvents();
+
         void createWindowSurface(VkInstance instance, VkSurfaceKHR *surface);
 
     private:
         static void framebufferresizeCallback(GLFWwindow *window, int width, int height);
         void initWindow();
 
-        int width;
-        int height;
-        bool frameBufferResized = false;
+        // written by the resize callback on the main thread, read by whichever thread renders
+        std::atomic<int> width;
+        std::atomic<int> height;
+        std::atomic<bool> frameBufferResized{false};
+        std::thread::id mainThreadId = std::this_thread::get_id();
+        std::atomic<bool> closeRequested{false};
 
         std::string windowName;
-        GLFWwindow *window;
+        bool headless;
+        GLFWwindow *window = nullptr;
     };
 }
\ No newline at end of file
@@ -1,15 +1,61 @@
 #include "app.hpp"
+#include "gen_cpu_profiler.hpp"
 
 //std
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
-int main(){
-    gen::App app{};
+int main(int argc, char **argv){
+    // options that have to be known before the app is created: the profiler captures device setup, model
+    // loading and pipeline creation, the window decides how the device is set up
+    std::string cpuTracePath{};
+    bool headless = false;
+    for (int i = 1; i < argc; i++){
+        if (std::string{argv[i]} == "--cpu-trace" && i + 1 < argc){
+            cpuTracePath = argv[i + 1];
+            gen::GenCpuProfiler::setThreadName("main");
+            gen::GenCpuProfiler::setEnabled(true);
+        }
+        else if (std::string{argv[i]} == "--headless"){
+            headless = true;
+        }
+    }
+
+    gen::App app{headless};
 
     try{
+        for (int i = 1; i < argc; i++){
+            if (std::string{argv[i]} == "--record-benchmark"){
+                app.enableRecordingBenchmark();
+            }
+            else if (std::string{argv[i]} == "--light-sweep"){
+                app.enableLightSweep();
+            }
+            else if (std::string{argv[i]} == "--pipelined"){
+                app.enablePipelinedRendering();
+            }
+            else if (std::string{argv[i]} == "--gpu-profile-csv" && i + 1 < argc){
+                app.setGpuProfileCsv(argv[++i]);
+            }
+            else if (std::string{argv[i]} == "--frames" && i + 1 < argc){
+                app.setFrameLimit(static_cast<uint32_t>(std::stoul(argv[++i])));
+            }
+            else if (std::string{argv[i]} == "--capture" && i + 1 < argc){
+                app.setCaptureFile(argv[++i]);
+            }
+            else if (std::string{argv[i]} == "--dynamic-resolution" && i + 1 < argc){
+                app.enableDynamicResolution(std::stod(argv[++i]));
+            }
+            else if (std::string{argv[i]} == "--cpu-trace" && i + 1 < argc){
+                i++;
+            }
+        }
         app.run();
+        if (!cpuTracePath.empty()){
+            gen::GenCpuProfiler::writeChromeTrace(cpuTracePath);
+        }
     } catch (const std::exception &e){
         std::cerr << e.what() << std::endl;
         return EXIT_FAILURE;
@@ -0,0 +1,172 @@
+#include "deferred_lighting_system.hpp"
+#include "gen_cpu_profiler.hpp"
+
+// std
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+namespace gen
+{
+
+    // one per frame in flight, like the g-buffer attachments
+    static constexpr uint32_t MAX_GBUFFER_SETS = GenSwapChain::MAX_FRAMES_IN_FLIGHT;
+
+    DeferredLightingSystem::DeferredLightingSystem(
+        GenDevice &device, VkRenderPass deferredRenderPass, VkDescriptorSetLayout globalSetLayout)
+        : genDevice{device}
+    {
+        createDescriptorResources();
+        createPipelineLayout(globalSetLayout);
+        createPipelines(deferredRenderPass);
+    }
+
+    DeferredLightingSystem::~DeferredLightingSystem()
+    {
+        vkDestroyPipelineLayout(genDevice.device(), pipelineLayout, nullptr);
+    }
+
+    void DeferredLightingSystem::createDescriptorResources()
+    {
+        gBufferSetLayout =
+            GenDescriptorSetLayout::Builder(genDevice)
+                .addBinding(0, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT) // albedo
+                .addBinding(1, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT) // normal
+                .addBinding(2, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT) // depth
+                .build();
+
+        gBufferPool =
+            GenDescriptorPool::Builder(genDevice)
+                .setMaxSets(MAX_GBUFFER_SETS)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 3 * MAX_GBUFFER_SETS)
+                .build();
+    }
+
+    void DeferredLightingSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
+    {
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout, gBufferSetLayout->getDescriptorSetLayout()};
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+        pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+        pipelineLayoutInfo.pushConstantRangeCount = 0;
+        pipelineLayoutInfo.pPushConstantRanges = nullptr;
+        if (vkCreatePipelineLayout(genDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
+            VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+    }
+
+    void DeferredLightingSystem::createPipelines(VkRenderPass deferredRenderPass)
+    {
+        assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+
+        // both passes generate their vertices in the vertex shader and have no depth attachment to test against
+        PipelineConfigInfo ambientConfig{};
+        GenPipeline::defaultPipelineConfigInfo(ambientConfig);
+        ambientConfig.attributeDescriptions.clear();
+        ambientConfig.bindingDescriptions.clear();
+        ambientConfig.depthStencilInfo.depthTestEnable = VK_FALSE;
+        ambientConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+        ambientConfig.renderPass = deferredRenderPass;
+        ambientConfig.subpass = GenSwapChain::LIGHTING_SUBPASS;
+        ambientConfig.pipelineLayout = pipelineLayout;
+        ambientPipeline = std::make_unique<GenPipeline>(
+            genDevice,
+            "shaders/deferred_ambient.vert.spv",
+            "shaders/deferred_ambient.frag.spv",
+            ambientConfig);
+
+        PipelineConfigInfo lightConfig{};
+        GenPipeline::defaultPipelineConfigInfo(lightConfig);
+        lightConfig.attributeDescriptions.clear();
+        lightConfig.bindingDescriptions.clear();
+        lightConfig.depthStencilInfo.depthTestEnable = VK_FALSE;
+        lightConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+        // light contributions simply add up
+        lightConfig.colorBlendAttachment.blendEnable = VK_TRUE;
+        lightConfig.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+        lightConfig.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+        lightConfig.colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+        lightConfig.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+        lightConfig.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        lightConfig.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+        lightConfig.renderPass = deferredRenderPass;
+        lightConfig.subpass = GenSwapChain::LIGHTING_SUBPASS;
+        lightConfig.pipelineLayout = pipelineLayout;
+        lightVolumePipeline = std::make_unique<GenPipeline>(
+            genDevice,
+            "shaders/deferred_light.vert.spv",
+            "shaders/deferred_light.frag.spv",
+            lightConfig);
+    }
+
+    VkDescriptorSet DeferredLightingSystem::getGBufferDescriptorSet(int frameIndex, const GBufferViews &gBuffer)
+    {
+        while (gBufferDescriptorSets.size() <= static_cast<size_t>(frameIndex))
+        {
+            VkDescriptorSet set;
+            if (!gBufferPool->allocateDescriptor(gBufferSetLayout->getDescriptorSetLayout(), set))
+            {
+                throw std::runtime_error("failed to allocate g-buffer descriptor set!");
+            }
+            gBufferDescriptorSets.push_back(set);
+            boundGBufferViews.push_back({});
+        }
+
+        // the views only change when the swap chain is recreated. Only frames of this slot use the set, and the
+        // slot's previous frame has completed by the time this one records, so it can be rewritten
+        if (boundGBufferViews[frameIndex] != gBuffer)
+        {
+            VkDescriptorImageInfo albedoInfo{VK_NULL_HANDLE, gBuffer.albedo, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+            VkDescriptorImageInfo normalInfo{VK_NULL_HANDLE, gBuffer.normal, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+            VkDescriptorImageInfo depthInfo{VK_NULL_HANDLE, gBuffer.depth, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL};
+            GenDescriptorWriter(*gBufferSetLayout, *gBufferPool)
+                .writeImage(0, &albedoInfo)
+                .writeImage(1, &normalInfo)
+                .writeImage(2, &depthInfo)
+                .overwrite(gBufferDescriptorSets[frameIndex]);
+            boundGBufferViews[frameIndex] = gBuffer;
+        }
+
+        return gBufferDescriptorSets[frameIndex];
+    }
+
+    void DeferredLightingSystem::render(
+        FrameInfo &frameInfo, const GBufferViews &gBuffer, uint32_t lightCount)
+    {
+        GEN_PROFILE_SCOPE("DeferredLightingSystem::render");
+        std::array<VkDescriptorSet, 2> descriptorSets{
+            frameInfo.globalDescriptorSet,
+            getGBufferDescriptorSet(frameInfo.frameIndex, gBuffer)};
+
+        ambientPipeline->bind(frameInfo.commandBuffer);
+
+        vkCmdBindDescriptorSets(
+            frameInfo.commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipelineLayout,
+            0,
+            static_cast<uint32_t>(descriptorSets.size()),
+            descriptorSets.data(),
+            1,
+            &frameInfo.globalUboOffset);
+
+        // fullscreen triangle
+        vkCmdDraw(frameInfo.commandBuffer, 3, 1, 0, 0);
+        frameInfo.drawCalls++;
+
+        if (lightCount == 0)
+        {
+            return;
+        }
+
+        // same layout, so the descriptor sets stay bound; one screen space quad per light
+        lightVolumePipeline->bind(frameInfo.commandBuffer);
+        vkCmdDraw(frameInfo.commandBuffer, 6, lightCount, 0, 0);
+        frameInfo.drawCalls++;
+    }
+
+} // namespace gen
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "gen_device.hpp"
+#include "gen_descriptors.hpp"
+#include "gen_frame_info.hpp"
+#include "gen_pipeline.hpp"
+#include "gen_swap_chain.hpp"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace gen
+{
+    // Lighting subpass of the deferred render path: resolves ambient light with a fullscreen triangle and then
+    // draws one screen space light volume per point light, additively blending each light's contribution.
+    class DeferredLightingSystem
+    {
+
+    public:
+        DeferredLightingSystem(GenDevice &device, VkRenderPass deferredRenderPass, VkDescriptorSetLayout globalSetLayout);
+        ~DeferredLightingSystem();
+
+        DeferredLightingSystem(const DeferredLightingSystem &) = delete;
+        DeferredLightingSystem &operator=(const DeferredLightingSystem &) = delete;
+
+        // lights are read from the light storage buffer of the global set, lightCount is the number of volumes drawn
+        void render(FrameInfo &frameInfo, const GBufferViews &gBuffer, uint32_t lightCount);
+
+    private:
+        void createDescriptorResources();
+        void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
+        void createPipelines(VkRenderPass deferredRenderPass);
+        VkDescriptorSet getGBufferDescriptorSet(int frameIndex, const GBufferViews &gBuffer);
+
+        GenDevice &genDevice;
+
+        std::unique_ptr<GenDescriptorSetLayout> gBufferSetLayout;
+        std::unique_ptr<GenDescriptorPool> gBufferPool;
+        // one set per frame in flight, rewritten when the swap chain is recreated
+        std::vector<VkDescriptorSet> gBufferDescriptorSets;
+        std::vector<GBufferViews> boundGBufferViews;
+
+        std::unique_ptr<GenPipeline> ambientPipeline;
+        std::unique_ptr<GenPipeline> lightVolumePipeline;
+        VkPipelineLayout pipelineLayout;
+    };
+}
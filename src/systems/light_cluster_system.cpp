@@ -0,0 +1,337 @@
+#include "light_cluster_system.hpp"
+#include "gen_cpu_profiler.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace gen
+{
+
+    // lights per job when computing cluster bounds in parallel
+    static constexpr uint32_t LIGHT_BOUNDS_BATCH_SIZE = 64;
+    static constexpr uint32_t CULLED_LIGHT = std::numeric_limits<uint32_t>::max();
+
+    LightClusterSystem::LightClusterSystem(GenDevice &device, VkDescriptorSetLayout globalSetLayout)
+        : genDevice{device}
+    {
+        createBuffers();
+        createPipelineLayout(globalSetLayout);
+        createPipeline();
+
+        clusterCounts.resize(CLUSTER_COUNT);
+        clusterOffsets.resize(CLUSTER_COUNT);
+    }
+
+    LightClusterSystem::~LightClusterSystem()
+    {
+        vkDestroyPipelineLayout(genDevice.device(), pipelineLayout, nullptr);
+    }
+
+    void LightClusterSystem::createBuffers()
+    {
+        lightBuffers.resize(GenSwapChain::MAX_FRAMES_IN_FLIGHT);
+        clusterBuffers.resize(GenSwapChain::MAX_FRAMES_IN_FLIGHT);
+        lightIndexBuffers.resize(GenSwapChain::MAX_FRAMES_IN_FLIGHT);
+
+        // host visible so the cpu path can write the light lists directly, the compute path writes them on the gpu
+        for (int i = 0; i < GenSwapChain::MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            lightBuffers[i] = createLightBuffer(INITIAL_LIGHT_CAPACITY);
+
+            clusterBuffers[i] = std::make_unique<GenBuffer>(
+                genDevice,
+                sizeof(Cluster),
+                CLUSTER_COUNT,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            clusterBuffers[i]->map();
+
+            lightIndexBuffers[i] = std::make_unique<GenBuffer>(
+                genDevice,
+                sizeof(uint32_t),
+                LIGHT_INDEX_CAPACITY,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            lightIndexBuffers[i]->map();
+        }
+    }
+
+    std::unique_ptr<GenBuffer> LightClusterSystem::createLightBuffer(uint32_t capacity)
+    {
+        auto buffer = std::make_unique<GenBuffer>(
+            genDevice,
+            sizeof(PointLight),
+            capacity,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        buffer->map();
+        return buffer;
+    }
+
+    void LightClusterSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
+    {
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+        pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+        pipelineLayoutInfo.pushConstantRangeCount = 0;
+        pipelineLayoutInfo.pPushConstantRanges = nullptr;
+        if (vkCreatePipelineLayout(genDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
+            VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+    }
+
+    void LightClusterSystem::createPipeline()
+    {
+        assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+
+        computePipeline = std::make_unique<GenPipeline>(
+            genDevice,
+            "shaders/light_cluster.comp.spv",
+            pipelineLayout);
+    }
+
+    bool LightClusterSystem::update(FrameInfo &frameInfo, GlobalUbo &ubo, const std::vector<PointLight> &lights)
+    {
+        GEN_PROFILE_SCOPE("LightClusterSystem::update");
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        // doubled until the lights fit, the old buffer is destroyed once the frames in flight reading it completed
+        auto &lightBuffer = lightBuffers[frameInfo.frameIndex];
+        bool replaced = lights.size() > lightBuffer->getInstanceCount();
+        if (replaced)
+        {
+            uint32_t capacity = lightBuffer->getInstanceCount();
+            while (capacity < lights.size())
+            {
+                capacity *= 2;
+            }
+            lightBuffer = createLightBuffer(capacity);
+        }
+
+        const float nearClip = frameInfo.camera.getNearClip();
+        const float farClip = frameInfo.camera.getFarClip();
+        const float logDepthRatio = std::log(farClip / nearClip);
+
+        // slice = log(z) * scale - bias, which distributes the slices exponentially between near and far
+        ubo.clusterGrid = {CLUSTER_COUNT_X, CLUSTER_COUNT_Y, CLUSTER_COUNT_Z, 0};
+        ubo.clusterDepth = {
+            nearClip,
+            farClip,
+            CLUSTER_COUNT_Z / logDepthRatio,
+            CLUSTER_COUNT_Z * std::log(nearClip) / logDepthRatio};
+        ubo.numLights = static_cast<int>(lights.size());
+
+        if (!lights.empty())
+        {
+            lightBuffer->writeToBuffer(
+                (void *)lights.data(),
+                sizeof(PointLight) * lights.size());
+        }
+
+        if (mode == Mode::CPU)
+        {
+            buildClusters(frameInfo, ubo, lights);
+        }
+        else
+        {
+            stats.indexCount = 0;
+        }
+
+        auto endTime = std::chrono::high_resolution_clock::now();
+        stats.lightCount = static_cast<uint32_t>(lights.size());
+        stats.buildMicros = std::chrono::duration<float, std::chrono::microseconds::period>(endTime - startTime).count();
+        stats.microsPerLight = stats.lightCount > 0 ? stats.buildMicros / stats.lightCount : 0.f;
+        return replaced;
+    }
+
+    void LightClusterSystem::dispatch(FrameInfo &frameInfo)
+    {
+        GEN_PROFILE_SCOPE("LightClusterSystem::dispatch");
+        if (mode != Mode::Compute)
+        {
+            return;
+        }
+
+        computePipeline->bind(frameInfo.commandBuffer);
+
+        vkCmdBindDescriptorSets(
+            frameInfo.commandBuffer,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            pipelineLayout,
+            0,
+            1,
+            &frameInfo.globalDescriptorSet,
+            1,
+            &frameInfo.globalUboOffset);
+
+        // one invocation per cluster, local size has to match light_cluster.comp
+        constexpr uint32_t localSize = 64;
+        vkCmdDispatch(frameInfo.commandBuffer, (CLUSTER_COUNT + localSize - 1) / localSize, 1, 1);
+    }
+
+    uint32_t LightClusterSystem::depthSlice(const GlobalUbo &ubo, float viewDepth) const
+    {
+        if (viewDepth <= ubo.clusterDepth.x)
+        {
+            return 0;
+        }
+        float slice = std::log(viewDepth) * ubo.clusterDepth.z - ubo.clusterDepth.w;
+        return static_cast<uint32_t>(glm::clamp(slice, 0.f, static_cast<float>(CLUSTER_COUNT_Z - 1)));
+    }
+
+    bool LightClusterSystem::computeLightBounds(const GlobalUbo &ubo, const PointLight &light, LightBounds &bounds) const
+    {
+        const glm::vec3 center = glm::vec3(ubo.view * glm::vec4(glm::vec3(light.position), 1.f));
+        const float range = light.position.w;
+        const float nearClip = ubo.clusterDepth.x;
+        const float farClip = ubo.clusterDepth.y;
+
+        float minDepth = center.z - range;
+        float maxDepth = center.z + range;
+        if (maxDepth <= nearClip || minDepth >= farClip)
+        {
+            return false;
+        }
+        minDepth = std::max(minDepth, nearClip);
+        maxDepth = std::min(maxDepth, farClip);
+
+        // project the corners of the light's view space bounding box, x / z is extremal at the corners
+        // so this gives a conservative screen space rectangle
+        glm::vec2 ndcMin{std::numeric_limits<float>::max()};
+        glm::vec2 ndcMax{std::numeric_limits<float>::lowest()};
+        for (int i = 0; i < 8; i++)
+        {
+            glm::vec4 corner{
+                center.x + ((i & 1) ? range : -range),
+                center.y + ((i & 2) ? range : -range),
+                (i & 4) ? maxDepth : minDepth,
+                1.f};
+            glm::vec4 clip = ubo.projection * corner;
+            glm::vec2 ndc = glm::vec2(clip) / clip.w;
+            ndcMin = glm::min(ndcMin, ndc);
+            ndcMax = glm::max(ndcMax, ndc);
+        }
+
+        if (ndcMax.x < -1.f || ndcMin.x > 1.f || ndcMax.y < -1.f || ndcMin.y > 1.f)
+        {
+            return false;
+        }
+
+        auto toTile = [](float ndc, uint32_t tileCount)
+        {
+            float tile = (ndc * 0.5f + 0.5f) * tileCount;
+            return static_cast<uint32_t>(glm::clamp(tile, 0.f, static_cast<float>(tileCount - 1)));
+        };
+
+        bounds.minX = toTile(ndcMin.x, CLUSTER_COUNT_X);
+        bounds.maxX = toTile(ndcMax.x, CLUSTER_COUNT_X);
+        bounds.minY = toTile(ndcMin.y, CLUSTER_COUNT_Y);
+        bounds.maxY = toTile(ndcMax.y, CLUSTER_COUNT_Y);
+        bounds.minZ = depthSlice(ubo, minDepth);
+        bounds.maxZ = depthSlice(ubo, maxDepth);
+        return true;
+    }
+
+    void LightClusterSystem::buildClusters(FrameInfo &frameInfo, const GlobalUbo &ubo, const std::vector<PointLight> &lights)
+    {
+        GEN_PROFILE_SCOPE("LightClusterSystem::buildClusters");
+        auto *clusters = static_cast<Cluster *>(clusterBuffers[frameInfo.frameIndex]->getMappedMemory());
+        auto *lightIndices = static_cast<uint32_t *>(lightIndexBuffers[frameInfo.frameIndex]->getMappedMemory());
+
+        // pass 1: find the cluster range of every light on the job system, each light writes only its own slot
+        uint32_t lightCount = static_cast<uint32_t>(lights.size());
+        lightBounds.resize(lightCount);
+        frameInfo.jobSystem.parallelFor(
+            lightCount,
+            LIGHT_BOUNDS_BATCH_SIZE,
+            [&](uint32_t begin, uint32_t end)
+            {
+                for (uint32_t i = begin; i < end; i++)
+                {
+                    bool visible = computeLightBounds(ubo, lights[i], lightBounds[i]);
+                    lightBounds[i].lightIndex = visible ? i : CULLED_LIGHT;
+                }
+            });
+
+        // then drop the culled lights, keeping light order so the lists match the single threaded build,
+        // and count the lights per cluster
+        std::fill(clusterCounts.begin(), clusterCounts.end(), 0);
+        uint32_t visibleCount = 0;
+        for (uint32_t i = 0; i < lightCount; i++)
+        {
+            if (lightBounds[i].lightIndex == CULLED_LIGHT)
+            {
+                continue;
+            }
+            const LightBounds bounds = lightBounds[i];
+            lightBounds[visibleCount++] = bounds;
+
+            for (uint32_t z = bounds.minZ; z <= bounds.maxZ; z++)
+            {
+                for (uint32_t y = bounds.minY; y <= bounds.maxY; y++)
+                {
+                    for (uint32_t x = bounds.minX; x <= bounds.maxX; x++)
+                    {
+                        clusterCounts[x + y * CLUSTER_COUNT_X + z * CLUSTER_COUNT_X * CLUSTER_COUNT_Y]++;
+                    }
+                }
+            }
+        }
+
+        lightBounds.resize(visibleCount);
+
+        // pass 2: prefix sum into compact offsets, clamped like the compute path so both stay within capacity
+        uint32_t offset = 0;
+        for (uint32_t i = 0; i < CLUSTER_COUNT; i++)
+        {
+            clusterOffsets[i] = offset;
+            offset += std::min(clusterCounts[i], MAX_LIGHTS_PER_CLUSTER);
+            clusterCounts[i] = 0;
+        }
+
+        // pass 3: scatter the light indices, the counts are rebuilt as write cursors
+        for (const auto &bounds : lightBounds)
+        {
+            for (uint32_t z = bounds.minZ; z <= bounds.maxZ; z++)
+            {
+                for (uint32_t y = bounds.minY; y <= bounds.maxY; y++)
+                {
+                    for (uint32_t x = bounds.minX; x <= bounds.maxX; x++)
+                    {
+                        uint32_t clusterIndex = x + y * CLUSTER_COUNT_X + z * CLUSTER_COUNT_X * CLUSTER_COUNT_Y;
+                        uint32_t &count = clusterCounts[clusterIndex];
+                        if (count < MAX_LIGHTS_PER_CLUSTER)
+                        {
+                            lightIndices[clusterOffsets[clusterIndex] + count] = bounds.lightIndex;
+                            count++;
+                        }
+                    }
+                }
+            }
+        }
+
+        // write the cluster table in one sequential pass, mapped memory may be write combined
+        for (uint32_t i = 0; i < CLUSTER_COUNT; i++)
+        {
+            clusters[i] = {clusterOffsets[i], clusterCounts[i]};
+        }
+
+        stats.indexCount = offset;
+    }
+
+} // namespace gen
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "gen_buffer.hpp"
+#include "gen_camera.hpp"
+#include "gen_device.hpp"
+#include "gen_frame_info.hpp"
+#include "gen_pipeline.hpp"
+#include "gen_swap_chain.hpp"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace gen
+{
+    // Bins point lights into a view space froxel grid (screen tiles x exponential depth slices) so the
+    // fragment shader only has to iterate over the lights that can actually reach its cluster.
+    // Light data lives in storage buffers (bindings 1-3 of the global set) instead of the GlobalUbo.
+    class LightClusterSystem
+    {
+    public:
+        static constexpr uint32_t CLUSTER_COUNT_X = 16;
+        static constexpr uint32_t CLUSTER_COUNT_Y = 9;
+        static constexpr uint32_t CLUSTER_COUNT_Z = 24;
+        static constexpr uint32_t CLUSTER_COUNT = CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z;
+        // the compute path writes into fixed slots, so this also bounds the light index list size
+        static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 128;
+        static constexpr uint32_t LIGHT_INDEX_CAPACITY = CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER;
+
+        enum class Mode
+        {
+            CPU,
+            Compute
+        };
+
+        struct Cluster
+        {
+            uint32_t offset; // first entry in the light index list
+            uint32_t count;
+        };
+
+        struct Stats
+        {
+            uint32_t lightCount = 0;
+            uint32_t indexCount = 0;   // total light index list entries, only known for the cpu path
+            float buildMicros = 0.f;   // cpu time spent uploading and binning lights this frame
+            float microsPerLight = 0.f;
+        };
+
+        LightClusterSystem(GenDevice &device, VkDescriptorSetLayout globalSetLayout);
+        ~LightClusterSystem();
+
+        LightClusterSystem(const LightClusterSystem &) = delete;
+        LightClusterSystem &operator=(const LightClusterSystem &) = delete;
+
+        // uploads the lights and fills in the cluster parameters of the ubo, on the cpu path this also builds the light lists.
+        // Returns true if the frame's light buffer was replaced by a larger one, binding 1 of the frame's global set
+        // has to be written again before it's bound
+        bool update(FrameInfo &frameInfo, GlobalUbo &ubo, const std::vector<PointLight> &lights);
+        // records the cluster build on the compute path, must be called outside of a render pass. Fragment shaders
+        // reading the light lists need a barrier after it, the render graph pass declaring the writes provides it
+        void dispatch(FrameInfo &frameInfo);
+
+        VkDescriptorBufferInfo lightBufferInfo(int frameIndex) { return lightBuffers[frameIndex]->descriptorInfo(); }
+        VkDescriptorBufferInfo clusterBufferInfo(int frameIndex) { return clusterBuffers[frameIndex]->descriptorInfo(); }
+        VkDescriptorBufferInfo lightIndexBufferInfo(int frameIndex) { return lightIndexBuffers[frameIndex]->descriptorInfo(); }
+
+        void setMode(Mode newMode) { mode = newMode; }
+        Mode getMode() const { return mode; }
+        const Stats &getStats() const { return stats; }
+
+    private:
+        struct LightBounds
+        {
+            uint32_t lightIndex;
+            uint32_t minX, maxX;
+            uint32_t minY, maxY;
+            uint32_t minZ, maxZ;
+        };
+
+        void createBuffers();
+        std::unique_ptr<GenBuffer> createLightBuffer(uint32_t capacity);
+        void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
+        void createPipeline();
+
+        void buildClusters(FrameInfo &frameInfo, const GlobalUbo &ubo, const std::vector<PointLight> &lights);
+        bool computeLightBounds(const GlobalUbo &ubo, const PointLight &light, LightBounds &bounds) const;
+        uint32_t depthSlice(const GlobalUbo &ubo, float viewDepth) const;
+
+        GenDevice &genDevice;
+
+        std::vector<std::unique_ptr<GenBuffer>> lightBuffers;
+        std::vector<std::unique_ptr<GenBuffer>> clusterBuffers;
+        std::vector<std::unique_ptr<GenBuffer>> lightIndexBuffers;
+
+        std::unique_ptr<GenPipeline> computePipeline;
+        VkPipelineLayout pipelineLayout;
+
+        // scratch storage reused every frame so binning doesn't allocate
+        std::vector<LightBounds> lightBounds;
+        std::vector<uint32_t> clusterCounts;
+        std::vector<uint32_t> clusterOffsets;
+
+        Mode mode = Mode::CPU;
+        Stats stats{};
+    };
+}
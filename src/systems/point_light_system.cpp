@@ -1,4 +1,5 @@
 #include "point_light_system.hpp"
+#include "gen_cpu_profiler.hpp"
 
 // libs
 #define GLM_FORCE_RADIANS
@@ -7,27 +8,22 @@
 #include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstddef>
 #include <stdexcept>
-#include <map>
 
 namespace gen
 {
 
-    struct PointLightPushConstants
-    {
-        glm::vec4 position{};
-        glm::vec4 color{};
-        float radius;
-    };
-
     PointLightSystem::PointLightSystem(
-        GenDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout)
+        GenDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, RenderPath renderPath)
         : genDevice{device}
     {
+        createInstanceBuffers();
         createPipelineLayout(globalSetLayout);
-        createPipeline(renderPass);
+        createPipeline(renderPass, renderPath);
     }
 
     PointLightSystem::~PointLightSystem()
@@ -35,21 +31,37 @@ namespace gen
         vkDestroyPipelineLayout(genDevice.device(), pipelineLayout, nullptr);
     }
 
-    void PointLightSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
+    void PointLightSystem::createInstanceBuffers()
     {
-        VkPushConstantRange pushConstantRange{};
-        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-        pushConstantRange.offset = 0;
-        pushConstantRange.size = sizeof(PointLightPushConstants);
+        instanceBuffers.resize(GenSwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (int i = 0; i < GenSwapChain::MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            instanceBuffers[i] = createInstanceBuffer(INITIAL_LIGHT_CAPACITY);
+        }
+    }
 
+    std::unique_ptr<GenBuffer> PointLightSystem::createInstanceBuffer(uint32_t capacity)
+    {
+        auto buffer = std::make_unique<GenBuffer>(
+            genDevice,
+            sizeof(BillboardInstance),
+            capacity,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        buffer->map();
+        return buffer;
+    }
+
+    void PointLightSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
+    {
         std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
 
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
         pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-        pipelineLayoutInfo.pushConstantRangeCount = 1;
-        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        pipelineLayoutInfo.pushConstantRangeCount = 0;
+        pipelineLayoutInfo.pPushConstantRanges = nullptr;
         if (vkCreatePipelineLayout(genDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
             VK_SUCCESS)
         {
@@ -57,66 +69,152 @@ namespace gen
         }
     }
 
-    void PointLightSystem::createPipeline(VkRenderPass renderPass)
+    void PointLightSystem::createPipeline(VkRenderPass renderPass, RenderPath renderPath)
     {
         assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
+        auto configure = [&](PipelineConfigInfo &configInfo)
+        {
+            // quad corners come from gl_VertexIndex, everything else is per instance
+            configInfo.bindingDescriptions = {{0, sizeof(BillboardInstance), VK_VERTEX_INPUT_RATE_INSTANCE}};
+            configInfo.attributeDescriptions = {
+                {0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(BillboardInstance, position)},
+                {1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(BillboardInstance, color)}};
+            configInfo.renderPass = renderPass;
+            configInfo.pipelineLayout = pipelineLayout;
+        };
+
+        // sorted billboards are composited on top of the lit image
         PipelineConfigInfo pipelineConfig{};
         GenPipeline::defaultPipelineConfigInfo(pipelineConfig);
         GenPipeline::enableAlphaBlending(pipelineConfig);
-        pipelineConfig.attributeDescriptions.clear();
-        pipelineConfig.bindingDescriptions.clear();
-        pipelineConfig.renderPass = renderPass;
-        pipelineConfig.pipelineLayout = pipelineLayout;
+        configure(pipelineConfig);
+        pipelineConfig.subpass = GenSwapChain::COMPOSITE_SUBPASS;
         genPipeline = std::make_unique<GenPipeline>(
             genDevice,
             "shaders/point_light.vert.spv",
             "shaders/point_light.frag.spv",
             pipelineConfig);
+
+        // only the forward render pass has the transparency accumulation targets
+        if (renderPath == RenderPath::Deferred)
+        {
+            return;
+        }
+
+        PipelineConfigInfo oitConfig{};
+        GenPipeline::defaultPipelineConfigInfo(oitConfig);
+        GenPipeline::enableWeightedBlendedAccumulation(oitConfig);
+        configure(oitConfig);
+        oitConfig.subpass = GenSwapChain::TRANSPARENT_SUBPASS;
+        oitPipeline = std::make_unique<GenPipeline>(
+            genDevice,
+            "shaders/point_light.vert.spv",
+            "shaders/point_light_oit.frag.spv",
+            oitConfig);
+    }
+
+    uint32_t PointLightSystem::writeInstances(FrameInfo &frameInfo, bool sortBackToFront)
+    {
+        // doubled until the billboards fit, the old buffer is destroyed once the frames in flight reading it completed
+        auto &instanceBuffer = instanceBuffers[frameInfo.frameIndex];
+        uint32_t billboardCount = countBillboards(frameInfo.gameObjects);
+        if (billboardCount > instanceBuffer->getInstanceCount())
+        {
+            uint32_t capacity = instanceBuffer->getInstanceCount();
+            while (capacity < billboardCount)
+            {
+                capacity *= 2;
+            }
+            instanceBuffer = createInstanceBuffer(capacity);
+        }
+
+        auto *instances = static_cast<BillboardInstance *>(instanceBuffer->getMappedMemory());
+        return packBillboards(frameInfo.gameObjects, frameInfo.camera.getPosition(), sortBackToFront, packScratch, instances);
     }
 
-    void PointLightSystem::update(FrameInfo &frameInfo, GlobalUbo &ubo)
+    uint32_t PointLightSystem::countBillboards(const GenGameObject::Map &gameObjects)
     {
-        auto rotateLight = glm::rotate(glm::mat4(1.f), 0.5f * frameInfo.frameTime, {0.f, -1.f, 0.f});
-        int lightIndex = 0;
-        for (auto &kv : frameInfo.gameObjects)
+        uint32_t count = 0;
+        for (auto &kv : gameObjects)
+        {
+            count += kv.second.pointLight != nullptr ? 1 : 0;
+        }
+        return count;
+    }
+
+    uint32_t PointLightSystem::packBillboards(
+        const GenGameObject::Map &gameObjects,
+        glm::vec3 cameraPosition,
+        bool sortBackToFront,
+        PackScratch &scratch,
+        BillboardInstance *instances)
+    {
+        // gather billboards, with their squared camera distance as sort key if they need ordering
+        uint32_t instanceCount = 0;
+        for (auto &kv : gameObjects)
         {
             auto &obj = kv.second;
             if (obj.pointLight == nullptr)
                 continue;
 
-            assert(lightIndex < MAX_LIGHTS && "Point lights exceed maximum specified");
+            if (sortBackToFront && instanceCount == scratch.sortEntries.size())
+            {
+                size_t capacity = std::max<size_t>(2 * scratch.sortEntries.size(), 64);
+                scratch.sortEntries.resize(capacity);
+                scratch.sortScratch.resize(capacity);
+                scratch.unsortedInstances.resize(capacity);
+            }
 
-            // update light position
-            obj.transform.translation = glm::vec3(rotateLight * glm::vec4(obj.transform.translation, 1.f));
+            auto &instance = sortBackToFront ? scratch.unsortedInstances[instanceCount] : instances[instanceCount];
+            instance.position = glm::vec4(obj.transform.translation, obj.transform.scale.x);
+            instance.color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
 
-            // copy light to ubo
-            ubo.pointLights[lightIndex].position = glm::vec4(obj.transform.translation, 1.f);
-            ubo.pointLights[lightIndex].color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
+            if (sortBackToFront)
+            {
+                auto offset = cameraPosition - obj.transform.translation;
+                float disSquared = glm::dot(offset, offset);
+                // inverted so ascending order is back to front, equal distances stay in gather order
+                scratch.sortEntries[instanceCount] = {~radixKeyFromFloat(disSquared), instanceCount};
+            }
+            instanceCount++;
+        }
+
+        if (!sortBackToFront || instanceCount == 0)
+        {
+            return instanceCount;
+        }
 
-            lightIndex += 1;
+        radixSort(scratch.sortEntries.data(), scratch.sortScratch.data(), instanceCount);
+        for (uint32_t i = 0; i < instanceCount; i++)
+        {
+            instances[i] = scratch.unsortedInstances[scratch.sortEntries[i].value];
         }
-        ubo.numLights = lightIndex;
+        return instanceCount;
     }
 
     void PointLightSystem::render(FrameInfo &frameInfo)
     {
-        //sort lights
-        std::map<float, GenGameObject::id_t> sorted;
-        for(auto &kv : frameInfo.gameObjects)
-        {
-            auto &obj = kv.second;
-            if(obj.pointLight == nullptr){
-                continue;
-            }
+        GEN_PROFILE_SCOPE("PointLightSystem::render");
+        draw(frameInfo, *genPipeline, writeInstances(frameInfo, true));
+    }
+
+    void PointLightSystem::renderAccumulation(FrameInfo &frameInfo)
+    {
+        GEN_PROFILE_SCOPE("PointLightSystem::renderAccumulation");
+        assert(oitPipeline != nullptr && "Transparency accumulation is only available on the forward render path");
+        // weighted blending is order independent, so the sort is skipped entirely
+        draw(frameInfo, *oitPipeline, writeInstances(frameInfo, false));
+    }
 
-            //calculate distance
-            auto offset = frameInfo.camera.getPosition() - obj.transform.translation;
-            float disSquared = glm::dot(offset, offset);
-            sorted[disSquared] = obj.getId();
+    void PointLightSystem::draw(FrameInfo &frameInfo, GenPipeline &pipeline, uint32_t instanceCount)
+    {
+        if (instanceCount == 0)
+        {
+            return;
         }
 
-        genPipeline->bind(frameInfo.commandBuffer);
+        pipeline.bind(frameInfo.commandBuffer);
 
         vkCmdBindDescriptorSets(
             frameInfo.commandBuffer,
@@ -125,29 +223,14 @@ namespace gen
             0,
             1,
             &frameInfo.globalDescriptorSet,
-            0,
-            nullptr);
+            1,
+            &frameInfo.globalUboOffset);
 
-        //iterate through sorted lights in reverse order
-        for (auto it = sorted.rbegin(); it != sorted.rend(); ++it)
-        {
-            //use game obj id to find light object
-            auto &obj = frameInfo.gameObjects.at(it->second);
-
-            PointLightPushConstants push{};
-            push.position = glm::vec4(obj.transform.translation, 1.f);
-            push.color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
-            push.radius = obj.transform.scale.x;
-
-            vkCmdPushConstants(
-                frameInfo.commandBuffer,
-                pipelineLayout,
-                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-                0,
-                sizeof(PointLightPushConstants),
-                &push);
-            vkCmdDraw(frameInfo.commandBuffer, 6, 1, 0, 0);
-        }
+        VkBuffer buffers[] = {instanceBuffers[frameInfo.frameIndex]->getBuffer()};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(frameInfo.commandBuffer, 0, 1, buffers, offsets);
+        vkCmdDraw(frameInfo.commandBuffer, 6, instanceCount, 0, 0);
+        frameInfo.drawCalls++;
     }
 
-} // namespace gen
\ No newline at end of file
+} // namespace gen
@@ -1,10 +1,13 @@
 #pragma once
 
+#include "gen_buffer.hpp"
 #include "gen_camera.hpp"
 #include "gen_device.hpp"
 #include "gen_game_object.hpp"
 #include "gen_pipeline.hpp"
 #include "gen_frame_info.hpp"
+#include "gen_radix_sort.hpp"
+#include "gen_swap_chain.hpp"
 
 // std
 #include <memory>
@@ -12,26 +15,64 @@
 
 namespace gen
 {
+    // Packs the point lights into camera facing billboards in a per-frame instance buffer, sorted back to front
+    // when blended, and draws them all with a single instanced draw.
     class PointLightSystem
     {
 
     public:
-        PointLightSystem(GenDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+        struct BillboardInstance
+        {
+            glm::vec4 position{}; // w is radius
+            glm::vec4 color{};    // w is intensity
+        };
+
+        // storage reused every frame so sorting doesn't allocate once it has grown to the light count
+        struct PackScratch
+        {
+            std::vector<RadixSortEntry> sortEntries{};
+            std::vector<RadixSortEntry> sortScratch{};
+            std::vector<BillboardInstance> unsortedInstances{};
+        };
+
+        // renderPath selects which render pass layout the pipeline is built for
+        PointLightSystem(GenDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, RenderPath renderPath = RenderPath::Forward);
         ~PointLightSystem();
 
         PointLightSystem(const PointLightSystem &) = delete;
         PointLightSystem &operator=(const PointLightSystem &) = delete;
 
-        void update(FrameInfo &frameInfo, GlobalUbo &ubo);
+        // sorted back to front and alpha blended, in the composite subpass
         void render(FrameInfo &frameInfo);
+        // unsorted into the weighted blended transparency targets, in the transparent subpass of the forward path
+        void renderAccumulation(FrameInfo &frameInfo);
+
+        // the point lights in gameObjects, the number of instances packBillboards writes
+        static uint32_t countBillboards(const GenGameObject::Map &gameObjects);
+        // writes the billboard of every point light into instances, which has room for countBillboards of them,
+        // sorted back to front from cameraPosition if requested. Returns the billboard count, touches no device state
+        static uint32_t packBillboards(
+            const GenGameObject::Map &gameObjects,
+            glm::vec3 cameraPosition,
+            bool sortBackToFront,
+            PackScratch &scratch,
+            BillboardInstance *instances);
 
     private:
+        void createInstanceBuffers();
+        std::unique_ptr<GenBuffer> createInstanceBuffer(uint32_t capacity);
         void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-        void createPipeline(VkRenderPass renderPass);
+        void createPipeline(VkRenderPass renderPass, RenderPath renderPath);
+        uint32_t writeInstances(FrameInfo &frameInfo, bool sortBackToFront);
+        void draw(FrameInfo &frameInfo, GenPipeline &pipeline, uint32_t instanceCount);
 
         GenDevice &genDevice;
 
+        std::vector<std::unique_ptr<GenBuffer>> instanceBuffers;
+        PackScratch packScratch;
+
         std::unique_ptr<GenPipeline> genPipeline;
+        std::unique_ptr<GenPipeline> oitPipeline;
         VkPipelineLayout pipelineLayout;
     };
 }
\ No newline at end of file
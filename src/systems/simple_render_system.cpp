@@ -1,4 +1,5 @@
 #include "simple_render_system.hpp"
+#include "gen_cpu_profiler.hpp"
 
 // libs
 #define GLM_FORCE_RADIANS
@@ -7,13 +8,17 @@
 #include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cmath>
 #include <stdexcept>
 
 namespace gen
 {
 
+    // with bindless textures the last column of the normal matrix, which the shaders only use as a mat3, holds
+    // the texture index
     struct SimplePushConstantData
     {
         glm::mat4 modelMatrix{1.f};
@@ -21,18 +26,37 @@ namespace gen
     };
 
     SimpleRenderSystem::SimpleRenderSystem(
-        GenDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout)
-        : genDevice{device}
+        GenDevice &device,
+        VkRenderPass renderPass,
+        VkDescriptorSetLayout globalSetLayout,
+        GenSamplerCache &samplerCache,
+        GenFrameDescriptorAllocator &frameDescriptorAllocator,
+        GenBindlessDescriptors *bindlessDescriptors,
+        RenderPath renderPath)
+        : genDevice{device}, frameDescriptorAllocator{frameDescriptorAllocator}, bindlessDescriptors{bindlessDescriptors}
     {
+        createTextureSets(samplerCache);
         createPipelineLayout(globalSetLayout);
-        createPipeline(renderPass);
+        createPipeline(renderPass, renderPath);
     }
 
     SimpleRenderSystem::~SimpleRenderSystem()
     {
+        for (const auto &kv : bindlessTextures)
+        {
+            bindlessDescriptors->removeSampledImage(kv.second.index);
+        }
         vkDestroyPipelineLayout(genDevice.device(), pipelineLayout, nullptr);
     }
 
+    void SimpleRenderSystem::createTextureSets(GenSamplerCache &samplerCache)
+    {
+        textureSetLayout = GenDescriptorSetLayout::Builder(genDevice)
+                               .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+                               .build();
+        defaultTexture = GenTexture::createSolidColor(genDevice, samplerCache);
+    }
+
     void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
     {
         VkPushConstantRange pushConstantRange{};
@@ -40,7 +64,9 @@ namespace gen
         pushConstantRange.offset = 0;
         pushConstantRange.size = sizeof(SimplePushConstantData);
 
-        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{
+            globalSetLayout,
+            bindlessDescriptors != nullptr ? bindlessDescriptors->getSetLayout() : textureSetLayout->getDescriptorSetLayout()};
 
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -55,53 +81,281 @@ namespace gen
         }
     }
 
-    void SimpleRenderSystem::createPipeline(VkRenderPass renderPass)
+    void SimpleRenderSystem::createPipeline(VkRenderPass renderPass, RenderPath renderPath)
     {
         assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
+        // writes albedo and normal to the g-buffer on the deferred path, lighting happens in DeferredLightingSystem
+        bool deferred = renderPath == RenderPath::Deferred;
+        uint32_t subpass = deferred ? GenSwapChain::GBUFFER_SUBPASS : GenSwapChain::OPAQUE_SUBPASS;
+        const char *fragFilepath = deferred ? "shaders/gbuffer.frag.spv" : "shaders/simple_shader.frag.spv";
+        if (bindlessDescriptors != nullptr)
+        {
+            fragFilepath = deferred ? "shaders/gbuffer_bindless.frag.spv" : "shaders/simple_shader_bindless.frag.spv";
+        }
+
+        auto configure = [&](PipelineConfigInfo &configInfo)
+        {
+            if (deferred)
+            {
+                GenPipeline::setColorAttachmentCount(configInfo, 2);
+            }
+            configInfo.renderPass = renderPass;
+            configInfo.subpass = subpass;
+            configInfo.pipelineLayout = pipelineLayout;
+        };
+
         PipelineConfigInfo pipelineConfig{};
         GenPipeline::defaultPipelineConfigInfo(pipelineConfig);
-        pipelineConfig.renderPass = renderPass;
-        pipelineConfig.pipelineLayout = pipelineLayout;
+        configure(pipelineConfig);
         genPipeline = std::make_unique<GenPipeline>(
             genDevice,
             "shaders/simple_shader.vert.spv",
-            "shaders/simple_shader.frag.spv",
+            fragFilepath,
             pipelineConfig);
+
+        PipelineConfigInfo prePassConfig{};
+        GenPipeline::defaultPipelineConfigInfo(prePassConfig);
+        GenPipeline::enableDepthOnly(prePassConfig);
+        configure(prePassConfig);
+        depthPrePassPipeline = std::make_unique<GenPipeline>(
+            genDevice,
+            "shaders/depth_prepass.vert.spv",
+            "",
+            prePassConfig);
+
+        PipelineConfigInfo equalConfig{};
+        GenPipeline::defaultPipelineConfigInfo(equalConfig, VK_COMPARE_OP_EQUAL, VK_FALSE);
+        configure(equalConfig);
+        depthEqualPipeline = std::make_unique<GenPipeline>(
+            genDevice,
+            "shaders/simple_shader.vert.spv",
+            fragFilepath,
+            equalConfig);
     }
 
     void SimpleRenderSystem::renderGameObjects(FrameInfo &frameInfo)
     {
-        genPipeline->bind(frameInfo.commandBuffer);
+        GEN_PROFILE_SCOPE("SimpleRenderSystem::renderGameObjects");
+        buildDrawList(frameInfo);
+        uint32_t count = static_cast<uint32_t>(drawList.size());
+        frameInfo.drawCalls += depthPrePass ? 2 * count : count;
+
+        // all pipelines share the layout, so the sets stay bound across the pipeline switch
+        bindDescriptorSets(frameInfo.commandBuffer, frameInfo);
+
+        if (!depthPrePass)
+        {
+            genPipeline->bind(frameInfo.commandBuffer);
+            drawGameObjects(frameInfo.commandBuffer, 0, count, true);
+            return;
+        }
+
+        depthPrePassPipeline->bind(frameInfo.commandBuffer);
+        drawGameObjects(frameInfo.commandBuffer, 0, count, false);
+
+        depthEqualPipeline->bind(frameInfo.commandBuffer);
+        drawGameObjects(frameInfo.commandBuffer, 0, count, true);
+    }
+
+    void SimpleRenderSystem::renderGameObjectsParallel(
+        FrameInfo &frameInfo,
+        GenParallelRecorder &recorder,
+        const VkCommandBufferInheritanceInfo &inheritanceInfo,
+        VkExtent2D extent)
+    {
+        GEN_PROFILE_SCOPE("SimpleRenderSystem::renderGameObjectsParallel");
+        buildDrawList(frameInfo);
+        uint32_t count = static_cast<uint32_t>(drawList.size());
+        frameInfo.drawCalls += depthPrePass ? 2 * count : count;
+
+        // every secondary command buffer starts without state, so each one binds pipeline and set itself
+        auto recordPass = [&](GenPipeline &pipeline, bool bindTextures)
+        {
+            recorder.record(
+                frameInfo.commandBuffer,
+                inheritanceInfo,
+                extent,
+                count,
+                [&](VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end)
+                {
+                    pipeline.bind(commandBuffer);
+                    bindDescriptorSets(commandBuffer, frameInfo);
+                    drawGameObjects(commandBuffer, begin, end, bindTextures);
+                });
+        };
+
+        if (!depthPrePass)
+        {
+            recordPass(*genPipeline, true);
+            return;
+        }
+
+        // executed in order, so all depth is laid down before any range is shaded
+        recordPass(*depthPrePassPipeline, false);
+        recordPass(*depthEqualPipeline, true);
+    }
+
+    void SimpleRenderSystem::buildDrawList(FrameInfo &frameInfo)
+    {
+        drawList.clear();
+        drawTextureSets.clear();
+        drawTextureIndices.clear();
+        // last frame's sets were reset with its frame slot, nothing may reuse them
+        textureSets.clear();
+        frameNumber++;
+
+        glm::vec3 cameraPosition = frameInfo.camera.getPosition();
+        // projection scale of the vertical axis times half the viewport, turns radius over distance into pixels
+        float pixelsPerUnit = frameInfo.camera.getProjection()[1][1] * .5f * frameInfo.extent.height;
+        for (auto &kv : frameInfo.gameObjects)
+        {
+            auto &obj = kv.second;
+            // transparent objects are drawn by the TransparentRenderSystem, evicted models are outside the view
+            if (obj.model == nullptr || obj.transparency != nullptr || !obj.model->isResident())
+                continue;
+            drawList.push_back(&obj);
+
+            if (obj.streamedTexture != nullptr)
+            {
+                // projected diameter of the bounding sphere, as if the texture covered the object once
+                const auto &scale = obj.transform.scale;
+                float radius = obj.model->getBoundingRadius() *
+                               std::max({std::abs(scale.x), std::abs(scale.y), std::abs(scale.z)});
+                float distance = glm::length(obj.transform.translation - cameraPosition);
+                float pixels = distance > radius ? 2.f * radius / distance * pixelsPerUnit : frameInfo.extent.height;
+                obj.streamedTexture->requestPixels(pixels);
+            }
+
+            const GenTexture *texture = defaultTexture.get();
+            if (obj.streamedTexture != nullptr)
+            {
+                texture = &obj.streamedTexture->getResident();
+            }
+            else if (obj.texture != nullptr)
+            {
+                texture = obj.texture.get();
+            }
+
+            if (bindlessDescriptors != nullptr)
+            {
+                drawTextureIndices.push_back(getTextureIndex(*texture));
+            }
+            else
+            {
+                drawTextureSets.push_back(getTextureSet(*texture));
+            }
+        }
+
+        if (bindlessDescriptors != nullptr)
+        {
+            releaseUndrawnTextures();
+        }
+    }
+
+    VkDescriptorSet SimpleRenderSystem::getTextureSet(const GenTexture &texture)
+    {
+        auto it = textureSets.find(texture.getId());
+        if (it != textureSets.end())
+        {
+            return it->second;
+        }
 
+        VkDescriptorSet set;
+        auto imageInfo = texture.descriptorInfo();
+        GenDescriptorWriter(*textureSetLayout, frameDescriptorAllocator)
+            .writeImage(0, &imageInfo)
+            .build(set);
+        textureSets.emplace(texture.getId(), set);
+        return set;
+    }
+
+    uint32_t SimpleRenderSystem::getTextureIndex(const GenTexture &texture)
+    {
+        auto it = bindlessTextures.find(texture.getId());
+        if (it == bindlessTextures.end())
+        {
+            auto imageInfo = texture.descriptorInfo();
+            it = bindlessTextures.emplace(texture.getId(), BindlessTexture{bindlessDescriptors->addSampledImage(imageInfo), 0}).first;
+        }
+        it->second.lastDrawnFrame = frameNumber;
+        return it->second.index;
+    }
+
+    void SimpleRenderSystem::releaseUndrawnTextures()
+    {
+        // a replaced streamed texture or a removed object's texture. The table keeps the index reserved until
+        // the frames that may still sample it have completed
+        for (auto it = bindlessTextures.begin(); it != bindlessTextures.end();)
+        {
+            if (it->second.lastDrawnFrame != frameNumber)
+            {
+                bindlessDescriptors->removeSampledImage(it->second.index);
+                it = bindlessTextures.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    void SimpleRenderSystem::bindDescriptorSets(VkCommandBuffer commandBuffer, FrameInfo &frameInfo)
+    {
+        std::array<VkDescriptorSet, 2> descriptorSets{frameInfo.globalDescriptorSet, VK_NULL_HANDLE};
+        uint32_t setCount = 1;
+        if (bindlessDescriptors != nullptr)
+        {
+            descriptorSets[setCount++] = bindlessDescriptors->getSet();
+        }
         vkCmdBindDescriptorSets(
-            frameInfo.commandBuffer,
+            commandBuffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
             pipelineLayout,
             0,
+            setCount,
+            descriptorSets.data(),
             1,
-            &frameInfo.globalDescriptorSet,
-            0,
-            nullptr);
+            &frameInfo.globalUboOffset);
+    }
 
-        for (auto &kv : frameInfo.gameObjects)
+    void SimpleRenderSystem::drawGameObjects(VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end, bool bindTextures)
+    {
+        VkDescriptorSet boundTextureSet = VK_NULL_HANDLE;
+        for (uint32_t i = begin; i < end; i++)
         {
-            auto &obj = kv.second;
-            if (obj.model == nullptr)
-                continue;
+            auto &obj = *drawList[i];
+            if (bindTextures && bindlessDescriptors == nullptr && drawTextureSets[i] != boundTextureSet)
+            {
+                boundTextureSet = drawTextureSets[i];
+                vkCmdBindDescriptorSets(
+                    commandBuffer,
+                    VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    pipelineLayout,
+                    1,
+                    1,
+                    &boundTextureSet,
+                    0,
+                    nullptr);
+            }
+
             SimplePushConstantData push{};
             push.modelMatrix = obj.transform.mat4();
             push.normalMatrix = obj.transform.normalMatrix();
+            if (bindTextures && bindlessDescriptors != nullptr)
+            {
+                push.normalMatrix[3][0] = static_cast<float>(drawTextureIndices[i]);
+            }
 
             vkCmdPushConstants(
-                frameInfo.commandBuffer,
+                commandBuffer,
                 pipelineLayout,
                 VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
                 0,
                 sizeof(SimplePushConstantData),
                 &push);
-            obj.model->bind(frameInfo.commandBuffer);
-            obj.model->draw(frameInfo.commandBuffer);
+            obj.model->bind(commandBuffer);
+            obj.model->draw(commandBuffer);
         }
     }
 
@@ -1,13 +1,20 @@
 #pragma once
 
+#include "gen_bindless.hpp"
 #include "gen_camera.hpp"
+#include "gen_descriptors.hpp"
 #include "gen_device.hpp"
 #include "gen_game_object.hpp"
+#include "gen_parallel_recorder.hpp"
 #include "gen_pipeline.hpp"
 #include "gen_frame_info.hpp"
+#include "gen_swap_chain.hpp"
+#include "gen_texture.hpp"
 
 // std
+#include <array>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace gen
@@ -16,21 +23,80 @@ namespace gen
     {
 
     public:
-        SimpleRenderSystem(GenDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+        // renderPath selects which render pass layout the pipeline is built for, samplerCache provides the sampler
+        // of the default texture. Textures are sampled through bindlessDescriptors, or through a set per texture
+        // allocated from frameDescriptorAllocator if it's nullptr
+        SimpleRenderSystem(
+            GenDevice &device,
+            VkRenderPass renderPass,
+            VkDescriptorSetLayout globalSetLayout,
+            GenSamplerCache &samplerCache,
+            GenFrameDescriptorAllocator &frameDescriptorAllocator,
+            GenBindlessDescriptors *bindlessDescriptors,
+            RenderPath renderPath = RenderPath::Forward);
         ~SimpleRenderSystem();
 
         SimpleRenderSystem(const SimpleRenderSystem &) = delete;
         SimpleRenderSystem &operator=(const SimpleRenderSystem &) = delete;
 
         void renderGameObjects(FrameInfo &frameInfo);
+        // same draws as renderGameObjects, split across the recorder's threads into secondary command buffers,
+        // the current subpass must have been begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+        void renderGameObjectsParallel(
+            FrameInfo &frameInfo,
+            GenParallelRecorder &recorder,
+            const VkCommandBufferInheritanceInfo &inheritanceInfo,
+            VkExtent2D extent);
+
+        // lays down depth with a position only pass first, so the lit pass only shades visible fragments
+        void setDepthPrePass(bool enabled) { depthPrePass = enabled; }
+        bool isDepthPrePassEnabled() const { return depthPrePass; }
 
     private:
+        void createTextureSets(GenSamplerCache &samplerCache);
         void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-        void createPipeline(VkRenderPass renderPass);
+        void createPipeline(VkRenderPass renderPass, RenderPath renderPath);
+        void buildDrawList(FrameInfo &frameInfo);
+        VkDescriptorSet getTextureSet(const GenTexture &texture);
+        uint32_t getTextureIndex(const GenTexture &texture);
+        // frees the bindless entries of textures not drawn this frame
+        void releaseUndrawnTextures();
+        // the global set and, without per texture sets, the bindless set
+        void bindDescriptorSets(VkCommandBuffer commandBuffer, FrameInfo &frameInfo);
+        // the depth pre-pass doesn't sample, so it skips selecting the textures
+        void drawGameObjects(VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end, bool bindTextures);
 
         GenDevice &genDevice;
 
         std::unique_ptr<GenPipeline> genPipeline;
+        // depth only pipeline and the lit pipeline that tests EQUAL against its result without writing depth
+        std::unique_ptr<GenPipeline> depthPrePassPipeline;
+        std::unique_ptr<GenPipeline> depthEqualPipeline;
         VkPipelineLayout pipelineLayout;
+
+        // set 1, the albedo texture. One transient set per texture drawn in a frame, since a streamed texture's
+        // resident image may change from one frame to the next
+        std::unique_ptr<GenDescriptorSetLayout> textureSetLayout;
+        GenFrameDescriptorAllocator &frameDescriptorAllocator;
+        std::unordered_map<uint64_t, VkDescriptorSet> textureSets;
+        std::unique_ptr<GenTexture> defaultTexture;
+
+        // set 1 instead of the texture sets if set, bound once per command buffer. Each texture drawn is
+        // registered while it's in use and the push constants select it
+        struct BindlessTexture
+        {
+            uint32_t index;
+            uint64_t lastDrawnFrame;
+        };
+        GenBindlessDescriptors *bindlessDescriptors;
+        std::unordered_map<uint64_t, BindlessTexture> bindlessTextures;
+        uint64_t frameNumber = 0;
+
+        bool depthPrePass = false;
+        // opaque objects of the current frame and their texture sets or bindless indices, indexable so recording
+        // can be split into ranges without touching the maps from several threads
+        std::vector<GenGameObject *> drawList;
+        std::vector<VkDescriptorSet> drawTextureSets;
+        std::vector<uint32_t> drawTextureIndices;
     };
 }
\ No newline at end of file
@@ -0,0 +1,287 @@
+#include "transparent_render_system.hpp"
+#include "gen_cpu_profiler.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+// std
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+namespace gen
+{
+
+    // the shaders only use the normal matrix as a mat3, its last element carries the alpha. A separate float
+    // would take the block past the 128 bytes of push constants every device has
+    struct TransparentPushConstantData
+    {
+        glm::mat4 modelMatrix{1.f};
+        glm::mat4 normalMatrix{1.f};
+    };
+
+    // one per frame in flight, like the transparency targets
+    static constexpr uint32_t MAX_RESOLVE_SETS = GenSwapChain::MAX_FRAMES_IN_FLIGHT;
+
+    TransparentRenderSystem::TransparentRenderSystem(
+        GenDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, RenderPath renderPath)
+        : genDevice{device}
+    {
+        createDescriptorResources();
+        createPipelineLayouts(globalSetLayout);
+        createPipelines(renderPass, renderPath);
+    }
+
+    TransparentRenderSystem::~TransparentRenderSystem()
+    {
+        vkDestroyPipelineLayout(genDevice.device(), pipelineLayout, nullptr);
+        vkDestroyPipelineLayout(genDevice.device(), resolvePipelineLayout, nullptr);
+    }
+
+    void TransparentRenderSystem::createDescriptorResources()
+    {
+        resolveSetLayout =
+            GenDescriptorSetLayout::Builder(genDevice)
+                .addBinding(0, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT) // accumulation
+                .addBinding(1, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_SHADER_STAGE_FRAGMENT_BIT) // revealage
+                .build();
+
+        resolvePool =
+            GenDescriptorPool::Builder(genDevice)
+                .setMaxSets(MAX_RESOLVE_SETS)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 2 * MAX_RESOLVE_SETS)
+                .build();
+    }
+
+    void TransparentRenderSystem::createPipelineLayouts(VkDescriptorSetLayout globalSetLayout)
+    {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(TransparentPushConstantData);
+
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+        pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(genDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
+            VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+
+        // the resolve only reads the transparency targets
+        VkDescriptorSetLayout resolveLayout = resolveSetLayout->getDescriptorSetLayout();
+        VkPipelineLayoutCreateInfo resolveLayoutInfo{};
+        resolveLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        resolveLayoutInfo.setLayoutCount = 1;
+        resolveLayoutInfo.pSetLayouts = &resolveLayout;
+        resolveLayoutInfo.pushConstantRangeCount = 0;
+        resolveLayoutInfo.pPushConstantRanges = nullptr;
+        if (vkCreatePipelineLayout(genDevice.device(), &resolveLayoutInfo, nullptr, &resolvePipelineLayout) !=
+            VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+    }
+
+    void TransparentRenderSystem::createPipelines(VkRenderPass renderPass, RenderPath renderPath)
+    {
+        assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+
+        PipelineConfigInfo sortedConfig{};
+        GenPipeline::defaultPipelineConfigInfo(sortedConfig, VK_COMPARE_OP_LESS, VK_FALSE);
+        GenPipeline::enableAlphaBlending(sortedConfig);
+        sortedConfig.renderPass = renderPass;
+        sortedConfig.subpass = GenSwapChain::COMPOSITE_SUBPASS;
+        sortedConfig.pipelineLayout = pipelineLayout;
+        sortedPipeline = std::make_unique<GenPipeline>(
+            genDevice,
+            "shaders/simple_shader.vert.spv",
+            "shaders/transparent_shader.frag.spv",
+            sortedConfig);
+
+        if (renderPath == RenderPath::Deferred)
+        {
+            return;
+        }
+
+        PipelineConfigInfo accumulationConfig{};
+        GenPipeline::defaultPipelineConfigInfo(accumulationConfig);
+        GenPipeline::enableWeightedBlendedAccumulation(accumulationConfig);
+        accumulationConfig.renderPass = renderPass;
+        accumulationConfig.subpass = GenSwapChain::TRANSPARENT_SUBPASS;
+        accumulationConfig.pipelineLayout = pipelineLayout;
+        accumulationPipeline = std::make_unique<GenPipeline>(
+            genDevice,
+            "shaders/simple_shader.vert.spv",
+            "shaders/transparent_oit.frag.spv",
+            accumulationConfig);
+
+        // fullscreen triangle blended over the opaque image
+        PipelineConfigInfo resolveConfig{};
+        GenPipeline::defaultPipelineConfigInfo(resolveConfig);
+        GenPipeline::enableAlphaBlending(resolveConfig);
+        resolveConfig.attributeDescriptions.clear();
+        resolveConfig.bindingDescriptions.clear();
+        resolveConfig.depthStencilInfo.depthTestEnable = VK_FALSE;
+        resolveConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+        resolveConfig.renderPass = renderPass;
+        resolveConfig.subpass = GenSwapChain::COMPOSITE_SUBPASS;
+        resolveConfig.pipelineLayout = resolvePipelineLayout;
+        resolvePipeline = std::make_unique<GenPipeline>(
+            genDevice,
+            "shaders/oit_resolve.vert.spv",
+            "shaders/oit_resolve.frag.spv",
+            resolveConfig);
+    }
+
+    VkDescriptorSet TransparentRenderSystem::getResolveDescriptorSet(int frameIndex, const OitViews &oitViews)
+    {
+        while (resolveDescriptorSets.size() <= static_cast<size_t>(frameIndex))
+        {
+            VkDescriptorSet set;
+            if (!resolvePool->allocateDescriptor(resolveSetLayout->getDescriptorSetLayout(), set))
+            {
+                throw std::runtime_error("failed to allocate transparency resolve descriptor set!");
+            }
+            resolveDescriptorSets.push_back(set);
+            boundOitViews.push_back({});
+        }
+
+        // the views only change when the swap chain is recreated, and the slot's previous frame has completed
+        if (boundOitViews[frameIndex] != oitViews)
+        {
+            VkDescriptorImageInfo accumInfo{VK_NULL_HANDLE, oitViews.accum, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+            VkDescriptorImageInfo revealageInfo{VK_NULL_HANDLE, oitViews.revealage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+            GenDescriptorWriter(*resolveSetLayout, *resolvePool)
+                .writeImage(0, &accumInfo)
+                .writeImage(1, &revealageInfo)
+                .overwrite(resolveDescriptorSets[frameIndex]);
+            boundOitViews[frameIndex] = oitViews;
+        }
+
+        return resolveDescriptorSets[frameIndex];
+    }
+
+    void TransparentRenderSystem::renderSorted(FrameInfo &frameInfo)
+    {
+        GEN_PROFILE_SCOPE("TransparentRenderSystem::renderSorted");
+        sortEntries.clear();
+        sortObjects.clear();
+        for (auto &kv : frameInfo.gameObjects)
+        {
+            auto &obj = kv.second;
+            // evicted models are outside the view
+            if (obj.model == nullptr || obj.transparency == nullptr || !obj.model->isResident())
+                continue;
+
+            auto offset = frameInfo.camera.getPosition() - obj.transform.translation;
+            float disSquared = glm::dot(offset, offset);
+            // inverted so ascending order is back to front
+            sortEntries.push_back({~radixKeyFromFloat(disSquared), static_cast<uint32_t>(sortObjects.size())});
+            sortObjects.push_back(&obj);
+        }
+
+        if (sortObjects.empty())
+        {
+            return;
+        }
+
+        sortScratch.resize(sortEntries.size());
+        radixSort(sortEntries.data(), sortScratch.data(), static_cast<uint32_t>(sortEntries.size()));
+
+        sortedPipeline->bind(frameInfo.commandBuffer);
+        vkCmdBindDescriptorSets(
+            frameInfo.commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipelineLayout,
+            0,
+            1,
+            &frameInfo.globalDescriptorSet,
+            1,
+            &frameInfo.globalUboOffset);
+
+        for (auto &entry : sortEntries)
+        {
+            drawObject(frameInfo, *sortObjects[entry.value]);
+        }
+    }
+
+    void TransparentRenderSystem::renderAccumulation(FrameInfo &frameInfo)
+    {
+        GEN_PROFILE_SCOPE("TransparentRenderSystem::renderAccumulation");
+        assert(accumulationPipeline != nullptr && "Transparency accumulation is only available on the forward render path");
+
+        accumulationPipeline->bind(frameInfo.commandBuffer);
+        vkCmdBindDescriptorSets(
+            frameInfo.commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipelineLayout,
+            0,
+            1,
+            &frameInfo.globalDescriptorSet,
+            1,
+            &frameInfo.globalUboOffset);
+
+        // any order works, the resolve normalizes the weighted sums
+        for (auto &kv : frameInfo.gameObjects)
+        {
+            auto &obj = kv.second;
+            // evicted models are outside the view
+            if (obj.model == nullptr || obj.transparency == nullptr || !obj.model->isResident())
+                continue;
+            drawObject(frameInfo, obj);
+        }
+    }
+
+    void TransparentRenderSystem::resolve(FrameInfo &frameInfo, const OitViews &oitViews)
+    {
+        GEN_PROFILE_SCOPE("TransparentRenderSystem::resolve");
+        assert(resolvePipeline != nullptr && "Transparency resolve is only available on the forward render path");
+
+        VkDescriptorSet resolveSet = getResolveDescriptorSet(frameInfo.frameIndex, oitViews);
+
+        resolvePipeline->bind(frameInfo.commandBuffer);
+        vkCmdBindDescriptorSets(
+            frameInfo.commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            resolvePipelineLayout,
+            0,
+            1,
+            &resolveSet,
+            0,
+            nullptr);
+
+        // fullscreen triangle
+        vkCmdDraw(frameInfo.commandBuffer, 3, 1, 0, 0);
+        frameInfo.drawCalls++;
+    }
+
+    void TransparentRenderSystem::drawObject(FrameInfo &frameInfo, GenGameObject &obj)
+    {
+        TransparentPushConstantData push{};
+        push.modelMatrix = obj.transform.mat4();
+        push.normalMatrix = obj.transform.normalMatrix();
+        push.normalMatrix[3][3] = obj.transparency->alpha;
+
+        vkCmdPushConstants(
+            frameInfo.commandBuffer,
+            pipelineLayout,
+            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+            0,
+            sizeof(TransparentPushConstantData),
+            &push);
+        obj.model->bind(frameInfo.commandBuffer);
+        obj.model->draw(frameInfo.commandBuffer);
+        frameInfo.drawCalls++;
+    }
+
+} // namespace gen
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "gen_camera.hpp"
+#include "gen_device.hpp"
+#include "gen_descriptors.hpp"
+#include "gen_game_object.hpp"
+#include "gen_pipeline.hpp"
+#include "gen_frame_info.hpp"
+#include "gen_radix_sort.hpp"
+#include "gen_swap_chain.hpp"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace gen
+{
+    // Draws game objects with a TransparencyComponent. Either sorted back to front and alpha blended in the
+    // composite subpass, or with weighted blended order independent transparency: accumulated in any order in
+    // the transparent subpass and resolved onto the swap chain image at the start of the composite subpass.
+    // Order independent transparency needs the forward render pass, the deferred path always sorts.
+    class TransparentRenderSystem
+    {
+
+    public:
+        // renderPath selects which render pass layout the pipelines are built for
+        TransparentRenderSystem(GenDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, RenderPath renderPath = RenderPath::Forward);
+        ~TransparentRenderSystem();
+
+        TransparentRenderSystem(const TransparentRenderSystem &) = delete;
+        TransparentRenderSystem &operator=(const TransparentRenderSystem &) = delete;
+
+        // composite subpass
+        void renderSorted(FrameInfo &frameInfo);
+        // transparent subpass, forward path only
+        void renderAccumulation(FrameInfo &frameInfo);
+        // composite subpass, before anything else is blended on top, forward path only
+        void resolve(FrameInfo &frameInfo, const OitViews &oitViews);
+
+    private:
+        void createDescriptorResources();
+        void createPipelineLayouts(VkDescriptorSetLayout globalSetLayout);
+        void createPipelines(VkRenderPass renderPass, RenderPath renderPath);
+        VkDescriptorSet getResolveDescriptorSet(int frameIndex, const OitViews &oitViews);
+        void drawObject(FrameInfo &frameInfo, GenGameObject &obj);
+
+        GenDevice &genDevice;
+
+        std::unique_ptr<GenDescriptorSetLayout> resolveSetLayout;
+        std::unique_ptr<GenDescriptorPool> resolvePool;
+        // one set per frame in flight, rewritten when the swap chain is recreated
+        std::vector<VkDescriptorSet> resolveDescriptorSets;
+        std::vector<OitViews> boundOitViews;
+
+        std::unique_ptr<GenPipeline> sortedPipeline;
+        std::unique_ptr<GenPipeline> accumulationPipeline;
+        std::unique_ptr<GenPipeline> resolvePipeline;
+        VkPipelineLayout pipelineLayout;
+        VkPipelineLayout resolvePipelineLayout = VK_NULL_HANDLE;
+
+        // scratch storage for the sorted path, only grows when more transparent objects are added
+        std::vector<RadixSortEntry> sortEntries;
+        std::vector<RadixSortEntry> sortScratch;
+        std::vector<GenGameObject *> sortObjects;
+    };
+}
@@ -0,0 +1,173 @@
+#include "upscale_system.hpp"
+#include "gen_cpu_profiler.hpp"
+#include "gen_swap_chain.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace gen
+{
+
+    struct UpscalePushConstantData
+    {
+        glm::vec2 uvScale{1.f};
+        glm::vec2 texelSize{1.f};
+        glm::vec2 maxUv{1.f};
+        float sharpness = 0.f;
+    };
+
+    // one per frame in flight, like the scene color
+    static constexpr uint32_t MAX_SCENE_SETS = GenSwapChain::MAX_FRAMES_IN_FLIGHT;
+
+    UpscaleSystem::UpscaleSystem(GenDevice &device, VkRenderPass upscaleRenderPass, GenSamplerCache &samplerCache)
+        : genDevice{device}
+    {
+        // the output never samples outside the rendered region, so clamping only matters at the image border
+        GenSamplerCache::SamplerKey samplerKey{};
+        samplerKey.filter = VK_FILTER_LINEAR;
+        samplerKey.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerKey.addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerKey.anisotropy = false;
+        sampler = samplerCache.getSampler(samplerKey);
+
+        createDescriptorResources();
+        createPipelineLayout();
+        createPipeline(upscaleRenderPass);
+    }
+
+    UpscaleSystem::~UpscaleSystem()
+    {
+        vkDestroyPipelineLayout(genDevice.device(), pipelineLayout, nullptr);
+    }
+
+    void UpscaleSystem::createDescriptorResources()
+    {
+        sceneSetLayout =
+            GenDescriptorSetLayout::Builder(genDevice)
+                .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+                .build();
+
+        scenePool =
+            GenDescriptorPool::Builder(genDevice)
+                .setMaxSets(MAX_SCENE_SETS)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_SCENE_SETS)
+                .build();
+    }
+
+    void UpscaleSystem::createPipelineLayout()
+    {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(UpscalePushConstantData);
+
+        VkDescriptorSetLayout descriptorSetLayout = sceneSetLayout->getDescriptorSetLayout();
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(genDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
+            VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+    }
+
+    void UpscaleSystem::createPipeline(VkRenderPass upscaleRenderPass)
+    {
+        assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+
+        // the fullscreen triangle is generated in the vertex shader and there is no depth attachment
+        PipelineConfigInfo pipelineConfig{};
+        GenPipeline::defaultPipelineConfigInfo(pipelineConfig);
+        pipelineConfig.attributeDescriptions.clear();
+        pipelineConfig.bindingDescriptions.clear();
+        pipelineConfig.depthStencilInfo.depthTestEnable = VK_FALSE;
+        pipelineConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+        pipelineConfig.renderPass = upscaleRenderPass;
+        pipelineConfig.subpass = 0;
+        pipelineConfig.pipelineLayout = pipelineLayout;
+        upscalePipeline = std::make_unique<GenPipeline>(
+            genDevice,
+            "shaders/upscale.vert.spv",
+            "shaders/upscale.frag.spv",
+            pipelineConfig);
+    }
+
+    VkDescriptorSet UpscaleSystem::getSceneDescriptorSet(int frameIndex, VkImageView sceneColor)
+    {
+        while (sceneDescriptorSets.size() <= static_cast<size_t>(frameIndex))
+        {
+            VkDescriptorSet set;
+            if (!scenePool->allocateDescriptor(sceneSetLayout->getDescriptorSetLayout(), set))
+            {
+                throw std::runtime_error("failed to allocate scene color descriptor set!");
+            }
+            sceneDescriptorSets.push_back(set);
+            boundSceneViews.push_back(VK_NULL_HANDLE);
+        }
+
+        // the view only changes when the render graph recreates its images. Only frames of this slot use the set,
+        // and the slot's previous frame has completed by the time this one records, so it can be rewritten
+        if (boundSceneViews[frameIndex] != sceneColor)
+        {
+            VkDescriptorImageInfo sceneInfo{sampler, sceneColor, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+            GenDescriptorWriter(*sceneSetLayout, *scenePool)
+                .writeImage(0, &sceneInfo)
+                .overwrite(sceneDescriptorSets[frameIndex]);
+            boundSceneViews[frameIndex] = sceneColor;
+        }
+
+        return sceneDescriptorSets[frameIndex];
+    }
+
+    void UpscaleSystem::render(
+        FrameInfo &frameInfo,
+        VkImageView sceneColor,
+        VkExtent2D renderExtent,
+        VkExtent2D outputExtent,
+        Filter filter)
+    {
+        GEN_PROFILE_SCOPE("UpscaleSystem::render");
+        VkDescriptorSet descriptorSet = getSceneDescriptorSet(frameInfo.frameIndex, sceneColor);
+
+        upscalePipeline->bind(frameInfo.commandBuffer);
+        vkCmdBindDescriptorSets(
+            frameInfo.commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipelineLayout,
+            0,
+            1,
+            &descriptorSet,
+            0,
+            nullptr);
+
+        glm::vec2 output{static_cast<float>(outputExtent.width), static_cast<float>(outputExtent.height)};
+        glm::vec2 rendered{static_cast<float>(renderExtent.width), static_cast<float>(renderExtent.height)};
+        UpscalePushConstantData push{};
+        push.uvScale = rendered / output;
+        push.texelSize = 1.f / output;
+        push.maxUv = (rendered - 0.5f) / output;
+        push.sharpness = filter == Filter::Sharpened ? sharpness : 0.f;
+        vkCmdPushConstants(
+            frameInfo.commandBuffer,
+            pipelineLayout,
+            VK_SHADER_STAGE_FRAGMENT_BIT,
+            0,
+            sizeof(UpscalePushConstantData),
+            &push);
+
+        vkCmdDraw(frameInfo.commandBuffer, 3, 1, 0, 0);
+        frameInfo.drawCalls++;
+    }
+
+} // namespace gen
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "gen_device.hpp"
+#include "gen_descriptors.hpp"
+#include "gen_frame_info.hpp"
+#include "gen_pipeline.hpp"
+#include "gen_texture.hpp"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace gen
+{
+    // Draws the scene color onto the swap chain image with a fullscreen triangle. The scene may only cover the
+    // top left part of the scene color when it was rendered at a lower resolution, that part is stretched over
+    // the whole output.
+    class UpscaleSystem
+    {
+
+    public:
+        enum class Filter
+        {
+            Bilinear,
+            // bilinear followed by contrast adaptive sharpening, recovers some of the detail lost to the lower
+            // resolution
+            Sharpened
+        };
+
+        UpscaleSystem(GenDevice &device, VkRenderPass upscaleRenderPass, GenSamplerCache &samplerCache);
+        ~UpscaleSystem();
+
+        UpscaleSystem(const UpscaleSystem &) = delete;
+        UpscaleSystem &operator=(const UpscaleSystem &) = delete;
+
+        // sceneColor has the output extent, renderExtent is the part of it the scene was rendered to
+        void render(
+            FrameInfo &frameInfo,
+            VkImageView sceneColor,
+            VkExtent2D renderExtent,
+            VkExtent2D outputExtent,
+            Filter filter);
+
+        // 0 to 1, only used by Filter::Sharpened
+        void setSharpness(float value) { sharpness = value; }
+
+    private:
+        void createDescriptorResources();
+        void createPipelineLayout();
+        void createPipeline(VkRenderPass upscaleRenderPass);
+        VkDescriptorSet getSceneDescriptorSet(int frameIndex, VkImageView sceneColor);
+
+        GenDevice &genDevice;
+        VkSampler sampler;
+
+        std::unique_ptr<GenDescriptorSetLayout> sceneSetLayout;
+        std::unique_ptr<GenDescriptorPool> scenePool;
+        // one set per frame in flight, rewritten when the scene color view changes
+        std::vector<VkDescriptorSet> sceneDescriptorSets;
+        std::vector<VkImageView> boundSceneViews;
+
+        std::unique_ptr<GenPipeline> upscalePipeline;
+        VkPipelineLayout pipelineLayout;
+        float sharpness = 0.5f;
+    };
+}